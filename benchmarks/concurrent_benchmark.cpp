@@ -1,82 +1,94 @@
 #include <benchmark/benchmark.h>
 #include "search_engine.hpp"
+#include "corpus_generator.hpp"
+#include "profiling.hpp"
+#include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
-#include <fstream>
-#include <sstream>
 #include <atomic>
+#include <algorithm>
 
 using namespace rtrv_search_engine;
 
-// Helper function to load Wikipedia sample data
-std::vector<std::pair<std::string, std::string>> loadWikipediaSample() {
-    std::vector<std::pair<std::string, std::string>> docs;
-    
-    // Try multiple paths to find the data file
-    std::vector<std::string> paths = {
-        "data/wikipedia_sample.txt",
-        "../data/wikipedia_sample.txt",
-        "../../data/wikipedia_sample.txt"
-    };
-    
-    std::ifstream file;
-    bool found = false;
-    for (const auto& path : paths) {
-        file.open(path);
-        if (file.is_open()) {
-            found = true;
-            break;
+using namespace rtrv_search_engine::bench;
+
+// Shared synthetic corpus (Zipfian terms, log-normal lengths, multiple fields)
+static const CorpusGenerator& corpus() {
+    static const CorpusGenerator generator = benchCorpus(benchCorpusSize(5000));
+    return generator;
+}
+
+// Head/torso/tail query stream replayed by the search threads
+static const std::vector<GeneratedQuery>& queryLog() {
+    static const std::vector<GeneratedQuery> log = [] {
+        QueryLogConfig config;
+        config.num_queries = benchQueryCount(1000);
+        return corpus().queryLog(config);
+    }();
+    return log;
+}
+
+// Indexed once and shared by every thread count, so large corpora are
+// only built once per run
+static SearchEngine& indexedEngine() {
+    static SearchEngine engine;
+    static const bool indexed = [] {
+        const auto& generator = corpus();
+        for (size_t i = 0; i < generator.config().num_documents; ++i) {
+            engine.indexDocument(generator.document(i));
         }
-        file.clear(); // Clear error flags before trying next path
-    }
-    
-    if (!found) {
-        return docs; // Return empty if file not found
+        return true;
+    }();
+    (void)indexed;
+    return engine;
+}
+
+// Merges the per-thread lock/allocation counters of worker threads. Only
+// populated when the library is built with -DRTRV_PROFILING=ON.
+class ProfileCollector {
+public:
+    // Call at the start of a worker thread
+    static void begin() { profiling::resetThreadProfile(); }
+
+    // Call at the end of a worker thread
+    void end() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        total_ += profiling::threadProfile();
     }
-    
-    std::string line;
-    while (std::getline(file, line)) {
-        if (!line.empty()) {
-            auto pos = line.find('|');
-            if (pos != std::string::npos) {
-                std::string title = line.substr(0, pos);
-                std::string content = line.substr(pos + 1);
-                docs.emplace_back(title, content);
-            }
+
+    // Per-operation lock wait, contention and allocation counters
+    void report(benchmark::State& state, int64_t operations) const {
+        if (!profiling::enabled() || operations == 0) {
+            return;
+        }
+        const double ops = static_cast<double>(operations);
+        for (size_t i = 0; i < NUM_LOCK_SITES; ++i) {
+            const std::string site = profiling::lockSiteName(static_cast<LockSite>(i));
+            state.counters[site + "_wait_ns_per_op"] = benchmark::Counter(total_.locks[i].wait_ns / ops);
+            state.counters[site + "_contended_per_op"] = benchmark::Counter(total_.locks[i].contended / ops);
         }
+        state.counters["allocs_per_op"] = benchmark::Counter(total_.allocations / ops);
+        state.counters["alloc_bytes_per_op"] = benchmark::Counter(total_.allocated_bytes / ops);
     }
-    
-    return docs;
-}
+
+private:
+    std::mutex mutex_;
+    ThreadProfile total_;
+};
+
+// Queries per search thread per iteration, so thread start-up does not
+// dominate the measurement
+static constexpr int kQueriesPerThread = 16;
 
 static void BM_ConcurrentSearches(benchmark::State& state) {
-    auto docs = loadWikipediaSample();
-    if (docs.empty()) {
-        state.SkipWithError("No Wikipedia sample data found");
-        return;
-    }
-    
-    SearchEngine engine;
-    
-    // Index documents
-    for (const auto& [title, content] : docs) {
-        Document doc;
-        doc.fields["title"] = title;
-        doc.fields["content"] = content;
-        engine.indexDocument(doc);
-    }
-    
-    // Sample queries to use
-    std::vector<std::string> queries = {
-        "computer science",
-        "artificial intelligence",
-        "machine learning",
-        "database systems",
-        "programming language"
-    };
+    SearchEngine& engine = indexedEngine();
+    const auto& queries = queryLog();
+    size_t next_query = 0;
     
     int num_threads = state.range(0);
     int64_t total_queries = 0;
+    ProfileCollector profile;
     
     for (auto _ : state) {
         std::vector<std::thread> threads;
@@ -85,8 +97,14 @@ static void BM_ConcurrentSearches(benchmark::State& state) {
         // Launch multiple threads performing searches (read-only, should be safe)
         for (int i = 0; i < num_threads; ++i) {
             threads.emplace_back([&, i]() {
-                auto results = engine.search(queries[i % queries.size()]);
-                queries_completed.fetch_add(1, std::memory_order_relaxed);
+                ProfileCollector::begin();
+                for (int q = 0; q < kQueriesPerThread; ++q) {
+                    const size_t index = next_query + static_cast<size_t>(i) * kQueriesPerThread + q;
+                    auto results = engine.search(queries[index % queries.size()].text);
+                    benchmark::DoNotOptimize(results);
+                    queries_completed.fetch_add(1, std::memory_order_relaxed);
+                }
+                profile.end();
             });
         }
         
@@ -96,27 +114,89 @@ static void BM_ConcurrentSearches(benchmark::State& state) {
         }
         
         total_queries += queries_completed.load();
+        next_query += static_cast<size_t>(num_threads) * kQueriesPerThread;
     }
     
     state.SetItemsProcessed(total_queries);
+    profile.report(state, total_queries);
 }
 
 BENCHMARK(BM_ConcurrentSearches)
-    ->Arg(1)   // Single thread
-    ->Arg(2)
-    ->Arg(4)
-    ->Arg(8)
-    ->Arg(16);
+    ->ArgName("threads")
+    ->RangeMultiplier(2)
+    ->Range(1, 64)
+    ->UseRealTime();
 
-static void BM_ConcurrentUpdates(benchmark::State& state) {
-    auto docs = loadWikipediaSample();
-    if (docs.empty()) {
-        state.SkipWithError("No Wikipedia sample data found");
-        return;
+// Searches on a shared engine while one thread keeps re-indexing documents,
+// so readers contend with the writer on the engine, index and cache locks
+static void BM_ConcurrentMixed(benchmark::State& state) {
+    SearchEngine& engine = indexedEngine();
+    const auto& queries = queryLog();
+    const size_t num_documents = corpus().config().num_documents;
+    size_t next_query = 0;
+    size_t next_update = 0;
+
+    int num_threads = state.range(0);
+    int64_t total_operations = 0;
+    ProfileCollector profile;
+
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        std::atomic<int> operations{0};
+
+        // Writer: indexes and then deletes extra documents with ids above
+        // the corpus, so the shared index is unchanged after the benchmark
+        threads.emplace_back([&]() {
+            ProfileCollector::begin();
+            for (int u = 0; u < kQueriesPerThread / 2; ++u) {
+                Document doc = corpus().document((next_update + u) % num_documents);
+                doc.id = num_documents + 1 + u;
+                engine.indexDocument(doc);
+                engine.deleteDocument(doc.id);
+                operations.fetch_add(2, std::memory_order_relaxed);
+            }
+            profile.end();
+        });
+
+        for (int i = 0; i < num_threads; ++i) {
+            threads.emplace_back([&, i]() {
+                ProfileCollector::begin();
+                for (int q = 0; q < kQueriesPerThread; ++q) {
+                    const size_t index = next_query + static_cast<size_t>(i) * kQueriesPerThread + q;
+                    auto results = engine.search(queries[index % queries.size()].text);
+                    benchmark::DoNotOptimize(results);
+                    operations.fetch_add(1, std::memory_order_relaxed);
+                }
+                profile.end();
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        total_operations += operations.load();
+        next_query += static_cast<size_t>(num_threads) * kQueriesPerThread;
+        next_update += kQueriesPerThread;
     }
+
+    state.SetItemsProcessed(total_operations);
+    profile.report(state, total_operations);
+}
+
+BENCHMARK(BM_ConcurrentMixed)
+    ->ArgName("readers")
+    ->RangeMultiplier(2)
+    ->Range(1, 64)
+    ->UseRealTime();
+
+static void BM_ConcurrentUpdates(benchmark::State& state) {
+    const auto docs = corpus().documents(0, std::min<size_t>(corpus().config().num_documents, 2000));
+    const auto& queries = queryLog();
     
     int num_threads = state.range(0);
     int64_t total_operations = 0;
+    ProfileCollector profile;
     
     for (auto _ : state) {
         std::vector<std::thread> threads;
@@ -126,23 +206,21 @@ static void BM_ConcurrentUpdates(benchmark::State& state) {
         // This benchmarks the overhead of parallel independent indexing operations
         for (int i = 0; i < num_threads; ++i) {
             threads.emplace_back([&, i]() {
+                ProfileCollector::begin();
                 SearchEngine engine;
                 
                 // Each thread indexes a subset of documents
                 for (size_t j = i; j < docs.size(); j += num_threads) {
-                    Document doc;
-                    doc.id = j;
-                    doc.fields["title"] = docs[j].first;
-                    doc.fields["content"] = docs[j].second;
-                    engine.indexDocument(doc);
+                    engine.indexDocument(docs[j]);
                     operations.fetch_add(1, std::memory_order_relaxed);
                 }
                 
                 // Then perform some searches
                 for (int k = 0; k < 10; ++k) {
-                    auto results = engine.search("computer");
+                    auto results = engine.search(queries[(i * 10 + k) % queries.size()].text);
                     operations.fetch_add(1, std::memory_order_relaxed);
                 }
+                profile.end();
             });
         }
         
@@ -154,6 +232,7 @@ static void BM_ConcurrentUpdates(benchmark::State& state) {
     }
     
     state.SetItemsProcessed(total_operations);
+    profile.report(state, total_operations);
 }
 
 BENCHMARK(BM_ConcurrentUpdates)
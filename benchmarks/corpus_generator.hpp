@@ -0,0 +1,436 @@
+#pragma once
+
+/**
+ * Deterministic synthetic corpus and query-log generator for benchmarks.
+ *
+ * Produces documents with a Zipfian term distribution, log-normal document
+ * lengths, topical co-occurrence and multiple fields (title, content,
+ * category, author), plus a matching query log with head/torso/tail
+ * popularity, 1-10 terms, typos and phrases.
+ *
+ * Every document is generated from (seed, index) alone, so corpora of
+ * 1M-10M documents can be streamed in any order without being stored, and
+ * two runs with the same config always produce identical text.
+ *
+ * Set RTRV_BENCH_DOCS / RTRV_BENCH_QUERIES to scale the benchmarks that use
+ * benchCorpusSize() / benchQueryCount().
+ */
+
+#include "document.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace rtrv_search_engine {
+namespace bench {
+
+struct CorpusConfig {
+    size_t num_documents = 10000;
+    size_t vocabulary_size = 50000;
+    double zipf_exponent = 1.07;        // Term frequency skew (English text is ~1.0-1.1)
+    double mean_doc_length = 250.0;     // Mean content length in tokens
+    double doc_length_sigma = 0.8;      // Log-normal shape of content length
+    size_t min_doc_length = 8;
+    size_t max_doc_length = 5000;
+    size_t num_topics = 64;             // Topics give query terms realistic co-occurrence
+    size_t terms_per_topic = 300;
+    double topic_term_ratio = 0.3;      // Fraction of content drawn from the document's topic
+    size_t num_categories = 32;
+    size_t num_authors = 5000;
+    uint64_t seed = 42;
+};
+
+enum class QueryClass { HEAD, TORSO, TAIL };
+
+struct QueryLogConfig {
+    size_t num_queries = 10000;         // Length of the replayed stream
+    size_t distinct_queries = 2000;     // Size of the query pool the stream is drawn from
+    double popularity_exponent = 1.0;   // Zipf skew of query repetition
+    double head_fraction = 0.01;        // Pool ranks below this fraction are HEAD
+    double torso_fraction = 0.20;       // ... below this are TORSO, the rest TAIL
+    double typo_rate = 0.05;
+    double phrase_rate = 0.10;
+    uint64_t seed = 7;
+};
+
+struct GeneratedQuery {
+    std::string text;
+    QueryClass query_class = QueryClass::TAIL;
+    size_t num_terms = 0;
+    bool has_typo = false;
+    bool is_phrase = false;
+};
+
+inline const char* queryClassName(QueryClass query_class) {
+    switch (query_class) {
+        case QueryClass::HEAD: return "head";
+        case QueryClass::TORSO: return "torso";
+        case QueryClass::TAIL: default: return "tail";
+    }
+}
+
+/**
+ * Samples ranks 0..n-1 with probability proportional to 1 / (rank + 1)^s.
+ */
+class ZipfSampler {
+public:
+    ZipfSampler() = default;
+
+    ZipfSampler(size_t n, double exponent) {
+        cumulative_.reserve(n);
+        double total = 0.0;
+        for (size_t rank = 0; rank < n; ++rank) {
+            total += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+            cumulative_.push_back(total);
+        }
+    }
+
+    template <typename Rng>
+    size_t operator()(Rng& rng) const {
+        std::uniform_real_distribution<double> uniform(0.0, cumulative_.back());
+        const double u = uniform(rng);
+        auto it = std::upper_bound(cumulative_.begin(), cumulative_.end(), u);
+        return std::min(static_cast<size_t>(it - cumulative_.begin()), cumulative_.size() - 1);
+    }
+
+    size_t size() const { return cumulative_.size(); }
+
+private:
+    std::vector<double> cumulative_;
+};
+
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(CorpusConfig config = {})
+        : config_(config),
+          term_sampler_(config.vocabulary_size, config.zipf_exponent),
+          topic_sampler_(config.num_topics, 0.8),
+          topic_term_sampler_(config.terms_per_topic, 1.0),
+          category_sampler_(config.num_categories, 1.2),
+          author_sampler_(config.num_authors, 1.1) {
+        buildVocabulary();
+        buildTopics();
+        buildLabels();
+    }
+
+    const CorpusConfig& config() const { return config_; }
+
+    /**
+     * Vocabulary ordered by frequency rank (rank 0 is the most common term).
+     */
+    const std::vector<std::string>& vocabulary() const { return vocabulary_; }
+
+    /**
+     * Generate document `index` (0-based); its id is index + 1.
+     */
+    Document document(size_t index) const {
+        std::mt19937_64 rng(mix(config_.seed, index));
+        const size_t topic = topic_sampler_(rng);
+
+        Document doc;
+        doc.id = static_cast<uint32_t>(index + 1);
+        doc.term_count = 0;
+
+        const size_t title_length = 2 + rng() % 7;
+        std::string title;
+        for (size_t i = 0; i < title_length; ++i) {
+            if (i > 0) title += ' ';
+            std::string word = (rng() % 10 < 7) ? topicTerm(topic, rng) : vocabulary_[term_sampler_(rng)];
+            word[0] = static_cast<char>(word[0] - 'a' + 'A');
+            title += word;
+        }
+
+        doc.fields["title"] = std::move(title);
+        doc.fields["content"] = text(contentLength(rng), rng, topic);
+        doc.fields["category"] = categories_[category_sampler_(rng)];
+        doc.fields["author"] = authors_[author_sampler_(rng)];
+        return doc;
+    }
+
+    /**
+     * Generate documents [begin, begin + count).
+     */
+    std::vector<Document> documents(size_t begin, size_t count) const {
+        std::vector<Document> docs;
+        docs.reserve(count);
+        for (size_t i = begin; i < begin + count; ++i) {
+            docs.push_back(document(i));
+        }
+        return docs;
+    }
+
+    std::vector<Document> documents() const {
+        return documents(0, config_.num_documents);
+    }
+
+    /**
+     * Generate free text with sentence structure drawn from the corpus
+     * distribution; `stream` selects an independent deterministic sequence.
+     */
+    std::string text(size_t word_count, uint64_t stream = 0) const {
+        std::mt19937_64 rng(mix(config_.seed ^ 0x7465787400000000ULL, stream));
+        return text(word_count, rng, topic_sampler_(rng));
+    }
+
+    /**
+     * Generate a query stream. The stream samples a pool of distinct
+     * queries by popularity, so head queries repeat the way they do in
+     * production logs while tail queries are mostly unique.
+     */
+    std::vector<GeneratedQuery> queryLog(const QueryLogConfig& log_config = {}) const {
+        std::vector<GeneratedQuery> pool;
+        pool.reserve(log_config.distinct_queries);
+        for (size_t i = 0; i < log_config.distinct_queries; ++i) {
+            pool.push_back(poolQuery(log_config, i));
+        }
+
+        std::vector<GeneratedQuery> log;
+        if (pool.empty()) {
+            return log;
+        }
+        log.reserve(log_config.num_queries);
+        ZipfSampler popularity(pool.size(), log_config.popularity_exponent);
+        std::mt19937_64 rng(mix(log_config.seed, 0x6c6f67ULL));
+        for (size_t i = 0; i < log_config.num_queries; ++i) {
+            log.push_back(pool[popularity(rng)]);
+        }
+        return log;
+    }
+
+private:
+    static uint64_t mix(uint64_t seed, uint64_t value) {
+        // splitmix64 finalizer: decorrelates neighbouring indices
+        uint64_t z = seed + 0x9e3779b97f4a7c15ULL * (value + 1);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Consonant-vowel syllables; the consonant set avoids every default
+    // stop word, so generated terms are never dropped by the tokenizer.
+    static std::string makeWord(uint64_t bits, size_t syllables) {
+        static const char consonants[] = "bdfgklnprtvz";
+        static const char vowels[] = "aeiou";
+        std::string word;
+        for (size_t s = 0; s < syllables; ++s) {
+            word += consonants[bits % 12];
+            bits /= 12;
+            word += vowels[bits % 5];
+            bits /= 5;
+        }
+        if (bits % 3 == 0) {
+            word += consonants[(bits / 3) % 12];
+        }
+        return word;
+    }
+
+    void buildVocabulary() {
+        // Frequent terms are short, as in natural language
+        std::unordered_set<std::string> seen;
+        vocabulary_.reserve(config_.vocabulary_size);
+        std::mt19937_64 rng(mix(config_.seed, 0x766f636162ULL));
+        while (vocabulary_.size() < config_.vocabulary_size) {
+            const size_t rank = vocabulary_.size();
+            const size_t syllables = rank < 300 ? 2 : (rank < 8000 ? 3 : 4);
+            std::string word = makeWord(rng(), syllables);
+            if (seen.insert(word).second) {
+                vocabulary_.push_back(std::move(word));
+            }
+        }
+    }
+
+    void buildTopics() {
+        // Topic terms come from the torso of the vocabulary: specific enough
+        // to discriminate, frequent enough to co-occur in queries
+        const size_t first = std::min<size_t>(100, config_.vocabulary_size - 1);
+        topics_.resize(config_.num_topics);
+        for (size_t t = 0; t < config_.num_topics; ++t) {
+            std::mt19937_64 rng(mix(config_.seed ^ 0x746f706963ULL, t));
+            std::uniform_int_distribution<size_t> pick(first, config_.vocabulary_size - 1);
+            topics_[t].reserve(config_.terms_per_topic);
+            for (size_t i = 0; i < config_.terms_per_topic; ++i) {
+                topics_[t].push_back(static_cast<uint32_t>(pick(rng)));
+            }
+        }
+    }
+
+    void buildLabels() {
+        std::mt19937_64 rng(mix(config_.seed, 0x6c6162656cULL));
+        auto capitalized = [&](size_t syllables) {
+            std::string word = makeWord(rng(), syllables);
+            word[0] = static_cast<char>(word[0] - 'a' + 'A');
+            return word;
+        };
+        for (size_t i = 0; i < config_.num_categories; ++i) {
+            categories_.push_back(capitalized(2));
+        }
+        for (size_t i = 0; i < config_.num_authors; ++i) {
+            authors_.push_back(capitalized(2) + " " + capitalized(3));
+        }
+    }
+
+    template <typename Rng>
+    const std::string& topicTerm(size_t topic, Rng& rng) const {
+        return vocabulary_[topics_[topic][topic_term_sampler_(rng)]];
+    }
+
+    template <typename Rng>
+    size_t contentLength(Rng& rng) const {
+        const double sigma = config_.doc_length_sigma;
+        const double mu = std::log(config_.mean_doc_length) - sigma * sigma / 2.0;
+        std::lognormal_distribution<double> length(mu, sigma);
+        const auto words = static_cast<size_t>(std::lround(length(rng)));
+        return std::clamp(words, config_.min_doc_length, config_.max_doc_length);
+    }
+
+    template <typename Rng>
+    std::string text(size_t word_count, Rng& rng, size_t topic) const {
+        std::string out;
+        out.reserve(word_count * 8);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        size_t sentence_left = 0;
+        for (size_t i = 0; i < word_count; ++i) {
+            const std::string& word = coin(rng) < config_.topic_term_ratio
+                ? topicTerm(topic, rng)
+                : vocabulary_[term_sampler_(rng)];
+            if (sentence_left == 0) {
+                if (i > 0) out += ". ";
+                out += static_cast<char>(word[0] - 'a' + 'A');
+                out.append(word, 1, std::string::npos);
+                sentence_left = 8 + rng() % 17;
+            } else {
+                out += (rng() % 12 == 0) ? ", " : " ";
+                out += word;
+            }
+            --sentence_left;
+        }
+        if (!out.empty()) out += '.';
+        return out;
+    }
+
+    GeneratedQuery poolQuery(const QueryLogConfig& log_config, size_t pool_rank) const {
+        std::mt19937_64 rng(mix(log_config.seed, pool_rank));
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        GeneratedQuery query;
+
+        const double position = static_cast<double>(pool_rank) / log_config.distinct_queries;
+        if (position < log_config.head_fraction) {
+            query.query_class = QueryClass::HEAD;
+        } else if (position < log_config.torso_fraction) {
+            query.query_class = QueryClass::TORSO;
+        } else {
+            query.query_class = QueryClass::TAIL;
+        }
+
+        // Web query lengths: mostly 1-3 terms with a long tail up to 10
+        static const double length_weights[] = {0.22, 0.30, 0.20, 0.11, 0.06, 0.04, 0.03, 0.02, 0.01, 0.01};
+        std::discrete_distribution<size_t> length(std::begin(length_weights), std::end(length_weights));
+        query.num_terms = length(rng) + 1;
+        if (query.query_class == QueryClass::HEAD) {
+            query.num_terms = std::min<size_t>(query.num_terms, 3);
+        }
+
+        // Head queries use common terms; tail queries lean on rare ones
+        const size_t topic = topic_sampler_(rng);
+        std::vector<std::string> terms;
+        for (size_t i = 0; i < query.num_terms; ++i) {
+            if (query.query_class == QueryClass::TAIL && coin(rng) < 0.5) {
+                std::uniform_int_distribution<size_t> rare(config_.vocabulary_size / 10,
+                                                           config_.vocabulary_size - 1);
+                terms.push_back(vocabulary_[rare(rng)]);
+            } else if (query.query_class == QueryClass::HEAD && coin(rng) < 0.5) {
+                terms.push_back(vocabulary_[term_sampler_(rng) % std::min<size_t>(1000, vocabulary_.size())]);
+            } else {
+                terms.push_back(topicTerm(topic, rng));
+            }
+        }
+
+        if (coin(rng) < log_config.typo_rate) {
+            std::string& victim = terms[rng() % terms.size()];
+            if (victim.size() >= 4) {
+                applyTypo(victim, rng);
+                query.has_typo = true;
+            }
+        }
+
+        size_t phrase_begin = 0;
+        size_t phrase_end = 0;
+        if (terms.size() >= 2 && coin(rng) < log_config.phrase_rate) {
+            const size_t phrase_length = std::min<size_t>(terms.size(), 2 + rng() % 2);
+            phrase_begin = rng() % (terms.size() - phrase_length + 1);
+            phrase_end = phrase_begin + phrase_length;
+            query.is_phrase = true;
+        }
+
+        for (size_t i = 0; i < terms.size(); ++i) {
+            if (i > 0) query.text += ' ';
+            if (query.is_phrase && i == phrase_begin) query.text += '"';
+            query.text += terms[i];
+            if (query.is_phrase && i + 1 == phrase_end) query.text += '"';
+        }
+        return query;
+    }
+
+    template <typename Rng>
+    static void applyTypo(std::string& word, Rng& rng) {
+        static const char letters[] = "abcdefghijklmnopqrstuvwxyz";
+        const size_t pos = 1 + rng() % (word.size() - 2);
+        switch (rng() % 4) {
+            case 0: word[pos] = letters[rng() % 26]; break;         // substitution
+            case 1: word.erase(pos, 1); break;                       // deletion
+            case 2: word.insert(pos, 1, letters[rng() % 26]); break; // insertion
+            default: std::swap(word[pos], word[pos + 1]); break;     // transposition
+        }
+    }
+
+    CorpusConfig config_;
+    ZipfSampler term_sampler_;
+    ZipfSampler topic_sampler_;
+    ZipfSampler topic_term_sampler_;
+    ZipfSampler category_sampler_;
+    ZipfSampler author_sampler_;
+    std::vector<std::string> vocabulary_;
+    std::vector<std::vector<uint32_t>> topics_;
+    std::vector<std::string> categories_;
+    std::vector<std::string> authors_;
+};
+
+inline size_t envSize(const char* name, size_t default_value) {
+    const char* value = std::getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return default_value;
+    }
+    const unsigned long long parsed = std::strtoull(value, nullptr, 10);
+    return parsed > 0 ? static_cast<size_t>(parsed) : default_value;
+}
+
+/**
+ * Corpus size for fixed-size benchmarks (override with RTRV_BENCH_DOCS).
+ */
+inline size_t benchCorpusSize(size_t default_docs) {
+    return envSize("RTRV_BENCH_DOCS", default_docs);
+}
+
+/**
+ * Query stream length (override with RTRV_BENCH_QUERIES).
+ */
+inline size_t benchQueryCount(size_t default_queries) {
+    return envSize("RTRV_BENCH_QUERIES", default_queries);
+}
+
+/**
+ * Corpus used by the benchmark suites: the default config at `num_docs`.
+ */
+inline CorpusGenerator benchCorpus(size_t num_docs) {
+    CorpusConfig config;
+    config.num_documents = num_docs;
+    return CorpusGenerator(config);
+}
+
+}  // namespace bench
+}  // namespace rtrv_search_engine
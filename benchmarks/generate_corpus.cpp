@@ -0,0 +1,77 @@
+// Writes the synthetic benchmark corpus and query log to disk so the same
+// data can be loaded by the servers (DocumentLoader::loadJSONL) or by
+// external tools.
+//
+// Usage: generate_corpus <num_docs> <docs.jsonl> [queries.tsv] [num_queries] [seed]
+//
+// Query log format: one query per line, "<head|torso|tail>\t<query text>".
+
+#include "corpus_generator.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace rtrv_search_engine;
+using namespace rtrv_search_engine::bench;
+
+static std::string escapeJSON(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default: out += c; break;
+        }
+    }
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <num_docs> <docs.jsonl> [queries.tsv] [num_queries] [seed]" << std::endl;
+        return 1;
+    }
+
+    CorpusConfig config;
+    config.num_documents = std::stoull(argv[1]);
+    if (argc > 5) {
+        config.seed = std::stoull(argv[5]);
+    }
+    CorpusGenerator generator(config);
+
+    std::ofstream docs_out(argv[2]);
+    if (!docs_out) {
+        std::cerr << "Cannot open " << argv[2] << std::endl;
+        return 1;
+    }
+    for (size_t i = 0; i < config.num_documents; ++i) {
+        const Document doc = generator.document(i);
+        docs_out << "{\"id\": " << doc.id;
+        for (const auto& [field, value] : doc.fields) {
+            docs_out << ", \"" << field << "\": \"" << escapeJSON(value) << "\"";
+        }
+        docs_out << "}\n";
+    }
+    std::cout << "Wrote " << config.num_documents << " documents to " << argv[2] << std::endl;
+
+    if (argc > 3) {
+        QueryLogConfig log_config;
+        log_config.num_queries = argc > 4 ? std::stoull(argv[4]) : 10000;
+        log_config.seed = config.seed + 1;
+        std::ofstream queries_out(argv[3]);
+        if (!queries_out) {
+            std::cerr << "Cannot open " << argv[3] << std::endl;
+            return 1;
+        }
+        for (const auto& query : generator.queryLog(log_config)) {
+            queries_out << queryClassName(query.query_class) << '\t' << query.text << '\n';
+        }
+        std::cout << "Wrote " << log_config.num_queries << " queries to " << argv[3] << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+/**
+ * Minimal HDR (High Dynamic Range) histogram for latency recording.
+ *
+ * Values are bucketed log-linearly: each power-of-two range is split into
+ * 2^sub_bucket_bits linear sub-buckets, so every recorded value keeps a
+ * fixed relative precision (~0.05% with the default 11 bits, i.e. three
+ * significant digits) from 1ns up to hours with a few hundred KB of counts.
+ * Layout and percentile semantics follow HdrHistogram: reported values are
+ * the highest value equivalent to the recorded bucket.
+ *
+ * Not thread-safe: record into one histogram per thread and add() them.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace rtrv_search_engine {
+namespace bench {
+
+class HdrHistogram {
+public:
+    explicit HdrHistogram(uint64_t highest_trackable = 3600ULL * 1000000000ULL,
+                          int sub_bucket_bits = 11)
+        : sub_bucket_half_bits_(sub_bucket_bits - 1),
+          sub_bucket_count_(uint64_t{1} << sub_bucket_bits),
+          sub_bucket_half_count_(sub_bucket_count_ / 2),
+          sub_bucket_mask_(sub_bucket_count_ - 1),
+          highest_trackable_(highest_trackable) {
+        int buckets = 1;
+        uint64_t smallest_untrackable = sub_bucket_count_;
+        while (smallest_untrackable <= highest_trackable &&
+               smallest_untrackable < (uint64_t{1} << 62)) {
+            smallest_untrackable <<= 1;
+            ++buckets;
+        }
+        counts_.assign(static_cast<size_t>(buckets + 1) * sub_bucket_half_count_, 0);
+    }
+
+    void record(uint64_t value, uint64_t count = 1) {
+        value = std::min(value, highest_trackable_);
+        counts_[countsIndex(value)] += count;
+        total_count_ += count;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+        sum_ += static_cast<double>(value) * count;
+    }
+
+    /**
+     * Merge another histogram with the same layout into this one.
+     */
+    void add(const HdrHistogram& other) {
+        for (size_t i = 0; i < counts_.size() && i < other.counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_count_ += other.total_count_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        sum_ += other.sum_;
+    }
+
+    void reset() {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_count_ = 0;
+        min_ = std::numeric_limits<uint64_t>::max();
+        max_ = 0;
+        sum_ = 0.0;
+    }
+
+    uint64_t totalCount() const { return total_count_; }
+    uint64_t min() const { return total_count_ > 0 ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return total_count_ > 0 ? sum_ / total_count_ : 0.0; }
+
+    /**
+     * Smallest recorded value v such that `percentile` percent of all
+     * recorded values are <= v (percentile in [0, 100]).
+     */
+    uint64_t valueAtPercentile(double percentile) const {
+        if (total_count_ == 0) {
+            return 0;
+        }
+        percentile = std::clamp(percentile, 0.0, 100.0);
+        auto target = static_cast<uint64_t>(percentile / 100.0 * total_count_ + 0.5);
+        target = std::max<uint64_t>(target, 1);
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            cumulative += counts_[i];
+            if (cumulative >= target) {
+                return std::min(highestEquivalentValue(valueFromIndex(i)), max_);
+            }
+        }
+        return max_;
+    }
+
+    /**
+     * Percentile distribution at HdrHistogram's standard log-spaced ticks
+     * (50, 75, 87.5, ... halving the remaining distance to 100).
+     */
+    std::vector<std::pair<double, uint64_t>> percentileDistribution(int ticks_per_half = 1) const {
+        std::vector<std::pair<double, uint64_t>> distribution;
+        distribution.emplace_back(0.0, min());
+        double remaining = 50.0;
+        double percentile = 50.0;
+        while (percentile < 99.9999) {
+            const double step = remaining / 2.0 / ticks_per_half;
+            for (int t = 0; t < ticks_per_half; ++t) {
+                distribution.emplace_back(percentile, valueAtPercentile(percentile));
+                percentile += step;
+            }
+            remaining /= 2.0;
+        }
+        distribution.emplace_back(100.0, max());
+        return distribution;
+    }
+
+private:
+    static int bitLength(uint64_t value) {
+        int bits = 0;
+        while (value != 0) {
+            value >>= 1;
+            ++bits;
+        }
+        return bits;
+    }
+
+    int bucketIndex(uint64_t value) const {
+        return bitLength(value | sub_bucket_mask_) - (sub_bucket_half_bits_ + 1);
+    }
+
+    size_t countsIndex(uint64_t value) const {
+        const int bucket = bucketIndex(value);
+        const uint64_t sub_bucket = value >> bucket;
+        return (static_cast<size_t>(bucket + 1) << sub_bucket_half_bits_) +
+               static_cast<size_t>(sub_bucket - sub_bucket_half_count_);
+    }
+
+    uint64_t valueFromIndex(size_t index) const {
+        int bucket = static_cast<int>(index >> sub_bucket_half_bits_) - 1;
+        uint64_t sub_bucket = (index & (sub_bucket_half_count_ - 1)) + sub_bucket_half_count_;
+        if (bucket < 0) {
+            sub_bucket -= sub_bucket_half_count_;
+            bucket = 0;
+        }
+        return sub_bucket << bucket;
+    }
+
+    uint64_t highestEquivalentValue(uint64_t value) const {
+        const int bucket = bucketIndex(value);
+        const uint64_t lowest = (value >> bucket) << bucket;
+        return lowest + (uint64_t{1} << bucket) - 1;
+    }
+
+    int sub_bucket_half_bits_;
+    uint64_t sub_bucket_count_;
+    uint64_t sub_bucket_half_count_;
+    uint64_t sub_bucket_mask_;
+    uint64_t highest_trackable_;
+    std::vector<uint64_t> counts_;
+    uint64_t total_count_ = 0;
+    uint64_t min_ = std::numeric_limits<uint64_t>::max();
+    uint64_t max_ = 0;
+    double sum_ = 0.0;
+};
+
+}  // namespace bench
+}  // namespace rtrv_search_engine
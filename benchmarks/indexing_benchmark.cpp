@@ -1,66 +1,27 @@
 #include <benchmark/benchmark.h>
 #include "search_engine.hpp"
-#include <fstream>
+#include "corpus_generator.hpp"
 #include <vector>
-#include <sstream>
 
 using namespace rtrv_search_engine;
 
-// Helper function to load Wikipedia sample data
-std::vector<std::pair<std::string, std::string>> loadWikipediaSample() {
-    std::vector<std::pair<std::string, std::string>> docs;
-    
-    // Try multiple paths to find the data file
-    std::vector<std::string> paths = {
-        "data/wikipedia_sample.txt",
-        "../data/wikipedia_sample.txt",
-        "../../data/wikipedia_sample.txt"
-    };
-    
-    std::ifstream file;
-    bool found = false;
-    for (const auto& path : paths) {
-        file.open(path);
-        if (file.is_open()) {
-            found = true;
-            break;
-        }
-        file.clear(); // Clear error flags before trying next path
-    }
-    
-    if (!found) {
-        return docs; // Return empty if file not found
-    }
-    
-    std::string line;
-    while (std::getline(file, line)) {
-        if (!line.empty()) {
-            auto pos = line.find('|');
-            if (pos != std::string::npos) {
-                std::string title = line.substr(0, pos);
-                std::string content = line.substr(pos + 1);
-                docs.emplace_back(title, content);
-            }
-        }
-    }
-    
-    return docs;
+using namespace rtrv_search_engine::bench;
+
+// Shared synthetic corpus (Zipfian terms, log-normal lengths, multiple fields)
+static const CorpusGenerator& corpus() {
+    static const CorpusGenerator generator = benchCorpus(benchCorpusSize(10000));
+    return generator;
 }
 
 static void BM_IndexDocument(benchmark::State& state) {
-    auto docs = loadWikipediaSample();
-    if (docs.empty()) {
-        state.SkipWithError("No Wikipedia sample data found");
-        return;
-    }
-    
+    const auto& generator = corpus();
     size_t doc_index = 0;
     
     for (auto _ : state) {
+        state.PauseTiming();
+        Document doc = generator.document(doc_index % generator.config().num_documents);
+        state.ResumeTiming();
         SearchEngine engine;
-        Document doc;
-        doc.fields["title"] = docs[doc_index % docs.size()].first;
-        doc.fields["content"] = docs[doc_index % docs.size()].second;
         engine.indexDocument(doc);
         doc_index++;
     }
@@ -71,21 +32,13 @@ static void BM_IndexDocument(benchmark::State& state) {
 BENCHMARK(BM_IndexDocument)->Range(1, 1<<10);
 
 static void BM_BatchIndexing(benchmark::State& state) {
-    auto docs = loadWikipediaSample();
-    if (docs.empty()) {
-        state.SkipWithError("No Wikipedia sample data found");
-        return;
-    }
-    
     int batch_size = state.range(0);
+    auto docs = corpus().documents(0, batch_size);
     
     for (auto _ : state) {
         SearchEngine engine;
         
-        for (int i = 0; i < batch_size && i < static_cast<int>(docs.size()); ++i) {
-            Document doc;
-            doc.fields["title"] = docs[i % docs.size()].first;
-            doc.fields["content"] = docs[i % docs.size()].second;
+        for (const auto& doc : docs) {
             engine.indexDocument(doc);
         }
     }
@@ -95,4 +48,24 @@ static void BM_BatchIndexing(benchmark::State& state) {
 
 BENCHMARK(BM_BatchIndexing)->Arg(100)->Arg(1000)->Arg(10000);
 
+// Full-corpus build; documents are streamed from the generator so
+// RTRV_BENCH_DOCS=1000000 (or more) does not need the corpus in memory twice
+static void BM_CorpusBuild(benchmark::State& state) {
+    const auto& generator = corpus();
+    const size_t num_docs = generator.config().num_documents;
+    
+    for (auto _ : state) {
+        SearchEngine engine;
+        for (size_t i = 0; i < num_docs; ++i) {
+            engine.indexDocument(generator.document(i));
+        }
+        state.counters["terms"] = static_cast<double>(engine.getStats().total_terms);
+    }
+    
+    state.counters["docs"] = static_cast<double>(num_docs);
+    state.SetItemsProcessed(state.iterations() * num_docs);
+}
+
+BENCHMARK(BM_CorpusBuild)->Iterations(1)->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
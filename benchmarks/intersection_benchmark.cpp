@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+#include "search_engine.hpp"
+#include "corpus_generator.hpp"
+#include "perf_counters.hpp"
+#include <vector>
+
+using namespace rtrv_search_engine;
+using namespace rtrv_search_engine::bench;
+
+// Shared synthetic corpus (Zipfian terms, log-normal lengths, multiple fields)
+static const CorpusGenerator& corpus() {
+    static const CorpusGenerator generator = benchCorpus(benchCorpusSize(10000));
+    return generator;
+}
+
+// Indexed once; posting lists are copied out per benchmark
+static const SearchEngine& indexedEngine() {
+    static SearchEngine engine;
+    static const bool indexed = [] {
+        const auto& generator = corpus();
+        for (size_t i = 0; i < generator.config().num_documents; ++i) {
+            engine.indexDocument(generator.document(i));
+        }
+        return true;
+    }();
+    (void)indexed;
+    return engine;
+}
+
+// Posting list of the term at a given frequency rank (rank 0 = most common)
+static PostingList postingListAtRank(size_t rank) {
+    const auto& vocabulary = corpus().vocabulary();
+    return indexedEngine().getIndex()->getPostingList(vocabulary[rank % vocabulary.size()]);
+}
+
+// Benchmark: AND of two posting lists, with and without skip pointers.
+// Rank pairs cover dense x dense, dense x sparse and sparse x sparse lists.
+static void BM_Intersect(benchmark::State& state) {
+    PostingList list1 = postingListAtRank(state.range(0));
+    PostingList list2 = postingListAtRank(state.range(1));
+    const bool use_skips = state.range(2) != 0;
+
+    if (use_skips) {
+        list1.buildSkipPointers();
+        list2.buildSkipPointers();
+    } else {
+        list1.skip_pointers.clear();
+        list2.skip_pointers.clear();
+    }
+
+    const double postings = static_cast<double>(list1.postings.size() + list2.postings.size());
+    size_t matches = 0;
+
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        auto result = intersectWithSkips(list1, list2);
+        matches = result.size();
+        benchmark::DoNotOptimize(result);
+    }
+    perf.stop();
+    perf.report(state, postings);
+
+    state.counters["list1"] = static_cast<double>(list1.postings.size());
+    state.counters["list2"] = static_cast<double>(list2.postings.size());
+    state.counters["matches"] = static_cast<double>(matches);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(postings));
+    state.SetLabel(use_skips ? "Skips" : "Linear");
+}
+
+BENCHMARK(BM_Intersect)
+    ->ArgNames({"rank1", "rank2", "skips"})
+    ->Args({0, 1, 0})        // Dense x dense
+    ->Args({0, 1, 1})
+    ->Args({0, 2000, 0})     // Dense x sparse: skips should help most
+    ->Args({0, 2000, 1})
+    ->Args({500, 20000, 0})  // Sparse x sparse
+    ->Args({500, 20000, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,629 @@
+// Query-log replay load tester.
+//
+// Replays a query log against an in-process SearchEngine or a running REST
+// server and reports latency percentiles (HDR histograms) and per-second
+// throughput. Two load models:
+//
+//   closed  N workers issue requests back to back. Measures capacity, but a
+//           slow request delays the ones queued behind it from being sent,
+//           so tail latency is under-reported (coordinated omission).
+//   open    Requests are scheduled at a fixed arrival rate and latency is
+//           measured from the *intended* send time, so queueing delay shows
+//           up in the percentiles the way users would see it.
+//
+// Results are written in Google Benchmark JSON layout (one entry per
+// operation and percentile, times in ns) so compare_benchmarks.py can diff
+// two runs; full percentile distributions are included under "histograms".
+//
+// Usage: load_tester [options]
+//   --mode open|closed       Load model (default: closed)
+//   --target inproc|URL      In-process engine or http://host:port (default: inproc)
+//   --threads N              Workers / connections (default: 4)
+//   --rate R                 Open-loop arrivals per second (default: 100)
+//   --duration S             Run time in seconds (default: 10)
+//   --write-ratio F          Fraction of operations that index a document (default: 0)
+//   --docs N                 In-process corpus size (default: RTRV_BENCH_DOCS or 10000)
+//   --queries FILE           Query log ("<class>\t<query>" or one query per line);
+//                            default: generated log
+//   --no-cache               Bypass the query cache
+//   --name NAME              Prefix for result names (default: LoadTest)
+//   --out FILE               Write JSON results to FILE
+
+#include "search_engine.hpp"
+#include "corpus_generator.hpp"
+#include "hdr_histogram.hpp"
+#include <nlohmann/json.hpp>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rtrv_search_engine;
+using namespace rtrv_search_engine::bench;
+using Clock = std::chrono::steady_clock;
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // macOS: SIGPIPE is suppressed per socket with SO_NOSIGPIPE
+#endif
+
+struct LoadTestConfig {
+    bool open_loop = false;
+    std::string target = "inproc";
+    size_t threads = 4;
+    double rate = 100.0;
+    double duration_seconds = 10.0;
+    double write_ratio = 0.0;
+    size_t num_docs = benchCorpusSize(10000);
+    std::string queries_file;
+    bool use_cache = true;
+    std::string name = "LoadTest";
+    std::string out_file;
+};
+
+// ==================== Targets ====================
+
+/**
+ * One connection / handle per worker thread.
+ */
+class LoadTarget {
+public:
+    virtual ~LoadTarget() = default;
+    virtual bool search(const std::string& query) = 0;
+    virtual bool index(const Document& doc) = 0;
+};
+
+class InProcessTarget : public LoadTarget {
+public:
+    InProcessTarget(SearchEngine& engine, bool use_cache) : engine_(engine) {
+        options_.use_cache = use_cache;
+    }
+
+    bool search(const std::string& query) override {
+        engine_.searchPaginated(query, options_);
+        return true;
+    }
+
+    bool index(const Document& doc) override {
+        return engine_.indexDocument(doc) != 0;
+    }
+
+private:
+    SearchEngine& engine_;
+    SearchOptions options_;
+};
+
+/**
+ * Minimal blocking HTTP/1.1 client with keep-alive, enough to drive the
+ * REST server's /search and /index endpoints without extra dependencies.
+ */
+class HttpTarget : public LoadTarget {
+public:
+    HttpTarget(std::string host, std::string port, bool use_cache)
+        : host_(std::move(host)), port_(std::move(port)), use_cache_(use_cache) {}
+
+    ~HttpTarget() override { disconnect(); }
+
+    bool search(const std::string& query) override {
+        std::string path = "/search?q=" + urlEncode(query);
+        if (!use_cache_) {
+            path += "&cache=false";
+        }
+        return request("GET", path, "");
+    }
+
+    bool index(const Document& doc) override {
+        nlohmann::json body;
+        body["id"] = doc.id;
+        body["content"] = doc.getAllText();
+        return request("POST", "/index", body.dump());
+    }
+
+private:
+    static std::string urlEncode(const std::string& value) {
+        static const char hex[] = "0123456789ABCDEF";
+        std::string out;
+        for (unsigned char c : value) {
+            if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+                out += static_cast<char>(c);
+            } else {
+                out += '%';
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+            }
+        }
+        return out;
+    }
+
+    bool connect() {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        if (getaddrinfo(host_.c_str(), port_.c_str(), &hints, &addresses) != 0) {
+            return false;
+        }
+        for (addrinfo* addr = addresses; addr != nullptr; addr = addr->ai_next) {
+            fd_ = ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+            if (fd_ < 0) {
+                continue;
+            }
+            if (::connect(fd_, addr->ai_addr, addr->ai_addrlen) == 0) {
+                int one = 1;
+                setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+                setsockopt(fd_, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+                break;
+            }
+            ::close(fd_);
+            fd_ = -1;
+        }
+        freeaddrinfo(addresses);
+        return fd_ >= 0;
+    }
+
+    void disconnect() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        buffer_.clear();
+    }
+
+    bool request(const std::string& method, const std::string& path, const std::string& body) {
+        // One reconnect attempt covers servers closing idle keep-alive sockets
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            if (fd_ < 0 && !connect()) {
+                return false;
+            }
+            if (sendRequest(method, path, body)) {
+                int status = 0;
+                if (readResponse(status)) {
+                    return status >= 200 && status < 300;
+                }
+            }
+            disconnect();
+        }
+        return false;
+    }
+
+    bool sendRequest(const std::string& method, const std::string& path, const std::string& body) {
+        std::string message = method + " " + path + " HTTP/1.1\r\nHost: " + host_ +
+                              "\r\nConnection: keep-alive\r\n";
+        if (!body.empty()) {
+            message += "Content-Type: application/json\r\nContent-Length: " +
+                       std::to_string(body.size()) + "\r\n";
+        }
+        message += "\r\n";
+        message += body;
+
+        size_t sent = 0;
+        while (sent < message.size()) {
+            ssize_t n = ::send(fd_, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool fill() {
+        char chunk[16384];
+        ssize_t n = ::recv(fd_, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    bool readResponse(int& status) {
+        size_t header_end;
+        while ((header_end = buffer_.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        const std::string headers = buffer_.substr(0, header_end);
+        if (headers.compare(0, 5, "HTTP/") != 0) {
+            return false;
+        }
+        status = std::atoi(headers.c_str() + headers.find(' ') + 1);
+
+        size_t content_length = 0;
+        std::string lower = headers;
+        for (auto& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        const size_t cl = lower.find("content-length:");
+        if (cl != std::string::npos) {
+            content_length = std::stoul(headers.substr(cl + 15));
+        }
+
+        const size_t total = header_end + 4 + content_length;
+        while (buffer_.size() < total) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        buffer_.erase(0, total);
+        return true;
+    }
+
+    std::string host_;
+    std::string port_;
+    bool use_cache_;
+    int fd_ = -1;
+    std::string buffer_;
+};
+
+// ==================== Load generation ====================
+
+enum OperationType { OP_SEARCH = 0, OP_INDEX = 1, OP_COUNT = 2 };
+
+static const char* operationName(int op) {
+    return op == OP_INDEX ? "index" : "search";
+}
+
+/**
+ * Per-worker recording state, merged after the run.
+ */
+struct WorkerStats {
+    HdrHistogram latency[OP_COUNT];   // Response time (from intended start in open loop)
+    HdrHistogram service[OP_COUNT];   // Time spent inside the request only
+    uint64_t errors[OP_COUNT] = {0, 0};
+};
+
+class LoadTester {
+public:
+    LoadTester(LoadTestConfig config, std::vector<std::string> queries, const CorpusGenerator& corpus)
+        : config_(std::move(config)), queries_(std::move(queries)), corpus_(corpus) {}
+
+    /**
+     * Run the configured load against targets[i] (one per worker).
+     */
+    void run(std::vector<std::unique_ptr<LoadTarget>>& targets) {
+        const size_t seconds = static_cast<size_t>(config_.duration_seconds) + 2;
+        per_second_ = std::vector<std::atomic<uint64_t>>(seconds);
+        stats_ = std::vector<WorkerStats>(targets.size());
+        next_op_.store(0);
+        next_doc_id_.store(config_.num_docs + 1);
+
+        start_ = Clock::now();
+        deadline_ = start_ + std::chrono::duration_cast<Clock::duration>(
+                                 std::chrono::duration<double>(config_.duration_seconds));
+
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < targets.size(); ++w) {
+            workers.emplace_back([this, w, &targets]() {
+                worker(*targets[w], stats_[w]);
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        elapsed_seconds_ = std::chrono::duration<double>(Clock::now() - start_).count();
+    }
+
+    nlohmann::json report() const {
+        WorkerStats merged;
+        for (const auto& stats : stats_) {
+            for (int op = 0; op < OP_COUNT; ++op) {
+                merged.latency[op].add(stats.latency[op]);
+                merged.service[op].add(stats.service[op]);
+                merged.errors[op] += stats.errors[op];
+            }
+        }
+
+        const std::string mode = config_.open_loop ? "open" : "closed";
+        nlohmann::json out;
+        out["context"] = {
+            {"executable", "load_tester"},
+            {"mode", mode},
+            {"target", config_.target},
+            {"threads", config_.threads},
+            {"rate", config_.open_loop ? config_.rate : 0.0},
+            {"duration_seconds", elapsed_seconds_},
+            {"write_ratio", config_.write_ratio},
+            {"num_docs", config_.num_docs},
+            {"use_cache", config_.use_cache},
+        };
+        out["benchmarks"] = nlohmann::json::array();
+        out["histograms"] = nlohmann::json::object();
+
+        uint64_t total_ops = 0;
+        for (int op = 0; op < OP_COUNT; ++op) {
+            total_ops += merged.latency[op].totalCount();
+        }
+
+        for (int op = 0; op < OP_COUNT; ++op) {
+            const HdrHistogram& latency = merged.latency[op];
+            if (latency.totalCount() == 0) {
+                continue;
+            }
+            const std::string prefix = config_.name + "/" + mode + "/" + operationName(op);
+            const double ops_per_second = latency.totalCount() / elapsed_seconds_;
+
+            const std::pair<const char*, double> points[] = {
+                {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p999", 99.9}, {"max", 100.0}};
+            for (const auto& [label, percentile] : points) {
+                out["benchmarks"].push_back(entry(prefix + "/" + label,
+                                                  static_cast<double>(latency.valueAtPercentile(percentile)),
+                                                  latency.totalCount(), ops_per_second));
+            }
+            out["benchmarks"].push_back(entry(prefix + "/mean", latency.mean(),
+                                              latency.totalCount(), ops_per_second));
+
+            nlohmann::json histogram;
+            histogram["count"] = latency.totalCount();
+            histogram["errors"] = merged.errors[op];
+            histogram["ops_per_second"] = ops_per_second;
+            histogram["latency_ns"] = distribution(latency);
+            if (config_.open_loop) {
+                histogram["service_time_ns"] = distribution(merged.service[op]);
+            }
+            out["histograms"][operationName(op)] = std::move(histogram);
+        }
+
+        // Inverse throughput keeps "lower is better" for compare_benchmarks.py
+        if (total_ops > 0) {
+            const double ops_per_second = total_ops / elapsed_seconds_;
+            out["benchmarks"].push_back(entry(config_.name + "/" + mode + "/throughput",
+                                              1e9 / ops_per_second, total_ops, ops_per_second));
+        }
+
+        nlohmann::json timeline = nlohmann::json::array();
+        for (const auto& count : per_second_) {
+            timeline.push_back(count.load());
+        }
+        out["throughput_per_second"] = std::move(timeline);
+        return out;
+    }
+
+private:
+    static nlohmann::json entry(const std::string& name, double time_ns,
+                                uint64_t iterations, double items_per_second) {
+        return {
+            {"name", name},
+            {"run_name", name},
+            {"run_type", "iteration"},
+            {"iterations", iterations},
+            {"real_time", time_ns},
+            {"cpu_time", time_ns},
+            {"time_unit", "ns"},
+            {"items_per_second", items_per_second},
+        };
+    }
+
+    static nlohmann::json distribution(const HdrHistogram& histogram) {
+        nlohmann::json points = nlohmann::json::array();
+        for (const auto& [percentile, value] : histogram.percentileDistribution(2)) {
+            points.push_back({{"percentile", percentile}, {"value", value}});
+        }
+        return points;
+    }
+
+    // Deterministic operation mix: the same op index is always the same
+    // request, so two runs replay identical traffic
+    bool isWrite(uint64_t op_index) const {
+        if (config_.write_ratio <= 0.0) {
+            return false;
+        }
+        uint64_t z = (op_index + 1) * 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 31)) * 0xbf58476d1ce4e5b9ULL;
+        return static_cast<double>(z >> 11) / static_cast<double>(1ULL << 53) < config_.write_ratio;
+    }
+
+    void worker(LoadTarget& target, WorkerStats& stats) {
+        const auto interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / std::max(config_.rate, 1e-9)));
+
+        while (true) {
+            const uint64_t op_index = next_op_.fetch_add(1, std::memory_order_relaxed);
+            Clock::time_point intended = Clock::now();
+            if (config_.open_loop) {
+                intended = start_ + interval * static_cast<int64_t>(op_index);
+                if (intended >= deadline_) {
+                    break;
+                }
+                std::this_thread::sleep_until(intended);
+            } else if (intended >= deadline_) {
+                break;
+            }
+
+            const int op = isWrite(op_index) ? OP_INDEX : OP_SEARCH;
+            const auto begin = Clock::now();
+            bool ok;
+            if (op == OP_INDEX) {
+                Document doc = corpus_.document(next_doc_id_.fetch_add(1) - 1);
+                ok = target.index(doc);
+            } else {
+                ok = target.search(queries_[op_index % queries_.size()]);
+            }
+            const auto end = Clock::now();
+
+            stats.latency[op].record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - intended).count()));
+            stats.service[op].record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+            if (!ok) {
+                stats.errors[op]++;
+            }
+
+            const auto second = static_cast<size_t>(
+                std::chrono::duration_cast<std::chrono::seconds>(end - start_).count());
+            if (second < per_second_.size()) {
+                per_second_[second].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    LoadTestConfig config_;
+    std::vector<std::string> queries_;
+    const CorpusGenerator& corpus_;
+    std::vector<WorkerStats> stats_;
+    std::vector<std::atomic<uint64_t>> per_second_;
+    std::atomic<uint64_t> next_op_{0};
+    std::atomic<uint64_t> next_doc_id_{0};
+    Clock::time_point start_;
+    Clock::time_point deadline_;
+    double elapsed_seconds_ = 0.0;
+};
+
+// ==================== Setup ====================
+
+static std::vector<std::string> loadQueries(const LoadTestConfig& config, const CorpusGenerator& corpus) {
+    std::vector<std::string> queries;
+    if (!config.queries_file.empty()) {
+        std::ifstream file(config.queries_file);
+        std::string line;
+        while (std::getline(file, line)) {
+            // Accept generate_corpus output ("<class>\t<query>") or bare queries
+            const size_t tab = line.find('\t');
+            std::string query = tab == std::string::npos ? line : line.substr(tab + 1);
+            if (!query.empty()) {
+                queries.push_back(std::move(query));
+            }
+        }
+        return queries;
+    }
+
+    QueryLogConfig log_config;
+    log_config.num_queries = benchQueryCount(100000);
+    for (auto& query : corpus.queryLog(log_config)) {
+        queries.push_back(std::move(query.text));
+    }
+    return queries;
+}
+
+static bool parseArgs(int argc, char* argv[], LoadTestConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            return i + 1 < argc ? argv[++i] : "";
+        };
+        if (arg == "--mode") {
+            const std::string mode = value();
+            if (mode != "open" && mode != "closed") return false;
+            config.open_loop = (mode == "open");
+        } else if (arg == "--target") {
+            config.target = value();
+        } else if (arg == "--threads") {
+            config.threads = std::max<size_t>(1, std::stoul(value()));
+        } else if (arg == "--rate") {
+            config.rate = std::stod(value());
+        } else if (arg == "--duration") {
+            config.duration_seconds = std::stod(value());
+        } else if (arg == "--write-ratio") {
+            config.write_ratio = std::stod(value());
+        } else if (arg == "--docs") {
+            config.num_docs = std::stoul(value());
+        } else if (arg == "--queries") {
+            config.queries_file = value();
+        } else if (arg == "--no-cache") {
+            config.use_cache = false;
+        } else if (arg == "--name") {
+            config.name = value();
+        } else if (arg == "--out") {
+            config.out_file = value();
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parseUrl(const std::string& url, std::string& host, std::string& port) {
+    const std::string scheme = "http://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        return false;
+    }
+    std::string authority = url.substr(scheme.size());
+    authority = authority.substr(0, authority.find('/'));
+    const size_t colon = authority.rfind(':');
+    host = authority.substr(0, colon);
+    port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+    return !host.empty();
+}
+
+int main(int argc, char* argv[]) {
+    LoadTestConfig config;
+    try {
+        if (!parseArgs(argc, argv, config)) {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--mode open|closed] [--target inproc|http://host:port] [--threads N]"
+                         " [--rate R] [--duration S] [--write-ratio F] [--docs N] [--queries FILE]"
+                         " [--no-cache] [--name NAME] [--out FILE]" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << std::endl;
+        return 1;
+    }
+
+    const CorpusGenerator corpus = benchCorpus(config.num_docs);
+    const auto queries = loadQueries(config, corpus);
+    if (queries.empty()) {
+        std::cerr << "No queries to replay" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<SearchEngine> engine;
+    std::vector<std::unique_ptr<LoadTarget>> targets;
+    if (config.target == "inproc") {
+        engine = std::make_unique<SearchEngine>();
+        std::cerr << "Indexing " << config.num_docs << " documents..." << std::endl;
+        for (size_t i = 0; i < config.num_docs; ++i) {
+            engine->indexDocument(corpus.document(i));
+        }
+        for (size_t t = 0; t < config.threads; ++t) {
+            targets.push_back(std::make_unique<InProcessTarget>(*engine, config.use_cache));
+        }
+    } else {
+        std::string host, port;
+        if (!parseUrl(config.target, host, port)) {
+            std::cerr << "Unsupported target: " << config.target << std::endl;
+            return 1;
+        }
+        for (size_t t = 0; t < config.threads; ++t) {
+            targets.push_back(std::make_unique<HttpTarget>(host, port, config.use_cache));
+        }
+    }
+
+    std::cerr << "Replaying " << queries.size() << " queries ("
+              << (config.open_loop ? "open loop, " + std::to_string(static_cast<long>(config.rate)) + " req/s"
+                                   : std::string("closed loop"))
+              << ", " << config.threads << " threads, " << config.duration_seconds << "s)..."
+              << std::endl;
+
+    LoadTester tester(config, queries, corpus);
+    tester.run(targets);
+    const nlohmann::json results = tester.report();
+
+    for (const auto& bench : results["benchmarks"]) {
+        std::cout << bench["name"].get<std::string>() << ": "
+                  << bench["real_time"].get<double>() / 1000.0 << " us" << std::endl;
+    }
+    for (const auto& [op, histogram] : results["histograms"].items()) {
+        std::cout << op << ": " << histogram["count"] << " ops, "
+                  << histogram["errors"] << " errors, "
+                  << histogram["ops_per_second"].get<double>() << " ops/s" << std::endl;
+    }
+
+    if (!config.out_file.empty()) {
+        std::ofstream out(config.out_file);
+        out << results.dump(2) << std::endl;
+        std::cerr << "Results written to " << config.out_file << std::endl;
+    }
+    return 0;
+}
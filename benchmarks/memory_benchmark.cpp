@@ -1,5 +1,6 @@
 #include <benchmark/benchmark.h>
 #include "search_engine.hpp"
+#include "corpus_generator.hpp"
 #include <fstream>
 #include <vector>
 #include <sstream>
@@ -13,45 +14,12 @@
 
 using namespace rtrv_search_engine;
 
-// Helper function to load Wikipedia sample data
-std::vector<std::pair<std::string, std::string>> loadWikipediaSample() {
-    std::vector<std::pair<std::string, std::string>> docs;
-    
-    // Try multiple paths to find the data file
-    std::vector<std::string> paths = {
-        "data/wikipedia_sample.txt",
-        "../data/wikipedia_sample.txt",
-        "../../data/wikipedia_sample.txt"
-    };
-    
-    std::ifstream file;
-    bool found = false;
-    for (const auto& path : paths) {
-        file.open(path);
-        if (file.is_open()) {
-            found = true;
-            break;
-        }
-        file.clear();
-    }
-    
-    if (!found) {
-        return docs;
-    }
-    
-    std::string line;
-    while (std::getline(file, line)) {
-        if (!line.empty()) {
-            auto pos = line.find('|');
-            if (pos != std::string::npos) {
-                std::string title = line.substr(0, pos);
-                std::string content = line.substr(pos + 1);
-                docs.emplace_back(title, content);
-            }
-        }
-    }
-    
-    return docs;
+using namespace rtrv_search_engine::bench;
+
+// Shared synthetic corpus (Zipfian terms, log-normal lengths, multiple fields)
+static const CorpusGenerator& corpus() {
+    static const CorpusGenerator generator = benchCorpus(benchCorpusSize(10000));
+    return generator;
 }
 
 // Get current memory usage in bytes
@@ -81,14 +49,28 @@ size_t getCurrentMemoryUsage() {
 #endif
 }
 
-static void BM_MemoryPerDocument(benchmark::State& state) {
-    auto docs = loadWikipediaSample();
-    if (docs.empty()) {
-        state.SkipWithError("No Wikipedia sample data found");
-        return;
+// Report the engine's own per-structure accounting next to the RSS delta.
+// accounted_vs_rss close to 1.0 means the breakdown explains the growth.
+void reportMemoryBreakdown(benchmark::State& state, const MemoryUsage& usage, size_t rss_delta) {
+    state.counters["dict_kb"] = benchmark::Counter(usage.term_dictionary_bytes / 1024.0);
+    state.counters["doc_ids_kb"] = benchmark::Counter(usage.posting_doc_id_bytes / 1024.0);
+    state.counters["tf_kb"] = benchmark::Counter(usage.posting_tf_bytes / 1024.0);
+    state.counters["positions_kb"] = benchmark::Counter(usage.posting_position_bytes / 1024.0);
+    state.counters["skips_kb"] = benchmark::Counter(usage.skip_data_bytes / 1024.0);
+    state.counters["doc_store_kb"] = benchmark::Counter(usage.document_store_bytes / 1024.0);
+    state.counters["fuzzy_kb"] = benchmark::Counter(usage.fuzzy_index_bytes / 1024.0);
+    state.counters["cache_kb"] = benchmark::Counter(usage.query_cache_bytes / 1024.0);
+    state.counters["slack_kb"] = benchmark::Counter(usage.allocator_slack_bytes / 1024.0);
+    state.counters["accounted_kb"] = benchmark::Counter(usage.totalBytes() / 1024.0);
+    if (rss_delta > 0) {
+        state.counters["accounted_vs_rss"] =
+            benchmark::Counter(static_cast<double>(usage.totalBytes()) / rss_delta);
     }
-    
+}
+
+static void BM_MemoryPerDocument(benchmark::State& state) {
     int num_docs = state.range(0);
+    const auto docs = corpus().documents(0, num_docs);
     SearchEngine* engine = nullptr;
     
     for (auto _ : state) {
@@ -99,11 +81,7 @@ static void BM_MemoryPerDocument(benchmark::State& state) {
         state.ResumeTiming();
         
         engine = new SearchEngine();
-        for (int i = 0; i < num_docs && i < static_cast<int>(docs.size()); ++i) {
-            Document doc;
-            doc.id = i;
-            doc.fields["title"] = docs[i % docs.size()].first;
-            doc.fields["content"] = docs[i % docs.size()].second;
+        for (const auto& doc : docs) {
             engine->indexDocument(doc);
         }
         
@@ -112,13 +90,19 @@ static void BM_MemoryPerDocument(benchmark::State& state) {
         state.PauseTiming();
         
         size_t mem_after = getCurrentMemoryUsage();
+        const MemoryUsage usage = engine->memoryUsage();
         
         if (mem_after > mem_before) {
             size_t memory_used = mem_after - mem_before;
             double bytes_per_doc = static_cast<double>(memory_used) / num_docs;
             state.counters["bytes_per_doc"] = benchmark::Counter(bytes_per_doc);
             state.counters["total_memory_kb"] = benchmark::Counter(memory_used / 1024.0);
+            reportMemoryBreakdown(state, usage, memory_used);
+        } else {
+            reportMemoryBreakdown(state, usage, 0);
         }
+        state.counters["accounted_bytes_per_doc"] =
+            benchmark::Counter(static_cast<double>(usage.totalBytes()) / num_docs);
         
         delete engine;
         engine = nullptr;
@@ -132,18 +116,16 @@ BENCHMARK(BM_MemoryPerDocument)
     ->Arg(1000)
     ->Arg(10000)
     ->Unit(benchmark::kMicrosecond)
-    ->Iterations(100);  // Fixed iterations for consistent memory measurement
+    ->Iterations(10);  // Fixed iterations for consistent memory measurement
 
 static void BM_IndexSize(benchmark::State& state) {
-    auto docs = loadWikipediaSample();
-    if (docs.empty()) {
-        state.SkipWithError("No Wikipedia sample data found");
-        return;
-    }
+    const auto docs = corpus().documents();
     
     size_t total_corpus_size = 0;
     for (const auto& doc : docs) {
-        total_corpus_size += doc.first.size() + doc.second.size();
+        for (const auto& [field, value] : doc.fields) {
+            total_corpus_size += value.size();
+        }
     }
     
     SearchEngine* engine = nullptr;
@@ -156,11 +138,7 @@ static void BM_IndexSize(benchmark::State& state) {
         state.ResumeTiming();
         
         engine = new SearchEngine();
-        for (size_t i = 0; i < docs.size(); ++i) {
-            Document doc;
-            doc.id = i;
-            doc.fields["title"] = docs[i].first;
-            doc.fields["content"] = docs[i].second;
+        for (const auto& doc : docs) {
             engine->indexDocument(doc);
         }
         
@@ -170,6 +148,7 @@ static void BM_IndexSize(benchmark::State& state) {
         
         size_t mem_after = getCurrentMemoryUsage();
         size_t index_size = mem_after > mem_before ? (mem_after - mem_before) : 0;
+        reportMemoryBreakdown(state, engine->memoryUsage(), index_size);
         
         double compression_ratio = total_corpus_size > 0 ? 
             static_cast<double>(index_size) / total_corpus_size : 0;
@@ -186,6 +165,6 @@ static void BM_IndexSize(benchmark::State& state) {
     }
 }
 
-BENCHMARK(BM_IndexSize)->Unit(benchmark::kMicrosecond)->Iterations(100);  // Fixed iterations for consistent memory measurement
+BENCHMARK(BM_IndexSize)->Unit(benchmark::kMillisecond)->Iterations(3);  // Fixed iterations for consistent memory measurement
 
 BENCHMARK_MAIN();
@@ -0,0 +1,243 @@
+#pragma once
+
+/**
+ * Hardware performance counters for benchmarks (Linux perf_event_open).
+ *
+ * Enabled with RTRV_PERF_COUNTERS=1. Counts cycles, instructions, cache
+ * misses, branch misses and LLC loads over the timed loop of a benchmark and
+ * reports them per iteration, plus IPC and misses per posting when the
+ * benchmark says how many postings one iteration touches.
+ *
+ * Degrades gracefully: on non-Linux platforms, when the variable is unset,
+ * or when the kernel refuses (containers, perf_event_paranoid > 2, no PMU
+ * in the VM) the counters stay closed and nothing is reported. Events the
+ * CPU does not support are skipped individually.
+ *
+ * Usage:
+ *     PerfCounters perf;
+ *     perf.start();
+ *     for (auto _ : state) { ... }
+ *     perf.stop();
+ *     perf.report(state, postings_per_iteration);
+ *
+ * Setup inside the loop goes between pause() and resume(), next to
+ * state.PauseTiming()/ResumeTiming(), so the counters cover what the timer does.
+ */
+
+#include <benchmark/benchmark.h>
+#include "search_engine.hpp"
+#include "tokenizer.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace rtrv_search_engine {
+namespace bench {
+
+class PerfCounters {
+public:
+    enum Event { CYCLES = 0, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, LLC_LOADS, NUM_EVENTS };
+
+    PerfCounters() {
+        const char* enabled = std::getenv("RTRV_PERF_COUNTERS");
+        if (enabled == nullptr || std::strcmp(enabled, "0") == 0 || *enabled == '\0') {
+            return;
+        }
+        open();
+        if (!available()) {
+            warnOnce();
+        }
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * True when at least cycles and instructions could be opened.
+     */
+    bool available() const { return fds_[CYCLES] >= 0 && fds_[INSTRUCTIONS] >= 0; }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    /**
+     * Stop and restart counting without resetting, for untimed setup
+     */
+    void pause() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void resume() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            if (fds_[e] < 0) {
+                continue;
+            }
+            ioctl(fds_[e], PERF_EVENT_IOC_DISABLE, 0);
+            values_[e] = readScaled(fds_[e]);
+        }
+#endif
+    }
+
+    /**
+     * Raw count of `event` over the last start()/stop() window (0 if closed).
+     */
+    double value(Event event) const { return fds_[event] >= 0 ? values_[event] : 0.0; }
+
+    /**
+     * Add per-iteration counters to `state`. `postings_per_iteration` is the
+     * number of postings one iteration processes; pass 0 to omit the
+     * per-posting ratios.
+     */
+    void report(benchmark::State& state, double postings_per_iteration = 0.0) const {
+        if (!available() || state.iterations() == 0) {
+            return;
+        }
+        const double iterations = static_cast<double>(state.iterations());
+        static const char* const names[NUM_EVENTS] = {
+            "cycles", "instructions", "cache_misses", "branch_misses", "llc_loads"};
+
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            if (fds_[e] >= 0) {
+                state.counters[names[e]] = benchmark::Counter(values_[e] / iterations);
+            }
+        }
+        if (values_[CYCLES] > 0) {
+            state.counters["IPC"] = benchmark::Counter(values_[INSTRUCTIONS] / values_[CYCLES]);
+        }
+        if (postings_per_iteration > 0) {
+            const double postings = postings_per_iteration * iterations;
+            state.counters["cycles_per_posting"] = benchmark::Counter(values_[CYCLES] / postings);
+            if (fds_[CACHE_MISSES] >= 0) {
+                state.counters["cache_misses_per_posting"] =
+                    benchmark::Counter(values_[CACHE_MISSES] / postings);
+            }
+            if (fds_[BRANCH_MISSES] >= 0) {
+                state.counters["branch_misses_per_posting"] =
+                    benchmark::Counter(values_[BRANCH_MISSES] / postings);
+            }
+        }
+    }
+
+private:
+#ifdef __linux__
+    static int openEvent(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;  // Allowed at perf_event_paranoid <= 2
+        attr.exclude_hv = 1;
+        attr.inherit = 1;         // Include threads spawned by the benchmark
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        const long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        return static_cast<int>(fd);
+    }
+
+    // Counts are scaled up when the kernel multiplexed more events than
+    // the PMU has registers for
+    static double readScaled(int fd) {
+        uint64_t data[3] = {0, 0, 0};  // value, time_enabled, time_running
+        if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(data[0]) * data[1] / data[2];
+    }
+#endif
+
+    void open() {
+#ifdef __linux__
+        fds_[CYCLES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds_[INSTRUCTIONS] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds_[CACHE_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds_[BRANCH_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        fds_[LLC_LOADS] = openEvent(PERF_TYPE_HW_CACHE,
+                                    PERF_COUNT_HW_CACHE_LL |
+                                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                    (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16));
+#endif
+    }
+
+    static void warnOnce() {
+        static bool warned = false;
+        if (!warned) {
+            std::cerr << "RTRV_PERF_COUNTERS: hardware counters unavailable "
+                         "(check perf_event_paranoid / container seccomp); "
+                         "reporting timings only" << std::endl;
+            warned = true;
+        }
+    }
+
+    int fds_[NUM_EVENTS] = {-1, -1, -1, -1, -1};
+    double values_[NUM_EVENTS] = {0, 0, 0, 0, 0};
+};
+
+/**
+ * Average number of postings a query from `queries` reads: the sum of the
+ * document frequencies of its terms, tokenized like the engine does.
+ */
+inline double averagePostingsPerQuery(const SearchEngine& engine, const std::vector<std::string>& queries,
+                                      size_t sample = 1000) {
+    const size_t count = std::min(sample, queries.size());
+    if (count == 0) {
+        return 0.0;
+    }
+    Tokenizer tokenizer;
+    double postings = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        for (const auto& term : tokenizer.tokenize(queries[i])) {
+            postings += static_cast<double>(engine.getIndex()->getDocumentFrequency(term));
+        }
+    }
+    return postings / count;
+}
+
+}  // namespace bench
+}  // namespace rtrv_search_engine
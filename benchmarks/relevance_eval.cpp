@@ -0,0 +1,288 @@
+// Relevance-quality evaluation next to latency.
+//
+// Runs a query set against a candidate search configuration and against the
+// exhaustive BM25 baseline (full scoring, full sort, no cache), then reports:
+//
+//   - with qrels:   NDCG@10, MRR and recall@k for candidate and baseline
+//   - always:       rank-biased overlap (RBO) and overlap@10 of the candidate
+//                   ranking against the baseline ranking
+//   - latency:      p50/p99/mean per configuration (HDR histogram)
+//
+// A performance change that approximates scoring (pruning, quantization,
+// fuzzy shortcuts, ...) should keep RBO near 1.0 and NDCG unchanged.
+//
+// Usage: relevance_eval [options]
+//   --docs FILE.jsonl        Corpus (default: generated, --num-docs documents)
+//   --num-docs N             Generated corpus size (default: RTRV_BENCH_DOCS or 10000)
+//   --topics FILE            "<query_id>\t<query text>" per line (default: generated)
+//   --qrels FILE             TREC qrels ("<qid> 0 <doc_id> <grade>")
+//   --k N                    Retrieval depth for recall@k and RBO (default: 100)
+//   --ranker NAME            Candidate ranker (default: engine default)
+//   --algorithm bm25|tfidf   Candidate ranking algorithm
+//   --no-top-k-heap          Candidate uses full sort
+//   --fuzzy                  Candidate uses fuzzy matching
+//   --out FILE               Write JSON results
+
+#include "search_engine.hpp"
+#include "document_loader.hpp"
+#include "relevance_metrics.hpp"
+#include "corpus_generator.hpp"
+#include "hdr_histogram.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace rtrv_search_engine;
+using namespace rtrv_search_engine::bench;
+
+struct EvalConfig {
+    std::string docs_file;
+    size_t num_docs = benchCorpusSize(10000);
+    std::string topics_file;
+    std::string qrels_file;
+    size_t k = 100;
+    SearchOptions candidate;
+    std::string out_file;
+};
+
+struct Topic {
+    std::string id;
+    std::string text;
+};
+
+/**
+ * Per-configuration accumulator of quality metrics and latency.
+ */
+struct RunStats {
+    HdrHistogram latency;
+    double ndcg_at_10 = 0.0;
+    double mrr = 0.0;
+    double recall_at_k = 0.0;
+    size_t judged_queries = 0;
+
+    void addJudged(const std::vector<uint64_t>& ranking, const Judgments& judgments, size_t k) {
+        ndcg_at_10 += relevance::ndcgAtK(ranking, judgments, 10);
+        mrr += relevance::reciprocalRank(ranking, judgments);
+        recall_at_k += relevance::recallAtK(ranking, judgments, k);
+        judged_queries++;
+    }
+
+    nlohmann::json toJson(size_t k) const {
+        nlohmann::json out;
+        if (judged_queries > 0) {
+            out["judged_queries"] = judged_queries;
+            out["ndcg@10"] = ndcg_at_10 / judged_queries;
+            out["mrr"] = mrr / judged_queries;
+            out["recall@" + std::to_string(k)] = recall_at_k / judged_queries;
+        }
+        out["latency_ns"] = {
+            {"p50", latency.valueAtPercentile(50.0)},
+            {"p99", latency.valueAtPercentile(99.0)},
+            {"mean", latency.mean()},
+        };
+        return out;
+    }
+};
+
+static std::vector<uint64_t> runQuery(SearchEngine& engine, const std::string& query,
+                                      const SearchOptions& options, HdrHistogram& latency) {
+    const auto begin = std::chrono::steady_clock::now();
+    auto results = engine.search(query, options);
+    const auto end = std::chrono::steady_clock::now();
+    latency.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+
+    std::vector<uint64_t> ranking;
+    ranking.reserve(results.size());
+    for (const auto& result : results) {
+        ranking.push_back(result.document.id);
+    }
+    return ranking;
+}
+
+static std::vector<Topic> loadTopics(const EvalConfig& config, const CorpusGenerator& corpus) {
+    std::vector<Topic> topics;
+    if (!config.topics_file.empty()) {
+        std::ifstream file(config.topics_file);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + config.topics_file);
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            const size_t tab = line.find('\t');
+            if (tab != std::string::npos && tab + 1 < line.size()) {
+                topics.push_back({line.substr(0, tab), line.substr(tab + 1)});
+            }
+        }
+        return topics;
+    }
+
+    // One topic per distinct generated query
+    QueryLogConfig log_config;
+    log_config.distinct_queries = benchQueryCount(500);
+    log_config.num_queries = log_config.distinct_queries * 20;
+    std::unordered_set<std::string> seen;
+    for (const auto& query : corpus.queryLog(log_config)) {
+        if (seen.insert(query.text).second) {
+            topics.push_back({"q" + std::to_string(topics.size() + 1), query.text});
+        }
+    }
+    return topics;
+}
+
+static bool parseArgs(int argc, char* argv[], EvalConfig& config) {
+    config.candidate.use_cache = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            return i + 1 < argc ? argv[++i] : "";
+        };
+        if (arg == "--docs") {
+            config.docs_file = value();
+        } else if (arg == "--num-docs") {
+            config.num_docs = std::stoul(value());
+        } else if (arg == "--topics") {
+            config.topics_file = value();
+        } else if (arg == "--qrels") {
+            config.qrels_file = value();
+        } else if (arg == "--k") {
+            config.k = std::max<size_t>(1, std::stoul(value()));
+        } else if (arg == "--ranker") {
+            config.candidate.ranker_name = value();
+        } else if (arg == "--algorithm") {
+            config.candidate.algorithm = value() == "tfidf" ? SearchOptions::TF_IDF : SearchOptions::BM25;
+        } else if (arg == "--no-top-k-heap") {
+            config.candidate.use_top_k_heap = false;
+        } else if (arg == "--fuzzy") {
+            config.candidate.fuzzy_enabled = true;
+        } else if (arg == "--out") {
+            config.out_file = value();
+        } else {
+            return false;
+        }
+    }
+    config.candidate.max_results = config.k;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    EvalConfig config;
+    std::vector<Topic> topics;
+    Qrels qrels;
+    SearchEngine engine;
+
+    try {
+        if (!parseArgs(argc, argv, config)) {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--docs FILE.jsonl | --num-docs N] [--topics FILE] [--qrels FILE] [--k N]"
+                         " [--ranker NAME] [--algorithm bm25|tfidf] [--no-top-k-heap] [--fuzzy]"
+                         " [--out FILE]" << std::endl;
+            return 1;
+        }
+
+        const CorpusGenerator corpus = benchCorpus(config.num_docs);
+        if (!config.docs_file.empty()) {
+            DocumentLoader loader;
+            engine.indexDocuments(loader.loadJSONL(config.docs_file));
+        } else {
+            for (size_t i = 0; i < config.num_docs; ++i) {
+                engine.indexDocument(corpus.document(i));
+            }
+        }
+        topics = loadTopics(config, corpus);
+        if (!config.qrels_file.empty()) {
+            qrels = relevance::loadTrecQrels(config.qrels_file);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // Exhaustive reference: every candidate scored by BM25, full sort
+    SearchOptions baseline;
+    baseline.ranker_name = "BM25";
+    baseline.use_top_k_heap = false;
+    baseline.use_cache = false;
+    baseline.max_results = config.k;
+
+    RunStats candidate_stats, baseline_stats;
+    double rbo = 0.0;
+    double overlap_at_10 = 0.0;
+
+    for (const auto& topic : topics) {
+        const auto reference = runQuery(engine, topic.text, baseline, baseline_stats.latency);
+        const auto ranking = runQuery(engine, topic.text, config.candidate, candidate_stats.latency);
+
+        rbo += relevance::rankBiasedOverlap(ranking, reference);
+        const std::vector<uint64_t> top_ranking(ranking.begin(), ranking.begin() + std::min<size_t>(10, ranking.size()));
+        const std::vector<uint64_t> top_reference(reference.begin(), reference.begin() + std::min<size_t>(10, reference.size()));
+        size_t shared = 0;
+        for (uint64_t doc_id : top_ranking) {
+            shared += std::count(top_reference.begin(), top_reference.end(), doc_id);
+        }
+        overlap_at_10 += top_reference.empty() ? 1.0 : static_cast<double>(shared) / top_reference.size();
+
+        auto judged = qrels.find(topic.id);
+        if (judged != qrels.end() && relevance::relevantCount(judged->second) > 0) {
+            candidate_stats.addJudged(ranking, judged->second, config.k);
+            baseline_stats.addJudged(reference, judged->second, config.k);
+        }
+    }
+
+    const size_t num_topics = topics.size();
+    nlohmann::json out;
+    out["context"] = {
+        {"executable", "relevance_eval"},
+        {"queries", num_topics},
+        {"k", config.k},
+        {"documents", engine.getStats().total_documents},
+    };
+    out["candidate"] = candidate_stats.toJson(config.k);
+    out["baseline"] = baseline_stats.toJson(config.k);
+    out["agreement"] = {
+        {"rbo", num_topics > 0 ? rbo / num_topics : 0.0},
+        {"overlap@10", num_topics > 0 ? overlap_at_10 / num_topics : 0.0},
+    };
+
+    // Latency in Google Benchmark layout for compare_benchmarks.py
+    out["benchmarks"] = nlohmann::json::array();
+    for (const auto& [name, stats] : {std::make_pair("candidate", &candidate_stats),
+                                       std::make_pair("baseline", &baseline_stats)}) {
+        for (const auto& [label, percentile] : {std::make_pair("p50", 50.0), std::make_pair("p99", 99.0)}) {
+            const std::string entry = std::string("RelevanceEval/") + name + "/" + label;
+            const double value = static_cast<double>(stats->latency.valueAtPercentile(percentile));
+            out["benchmarks"].push_back({{"name", entry}, {"run_name", entry}, {"run_type", "iteration"},
+                                         {"iterations", stats->latency.totalCount()},
+                                         {"real_time", value}, {"cpu_time", value}, {"time_unit", "ns"}});
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "Queries: " << num_topics << ", documents: " << engine.getStats().total_documents << std::endl;
+    std::cout << "Agreement with exhaustive BM25: RBO=" << out["agreement"]["rbo"].get<double>()
+              << " overlap@10=" << out["agreement"]["overlap@10"].get<double>() << std::endl;
+    for (const char* name : {"candidate", "baseline"}) {
+        const auto& stats = out[name];
+        std::cout << name << ":";
+        if (stats.contains("ndcg@10")) {
+            std::cout << " NDCG@10=" << stats["ndcg@10"].get<double>()
+                      << " MRR=" << stats["mrr"].get<double>()
+                      << " recall@" << config.k << "=" << stats["recall@" + std::to_string(config.k)].get<double>();
+        }
+        std::cout << " p50=" << stats["latency_ns"]["p50"].get<uint64_t>() / 1000.0 << "us"
+                  << " p99=" << stats["latency_ns"]["p99"].get<uint64_t>() / 1000.0 << "us" << std::endl;
+    }
+
+    if (!config.out_file.empty()) {
+        std::ofstream file(config.out_file);
+        file << out.dump(2) << std::endl;
+        std::cerr << "Results written to " << config.out_file << std::endl;
+    }
+    return 0;
+}
@@ -1,76 +1,81 @@
 #include <benchmark/benchmark.h>
 #include "search_engine.hpp"
+#include "corpus_generator.hpp"
+#include "perf_counters.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
-#include <random>
 
 using namespace rtrv_search_engine;
 
-// Helper function to generate synthetic documents
-std::vector<std::pair<std::string, std::string>> generateSyntheticDocuments(size_t count) {
-    std::vector<std::pair<std::string, std::string>> docs;
-    
-    std::vector<std::string> words = {
-        "computer", "science", "algorithm", "data", "machine",
-        "learning", "artificial", "intelligence", "programming", "software",
-        "engineering", "database", "network", "system", "design",
-        "pattern", "architecture", "development", "technology", "analysis",
-        "structure", "management", "application", "research", "method"
-    };
-    
-    std::vector<std::string> topics = {
-        "Computer Science", "Machine Learning", "Data Structures",
-        "Algorithms", "Software Engineering", "Artificial Intelligence",
-        "Database Systems", "Network Programming", "System Design"
-    };
-    
-    std::mt19937 gen(42);
-    std::uniform_int_distribution<> word_dist(0, words.size() - 1);
-    std::uniform_int_distribution<> count_dist(50, 200);
-    std::uniform_int_distribution<> topic_dist(0, topics.size() - 1);
-    
-    docs.reserve(count);
-    for (size_t i = 0; i < count; ++i) {
-        std::string title = topics[topic_dist(gen)] + " " + std::to_string(i);
-        
-        std::string content;
-        int num_words = count_dist(gen);
-        for (int j = 0; j < num_words; ++j) {
-            content += words[word_dist(gen)] + " ";
+using namespace rtrv_search_engine::bench;
+
+// Shared synthetic corpus (Zipfian terms, log-normal lengths, multiple fields)
+static const CorpusGenerator& corpus() {
+    static const CorpusGenerator generator = benchCorpus(benchCorpusSize(5000));
+    return generator;
+}
+
+// Replayed query stream with head/torso/tail popularity, typos and phrases
+static const std::vector<GeneratedQuery>& queryLog() {
+    static const std::vector<GeneratedQuery> log = [] {
+        QueryLogConfig config;
+        config.num_queries = benchQueryCount(10000);
+        return corpus().queryLog(config);
+    }();
+    return log;
+}
+
+// Queries from the log matching a predicate (e.g. one popularity class)
+template <typename Predicate>
+std::vector<std::string> selectQueries(Predicate predicate) {
+    std::vector<std::string> queries;
+    for (const auto& query : queryLog()) {
+        if (predicate(query)) {
+            queries.push_back(query.text);
         }
-        
-        docs.emplace_back(title, content);
     }
-    
-    return docs;
+    return queries;
+}
+
+// Query strings of the full log
+static std::vector<std::string> queryTexts() {
+    return selectQueries([](const GeneratedQuery&) { return true; });
+}
+
+// Index the first num_docs documents of the corpus
+void indexCorpus(SearchEngine& engine, size_t num_docs) {
+    const auto& generator = corpus();
+    for (size_t i = 0; i < num_docs; ++i) {
+        engine.indexDocument(generator.document(i));
+    }
 }
 
 static void BM_Search(benchmark::State& state) {
     int num_docs = state.range(0);
-    auto docs = generateSyntheticDocuments(num_docs);
-    
     SearchEngine engine;
+    indexCorpus(engine, num_docs);
     
-    // Index documents for testing
-    for (int i = 0; i < num_docs; ++i) {
-        Document doc;
-        doc.id = i;
-        doc.fields["title"] = docs[i].first;
-        doc.fields["content"] = docs[i].second;
-        engine.indexDocument(doc);
-    }
-    
-    // Sample queries
-    std::vector<std::string> queries = {
-        "computer", "science", "algorithm", "data", "machine"
-    };
+    // Full query log: mixed popularity, 1-10 terms, typos and phrases
+    const auto& queries = queryLog();
     
+    SearchOptions options;
+    options.use_cache = false;  // Repeated queries would be served from the cache
     size_t query_idx = 0;
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
-        auto results = engine.search(queries[query_idx % queries.size()]);
+        auto results = engine.search(queries[query_idx % queries.size()].text, options);
         benchmark::DoNotOptimize(results);
         query_idx++;
     }
+    perf.stop();
+    perf.report(state, averagePostingsPerQuery(engine, queryTexts()));
     
     state.SetItemsProcessed(state.iterations());
 }
@@ -83,35 +88,27 @@ BENCHMARK(BM_Search)
 
 static void BM_SearchComplexQuery(benchmark::State& state) {
     int num_docs = state.range(0);
-    auto docs = generateSyntheticDocuments(num_docs);
-    
     SearchEngine engine;
-    
-    // Index documents
-    for (int i = 0; i < num_docs; ++i) {
-        Document doc;
-        doc.id = i;
-        doc.fields["title"] = docs[i].first;
-        doc.fields["content"] = docs[i].second;
-        engine.indexDocument(doc);
-    }
+    indexCorpus(engine, num_docs);
     
     // Multi-term complex queries
-    std::vector<std::string> complex_queries = {
-        "computer science programming",
-        "artificial intelligence machine learning",
-        "data structures algorithms",
-        "software engineering design patterns",
-        "database management systems"
-    };
+    auto complex_queries = selectQueries([](const GeneratedQuery& query) {
+        return query.num_terms >= 3;
+    });
     
+    SearchOptions options;
+    options.use_cache = false;
     size_t query_idx = 0;
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
-        auto results = engine.search(complex_queries[query_idx % complex_queries.size()]);
+        auto results = engine.search(complex_queries[query_idx % complex_queries.size()], options);
         benchmark::DoNotOptimize(results);
         query_idx++;
     }
+    perf.stop();
+    perf.report(state, averagePostingsPerQuery(engine, complex_queries));
     
     state.SetItemsProcessed(state.iterations());
 }
@@ -123,27 +120,26 @@ BENCHMARK(BM_SearchComplexQuery)
 
 static void BM_SearchWithTfIdf(benchmark::State& state) {
     int num_docs = state.range(0);
-    auto docs = generateSyntheticDocuments(num_docs);
-    
     SearchEngine engine;
-    
-    // Index documents
-    for (int i = 0; i < num_docs; ++i) {
-        Document doc;
-        doc.id = i;
-        doc.fields["title"] = docs[i].first;
-        doc.fields["content"] = docs[i].second;
-        engine.indexDocument(doc);
-    }
+    indexCorpus(engine, num_docs);
     
     SearchOptions options;
     options.algorithm = SearchOptions::TF_IDF;
     options.max_results = 10;
+    options.use_cache = false;
+    
+    const auto& queries = queryLog();
+    size_t query_idx = 0;
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
-        auto results = engine.search("computer science", options);
+        auto results = engine.search(queries[query_idx % queries.size()].text, options);
         benchmark::DoNotOptimize(results);
+        query_idx++;
     }
+    perf.stop();
+    perf.report(state, averagePostingsPerQuery(engine, queryTexts()));
     
     state.SetItemsProcessed(state.iterations());
 }
@@ -155,27 +151,26 @@ BENCHMARK(BM_SearchWithTfIdf)
 
 static void BM_SearchWithBm25(benchmark::State& state) {
     int num_docs = state.range(0);
-    auto docs = generateSyntheticDocuments(num_docs);
-    
     SearchEngine engine;
-    
-    // Index documents
-    for (int i = 0; i < num_docs; ++i) {
-        Document doc;
-        doc.id = i;
-        doc.fields["title"] = docs[i].first;
-        doc.fields["content"] = docs[i].second;
-        engine.indexDocument(doc);
-    }
+    indexCorpus(engine, num_docs);
     
     SearchOptions options;
     options.algorithm = SearchOptions::BM25;
     options.max_results = 10;
+    options.use_cache = false;
+    
+    const auto& queries = queryLog();
+    size_t query_idx = 0;
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
-        auto results = engine.search("computer science", options);
+        auto results = engine.search(queries[query_idx % queries.size()].text, options);
         benchmark::DoNotOptimize(results);
+        query_idx++;
     }
+    perf.stop();
+    perf.report(state, averagePostingsPerQuery(engine, queryTexts()));
     
     state.SetItemsProcessed(state.iterations());
 }
@@ -187,26 +182,24 @@ BENCHMARK(BM_SearchWithBm25)
 
 static void BM_SearchResultSize(benchmark::State& state) {
     size_t num_docs = 1000;  // Fixed dataset size
-    auto docs = generateSyntheticDocuments(num_docs);
-    
     SearchEngine engine;
-    
-    // Index all documents
-    for (size_t i = 0; i < num_docs; ++i) {
-        Document doc;
-        doc.id = i;
-        doc.fields["title"] = docs[i].first;
-        doc.fields["content"] = docs[i].second;
-        engine.indexDocument(doc);
-    }
+    indexCorpus(engine, num_docs);
     
     SearchOptions options;
     options.max_results = state.range(0);  // Variable result size
+    options.use_cache = false;
+    
+    // Most frequent term: matches a large share of the corpus
+    const std::string& term = corpus().vocabulary().front();
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
-        auto results = engine.search("computer", options);
+        auto results = engine.search(term, options);
         benchmark::DoNotOptimize(results);
     }
+    perf.stop();
+    perf.report(state, averagePostingsPerQuery(engine, {term}));
     
     state.SetItemsProcessed(state.iterations());
     state.counters["result_count"] = static_cast<double>(state.range(0));
@@ -218,4 +211,644 @@ BENCHMARK(BM_SearchResultSize)
     ->Arg(50)
     ->MinTime(0.1);
 
+static void BM_SearchByQueryClass(benchmark::State& state) {
+    const auto query_class = static_cast<QueryClass>(state.range(0));
+    size_t num_docs = corpus().config().num_documents;
+    
+    SearchEngine engine;
+    indexCorpus(engine, num_docs);
+    
+    auto queries = selectQueries([query_class](const GeneratedQuery& query) {
+        return query.query_class == query_class;
+    });
+    if (queries.empty()) {
+        state.SkipWithError("No queries of this class in the log");
+        return;
+    }
+    
+    SearchOptions options;
+    options.use_cache = false;
+    size_t query_idx = 0;
+    
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        auto results = engine.search(queries[query_idx % queries.size()], options);
+        benchmark::DoNotOptimize(results);
+        query_idx++;
+    }
+    perf.stop();
+    perf.report(state, averagePostingsPerQuery(engine, queries));
+    
+    state.SetLabel(queryClassName(query_class));
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_SearchByQueryClass)
+    ->Arg(static_cast<int>(QueryClass::HEAD))
+    ->Arg(static_cast<int>(QueryClass::TORSO))
+    ->Arg(static_cast<int>(QueryClass::TAIL))
+    ->MinTime(0.1);
+
+// Synonym dictionary of `entries` one- to three-word entries over the
+// corpus vocabulary plus synthetic words, one alternative each
+static std::shared_ptr<SynonymMap> synonymDictionary(size_t entries) {
+    const auto& vocabulary = corpus().vocabulary();
+    auto map = std::make_shared<SynonymMap>();
+    for (size_t i = 0; i < entries; ++i) {
+        std::string entry = i < vocabulary.size() ? vocabulary[i] : "syn" + std::to_string(i);
+        for (size_t words = 1; words <= i % 3; ++words) {
+            entry += " " + vocabulary[(i * 7 + words) % vocabulary.size()];
+        }
+        map->addMapping(entry, {vocabulary[(i + 1) % vocabulary.size()]});
+    }
+    return map;
+}
+
+// Benchmark: trie lookup over an 8-token query vs dictionary size. Query
+// words are entries at every size, so the work per query is the same and
+// only the tables grow (what remains is cache misses, not entry count)
+static void BM_SynonymLookup(benchmark::State& state) {
+    const auto map = synonymDictionary(state.range(0));
+    const auto& vocabulary = corpus().vocabulary();
+    std::vector<std::vector<std::string>> queries(256);
+    for (size_t q = 0; q < queries.size(); ++q) {
+        for (size_t t = 0; t < 8; ++t) {
+            queries[q].push_back(vocabulary[(q * 31 + t * 7) % 10000]);
+        }
+    }
+
+    size_t q = 0;
+    for (auto _ : state) {
+        auto matches = map->match(queries[q++ % queries.size()]);
+        benchmark::DoNotOptimize(matches);
+    }
+    state.counters["dictionary_mb"] = benchmark::Counter(map->memoryUsage() / (1024.0 * 1024.0));
+    state.SetItemsProcessed(state.iterations() * 8);
+}
+
+BENCHMARK(BM_SynonymLookup)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(500000);
+
+// Benchmark: search without synonyms (0), with query-time expansion (1)
+// and with the same dictionary applied at index time (2)
+static void BM_SearchWithSynonyms(benchmark::State& state) {
+    const int mode = static_cast<int>(state.range(0));
+    const auto& vocabulary = corpus().vocabulary();
+    auto map = std::make_shared<SynonymMap>();
+    for (size_t i = 500; i + 1 < vocabulary.size(); i += 2) {
+        map->addEquivalent({vocabulary[i], vocabulary[i + 1]});
+    }
+
+    SearchEngine engine;
+    if (mode != 0) {
+        engine.setSynonyms(map, mode == 1 ? SynonymMode::QUERY_TIME : SynonymMode::INDEX_TIME);
+    }
+    indexCorpus(engine, corpus().config().num_documents);
+
+    SearchOptions options;
+    options.use_cache = false;
+    size_t q = 0;
+    for (auto _ : state) {
+        const size_t i = q++ % 500;
+        auto results = engine.search(vocabulary[500 + i] + " " + vocabulary[2000 + i], options);
+        benchmark::DoNotOptimize(results);
+    }
+    state.SetLabel(mode == 0 ? "none" : mode == 1 ? "query_time" : "index_time");
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_SearchWithSynonyms)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Unit(benchmark::kMicrosecond);
+
+// Benchmark: facet counting over a 1M-hit result (one keyword field with
+// `arg` distinct values): the per-hit cost added to the scoring pass
+static void BM_FacetCounts(benchmark::State& state) {
+    constexpr uint64_t kHits = 1000000;
+    const size_t cardinality = state.range(0);
+    DocValues doc_values;
+    doc_values.defineField("category", FieldType::KEYWORD);
+    Document doc;
+    for (uint64_t id = 1; id <= kHits; ++id) {
+        doc.fields["category"] = "value" + std::to_string((id * 2654435761ULL) % cardinality);
+        doc_values.addDocument(id, doc);
+    }
+
+    for (auto _ : state) {
+        FacetCounter counter(doc_values, {"category"});
+        for (uint64_t id = 1; id <= kHits; ++id) {
+            counter.collect(id);
+        }
+        auto facets = counter.results(10);
+        benchmark::DoNotOptimize(facets);
+    }
+    state.SetItemsProcessed(state.iterations() * kHits);
+}
+
+BENCHMARK(BM_FacetCounts)
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+// Benchmark: range filter over 1M int64 values selecting `arg` per mille
+// of the documents: range-index lookup plus materializing the doc-id set
+static void BM_RangeFilter(benchmark::State& state) {
+    constexpr uint64_t kDocs = 1000000;
+    const int64_t per_mille = state.range(0);
+    DocValues doc_values;
+    doc_values.defineField("price", FieldType::INT64);
+    Document doc;
+    for (uint64_t id = 1; id <= kDocs; ++id) {
+        doc.fields["price"] = std::to_string((id * 2654435761ULL) % 1000);
+        doc_values.addDocument(id, doc);
+    }
+    doc_values.rangeIterator("price", 0, 0);  // Build the range index outside the loop
+
+    for (auto _ : state) {
+        auto matches = doc_values.rangeIterator("price", 100, 100 + per_mille - 1)->toBitSet(doc_values.ordinals());
+        benchmark::DoNotOptimize(matches);
+    }
+    state.SetItemsProcessed(state.iterations() * kDocs * per_mille / 1000);
+}
+
+BENCHMARK(BM_RangeFilter)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(500)
+    ->Unit(benchmark::kMicrosecond);
+
+// Benchmark: head queries sorted by a date field, top 10, over the full
+// corpus: arg 0 = top-k field collector over every candidate, arg 1 = index
+// sorted on the same field (walk in index order, stop after the page)
+static void BM_SortedSearch(benchmark::State& state) {
+    const bool index_sorted = state.range(0) != 0;
+    const size_t num_docs = corpus().config().num_documents;
+
+    SearchEngine engine;
+    engine.defineField("published", FieldType::DATE);  // Epoch millis
+    const auto& generator = corpus();
+    for (size_t i = 0; i < num_docs; ++i) {
+        Document doc = generator.document(i);
+        doc.fields["published"] = std::to_string((i * 2654435761ULL) % 100000);  // Unrelated to id order
+        engine.indexDocument(doc);
+    }
+    if (index_sorted) {
+        engine.setIndexSort("published", true);
+    }
+
+    auto queries = selectQueries([](const GeneratedQuery& query) { return query.query_class == QueryClass::HEAD; });
+    SearchOptions options;
+    options.sort = {{"published", true}};
+    options.use_cache = false;
+
+    size_t query_idx = 0;
+    for (auto _ : state) {
+        auto results = engine.search(queries[query_idx++ % queries.size()], options);
+        benchmark::DoNotOptimize(results);
+    }
+    state.SetLabel(index_sorted ? "index sorted" : "collector");
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_SortedSearch)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
+// Benchmark: a recurring "tenant AND lang" filter (1 of 50 tenants, 1 of 5
+// languages) applied to 10K candidates out of 1M documents: arg 0 = both
+// clauses evaluated per query (column scans into a bitset, then probes),
+// arg 1 = filter cache (cached sets, one probe per candidate and clause)
+static void BM_CachedFilter(benchmark::State& state) {
+    constexpr uint64_t kDocs = 1000000;
+    constexpr size_t kCandidates = 10000;
+    const bool cached = state.range(0) != 0;
+    static const char* kLanguages[] = {"en", "de", "fr", "es", "ja"};
+
+    DocValues doc_values;
+    doc_values.defineField("tenant", FieldType::KEYWORD);
+    doc_values.defineField("lang", FieldType::KEYWORD);
+    Document doc;
+    for (uint64_t id = 1; id <= kDocs; ++id) {
+        doc.fields["tenant"] = "tenant" + std::to_string((id * 2654435761ULL) % 50);
+        doc.fields["lang"] = kLanguages[id % 7 % 5];
+        doc_values.addDocument(id, doc);
+    }
+    std::vector<uint32_t> candidates;
+    for (size_t i = 0; i < kCandidates; ++i) {
+        candidates.push_back(static_cast<uint32_t>((i * 40503ULL) % kDocs));
+    }
+
+    FilterCache cache;
+    const auto tenant = [&] { return doc_values.keywordIterator("tenant", "tenant7"); };
+    const auto lang = [&] { return doc_values.keywordIterator("lang", "fr"); };
+    for (auto _ : state) {
+        size_t kept = 0;
+        if (cached) {
+            const auto tenant_set = cache.getOrCompute("tenant:tenant7", doc_values, tenant);
+            const auto lang_set = cache.getOrCompute("lang:fr", doc_values, lang);
+            for (uint32_t doc : candidates) {
+                kept += tenant_set->contains(doc) && lang_set->contains(doc);
+            }
+        } else {
+            const BitSet tenant_bits = tenant()->toBitSet(doc_values.ordinals());
+            const BitSet lang_bits = lang()->toBitSet(doc_values.ordinals());
+            for (uint32_t doc : candidates) {
+                kept += tenant_bits.get(doc) && lang_bits.get(doc);
+            }
+        }
+        benchmark::DoNotOptimize(kept);
+    }
+    state.SetLabel(cached ? "cached" : "evaluated per query");
+    state.SetItemsProcessed(state.iterations() * kCandidates);
+}
+
+BENCHMARK(BM_CachedFilter)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
+// Benchmark: terms, histogram, date histogram and stats over 200K hits:
+// arg 0 = second pass over the hits' Document::fields maps (parse every
+// value), arg 1 = AggregationCollector reading the doc-values columns
+static void BM_Aggregations(benchmark::State& state) {
+    constexpr uint64_t kHits = 200000;
+    const bool columnar = state.range(0) != 0;
+
+    DocValues doc_values;
+    doc_values.defineField("brand", FieldType::KEYWORD);
+    doc_values.defineField("price", FieldType::DOUBLE);
+    doc_values.defineField("published", FieldType::DATE);
+    std::vector<Document> docs;
+    docs.reserve(kHits);
+    for (uint64_t id = 1; id <= kHits; ++id) {
+        const uint64_t hash = id * 2654435761ULL;
+        Document doc(static_cast<uint32_t>(id), {});
+        doc.fields["brand"] = "brand" + std::to_string(hash % 100);
+        doc.fields["price"] = std::to_string(hash % 100000 / 100.0);
+        doc.fields["published"] = std::to_string(1700000000000LL + static_cast<int64_t>(hash % 31536000) * 1000);
+        doc_values.addDocument(id, doc);
+        docs.push_back(std::move(doc));
+    }
+    std::vector<AggregationRequest> requests(4);
+    requests[0].field = "brand";
+    requests[1] = {"", AggregationRequest::HISTOGRAM, "price", 10, 50.0};
+    requests[2] = {"", AggregationRequest::DATE_HISTOGRAM, "published", 10, 0.0, AggregationRequest::MONTH};
+    requests[3] = {"", AggregationRequest::STATS, "price"};
+
+    for (auto _ : state) {
+        if (columnar) {
+            AggregationCollector collector(doc_values, requests);
+            for (uint64_t id = 1; id <= kHits; ++id) {
+                collector.collect(doc_values.ordinal(id));
+            }
+            auto results = collector.results();
+            benchmark::DoNotOptimize(results);
+        } else {
+            std::unordered_map<std::string, size_t> brands;
+            std::unordered_map<int64_t, size_t> price_buckets;
+            std::unordered_map<int64_t, size_t> months;
+            double sum = 0.0, min = 1e300, max = -1e300;
+            for (const auto& doc : docs) {
+                ++brands[doc.fields.at("brand")];
+                const double price = std::stod(doc.fields.at("price"));
+                ++price_buckets[static_cast<int64_t>(price / 50.0)];
+                sum += price;
+                min = std::min(min, price);
+                max = std::max(max, price);
+                int64_t millis;
+                DocValues::parseValue(FieldType::DATE, doc.fields.at("published"), millis);
+                int64_t year;
+                unsigned month, day;
+                DocValues::civilFromDays(millis / 86400000, year, month, day);
+                ++months[year * 12 + month];
+            }
+            benchmark::DoNotOptimize(brands);
+            benchmark::DoNotOptimize(sum + min + max);
+        }
+    }
+    state.SetLabel(columnar ? "doc values" : "document maps");
+    state.SetItemsProcessed(state.iterations() * kHits);
+}
+
+BENCHMARK(BM_Aggregations)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+// Benchmark: distinct authors over 1M hits with {1K, 500K} distinct values:
+// arg 0 = exact, a hash set of the hits' author strings; arg 1 =
+// cardinality aggregation (ordinal bits, then a HyperLogLog at precision 14)
+static void BM_Cardinality(benchmark::State& state) {
+    constexpr uint64_t kHits = 1000000;
+    const bool sketch = state.range(0) != 0;
+    const uint64_t distinct = state.range(1);
+
+    DocValues doc_values;
+    doc_values.defineField("author", FieldType::KEYWORD);
+    Document doc;
+    for (uint64_t id = 1; id <= kHits; ++id) {
+        doc.fields["author"] = "author" + std::to_string((id * 2654435761ULL) % distinct);
+        doc_values.addDocument(id, doc);
+    }
+    const KeywordColumn* column = doc_values.keywordColumn("author");
+    AggregationRequest request;
+    request.type = AggregationRequest::CARDINALITY;
+    request.field = "author";
+
+    uint64_t count = 0;
+    for (auto _ : state) {
+        if (sketch) {
+            AggregationCollector collector(doc_values, {request});
+            for (uint64_t id = 1; id <= kHits; ++id) {
+                collector.collect(doc_values.ordinal(id));
+            }
+            count = collector.results()[0].cardinality;
+        } else {
+            std::unordered_set<std::string> authors;
+            for (uint64_t id = 1; id <= kHits; ++id) {
+                authors.insert(column->values[column->valueOrdinal(doc_values.ordinal(id))]);
+            }
+            count = authors.size();
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    const uint64_t actual = column->values.size();
+    state.counters["error_pct"] = 100.0 * std::abs(static_cast<double>(count) - actual) / actual;
+    state.SetLabel(sketch ? "hyperloglog" : "exact hash set");
+    state.SetItemsProcessed(state.iterations() * kHits);
+}
+
+BENCHMARK(BM_Cardinality)
+    ->Args({0, 1000})
+    ->Args({1, 1000})
+    ->Args({0, 500000})
+    ->Args({1, 500000})
+    ->Unit(benchmark::kMillisecond);
+
+// Benchmark: top 10 groups (3 hits each) of 1M scored hits by a keyword
+// field with {1K, 100K} distinct values: arg 0 = post-hoc, sort every hit
+// then group in order; arg 1 = TopGroupsCollector (group heap + key map)
+static void BM_Collapse(benchmark::State& state) {
+    constexpr uint64_t kHits = 1000000;
+    constexpr size_t kGroups = 10;
+    constexpr size_t kPerGroup = 3;
+    const bool collector = state.range(0) != 0;
+    const uint64_t distinct = state.range(1);
+
+    DocValues doc_values;
+    doc_values.defineField("family", FieldType::KEYWORD);
+    std::vector<FieldHit> hits;
+    hits.reserve(kHits);
+    Document doc;
+    for (uint64_t id = 1; id <= kHits; ++id) {
+        doc.fields["family"] = "family" + std::to_string((id * 2654435761ULL) % distinct);
+        doc_values.addDocument(id, doc);
+        const double score = static_cast<double>((id * 11400714819323198485ULL) >> 40) / (1 << 24);
+        hits.push_back({id, doc_values.ordinal(id), score});
+    }
+    const FieldComparator comparator(doc_values, {});
+    const KeywordColumn* column = doc_values.keywordColumn("family");
+
+    size_t groups_found = 0;
+    for (auto _ : state) {
+        if (collector) {
+            TopGroupsCollector groups(comparator, doc_values, "family", kGroups, kPerGroup);
+            for (const auto& hit : hits) {
+                groups.collect(hit);
+            }
+            if (groups.beginRecollect()) {
+                for (const auto& hit : hits) {
+                    if (groups.recollects(hit.ordinal)) groups.recollect(hit);
+                }
+            }
+            groups_found = groups.sorted().size();
+        } else {
+            std::vector<FieldHit> ordered = hits;
+            std::sort(ordered.begin(), ordered.end(), comparator);
+            std::unordered_map<uint32_t, std::vector<FieldHit>> members;
+            std::vector<uint32_t> order;
+            for (const auto& hit : ordered) {
+                const uint32_t value = column->valueOrdinal(hit.ordinal);
+                auto it = members.find(value);
+                if (it == members.end()) {
+                    if (order.size() == kGroups) continue;
+                    order.push_back(value);
+                    it = members.emplace(value, std::vector<FieldHit>()).first;
+                }
+                if (it->second.size() < kPerGroup) it->second.push_back(hit);
+            }
+            groups_found = order.size();
+        }
+        benchmark::DoNotOptimize(groups_found);
+    }
+    state.SetLabel(collector ? "group heap + hash" : "sort, then group");
+    state.SetItemsProcessed(state.iterations() * kHits);
+}
+
+BENCHMARK(BM_Collapse)
+    ->Args({0, 1000})
+    ->Args({1, 1000})
+    ->Args({0, 100000})
+    ->Args({1, 100000})
+    ->Unit(benchmark::kMillisecond);
+
+// ==================== Percolation ====================
+
+// Stored alerts over a skewed 100K-word vocabulary (word wN has document
+// frequency ~ 1/(N+1)); alerts favour the rarer words. Conjunctions,
+// phrases, disjunctions, keyword filters and exclusions. The last
+// percolator built is kept between runs.
+static constexpr uint64_t kPercolateVocabulary = 100000;
+
+static std::string percolateWord(uint64_t& state, double rarest_share = 1.0) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    const double u = 1.0 - rarest_share * static_cast<double>(state >> 11) / static_cast<double>(1ULL << 53);
+    return "w" + std::to_string(static_cast<uint64_t>(std::pow(static_cast<double>(kPercolateVocabulary), u)) - 1);
+}
+
+struct PercolateFixture {
+    Tokenizer tokenizer;
+    DocValues schema;
+    Percolator percolator;
+    std::vector<Document> documents;
+
+    Percolator::Context context() {
+        return {tokenizer, schema, [](const std::string& term) {
+                    return static_cast<size_t>(1000000 / (std::stoull(term.substr(1)) + 1));
+                }};
+    }
+};
+
+static PercolateFixture& percolateFixture(uint64_t queries) {
+    static std::unique_ptr<PercolateFixture> fixture;
+    static uint64_t built = 0;
+    if (!fixture || built != queries) {
+        fixture.reset();
+        fixture = std::make_unique<PercolateFixture>();
+        fixture->schema.defineField("brand", FieldType::KEYWORD);
+        const auto context = fixture->context();
+        uint64_t state = 42;
+        for (uint64_t id = 1; id <= queries; ++id) {
+            const std::string a = percolateWord(state, 0.6);
+            const std::string b = percolateWord(state, 0.6);
+            std::string query;
+            switch (id % 10) {
+                case 0: case 1: case 2: case 3: query = a + " AND " + b; break;
+                case 4: case 5: query = "\"" + a + " " + b + "\"~2"; break;
+                case 6: case 7: query = a + " OR " + b; break;
+                case 8: query = "brand:b" + std::to_string(id % 50) + " AND " + a; break;
+                default: query = a + " NOT " + b; break;
+            }
+            fixture->percolator.addQuery(id, query, context);
+        }
+        for (uint32_t i = 0; i < 64; ++i) {
+            std::string text;
+            for (int w = 0; w < 150; ++w) text += percolateWord(state) + " ";
+            fixture->documents.push_back(Document{i, {{"body", text}, {"brand", "B" + std::to_string(i % 50)}}});
+        }
+        built = queries;
+    }
+    return *fixture;
+}
+
+// Benchmark: match one 150-word document against {10K, 100K, 1M} stored
+// queries: arg 0 = verify every query; arg 1 = term pre-filter, verify
+// candidates only
+static void BM_Percolate(benchmark::State& state) {
+    const bool prefilter = state.range(0) != 0;
+    PercolateFixture& fixture = percolateFixture(state.range(1));
+    const auto context = fixture.context();
+
+    size_t next = 0;
+    size_t candidates = 0;
+    size_t matches = 0;
+    for (auto _ : state) {
+        const Document& doc = fixture.documents[next++ % fixture.documents.size()];
+        PercolateStats stats;
+        const auto ids = prefilter ? fixture.percolator.percolate(doc, context, &stats)
+                                   : fixture.percolator.percolateExhaustive(doc, context);
+        candidates += prefilter ? stats.candidates : fixture.percolator.size();
+        matches += ids.size();
+        benchmark::DoNotOptimize(ids.data());
+    }
+    state.counters["candidates"] = benchmark::Counter(static_cast<double>(candidates), benchmark::Counter::kAvgIterations);
+    state.counters["matches"] = benchmark::Counter(static_cast<double>(matches), benchmark::Counter::kAvgIterations);
+    state.SetLabel(prefilter ? "term pre-filter" : "verify all");
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Percolate)
+    ->Args({0, 10000})
+    ->Args({1, 10000})
+    ->Args({0, 100000})
+    ->Args({1, 100000})
+    ->Args({0, 1000000})
+    ->Args({1, 1000000})
+    ->Unit(benchmark::kMicrosecond);
+
+// ==================== Continuous queries ====================
+
+// Benchmark: keep {100, 1000} live queries (two words, top 10) current
+// while documents are added one at a time to 20K: arg 0 = every query
+// polled (searched again) after each write; arg 1 = subscriptions
+// maintained by the write (0 queries: the write alone)
+static void BM_Subscriptions(benchmark::State& state) {
+    constexpr uint32_t kDocuments = 20000;
+    const bool subscribed = state.range(0) != 0;
+    const size_t queries = static_cast<size_t>(state.range(1));
+
+    uint64_t seed = 7;
+    const auto document = [&](uint32_t id) {
+        std::string text;
+        for (int w = 0; w < 12; ++w) text += percolateWord(seed, 0.7) + " ";
+        return Document{id, {{"content", text}}};
+    };
+    SearchEngine engine;
+    for (uint32_t id = 1; id <= kDocuments; ++id) {
+        engine.indexDocument(document(id));
+    }
+    std::vector<std::string> live;
+    SearchOptions options;
+    options.max_results = 10;
+    size_t deltas = 0;
+    for (size_t i = 0; i < queries; ++i) {
+        live.push_back(percolateWord(seed, 0.7) + " " + percolateWord(seed, 0.7));
+        if (subscribed) {
+            engine.subscribe(live.back(), options, [&deltas](const SubscriptionDelta&) { ++deltas; });
+        }
+    }
+
+    uint32_t next = kDocuments + 1;
+    size_t results = 0;
+    for (auto _ : state) {
+        engine.indexDocument(document(next++));
+        if (!subscribed) {
+            for (const auto& query : live) {
+                results += engine.search(query, options).size();
+            }
+        }
+        benchmark::DoNotOptimize(results);
+    }
+    state.counters["deltas"] = benchmark::Counter(static_cast<double>(deltas), benchmark::Counter::kAvgIterations);
+    state.SetLabel(!subscribed ? "poll every query" : queries ? "incremental subscriptions" : "write only");
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Subscriptions)
+    ->Args({1, 0})
+    ->Args({0, 100})
+    ->Args({1, 100})
+    ->Args({0, 1000})
+    ->Args({1, 1000})
+    ->Unit(benchmark::kMicrosecond);
+
+// Benchmark: "related documents" for a 10K-document corpus (100 words
+// each, top 10): arg 0 = the source's top terms sent to search() as one
+// OR query; arg 1 = moreLikeThis() re-tokenizing the source; arg 2 =
+// moreLikeThis() reading stored term vectors
+static void BM_MoreLikeThis(benchmark::State& state) {
+    constexpr uint32_t kDocuments = 10000;
+    const int mode = static_cast<int>(state.range(0));
+
+    SearchEngine engine;
+    engine.setStoreTermVectors(mode == 2);
+    uint64_t seed = 5;
+    for (uint32_t id = 1; id <= kDocuments; ++id) {
+        std::string text;
+        for (int w = 0; w < 100; ++w) text += percolateWord(seed, 0.8) + " ";
+        engine.indexDocument(Document{id, {{"content", text}}});
+    }
+    SearchOptions options;
+    options.max_results = 10;
+    options.use_cache = false;
+
+    uint64_t source = 1;
+    size_t results = 0;
+    for (auto _ : state) {
+        if (mode == 0) {
+            std::string query;
+            for (const auto& term : engine.moreLikeThisTerms(source)) {
+                query += (query.empty() ? "" : " OR ") + term.first;
+            }
+            results += engine.search(query, options).size();
+        } else {
+            results += engine.moreLikeThis(source, 10).size();
+        }
+        source = source % kDocuments + 1;
+        benchmark::DoNotOptimize(results);
+    }
+    state.SetLabel(mode == 0 ? "OR query via search()" : mode == 1 ? "moreLikeThis, re-tokenized" : "moreLikeThis, term vectors");
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_MoreLikeThis)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_MAIN();
@@ -1,40 +1,25 @@
 #include <benchmark/benchmark.h>
 #include "tokenizer.hpp"
+#include "corpus_generator.hpp"
+#include "perf_counters.hpp"
 #include <fstream>
 #include <vector>
-#include <random>
 #include <sstream>
 #include <iostream>
 
 using namespace rtrv_search_engine;
 
+using namespace rtrv_search_engine::bench;
+
+// Shared synthetic corpus (Zipfian terms, sentence punctuation)
+static const CorpusGenerator& corpus() {
+    static const CorpusGenerator generator = benchCorpus(benchCorpusSize(1000));
+    return generator;
+}
+
 // Helper function to generate test text of varying sizes
 std::string generateTestText(size_t word_count) {
-    std::vector<std::string> words = {
-        "The", "quick", "brown", "fox", "jumps", "over", "the", "lazy", "dog",
-        "Computer", "science", "is", "the", "study", "of", "computation", "and", "information",
-        "Algorithm", "design", "requires", "careful", "analysis", "of", "complexity",
-        "Data", "structures", "organize", "and", "store", "information", "efficiently",
-        "Machine", "learning", "enables", "computers", "to", "learn", "from", "experience",
-        "Natural", "language", "processing", "helps", "computers", "understand", "human", "text",
-        "Artificial", "intelligence", "systems", "perform", "tasks", "requiring", "human", "cognition",
-        "Software", "engineering", "practices", "improve", "code", "quality", "and", "maintainability",
-        "Database", "management", "systems", "efficiently", "store", "and", "retrieve", "data",
-        "Network", "protocols", "enable", "communication", "between", "distributed", "systems"
-    };
-    
-    std::mt19937 rng(42); // Fixed seed for reproducibility
-    std::uniform_int_distribution<size_t> dist(0, words.size() - 1);
-    
-    std::ostringstream oss;
-    for (size_t i = 0; i < word_count; ++i) {
-        oss << words[dist(rng)];
-        if (i < word_count - 1) {
-            oss << " ";
-        }
-    }
-    
-    return oss.str();
+    return corpus().text(word_count);
 }
 
 // Helper to load real Wikipedia data if available
@@ -54,8 +39,15 @@ std::string loadWikipediaText() {
         }
     }
     
-    // Return generated text if file not found
-    return generateTestText(1000);
+    // Fall back to generated multi-field documents if file not found
+    std::string text;
+    for (size_t i = 0; i < 200; ++i) {
+        for (const auto& [field, value] : corpus().document(i).fields) {
+            text += value;
+            text += '\n';
+        }
+    }
+    return text;
 }
 
 // Benchmark: SIMD-enabled tokenization (short text)
@@ -64,10 +56,14 @@ static void BM_Tokenize_SIMD_Short(benchmark::State& state) {
     tokenizer.enableSIMD(true);
     std::string text = generateTestText(50); // ~50 words
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenize(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -81,10 +77,14 @@ static void BM_Tokenize_Scalar_Short(benchmark::State& state) {
     tokenizer.enableSIMD(false);
     std::string text = generateTestText(50); // ~50 words
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenize(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -98,10 +98,14 @@ static void BM_Tokenize_SIMD_Medium(benchmark::State& state) {
     tokenizer.enableSIMD(true);
     std::string text = generateTestText(500); // ~500 words
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenize(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -115,10 +119,14 @@ static void BM_Tokenize_Scalar_Medium(benchmark::State& state) {
     tokenizer.enableSIMD(false);
     std::string text = generateTestText(500); // ~500 words
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenize(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -132,10 +140,14 @@ static void BM_Tokenize_SIMD_Long(benchmark::State& state) {
     tokenizer.enableSIMD(true);
     std::string text = generateTestText(5000); // ~5000 words
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenize(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -149,10 +161,14 @@ static void BM_Tokenize_Scalar_Long(benchmark::State& state) {
     tokenizer.enableSIMD(false);
     std::string text = generateTestText(5000); // ~5000 words
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenize(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -167,10 +183,14 @@ static void BM_TokenizeWithPositions_SIMD(benchmark::State& state) {
     size_t text_size = state.range(0);
     std::string text = generateTestText(text_size);
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenizeWithPositions(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -185,10 +205,14 @@ static void BM_TokenizeWithPositions_Scalar(benchmark::State& state) {
     size_t text_size = state.range(0);
     std::string text = generateTestText(text_size);
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenizeWithPositions(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -214,12 +238,16 @@ static void BM_BatchTokenize_SIMD(benchmark::State& state) {
         total_bytes += text.size();
     }
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         for (const auto& text : texts) {
             auto tokens = tokenizer.tokenize(text);
             benchmark::DoNotOptimize(tokens);
         }
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations() * batch_size);
     state.SetBytesProcessed(state.iterations() * total_bytes);
@@ -245,12 +273,16 @@ static void BM_BatchTokenize_Scalar(benchmark::State& state) {
         total_bytes += text.size();
     }
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         for (const auto& text : texts) {
             auto tokens = tokenizer.tokenize(text);
             benchmark::DoNotOptimize(tokens);
         }
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations() * batch_size);
     state.SetBytesProcessed(state.iterations() * total_bytes);
@@ -266,10 +298,14 @@ static void BM_Lowercase_SIMD(benchmark::State& state) {
     
     std::string text = generateTestText(state.range(0));
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenize(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -285,10 +321,14 @@ static void BM_Lowercase_Scalar(benchmark::State& state) {
     
     std::string text = generateTestText(state.range(0));
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenize(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -302,10 +342,14 @@ static void BM_RealData_SIMD(benchmark::State& state) {
     tokenizer.enableSIMD(true);
     std::string text = loadWikipediaText();
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenize(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
@@ -319,10 +363,14 @@ static void BM_RealData_Scalar(benchmark::State& state) {
     tokenizer.enableSIMD(false);
     std::string text = loadWikipediaText();
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto tokens = tokenizer.tokenize(text);
         benchmark::DoNotOptimize(tokens);
     }
+    perf.stop();
+    perf.report(state);
     
     state.SetItemsProcessed(state.iterations());
     state.SetBytesProcessed(state.iterations() * text.size());
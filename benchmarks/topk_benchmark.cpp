@@ -1,35 +1,51 @@
 #include <benchmark/benchmark.h>
 #include "search_engine.hpp"
 #include "top_k_heap.hpp"
+#include "corpus_generator.hpp"
+#include "perf_counters.hpp"
 #include <random>
 #include <algorithm>
-#include <fstream>
 
 using namespace rtrv_search_engine;
 
-// Helper to generate random documents
-std::vector<std::pair<std::string, std::string>> generateRandomDocuments(size_t count) {
-    std::vector<std::pair<std::string, std::string>> docs;
-    std::vector<std::string> words = {
-        "machine", "learning", "algorithm", "data", "science",
-        "computer", "programming", "software", "engineering", "artificial",
-        "intelligence", "neural", "network", "deep", "model"
-    };
-    
-    std::mt19937 gen(42);
-    std::uniform_int_distribution<> word_dist(0, words.size() - 1);
-    std::uniform_int_distribution<> count_dist(50, 200);
-    
-    for (size_t i = 0; i < count; ++i) {
-        std::string content;
-        int num_words = count_dist(gen);
-        for (int j = 0; j < num_words; ++j) {
-            content += words[word_dist(gen)] + " ";
+using namespace rtrv_search_engine::bench;
+
+// Shared synthetic corpus (Zipfian terms, log-normal lengths, multiple fields)
+static const CorpusGenerator& corpus() {
+    static const CorpusGenerator generator = benchCorpus(benchCorpusSize(10000));
+    return generator;
+}
+
+// Index the first num_docs documents of the corpus
+void indexCorpus(SearchEngine& engine, size_t num_docs) {
+    const auto& generator = corpus();
+    for (size_t i = 0; i < num_docs; ++i) {
+        engine.indexDocument(generator.document(i));
+    }
+}
+
+// First plain (no typo, no phrase) query in the log with the given term
+// count and popularity class
+std::string sampleQuery(size_t num_terms, QueryClass query_class) {
+    static const std::vector<GeneratedQuery> pool = [] {
+        QueryLogConfig pool_config;
+        pool_config.num_queries = 20000;
+        pool_config.distinct_queries = 5000;
+        return corpus().queryLog(pool_config);
+    }();
+    for (const auto& query : pool) {
+        if (query.num_terms == num_terms && query.query_class == query_class &&
+            !query.has_typo && !query.is_phrase) {
+            return query.text;
         }
-        docs.emplace_back("Doc " + std::to_string(i), content);
     }
-    
-    return docs;
+    // Fall back to the most frequent terms
+    std::string text;
+    for (size_t i = 0; i < num_terms; ++i) {
+        if (i > 0) text += " ";
+        text += corpus().vocabulary()[i];
+    }
+    return text;
 }
 
 // Benchmark: Top-K heap vs traditional full sort
@@ -57,6 +73,8 @@ static void BM_TopK_Heap_vs_Sort(benchmark::State& state) {
         results.push_back(result);
     }
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         if (use_heap) {
             // Use Top-K heap
@@ -79,6 +97,8 @@ static void BM_TopK_Heap_vs_Sort(benchmark::State& state) {
             benchmark::DoNotOptimize(sorted);
         }
     }
+    perf.stop();
+    perf.report(state, static_cast<double>(total_docs));
     
     state.SetItemsProcessed(state.iterations() * total_docs);
     state.SetLabel(use_heap ? "Heap" : "Sort");
@@ -98,26 +118,25 @@ static void BM_TopK_VaryingK(benchmark::State& state) {
     size_t k = state.range(0);
     size_t total_docs = 10000;  // Reduced from 100K
     
-    auto docs = generateRandomDocuments(total_docs);
     SearchEngine engine;
-    
-    // Index documents
-    for (size_t i = 0; i < docs.size(); ++i) {
-        Document doc;
-        doc.id = i;
-        doc.fields["title"] = docs[i].first;
-        doc.fields["content"] = docs[i].second;
-        engine.indexDocument(doc);
-    }
+    indexCorpus(engine, total_docs);
     
     SearchOptions options;
     options.max_results = k;
     options.use_top_k_heap = true;
+    options.use_cache = false;  // The same query every iteration
+    
+    // Popular two-term query: many candidates compete for the top K
+    const std::string query = sampleQuery(2, QueryClass::HEAD);
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
-        auto results = engine.search("machine learning", options);
+        auto results = engine.search(query, options);
         benchmark::DoNotOptimize(results);
     }
+    perf.stop();
+    perf.report(state, averagePostingsPerQuery(engine, {query}));
     
     state.SetItemsProcessed(state.iterations());
     state.counters["K"] = static_cast<double>(k);
@@ -152,6 +171,8 @@ static void BM_TopK_EarlyTermination(benchmark::State& state) {
         results.push_back(result);
     }
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         BoundedPriorityQueue<SearchResult> heap(k);
         size_t early_exits = 0;
@@ -168,6 +189,8 @@ static void BM_TopK_EarlyTermination(benchmark::State& state) {
         benchmark::DoNotOptimize(top_k);
         benchmark::DoNotOptimize(early_exits);
     }
+    perf.stop();
+    perf.report(state, static_cast<double>(total_candidates));
     
     state.SetItemsProcessed(state.iterations() * total_candidates);
 }
@@ -184,26 +207,25 @@ static void BM_TopK_RankerComparison(benchmark::State& state) {
     size_t num_docs = 5000;  // Reduced for speed
     bool use_bm25 = state.range(0) != 0;
     
-    auto docs = generateRandomDocuments(num_docs);
     SearchEngine engine;
-    
-    for (size_t i = 0; i < docs.size(); ++i) {
-        Document doc;
-        doc.id = i;
-        doc.fields["title"] = docs[i].first;
-        doc.fields["content"] = docs[i].second;
-        engine.indexDocument(doc);
-    }
+    indexCorpus(engine, num_docs);
     
     SearchOptions options;
     options.max_results = 10;
     options.use_top_k_heap = true;
+    options.use_cache = false;
     options.algorithm = use_bm25 ? SearchOptions::BM25 : SearchOptions::TF_IDF;
     
+    const std::string query = sampleQuery(3, QueryClass::TORSO);
+    
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
-        auto results = engine.search("machine learning algorithm", options);
+        auto results = engine.search(query, options);
         benchmark::DoNotOptimize(results);
     }
+    perf.stop();
+    perf.report(state, averagePostingsPerQuery(engine, {query}));
     
     state.SetItemsProcessed(state.iterations());
     state.SetLabel(use_bm25 ? "BM25" : "TF-IDF");
@@ -220,36 +242,25 @@ static void BM_TopK_QueryComplexity(benchmark::State& state) {
     size_t num_terms = state.range(0);
     size_t num_docs = 5000;  // Reduced for speed
     
-    auto docs = generateRandomDocuments(num_docs);
     SearchEngine engine;
+    indexCorpus(engine, num_docs);
     
-    for (size_t i = 0; i < docs.size(); ++i) {
-        Document doc;
-        doc.id = i;
-        doc.fields["content"] = docs[i].second;
-        engine.indexDocument(doc);
-    }
-    
-    // Build query with variable number of terms
-    std::vector<std::string> terms = {
-        "machine", "learning", "algorithm", "data", "science",
-        "artificial", "intelligence", "neural", "network", "deep"
-    };
-    
-    std::string query;
-    for (size_t i = 0; i < num_terms && i < terms.size(); ++i) {
-        if (i > 0) query += " ";
-        query += terms[i];
-    }
+    // Query with variable number of terms
+    const std::string query = sampleQuery(num_terms, QueryClass::TORSO);
     
     SearchOptions options;
     options.max_results = 10;
     options.use_top_k_heap = true;
+    options.use_cache = false;
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         auto results = engine.search(query, options);
         benchmark::DoNotOptimize(results);
     }
+    perf.stop();
+    perf.report(state, averagePostingsPerQuery(engine, {query}));
     
     state.SetItemsProcessed(state.iterations());
     state.counters["query_terms"] = static_cast<double>(num_terms);
@@ -270,12 +281,16 @@ static void BM_TopK_MemoryEfficiency(benchmark::State& state) {
     std::mt19937 gen(42);
     std::uniform_real_distribution<> score_dist(0.0, 100.0);
     
+    PerfCounters perf;
+    perf.start();
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         
         // Generate results on the fly
         BoundedPriorityQueue<SearchResult> heap(k);
         
+        perf.resume();
         state.ResumeTiming();
         
         for (size_t i = 0; i < total_candidates; ++i) {
@@ -291,6 +306,8 @@ static void BM_TopK_MemoryEfficiency(benchmark::State& state) {
         auto top_k = heap.getSorted();
         benchmark::DoNotOptimize(top_k);
     }
+    perf.stop();
+    perf.report(state, static_cast<double>(total_candidates));
     
     state.SetItemsProcessed(state.iterations() * total_candidates);
     state.SetLabel("K=" + std::to_string(k));
@@ -0,0 +1,298 @@
+#include <benchmark/benchmark.h>
+#include "vector_index.hpp"
+#include "search_engine.hpp"
+#include "corpus_generator.hpp"
+#include "perf_counters.hpp"
+#include <memory>
+#include <random>
+#include <unordered_set>
+
+using namespace rtrv_search_engine;
+
+using namespace rtrv_search_engine::bench;
+
+namespace {
+
+constexpr size_t kDimension = 128;
+constexpr size_t kClusters = 64;
+constexpr size_t kQueries = 200;
+constexpr size_t kTopK = 10;
+
+// Clustered Gaussian vectors: real embeddings are far from uniform, and
+// clusters are what make graph search (and recall) non-trivial
+std::vector<std::vector<float>> syntheticVectors(size_t count, uint32_t seed) {
+    std::mt19937 gen(42);
+    std::normal_distribution<float> centroid_dist(0.0f, 1.0f);
+    std::vector<std::vector<float>> centroids(kClusters, std::vector<float>(kDimension));
+    for (auto& centroid : centroids) {
+        for (auto& x : centroid) x = centroid_dist(gen);
+    }
+
+    gen.seed(seed);
+    std::uniform_int_distribution<size_t> cluster_dist(0, kClusters - 1);
+    std::normal_distribution<float> noise(0.0f, 0.35f);
+    std::vector<std::vector<float>> vectors(count);
+    for (auto& vector : vectors) {
+        vector = centroids[cluster_dist(gen)];
+        for (auto& x : vector) x += noise(gen);
+    }
+    return vectors;
+}
+
+// Vector count (override with RTRV_BENCH_VECTORS)
+size_t vectorCount() {
+    return envSize("RTRV_BENCH_VECTORS", 20000);
+}
+
+const std::vector<std::vector<float>>& corpusVectors() {
+    static const auto vectors = syntheticVectors(vectorCount(), 1);
+    return vectors;
+}
+
+const std::vector<std::vector<float>>& queryVectors() {
+    static const auto vectors = syntheticVectors(kQueries, 2);
+    return vectors;
+}
+
+const HnswIndex& sharedIndex() {
+    static const HnswIndex index = [] {
+        HnswIndex built(kDimension, VectorMetric::COSINE);
+        const auto& vectors = corpusVectors();
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            built.add(i, vectors[i]);
+        }
+        return built;
+    }();
+    return index;
+}
+
+// Exact top-k per query, computed once
+const std::vector<std::unordered_set<uint64_t>>& groundTruth() {
+    static const auto truth = [] {
+        std::vector<std::unordered_set<uint64_t>> sets;
+        for (const auto& query : queryVectors()) {
+            std::unordered_set<uint64_t> ids;
+            for (const auto& hit : sharedIndex().exactSearch(query, kTopK)) ids.insert(hit.doc_id);
+            sets.push_back(std::move(ids));
+        }
+        return sets;
+    }();
+    return truth;
+}
+
+double recallAtK(size_t ef) {
+    size_t found = 0;
+    const auto& truth = groundTruth();
+    for (size_t q = 0; q < kQueries; ++q) {
+        for (const auto& hit : sharedIndex().search(queryVectors()[q], kTopK, ef)) {
+            found += truth[q].count(hit.doc_id);
+        }
+    }
+    return static_cast<double>(found) / (kQueries * kTopK);
+}
+
+}  // anonymous namespace
+
+// Benchmark: raw distance kernels (dimension = arg)
+static void BM_DistanceKernel(benchmark::State& state) {
+    const size_t dimension = state.range(0);
+    const bool l2 = state.range(1) != 0;
+    std::vector<float> a(dimension, 0.5f);
+    std::vector<float> b(dimension, 0.25f);
+
+    for (auto _ : state) {
+        float distance = l2 ? vector_kernels::squaredL2(a.data(), b.data(), dimension)
+                            : vector_kernels::dotProduct(a.data(), b.data(), dimension);
+        benchmark::DoNotOptimize(distance);
+    }
+    state.SetItemsProcessed(state.iterations() * dimension);
+    state.SetLabel(std::string(l2 ? "l2/" : "dot/") + vector_kernels::simdLevel());
+}
+
+BENCHMARK(BM_DistanceKernel)
+    ->Args({128, 0})->Args({128, 1})
+    ->Args({768, 0})->Args({768, 1});
+
+// Benchmark: HNSW construction throughput
+static void BM_HnswBuild(benchmark::State& state) {
+    const auto& vectors = corpusVectors();
+    for (auto _ : state) {
+        HnswIndex index(kDimension, VectorMetric::COSINE);
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            index.add(i, vectors[i]);
+        }
+        benchmark::DoNotOptimize(index.size());
+    }
+    state.SetItemsProcessed(state.iterations() * vectors.size());
+    state.counters["vectors"] = benchmark::Counter(static_cast<double>(vectors.size()));
+}
+
+BENCHMARK(BM_HnswBuild)->Unit(benchmark::kMillisecond)->Iterations(1);
+
+// Benchmark: approximate search latency vs recall@10 (ef = arg)
+static void BM_HnswSearch(benchmark::State& state) {
+    const size_t ef = state.range(0);
+    const auto& index = sharedIndex();
+    const auto& queries = queryVectors();
+    const double recall = recallAtK(ef);
+
+    PerfCounters perf;
+    perf.start();
+    size_t q = 0;
+    for (auto _ : state) {
+        auto hits = index.search(queries[q++ % kQueries], kTopK, ef);
+        benchmark::DoNotOptimize(hits);
+    }
+    perf.stop();
+    perf.report(state);
+
+    state.counters["recall_at_10"] = benchmark::Counter(recall);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_HnswSearch)
+    ->Arg(16)->Arg(32)->Arg(64)->Arg(128)->Arg(256)
+    ->Unit(benchmark::kMicrosecond);
+
+// Benchmark: exact linear scan (the baseline HNSW has to beat)
+static void BM_ExactSearch(benchmark::State& state) {
+    const auto& index = sharedIndex();
+    const auto& queries = queryVectors();
+
+    size_t q = 0;
+    for (auto _ : state) {
+        auto hits = index.exactSearch(queries[q++ % kQueries], kTopK);
+        benchmark::DoNotOptimize(hits);
+    }
+    state.counters["recall_at_10"] = benchmark::Counter(1.0);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ExactSearch)->Unit(benchmark::kMicrosecond);
+
+// Benchmark: filtered search (1 in `arg` documents accepted)
+static void BM_HnswFilteredSearch(benchmark::State& state) {
+    const uint64_t modulus = state.range(0);
+    const auto& index = sharedIndex();
+    const auto& queries = queryVectors();
+    const std::function<bool(uint64_t)> filter = [modulus](uint64_t id) { return id % modulus == 0; };
+
+    size_t q = 0;
+    for (auto _ : state) {
+        auto hits = index.search(queries[q++ % kQueries], kTopK, 64, filter);
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel("selectivity=1/" + std::to_string(modulus));
+}
+
+BENCHMARK(BM_HnswFilteredSearch)
+    ->Arg(2)->Arg(10)->Arg(100)
+    ->Unit(benchmark::kMicrosecond);
+
+// Quantized indexes over the shared corpus: 0 = INT8, 1 = PQ (32 bytes);
+// arg 1 selects re-scoring from an mmapped full-precision file
+const HnswIndex& quantizedIndex(int type, bool rescore) {
+    static std::unique_ptr<HnswIndex> indexes[2][2];
+    auto& index = indexes[type][rescore];
+    if (!index) {
+        HnswParams params;
+        params.quantization = type == 0 ? VectorQuantization::INT8 : VectorQuantization::PQ;
+        params.pq_subspaces = kDimension / 4;
+        if (rescore) {
+            params.vector_file = "/tmp/rtrv_vector_benchmark_" + std::to_string(type) + ".f32";
+        }
+        index = std::make_unique<HnswIndex>(kDimension, VectorMetric::COSINE, params);
+        const auto& vectors = corpusVectors();
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            index->add(i, vectors[i]);
+        }
+        index->quantize();
+    }
+    return *index;
+}
+
+// Benchmark: quantized search latency, recall@10 and bytes per vector
+static void BM_QuantizedSearch(benchmark::State& state) {
+    const int type = static_cast<int>(state.range(0));
+    const bool rescore = state.range(1) != 0;
+    const auto& index = quantizedIndex(type, rescore);
+    const auto& queries = queryVectors();
+    const auto& truth = groundTruth();
+
+    size_t found = 0;
+    for (size_t q = 0; q < kQueries; ++q) {
+        for (const auto& hit : index.search(queries[q], kTopK, 64)) found += truth[q].count(hit.doc_id);
+    }
+
+    size_t q = 0;
+    for (auto _ : state) {
+        auto hits = index.search(queries[q++ % kQueries], kTopK, 64);
+        benchmark::DoNotOptimize(hits);
+    }
+    const size_t code_bytes = type == 0 ? kDimension : kDimension / 4;
+    state.counters["recall_at_10"] = benchmark::Counter(static_cast<double>(found) / (kQueries * kTopK));
+    state.counters["bytes_per_vector"] = benchmark::Counter(static_cast<double>(code_bytes));
+    state.counters["compression"] = benchmark::Counter(kDimension * sizeof(float) / static_cast<double>(code_bytes));
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(std::string(type == 0 ? "int8" : "pq") + (rescore ? "+rescore" : ""));
+}
+
+BENCHMARK(BM_QuantizedSearch)
+    ->Args({0, 0})->Args({0, 1})->Args({1, 0})->Args({1, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+// Engine over the benchmark text corpus, one synthetic vector per document
+SearchEngine& hybridEngine() {
+    static SearchEngine* engine = [] {
+        auto* built = new SearchEngine();
+        const auto& vectors = corpusVectors();
+        auto corpus = benchCorpus(vectors.size());
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            Document doc = corpus.document(i);
+            doc.vector = vectors[i];
+            built->indexDocument(doc);
+        }
+        built->enableVectorSearch(kDimension, VectorMetric::COSINE);
+        return built;
+    }();
+    return *engine;
+}
+
+// Benchmark: lexical only (0), kNN only (1), hybrid RRF (2); the two
+// sides of the hybrid run concurrently, so it should track the slower one
+static void BM_HybridSearch(benchmark::State& state) {
+    const int mode = static_cast<int>(state.range(0));
+    auto& engine = hybridEngine();
+    const auto& queries = queryVectors();
+    const auto corpus = benchCorpus(1);
+    const auto& vocabulary = corpus.vocabulary();
+
+    SearchOptions options;
+    options.max_results = kTopK;
+    options.use_cache = false;
+    options.ranker_name = mode == 2 ? "Hybrid-RRF" : "BM25";
+
+    size_t q = 0;
+    for (auto _ : state) {
+        const size_t i = q++ % kQueries;
+        if (mode == 1) {
+            auto hits = engine.knnSearch(queries[i], kTopK);
+            benchmark::DoNotOptimize(hits);
+            continue;
+        }
+        if (mode == 2) {
+            options.query_vector = queries[i];
+        }
+        auto hits = engine.search(vocabulary[500 + i % 200] + " " + vocabulary[2000 + i % 500], options);
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(mode == 0 ? "bm25" : mode == 1 ? "knn" : "hybrid_rrf");
+}
+
+BENCHMARK(BM_HybridSearch)
+    ->Arg(0)->Arg(1)->Arg(2)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -7,6 +7,7 @@
 #include "inverted_index.hpp"
 #include <iostream>
 #include <chrono>
+#include <cmath>
 #include <iomanip>
 
 using namespace rtrv_search_engine;
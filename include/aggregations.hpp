@@ -0,0 +1,101 @@
+#pragma once
+
+#include "doc_values.hpp"
+#include "hyperloglog.hpp"
+#include "search_types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * Aggregations collected during the scoring pass (SearchOptions::aggregations).
+ *
+ * Hits are passed by doc ordinal and read straight from the doc-values
+ * columns: terms on a keyword field count value ordinals in an array,
+ * numeric terms and histograms count bucket keys in a hash map, stats
+ * keep running values, and cardinality feeds value hashes to a
+ * HyperLogLog sketch. A collector owns its partial state (one per
+ * searching thread, so nothing is shared); merge() combines collectors
+ * over disjoint hits and results() finalizes them.
+ */
+class AggregationCollector {
+public:
+    AggregationCollector(const DocValues& doc_values, const std::vector<AggregationRequest>& requests);
+
+    void collect(uint32_t doc) {
+        for (auto& aggregation : aggregations_) {
+            collect(aggregation, doc);
+        }
+    }
+
+    void merge(const AggregationCollector& other);
+
+    /**
+     * One result per request, in request order
+     */
+    std::vector<AggregationResult> results() const;
+
+    /**
+     * Parse "[name=]type:field[:param]": "terms:brand[:size]",
+     * "histogram:price:interval", "date_histogram:published:unit" (minute,
+     * hour, day, week, month, quarter or year), "stats:price" and
+     * "cardinality:author[:precision]". False if the spec is malformed.
+     */
+    static bool parse(const std::string& spec, AggregationRequest& request);
+
+private:
+    struct Aggregation {
+        AggregationRequest request;
+        const KeywordColumn* keyword = nullptr;       // TERMS / CARDINALITY on a keyword field
+        const NumericColumn* numeric = nullptr;       // Everything else
+        std::vector<size_t> value_counts;             // Keyword value ordinal -> hits
+        std::unordered_map<int64_t, size_t> counts;   // Numeric key or bucket -> hits
+        size_t missing = 0;
+        AggregationStats stats;                       // avg is filled in by results()
+
+        // CARDINALITY: keyword value ordinals seen (a bit each, hashed once
+        // in results()) while the dictionary is small, else value hashes
+        // go straight into the sketch
+        std::vector<uint64_t> seen_values;
+        HyperLogLog sketch;
+
+        // DATE_HISTOGRAM: the last bucket seen, [start, end), so that runs
+        // of nearby dates skip the calendar arithmetic
+        int64_t bucket_start = 0;
+        int64_t bucket_end = 0;
+    };
+
+    // Largest dictionary tracked by ordinal bits: 1M values, 128 KB
+    static constexpr size_t kMaxOrdinalBits = size_t{1} << 20;
+
+    void collect(Aggregation& aggregation, uint32_t doc);
+    static int64_t dateBucket(int64_t millis, AggregationRequest::DateInterval interval, int64_t& end);
+
+    std::vector<Aggregation> aggregations_;
+};
+
+/**
+ * What the scoring pass feeds every hit to: facet counts and aggregations
+ * (either may be null). The doc ordinal is looked up once for both.
+ */
+struct HitCollector {
+    const DocValues& doc_values;
+    FacetCounter* facets = nullptr;
+    AggregationCollector* aggregations = nullptr;
+
+    void collect(uint64_t doc_id) {
+        const uint32_t doc = doc_values.ordinal(doc_id);
+        if (facets) {
+            facets->collectOrdinal(doc);
+        }
+        if (aggregations) {
+            aggregations->collect(doc);
+        }
+    }
+};
+
+}  // namespace rtrv_search_engine
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * Fixed-size bitset over doc ordinals
+ */
+class BitSet {
+public:
+    BitSet() = default;
+    explicit BitSet(size_t size) : size_(size), words_((size + 63) / 64, 0) {}
+
+    void set(uint32_t i) { words_[i >> 6] |= uint64_t{1} << (i & 63); }
+    bool get(uint32_t i) const { return i < size_ && (words_[i >> 6] >> (i & 63)) & 1; }
+    size_t size() const { return size_; }
+    size_t count() const;
+    size_t memoryUsage() const { return words_.size() * sizeof(uint64_t); }
+
+    /**
+     * First set bit >= `from` (BitSet::npos if none)
+     */
+    uint32_t nextSetBit(uint32_t from) const;
+
+    const std::vector<uint64_t>& words() const { return words_; }
+    std::vector<uint64_t>& words() { return words_; }
+
+    static constexpr uint32_t npos = UINT32_MAX;
+
+private:
+    size_t size_ = 0;
+    std::vector<uint64_t> words_;
+};
+
+/**
+ * Forward-only iterator over increasing doc ordinals (Lucene's
+ * DocIdSetIterator). A fresh iterator is positioned before its first
+ * document (docID() is meaningless until the first nextDoc()/advance());
+ * both return NO_MORE_DOCS when exhausted.
+ */
+class DocIdSetIterator {
+public:
+    static constexpr uint32_t NO_MORE_DOCS = UINT32_MAX;
+
+    virtual ~DocIdSetIterator() = default;
+
+    virtual uint32_t docID() const = 0;
+    virtual uint32_t nextDoc() = 0;
+
+    /**
+     * First document >= `target` (target must be > docID())
+     */
+    virtual uint32_t advance(uint32_t target) = 0;
+
+    /**
+     * Upper bound on the documents left (drives conjunction order)
+     */
+    virtual size_t cost() const = 0;
+
+    /**
+     * Drain the iterator into a bitset of `size` ordinals
+     */
+    BitSet toBitSet(size_t size);
+};
+
+/**
+ * Sorted, unique ordinals
+ */
+class SortedDocIdIterator : public DocIdSetIterator {
+public:
+    explicit SortedDocIdIterator(std::vector<uint32_t> docs) : docs_(std::move(docs)) {}
+
+    uint32_t docID() const override { return doc_; }
+    uint32_t nextDoc() override;
+    uint32_t advance(uint32_t target) override;  // Galloping search
+    size_t cost() const override { return docs_.size(); }
+
+private:
+    std::vector<uint32_t> docs_;
+    size_t index_ = 0;  // Next unread position
+    uint32_t doc_ = 0;
+};
+
+/**
+ * Set bits of a (possibly shared) bitset
+ */
+class BitSetIterator : public DocIdSetIterator {
+public:
+    BitSetIterator(std::shared_ptr<const BitSet> bits, size_t cost);
+
+    uint32_t docID() const override { return doc_; }
+    uint32_t nextDoc() override { return advance(started_ ? doc_ + 1 : 0); }
+    uint32_t advance(uint32_t target) override;
+    size_t cost() const override { return cost_; }
+
+private:
+    std::shared_ptr<const BitSet> bits_;
+    size_t cost_;
+    uint32_t doc_ = 0;
+    bool started_ = false;
+};
+
+/**
+ * Every ordinal below `max_doc`
+ */
+class AllDocsIterator : public DocIdSetIterator {
+public:
+    explicit AllDocsIterator(uint32_t max_doc) : max_doc_(max_doc) {}
+
+    uint32_t docID() const override { return doc_; }
+    uint32_t nextDoc() override { return advance(started_ ? doc_ + 1 : 0); }
+    uint32_t advance(uint32_t target) override;
+    size_t cost() const override { return max_doc_; }
+
+private:
+    uint32_t max_doc_;
+    uint32_t doc_ = 0;
+    bool started_ = false;
+};
+
+/**
+ * AND: leapfrogs the children, cheapest first
+ */
+class ConjunctionIterator : public DocIdSetIterator {
+public:
+    explicit ConjunctionIterator(std::vector<std::unique_ptr<DocIdSetIterator>> children);
+
+    uint32_t docID() const override { return lead_->docID(); }
+    uint32_t nextDoc() override { return align(lead_->nextDoc()); }
+    uint32_t advance(uint32_t target) override { return align(lead_->advance(target)); }
+    size_t cost() const override { return lead_->cost(); }
+
+private:
+    uint32_t align(uint32_t target);
+
+    std::vector<std::unique_ptr<DocIdSetIterator>> children_;
+    DocIdSetIterator* lead_;
+};
+
+/**
+ * OR: min-heap of the children by current document
+ */
+class DisjunctionIterator : public DocIdSetIterator {
+public:
+    explicit DisjunctionIterator(std::vector<std::unique_ptr<DocIdSetIterator>> children);
+
+    uint32_t docID() const override { return doc_; }
+    uint32_t nextDoc() override;
+    uint32_t advance(uint32_t target) override;
+    size_t cost() const override { return cost_; }
+
+private:
+    uint32_t top() const;
+
+    std::vector<std::unique_ptr<DocIdSetIterator>> children_;  // Heap ordered by docID()
+    size_t cost_ = 0;
+    uint32_t doc_ = 0;
+    bool started_ = false;
+};
+
+/**
+ * AND NOT: documents of `include` that `exclude` does not have
+ */
+class ExclusionIterator : public DocIdSetIterator {
+public:
+    ExclusionIterator(std::unique_ptr<DocIdSetIterator> include, std::unique_ptr<DocIdSetIterator> exclude)
+        : include_(std::move(include)), exclude_(std::move(exclude)) {}
+
+    uint32_t docID() const override { return include_->docID(); }
+    uint32_t nextDoc() override { return skipExcluded(include_->nextDoc()); }
+    uint32_t advance(uint32_t target) override { return skipExcluded(include_->advance(target)); }
+    size_t cost() const override { return include_->cost(); }
+
+private:
+    uint32_t skipExcluded(uint32_t doc);
+
+    std::unique_ptr<DocIdSetIterator> include_;
+    std::unique_ptr<DocIdSetIterator> exclude_;
+};
+
+}  // namespace rtrv_search_engine
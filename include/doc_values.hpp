@@ -0,0 +1,418 @@
+#pragma once
+
+#include "document.hpp"
+#include "search_types.hpp"
+#include "doc_id_iterator.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * Field schema: every field is full-text searchable; typed fields also get
+ * a doc-values column
+ */
+enum class FieldType {
+    TEXT,     // Tokenized only (default for undeclared fields)
+    KEYWORD,  // Whole value as one exact string: facets
+    INT64,    // Signed integer: range filters
+    DOUBLE,   // Floating point: range filters
+    DATE      // ISO-8601 date/time or epoch millis, stored as epoch millis (UTC)
+};
+
+inline bool isNumericType(FieldType type) {
+    return type == FieldType::INT64 || type == FieldType::DOUBLE || type == FieldType::DATE;
+}
+
+/**
+ * One keyword field: value ordinals in a dense array indexed by doc
+ * ordinal, plus the dictionary of distinct values (in first-seen order)
+ */
+struct KeywordColumn {
+    static constexpr uint32_t kMissing = UINT32_MAX;
+
+    std::vector<uint32_t> ords;                           // Doc ordinal -> value ordinal
+    std::vector<std::string> values;                      // Value ordinal -> value
+    std::unordered_map<std::string, uint32_t> value_ids;  // Value -> value ordinal
+
+    uint32_t valueOrdinal(uint32_t doc) const { return doc < ords.size() ? ords[doc] : kMissing; }
+};
+
+/**
+ * One numeric field (INT64, DOUBLE or DATE): every value is stored as an
+ * order-preserving int64 key (doubles are bit-mapped so that integer order
+ * is numeric order), so range checks never look at the original text.
+ */
+struct NumericColumn {
+    FieldType type = FieldType::INT64;
+    std::vector<int64_t> keys;     // Doc ordinal -> sortable key
+    std::vector<uint8_t> present;  // Doc ordinal -> has a value
+
+    // Range index: (key, doc ordinal) sorted by key, rebuilt on the first
+    // range query after a write. Stale entries (deleted or updated docs)
+    // are skipped by checking `keys`/`present`.
+    mutable std::vector<std::pair<int64_t, uint32_t>> sorted;
+    mutable bool dirty = false;
+
+    bool has(uint32_t doc) const { return doc < present.size() && present[doc]; }
+};
+
+/**
+ * Columnar per-document field values ("doc values").
+ *
+ * Documents get a dense ordinal on first sight, and each column is an
+ * array indexed by it, so scanning a field over many hits touches a few
+ * contiguous arrays instead of one hash map per document. Doc id ->
+ * ordinal is itself a direct array for ids below kDirectIds (the engine
+ * assigns ids sequentially) with a hash map beyond. Deleted documents keep
+ * their ordinal, with every value cleared, and get it back on re-index.
+ *
+ * Not internally synchronized: SearchEngine guards it with its mutex.
+ */
+class DocValues {
+public:
+    static constexpr uint32_t kNoOrdinal = UINT32_MAX;
+    static constexpr uint64_t kDirectIds = 1u << 24;
+    static constexpr uint32_t kSegmentBits = 16;  // Ordinals per segment: 64K
+
+    /**
+     * Declare `field`; TEXT drops its column. Returns true if the type
+     * changed (existing documents must then be re-added).
+     */
+    bool defineField(const std::string& field, FieldType type);
+    FieldType fieldType(const std::string& field) const;
+    bool empty() const { return keyword_columns_.empty() && numeric_columns_.empty(); }
+
+    /**
+     * Store the declared fields of `doc` under `doc_id` (replaces its values)
+     */
+    void addDocument(uint64_t doc_id, const Document& doc);
+    void removeDocument(uint64_t doc_id);
+
+    uint32_t ordinal(uint64_t doc_id) const {
+        if (doc_id < direct_.size()) {
+            return direct_[doc_id];
+        }
+        auto it = sparse_.find(doc_id);
+        return it != sparse_.end() ? it->second : kNoOrdinal;
+    }
+    uint64_t docId(uint32_t ordinal) const { return doc_ids_[ordinal]; }
+    size_t ordinals() const { return doc_ids_.size(); }
+
+    const KeywordColumn* keywordColumn(const std::string& field) const;
+    const NumericColumn* numericColumn(const std::string& field) const;
+
+    /**
+     * Sortable key of `text` for a field of `type`; false if it does not
+     * parse. Used once per value at index time and once per bound at query
+     * time.
+     */
+    static bool parseValue(FieldType type, const std::string& text, int64_t& key);
+    /**
+     * Inclusive key bounds of a range on a field of `type`. An empty bound
+     * is open; an exclusive bound is one key further (keys are dense in
+     * value order). False if the range matches nothing: a non-numeric
+     * type, a bound that does not parse, or an empty interval. Shared by
+     * search filters, subscriptions and stored queries.
+     */
+    static bool rangeKeys(FieldType type, const std::string& lower_text, bool include_lower,
+                          const std::string& upper_text, bool include_upper, int64_t& lower, int64_t& upper);
+    static double keyToDouble(int64_t key);
+    static int64_t doubleToKey(double value);
+
+    /**
+     * Text of a key: the number, or for DATE "YYYY-MM-DD" at midnight UTC
+     * and "YYYY-MM-DDTHH:MM:SS[.fff]Z" otherwise. parseValue() reads it back.
+     */
+    static std::string formatValue(FieldType type, int64_t key);
+
+    /**
+     * Days since 1970-01-01 of a proleptic Gregorian date, and back
+     */
+    static int64_t daysFromCivil(int64_t year, unsigned month, unsigned day);
+    static void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day);
+
+    /**
+     * Doc ordinals whose `field` key lies in [lower, upper] (empty iterator
+     * for a non-numeric field). Binary search over the range index, then a
+     * sorted ordinal list or, for dense ranges, a bitset.
+     */
+    std::unique_ptr<DocIdSetIterator> rangeIterator(const std::string& field, int64_t lower, int64_t upper) const;
+
+    /**
+     * Doc ordinals whose keyword `field` equals `value`, both compared as
+     * normalizeKeyword() text (empty iterator for a non-keyword field). One
+     * pass over the dictionary, then one over the column.
+     */
+    std::unique_ptr<DocIdSetIterator> keywordIterator(const std::string& field, const std::string& value) const;
+
+    /**
+     * Lower-cased word runs joined by single spaces: "Home & Garden" ->
+     * "home garden", which is how the query parser hands the value over
+     */
+    static std::string normalizeKeyword(const std::string& text);
+
+    /**
+     * Index sort: renumber ordinals so that ordinal order is `sort` order
+     * (keyword or numeric field; false otherwise). Documents added or
+     * updated later are tracked as out of order until enough accumulate
+     * to re-sort. An empty field turns index sorting off.
+     */
+    bool setIndexSort(const SortField& sort);
+    const SortField* indexSort() const { return index_sort_.field.empty() ? nullptr : &index_sort_; }
+    bool inIndexOrder(uint32_t ordinal) const { return ordinal < order_state_.size() && order_state_[ordinal] == kInOrder; }
+    const std::vector<uint32_t>& unsortedOrdinals() const { return unsorted_; }
+
+    /**
+     * Bumped whenever ordinals are renumbered (anything caching ordinals
+     * must be rebuilt)
+     */
+    uint64_t ordinalGeneration() const { return ordinal_generation_; }
+
+    /**
+     * Ordinals are grouped into segments of 2^kSegmentBits. Each segment
+     * records the write epoch of its last added, updated or removed
+     * document, so a set cached over ordinals can tell which of its
+     * segments a later write made stale (within one ordinal generation).
+     */
+    size_t segments() const { return (doc_ids_.size() + (size_t{1} << kSegmentBits) - 1) >> kSegmentBits; }
+    uint64_t segmentEpoch(size_t segment) const {
+        return segment < segment_epochs_.size() ? segment_epochs_[segment] : 0;
+    }
+
+    size_t memoryUsage() const;
+
+    /**
+     * Drop all values and ordinals (the schema is kept)
+     */
+    void clear();
+
+private:
+    // Index-order states (order_state_, only kept while an index sort is set)
+    static constexpr uint8_t kInOrder = 1;    // At its sorted position
+    static constexpr uint8_t kUnsorted = 0;   // Listed in unsorted_
+    static constexpr uint8_t kRemoved = 2;    // Deleted; in neither
+    static constexpr size_t kMinResort = 1024;  // Re-sort once unsorted_ exceeds this and 1/8 of the ordinals
+
+    uint32_t assignOrdinal(uint64_t doc_id);
+    void markUnsorted(uint32_t ordinal);
+    void applyIndexSort();
+    void touchSegment(uint32_t ordinal);
+
+    std::unordered_map<std::string, KeywordColumn> keyword_columns_;
+    std::unordered_map<std::string, NumericColumn> numeric_columns_;
+    mutable std::mutex range_index_mutex_;  // Lazy range-index rebuilds under a shared engine lock
+    std::vector<uint32_t> direct_;                  // Doc id -> ordinal (ids < kDirectIds)
+    std::unordered_map<uint64_t, uint32_t> sparse_;  // Doc id -> ordinal (larger ids)
+    std::vector<uint64_t> doc_ids_;                 // Ordinal -> doc id
+
+    SortField index_sort_;               // Empty field = no index sort
+    std::vector<uint8_t> order_state_;   // Ordinal -> kInOrder / kUnsorted / kRemoved
+    std::vector<uint32_t> unsorted_;     // Ordinals added or updated since the last sort
+    uint64_t ordinal_generation_ = 0;
+
+    std::vector<uint64_t> segment_epochs_;  // Segment -> epoch of its last write
+    uint64_t write_epoch_ = 0;
+};
+
+/**
+ * A hit as seen by sorting: doc id, its doc-values ordinal and its score
+ */
+struct FieldHit {
+    uint64_t doc_id;
+    uint32_t ordinal;
+    double score;
+};
+
+/**
+ * Orders hits by SearchOptions::sort keys, then score (descending), then
+ * doc id. Reads the doc-values columns directly: no per-document lookups.
+ */
+class FieldComparator {
+public:
+    FieldComparator(const DocValues& doc_values, const std::vector<SortField>& sort);
+
+    /**
+     * True if `a` sorts before `b`
+     */
+    bool operator()(const FieldHit& a, const FieldHit& b) const {
+        for (const auto& key : keys_) {
+            const int order = compare(key, a, b);
+            if (order != 0) return order < 0;
+        }
+        if (a.score != b.score) return a.score > b.score;
+        return a.doc_id < b.doc_id;
+    }
+
+    /**
+     * <0, 0, >0 as `a` sorts before, with or after `b` on the first key only
+     */
+    int comparePrimary(const FieldHit& a, const FieldHit& b) const {
+        return keys_.empty() ? 0 : compare(keys_.front(), a, b);
+    }
+
+private:
+    struct Key {
+        const NumericColumn* numeric = nullptr;
+        const KeywordColumn* keyword = nullptr;
+        bool by_score = false;
+        bool descending = false;
+    };
+
+    static int compare(const Key& key, const FieldHit& a, const FieldHit& b);
+
+    std::vector<Key> keys_;
+};
+
+/**
+ * Top-k hits by a FieldComparator: a bounded heap whose root is the worst
+ * hit kept, so a hit that cannot make the page costs one comparison
+ */
+class TopFieldCollector {
+public:
+    TopFieldCollector(FieldComparator comparator, size_t k) : comparator_(std::move(comparator)), k_(k) {}
+
+    void collect(const FieldHit& hit) {
+        if (k_ == 0) {
+            return;
+        }
+        if (heap_.size() < k_) {
+            heap_.push_back(hit);
+            std::push_heap(heap_.begin(), heap_.end(), comparator_);
+        } else if (comparator_(hit, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), comparator_);
+            heap_.back() = hit;
+            std::push_heap(heap_.begin(), heap_.end(), comparator_);
+        }
+    }
+
+    bool full() const { return k_ > 0 && heap_.size() == k_; }
+    const FieldHit& worst() const { return heap_.front(); }
+    const FieldComparator& comparator() const { return comparator_; }
+
+    /**
+     * Collected hits in sort order (empties the collector)
+     */
+    std::vector<FieldHit> sorted() {
+        std::sort_heap(heap_.begin(), heap_.end(), comparator_);
+        return std::move(heap_);
+    }
+
+private:
+    FieldComparator comparator_;
+    size_t k_;
+    std::vector<FieldHit> heap_;  // Max-heap by comparator: worst hit on top
+};
+
+/**
+ * Field collapsing: the top `k` groups of hits sharing a value of a
+ * keyword or numeric field, ranked by each group's best hit, with up to
+ * `per_group` best hits of each. Hits without a value are groups of their own.
+ *
+ * The kept groups form a heap (worst best hit at the root) indexed by a
+ * hash map from group key to slot, so a hit costs one column read and one
+ * lookup, plus a sift when it improves its group or displaces the worst.
+ * A group that lost hits while out of the heap has incomplete inner hits;
+ * beginRecollect() lists the kept ones and a second pass over just their
+ * hits (recollects() / recollect()) refills them.
+ */
+class TopGroupsCollector {
+public:
+    struct Group {
+        FieldHit head;               // Best hit
+        std::vector<FieldHit> hits;  // Best `per_group` hits, head first
+    };
+
+    TopGroupsCollector(FieldComparator comparator, const DocValues& doc_values, const std::string& field, size_t k,
+                       size_t per_group);
+
+    void collect(const FieldHit& hit);
+
+    /**
+     * Clear the hits of kept groups that missed some; false if there are none
+     */
+    bool beginRecollect();
+    bool recollects(uint32_t ordinal) const;
+    void recollect(const FieldHit& hit);
+
+    /**
+     * Kept groups in order of their best hit (empties the collector)
+     */
+    std::vector<Group> sorted();
+
+private:
+    struct Slot {
+        Group group;
+        int64_t key = 0;
+        bool keyed = false;     // False: a hit without a value, alone in its group
+        bool partial = false;   // Hits were dropped while the group was out of the heap
+        size_t heap_index = 0;
+    };
+
+    bool groupKey(uint32_t ordinal, int64_t& key) const;
+    void addHit(Group& group, const FieldHit& hit);
+    bool worse(size_t a, size_t b) const;  // Heap positions: group at `a` ranks below `b`
+    void swapHeap(size_t a, size_t b);
+    void siftUp(size_t pos);
+    void siftDown(size_t pos);
+
+    FieldComparator comparator_;
+    const KeywordColumn* keyword_;
+    const NumericColumn* numeric_;
+    size_t k_;
+    size_t per_group_;
+    std::vector<Slot> slots_;
+    std::vector<size_t> heap_;                        // Slot indexes, worst group at the root
+    std::unordered_map<int64_t, size_t> kept_;         // Group key -> slot
+    std::unordered_set<int64_t> dropped_;              // Keys with hits dropped (per_group > 1 only)
+};
+
+/**
+ * Facet counts collected during the scoring pass: one count per value
+ * ordinal, in arrays owned by this counter (one per searching thread, so
+ * nothing is shared); merge() combines counters over disjoint hits.
+ */
+class FacetCounter {
+public:
+    FacetCounter(const DocValues& doc_values, const std::vector<std::string>& fields);
+
+    void collect(uint64_t doc_id) { collectOrdinal(doc_values_.ordinal(doc_id)); }
+
+    void collectOrdinal(uint32_t doc) {
+        for (auto& facet : facets_) {
+            const uint32_t value = facet.column ? facet.column->valueOrdinal(doc) : KeywordColumn::kMissing;
+            if (value == KeywordColumn::kMissing) {
+                ++facet.missing;
+            } else {
+                ++facet.counts[value];
+            }
+        }
+    }
+
+    void merge(const FacetCounter& other);
+
+    /**
+     * Top `size` values per field
+     */
+    std::vector<FacetResult> results(size_t size) const;
+
+private:
+    struct Facet {
+        std::string field;
+        const KeywordColumn* column;
+        std::vector<uint32_t> counts;  // Value ordinal -> hits
+        size_t missing = 0;
+    };
+
+    const DocValues& doc_values_;
+    std::vector<Facet> facets_;
+};
+
+}  // namespace rtrv_search_engine
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace rtrv_search_engine {
 
@@ -13,12 +14,16 @@ struct Document {
     uint32_t id;                                             // Unique document ID (supports 4B docs)
     std::unordered_map<std::string, std::string> fields;     // Field-based storage
     size_t term_count;                                       // Cached for BM25
+    std::vector<float> vector;                               // Optional dense embedding (see enableVectorSearch)
     
     Document() = default;
     Document(uint32_t id, const std::unordered_map<std::string, std::string>& fields);
 
     std::string getField(const std::string& field_name) const;
     std::string getAllText() const;
+
+    // Heap bytes owned by this document (field map nodes and string storage)
+    size_t memoryUsage() const;
 };
 
 } 
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "doc_id_iterator.hpp"
+#include "doc_values.hpp"
+#include "profiling.hpp"
+#include "search_types.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * Immutable set of doc ordinals split into the DocValues segments
+ * (roaring-style): a segment with at most kMaxArray documents is a sorted
+ * array of 16-bit offsets, any other a 64K-bit bitmap. Membership is one
+ * bit test, or at most eight binary-search steps in a very sparse segment.
+ * The threshold favors probe speed over size: roaring's 4096 would save
+ * memory, but a binary search over thousands of offsets mispredicts on
+ * every step and costs tens of times a bit test.
+ *
+ * Each segment remembers the DocValues write epoch it was built at.
+ * Segments are shared between versions of a set, so rebuilding after a
+ * write only re-evaluates the segments the write touched.
+ */
+class SegmentedDocIdSet {
+public:
+    static constexpr uint32_t kSegmentBits = DocValues::kSegmentBits;
+    static constexpr size_t kMaxArray = 256;  // Larger segments get the 8 KB bitmap
+
+    /**
+     * Drain `docs` (ordinals of the current `doc_values`) into a set,
+     * taking every segment that is still current from `previous` instead
+     * of reading it from `docs`
+     */
+    static std::shared_ptr<const SegmentedDocIdSet> build(DocIdSetIterator& docs, const DocValues& doc_values,
+                                                          const SegmentedDocIdSet* previous = nullptr);
+
+    /**
+     * Iterator over the set (which it keeps alive)
+     */
+    static std::unique_ptr<DocIdSetIterator> iterator(std::shared_ptr<const SegmentedDocIdSet> set);
+
+    bool contains(uint32_t ordinal) const {
+        const size_t segment = ordinal >> kSegmentBits;
+        if (segment >= segments_.size() || !segments_[segment].docs) {
+            return false;
+        }
+        const Segment& docs = *segments_[segment].docs;
+        const uint16_t offset = static_cast<uint16_t>(ordinal);
+        if (!docs.bitmap.empty()) {
+            return (docs.bitmap[offset >> 6] >> (offset & 63)) & 1;
+        }
+        return std::binary_search(docs.array.begin(), docs.array.end(), offset);
+    }
+
+    /**
+     * First member >= `target` (DocIdSetIterator::NO_MORE_DOCS if none)
+     */
+    uint32_t nextDoc(uint32_t target) const;
+
+    size_t cardinality() const { return cardinality_; }
+
+    /**
+     * True if no write since the build touched any segment
+     */
+    bool current(const DocValues& doc_values) const;
+
+    /**
+     * Segments taken from `previous` by build()
+     */
+    size_t reusedSegments() const { return reused_; }
+
+    size_t memoryUsage() const;
+
+private:
+    struct Segment {
+        std::vector<uint16_t> array;   // Sorted offsets (sparse segments)
+        std::vector<uint64_t> bitmap;  // 1024 words (dense segments)
+        uint32_t cardinality = 0;
+    };
+
+    struct Slot {
+        std::shared_ptr<const Segment> docs;  // Null = no member
+        uint64_t epoch = 0;                   // DocValues::segmentEpoch() at build
+    };
+
+    bool reusable(size_t segment, const DocValues& doc_values) const;
+
+    std::vector<Slot> segments_;
+    uint64_t generation_ = 0;  // DocValues::ordinalGeneration() at build
+    size_t cardinality_ = 0;
+    size_t reused_ = 0;
+};
+
+/**
+ * Filter cache: non-scoring clauses evaluated once into SegmentedDocIdSets
+ * and reused by every query that repeats them.
+ *
+ * Admission is by usage frequency: a clause is only cached once it has
+ * been looked up `min_frequency` times within the last kHistorySize
+ * lookups, so one-off filters never push out the few that dominate
+ * traffic. Entries are evicted least recently used beyond a byte budget.
+ * A write does not drop entries: on its next use an entry rebuilds only
+ * the segments the write touched.
+ */
+class FilterCache {
+public:
+    static constexpr size_t kHistorySize = 256;
+
+    /**
+     * Evaluates one clause over the current doc values; null when the
+     * clause is not a filter
+     */
+    using Compute = std::function<std::unique_ptr<DocIdSetIterator>()>;
+
+    explicit FilterCache(size_t max_bytes = 32 * 1024 * 1024, size_t min_frequency = 2);
+
+    /**
+     * Set of the clause `key`: the cached one while it is current, else
+     * `compute()` drained (reusing the cached set's current segments).
+     * Null if `compute` returns null.
+     */
+    std::shared_ptr<const SegmentedDocIdSet> getOrCompute(const std::string& key, const DocValues& doc_values,
+                                                          const Compute& compute);
+
+    void clear();
+    void configure(size_t max_bytes, size_t min_frequency);
+
+    FilterCacheStatistics getStats() const;
+
+    // Cached sets, keys and LRU bookkeeping
+    size_t memoryUsage() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const SegmentedDocIdSet> set;
+        size_t bytes;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    // Record a lookup of `key`; true once it is frequent enough to cache
+    bool recordUse(const std::string& key);
+    void evictIfNeeded();
+    size_t entryBytes(const std::string& key, const SegmentedDocIdSet& set) const;
+
+    mutable ProfiledSharedMutex<LockSite::FILTER_CACHE> mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_order_;
+    size_t bytes_ = 0;
+    size_t max_bytes_;
+    size_t min_frequency_;
+
+    std::vector<size_t> history_;                     // Ring of recent key hashes
+    size_t history_next_ = 0;
+    std::unordered_map<size_t, uint32_t> frequency_;  // Key hash -> uses within the ring
+
+    std::atomic<size_t> hit_count_{0};
+    std::atomic<size_t> miss_count_{0};
+    std::atomic<size_t> refresh_count_{0};
+    std::atomic<size_t> segments_reused_{0};
+    std::atomic<size_t> eviction_count_{0};
+};
+
+}  // namespace rtrv_search_engine
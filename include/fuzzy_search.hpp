@@ -102,6 +102,11 @@ public:
      */
     size_t vocabularySize() const { return vocabulary_.size(); }
 
+    /**
+     * Approximate bytes held by the n-gram index and vocabulary.
+     */
+    size_t memoryUsage() const;
+
     /**
      * Clear the n-gram index.
      */
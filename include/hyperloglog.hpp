@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * HyperLogLog++ distinct-count sketch over 64-bit hashes.
+ *
+ * Starts sparse: one 32-bit entry per distinct 25-bit register index
+ * (index << 6 | rank), kept sorted, with new entries buffered and merged
+ * in batches. Small counts are estimated by linear counting over 2^25
+ * registers, which is near-exact. Once the entries would outgrow the dense
+ * form, the sketch becomes 2^precision one-byte registers.
+ *
+ * Dense estimates use Ertl's improved estimator ("New cardinality
+ * estimation algorithms for HyperLogLog sketches", 2017) in place of
+ * HLL++'s empirical bias tables: it needs no tables and is unbiased from
+ * small to very large counts. Standard error is about 1.04 / sqrt(2^precision):
+ * 0.8% at the default precision of 14, in 16 KB.
+ *
+ * Sketches merge (the union of the hashed sets) across partitions, and
+ * across shards through serialize() / deserialize(). Merging sketches of
+ * different precision keeps the lower one.
+ */
+class HyperLogLog {
+public:
+    static constexpr uint8_t kMinPrecision = 4;
+    static constexpr uint8_t kMaxPrecision = 18;
+    static constexpr uint8_t kSparsePrecision = 25;
+
+    explicit HyperLogLog(uint8_t precision = 14);
+
+    void add(uint64_t hash);
+    void merge(const HyperLogLog& other);
+
+    /**
+     * Estimated number of distinct hashes added
+     */
+    uint64_t estimate() const;
+
+    uint8_t precision() const { return precision_; }
+    bool sparse() const { return registers_.empty(); }
+    size_t memoryUsage() const;
+
+    /**
+     * Compact byte form (version, precision, then sparse entries or dense
+     * registers); deserialize() returns false on malformed input
+     */
+    std::vector<uint8_t> serialize() const;
+    static bool deserialize(const std::vector<uint8_t>& bytes, HyperLogLog& sketch);
+
+    /**
+     * Stable 64-bit hashes (same value on every shard and platform)
+     */
+    static uint64_t hashString(const std::string& text);
+    static uint64_t hashInteger(uint64_t value);
+
+private:
+    void flushBuffer();
+    void toDense();
+    void addEntry(uint32_t entry);  // Dense: apply one sparse entry
+    void reduce(uint8_t precision);
+    std::vector<uint32_t> sparseEntries() const;  // Sorted, one per index, with the buffer merged in
+
+    uint8_t precision_;
+    std::vector<uint32_t> sparse_;   // Sorted entries, one per 25-bit index (max rank)
+    std::vector<uint32_t> buffer_;   // Unsorted recent entries, up to a quarter of the dense size
+    std::vector<uint8_t> registers_;  // Dense: 2^precision ranks (empty while sparse)
+};
+
+}  // namespace rtrv_search_engine
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * Runtime counters of skip-pointer intersections (intersectWithSkips),
+ * process-wide. A skip is taken when a skip pointer moves the cursor past
+ * more than the next posting.
+ */
+struct SkipStatistics {
+    uint64_t intersections = 0;     // intersectWithSkips() calls
+    uint64_t skips_taken = 0;       // Cursor jumps via skip pointers
+    uint64_t postings_skipped = 0;  // Postings jumped over by those skips
+    uint64_t postings_scanned = 0;  // Postings visited one at a time
+
+    /**
+     * Fraction of postings that intersections did not have to visit
+     */
+    double skippedFraction() const {
+        const uint64_t total = postings_skipped + postings_scanned;
+        return total > 0 ? static_cast<double>(postings_skipped) / total : 0.0;
+    }
+};
+
+/**
+ * Posting lists whose length falls in [min_length, max_length]
+ * (power-of-two classes: 1, 2-3, 4-7, ...).
+ */
+struct PostingLengthClass {
+    size_t min_length = 0;
+    size_t max_length = 0;
+    size_t lists = 0;
+    size_t postings = 0;
+    size_t positions = 0;
+    size_t raw_bytes = 0;      // Doc id + term frequency + position payload as stored
+    size_t encoded_bytes = 0;  // Estimated size with delta + varint encoding
+
+    /**
+     * raw_bytes / encoded_bytes (how much a compressed encoding would save)
+     */
+    double compressionRatio() const {
+        return encoded_bytes > 0 ? static_cast<double>(raw_bytes) / encoded_bytes : 0.0;
+    }
+};
+
+struct TermPostingCount {
+    std::string term;
+    size_t postings = 0;
+};
+
+/**
+ * Index shape report: posting-length histogram, longest lists, compression
+ * potential per length class and skip effectiveness. Maintained
+ * incrementally by InvertedIndex as terms are added and documents removed,
+ * so producing it does not scan the postings.
+ */
+struct IndexAnalysis {
+    size_t terms = 0;
+    size_t postings = 0;
+    size_t positions = 0;
+    size_t raw_bytes = 0;
+    size_t encoded_bytes = 0;
+    std::vector<PostingLengthClass> length_classes;  // Non-empty classes, shortest first
+    std::vector<TermPostingCount> longest_lists;     // Longest first
+    SkipStatistics skips;
+
+    /**
+     * Share of the raw posting payload taken by positions
+     */
+    double positionShare() const {
+        const size_t position_bytes = positions * sizeof(uint32_t);
+        return raw_bytes > 0 ? static_cast<double>(position_bytes) / raw_bytes : 0.0;
+    }
+
+    double compressionRatio() const {
+        return encoded_bytes > 0 ? static_cast<double>(raw_bytes) / encoded_bytes : 0.0;
+    }
+};
+
+}  // namespace rtrv_search_engine
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "index_analysis.hpp"
+#include "memory_usage.hpp"
+#include "profiling.hpp"
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <mutex>
 #include <shared_mutex>
 #include <unordered_set>
 
@@ -70,8 +75,19 @@ public:
      */
     bool needsSkipRebuild() const { return skips_dirty_; }
     
+    /**
+     * Total positions and estimated delta + varint encoded size of this list.
+     * Kept up to date by InvertedIndex for analyze().
+     */
+    size_t positionCount() const { return position_count_; }
+    size_t encodedBytes() const { return encoded_bytes_; }
+    
 private:
+    friend class InvertedIndex;
+    
     mutable bool skips_dirty_ = true;  // Skip pointers need rebuilding (mutable for lazy rebuild)
+    size_t position_count_ = 0;
+    size_t encoded_bytes_ = 0;
 };
 
 /**
@@ -85,6 +101,12 @@ std::vector<uint64_t> intersectWithSkips(
     const PostingList& list2
 );
 
+/**
+ * Process-wide skip counters accumulated by intersectWithSkips()
+ */
+SkipStatistics skipStatistics();
+void resetSkipStatistics();
+
 /**
  * Inverted index mapping terms to documents
  */
@@ -103,6 +125,17 @@ public:
      */
     std::vector<Posting> getPostings(const std::string& term) const;
     
+    /**
+     * Call `visit` for each posting of a term in place, without copying the
+     * list (the index stays read-locked: `visit` must not call back into it)
+     */
+    void forEachPosting(const std::string& term, const std::function<void(const Posting&)>& visit) const;
+    
+    /**
+     * Positions of a term within one document (empty if it does not occur)
+     */
+    std::vector<uint32_t> getPositions(const std::string& term, uint64_t doc_id) const;
+
     /**
      * Get posting list with skip pointers for a term
      */
@@ -150,11 +183,41 @@ public:
      */
     bool hasTerm(const std::string& term) const;
     
+    /**
+     * Add this index's memory footprint to a breakdown: term dictionary,
+     * posting doc ids / term frequencies / positions, skip data and slack.
+     */
+    void accumulateMemoryUsage(MemoryUsage& usage) const;
+    
+    /**
+     * Posting-length histogram, `top_n` longest lists, compression estimate
+     * per length class, position share and skip counters. Reads totals that
+     * addTerm()/removeDocument() maintain; does not scan postings.
+     */
+    IndexAnalysis analyze(size_t top_n = 10) const;
+    
 private:
     friend class Persistence;
     
+    using IndexEntry = std::pair<const std::string, PostingList>;
+    
+    // Running totals of one posting-length class (see IndexAnalysis)
+    struct LengthClassTotals {
+        size_t lists = 0;
+        size_t postings = 0;
+        size_t positions = 0;
+        size_t encoded_bytes = 0;
+        std::unordered_set<const IndexEntry*> entries;  // Nodes of index_ in this class
+    };
+    
+    // Move a list's contribution between length classes after it changed
+    // from `before` (postings, positions, encoded bytes) to its current state
+    void updateAnalysis(const IndexEntry& entry, size_t before_postings,
+                        size_t before_positions, size_t before_encoded);
+    
     std::unordered_map<std::string, PostingList> index_;
-    mutable std::shared_mutex mutex_;  // Thread safety
+    std::vector<LengthClassTotals> length_classes_;  // Indexed by floor(log2(length))
+    mutable ProfiledSharedMutex<LockSite::INVERTED_INDEX> mutex_;  // Thread safety
 };
 
 } 
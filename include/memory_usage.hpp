@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * Per-structure memory breakdown (bytes).
+ *
+ * Each component reports its own share via accumulateMemoryUsage(), so the
+ * numbers are attributable to a structure instead of being an RSS delta.
+ * Container sizes are estimated from the standard library layout
+ * (node-based hash tables, SSO strings); allocator_slack_bytes is memory that
+ * is reserved but unused (vector/string capacity beyond size, struct padding).
+ */
+struct MemoryUsage {
+    size_t term_dictionary_bytes = 0;    // Term -> posting list hash table (keys, nodes, buckets)
+    size_t posting_doc_id_bytes = 0;     // Posting::doc_id
+    size_t posting_tf_bytes = 0;         // Posting::term_frequency
+    size_t posting_position_bytes = 0;   // Posting::positions (headers + payload)
+    size_t skip_data_bytes = 0;          // Skip pointers
+    size_t document_store_bytes = 0;     // Stored documents and their field maps
+    size_t fuzzy_index_bytes = 0;        // Fuzzy n-gram index + vocabulary
+    size_t query_cache_bytes = 0;        // Cached result lists + LRU bookkeeping
+    size_t filter_cache_bytes = 0;       // Cached filter sets + admission history
+    size_t vector_index_bytes = 0;       // HNSW vectors, links and id map
+    size_t doc_values_bytes = 0;         // Columnar field values, dictionaries and doc ordinals
+    size_t percolator_bytes = 0;         // Stored queries, their term dictionary and pre-filter postings
+    size_t allocator_slack_bytes = 0;    // Reserved-but-unused capacity and padding
+
+    size_t totalBytes() const {
+        return term_dictionary_bytes + posting_doc_id_bytes + posting_tf_bytes +
+               posting_position_bytes + skip_data_bytes + document_store_bytes +
+               fuzzy_index_bytes + query_cache_bytes + filter_cache_bytes + vector_index_bytes +
+               doc_values_bytes + percolator_bytes + allocator_slack_bytes;
+    }
+};
+
+namespace memory_accounting {
+
+// Pointer-sized overhead per node of a node-based container (next pointer)
+constexpr size_t kNodeLinkBytes = sizeof(void*);
+
+/**
+ * Heap bytes owned by a string (0 when the contents fit the SSO buffer).
+ */
+inline size_t stringHeapBytes(const std::string& str) {
+    static const size_t sso_capacity = std::string().capacity();
+    return str.capacity() > sso_capacity ? str.capacity() + 1 : 0;
+}
+
+/**
+ * Heap bytes of a string that are allocated but unused.
+ */
+inline size_t stringSlackBytes(const std::string& str) {
+    return stringHeapBytes(str) > 0 ? str.capacity() - str.size() : 0;
+}
+
+template <typename T>
+size_t vectorUsedBytes(const std::vector<T>& vec) {
+    return vec.size() * sizeof(T);
+}
+
+template <typename T>
+size_t vectorSlackBytes(const std::vector<T>& vec) {
+    return (vec.capacity() - vec.size()) * sizeof(T);
+}
+
+/**
+ * Bucket array plus per-node overhead of an unordered container, excluding
+ * the heap memory owned by the stored values themselves.
+ */
+template <typename HashContainer>
+size_t hashTableBytes(const HashContainer& table) {
+    const size_t node_bytes = sizeof(typename HashContainer::value_type) +
+                              kNodeLinkBytes + sizeof(size_t);  // value + next + cached hash
+    // A single bucket is stored inline and does not allocate
+    const size_t bucket_bytes = table.bucket_count() > 1 ? table.bucket_count() * sizeof(void*) : 0;
+    return bucket_bytes + table.size() * node_bytes;
+}
+
+}  // namespace memory_accounting
+
+}  // namespace rtrv_search_engine
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "doc_values.hpp"
+#include "document.hpp"
+#include "tokenizer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+class QueryNode;
+
+/**
+ * Counters of one percolate() call
+ */
+struct PercolateStats {
+    size_t candidates = 0;  // Stored queries verified against the document
+    size_t matches = 0;
+};
+
+/**
+ * Reverse search: stored queries ("alerts") matched against one incoming
+ * document at a time.
+ *
+ * Queries use the query syntax with boolean semantics: AND (also
+ * implicit), OR, NOT, phrases ("a b", "a b"~N in order within N extra
+ * positions), field:term on text fields, field:value on keyword and
+ * numeric fields, and ranges. They are compiled once, analyzed with the
+ * engine's tokenizer against the field schema, into a flat node array
+ * over a shared term dictionary. Dictionary terms are reference counted:
+ * removing the last query that names a term frees it.
+ *
+ * Each query is indexed under terms at least one of which any matching
+ * document must contain: its own term, the rarest word of a phrase, the
+ * cheapest child of an AND, the union of an OR's children. Keyword and
+ * numeric field values are indexed as field-qualified terms. Queries with
+ * no such set (a NOT or a range on its own) are checked for every document.
+ * percolate() tokenizes the document once into a term -> positions map
+ * (a single-document in-memory index), collects the queries indexed under
+ * its terms and verifies only those.
+ *
+ * Not internally synchronized: SearchEngine guards it with its mutex.
+ */
+class Percolator {
+public:
+    /**
+     * How queries and documents are read: the tokenizer and field schema
+     * used for indexing, and optionally document frequencies in the index
+     * (rarer terms make better pre-filter terms)
+     */
+    struct Context {
+        Tokenizer& tokenizer;
+        const DocValues& schema;
+        std::function<size_t(const std::string&)> document_frequency;
+    };
+
+    /**
+     * Store (or replace) query `id`; false if it has no clause
+     */
+    bool addQuery(uint64_t id, const std::string& query, const Context& context);
+    bool removeQuery(uint64_t id);
+
+    /**
+     * Recompile every query (after the field schema changed)
+     */
+    void rebuild(const Context& context);
+
+    /**
+     * Ids of the stored queries matching `doc`, ascending
+     */
+    std::vector<uint64_t> percolate(const Document& doc, const Context& context,
+                                    PercolateStats* stats = nullptr) const;
+
+    /**
+     * Every stored query verified, without the pre-filter: the reference
+     * percolate() agrees with
+     */
+    std::vector<uint64_t> percolateExhaustive(const Document& doc, const Context& context) const;
+
+    size_t size() const { return slots_.size(); }
+    size_t memoryUsage() const;
+    void clear();
+
+private:
+    struct Node {
+        enum Kind : uint8_t {
+            ALL,      // Matches everything (e.g. only stop words)
+            NONE,     // Matches nothing (e.g. a malformed range)
+            TERM,     // arg: term id (also field-qualified keyword / numeric values)
+            PHRASE,   // terms[arg, arg + count), within `slop` extra positions
+            FIELD,    // PHRASE in field values[field] only
+            RANGE,    // values[field] key in keys[arg], keys[arg + 1]
+            AND,      // `count` children
+            OR,
+            NOT       // One child
+        };
+        Kind kind = ALL;
+        uint8_t type = 0;      // RANGE: FieldType
+        uint32_t span = 1;     // Nodes in this subtree (children follow in pre-order)
+        uint32_t count = 0;
+        uint32_t arg = 0;
+        uint32_t field = 0;
+        int32_t slop = 0;
+    };
+
+    struct StoredQuery {
+        uint64_t id = 0;
+        std::string text;
+        std::vector<Node> nodes;          // Pre-order; nodes[0] is the root
+        std::vector<uint32_t> terms;      // PHRASE / FIELD term ids
+        std::vector<int64_t> keys;        // RANGE bounds
+        std::vector<std::string> values;  // FIELD / RANGE field names
+        std::vector<uint32_t> indexed;    // Pre-filter terms
+        bool always_checked = false;      // No pre-filter terms: verified for every document
+    };
+
+    // One document's terms: term id -> positions (keyword / numeric values
+    // have none); fields are tokenized only when a FIELD node asks
+    struct MemoryIndex {
+        std::unordered_map<uint32_t, std::vector<uint32_t>> positions;
+    };
+    struct DocumentView;
+
+    bool compile(StoredQuery& query, const Context& context);
+    void compileNode(const QueryNode& node, StoredQuery& query, const Context& context);
+    void analyzeWords(const std::vector<std::string>& words, StoredQuery& query, size_t node, const Context& context);
+    // Id of `term`, with one more reference; releaseTerms() drops the
+    // references a query took, freeing terms no query names any more
+    uint32_t termId(const std::string& term);
+    void releaseTerms(const StoredQuery& query);
+    static std::string fieldTerm(const std::string& field, const std::string& value);
+
+    // Pre-filter: terms one of which every match contains, and their cost
+    // (expected matching documents); false if there are none
+    bool requiredTerms(const StoredQuery& query, size_t node, const Context& context, std::vector<uint32_t>& terms,
+                       double& cost) const;
+    double termCost(uint32_t term, const Context& context) const;
+
+    void index(uint32_t slot);
+    void unindex(uint32_t slot);
+
+    bool matches(const StoredQuery& query, size_t node, DocumentView& doc) const;
+    static bool phraseMatches(const std::vector<const std::vector<uint32_t>*>& positions, int32_t slop);
+    std::vector<uint64_t> verify(const std::vector<uint32_t>& slots, DocumentView& doc,
+                                 PercolateStats* stats) const;
+
+    std::vector<StoredQuery> slots_;                  // Dense: removal moves the last query into the hole
+    std::unordered_map<uint64_t, uint32_t> slot_of_;  // Query id -> slot
+    std::unordered_map<std::string, uint32_t> term_ids_;
+    std::vector<std::string> term_text_;              // Term id -> term
+    std::vector<std::vector<uint32_t>> postings_;     // Term id -> slots indexed under it
+    std::vector<uint32_t> term_refs_;                 // Term id -> references from stored queries (0 = free)
+    std::vector<uint32_t> free_terms_;                // Freed ids below term_text_.size(), reused first
+    std::vector<uint32_t> unindexed_;                 // Slots checked for every document
+};
+
+}  // namespace rtrv_search_engine
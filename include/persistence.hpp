@@ -11,7 +11,7 @@ class SearchEngine;
  */
 struct SnapshotHeader {
     uint32_t magic = 0x53454152;  // "SEAR"
-    uint32_t version = 1;
+    uint32_t version = 3;  // 2 adds document vectors and the HNSW graph, 3 quantization
     uint64_t num_documents;
     uint64_t num_terms;
 };
@@ -19,8 +19,11 @@ struct SnapshotHeader {
 // [Header]                    // SnapshotHeader (magic, version, num_documents, num_terms)
 // [next_doc_id]              // uint64_t for ID generation
 // [Document1]...[DocumentN]  // Each document: doc_id, content_len, content, term_count, metadata
+//                            // (v2: then vector_len and float32 vector)
 // [num_index_terms]          // Size of index
 // [Term1][PostingList1]...   // Each term: term_len, term, postings_count, then postings
+// [has_vector_index]         // v2: uint8_t; if 1, dimension, metric, HnswParams, then the graph
+//                            // (v3: quantization params; graph may hold codes + full-precision rows)
 
 
 /**
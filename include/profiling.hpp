@@ -0,0 +1,142 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+
+namespace rtrv_search_engine {
+
+/**
+ * Locks instrumented by the contention profiler
+ */
+enum class LockSite {
+    SEARCH_ENGINE = 0,  // SearchEngine::mutex_
+    INVERTED_INDEX,     // InvertedIndex::mutex_
+    QUERY_CACHE,        // QueryCache::mutex_
+    FILTER_CACHE,       // FilterCache::mutex_
+};
+
+constexpr size_t NUM_LOCK_SITES = 4;
+
+/**
+ * Acquisition counts and time spent waiting for one lock
+ */
+struct LockSiteStats {
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;  // Acquisitions that had to block
+    uint64_t wait_ns = 0;    // Time blocked in those acquisitions
+};
+
+/**
+ * Per-thread profiling counters. Only updated in builds configured with
+ * -DRTRV_PROFILING=ON; otherwise they stay zero.
+ */
+struct ThreadProfile {
+    LockSiteStats locks[NUM_LOCK_SITES];
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+
+    ThreadProfile& operator+=(const ThreadProfile& other);
+};
+
+namespace profiling {
+
+/**
+ * True when the library was built with the RTRV_PROFILING option
+ */
+constexpr bool enabled() {
+#ifdef RTRV_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Counters of the calling thread
+ */
+ThreadProfile& threadProfile();
+
+/**
+ * Zero the calling thread's counters
+ */
+void resetThreadProfile();
+
+/**
+ * Short name of a lock site ("search_engine", "inverted_index", "query_cache",
+ * "filter_cache")
+ */
+const char* lockSiteName(LockSite site);
+
+}  // namespace profiling
+
+/**
+ * std::shared_mutex that records acquisitions and blocked time for `Site`
+ * in the calling thread's ThreadProfile. The uncontended path is a single
+ * try_lock; the clock is only read when the lock has to wait.
+ */
+template <LockSite Site>
+class InstrumentedSharedMutex {
+public:
+    void lock() {
+        if (!mutex_.try_lock()) {
+            const auto begin = std::chrono::steady_clock::now();
+            mutex_.lock();
+            recordWait(begin);
+        }
+        stats().acquisitions++;
+    }
+
+    void lock_shared() {
+        if (!mutex_.try_lock_shared()) {
+            const auto begin = std::chrono::steady_clock::now();
+            mutex_.lock_shared();
+            recordWait(begin);
+        }
+        stats().acquisitions++;
+    }
+
+    bool try_lock() {
+        const bool locked = mutex_.try_lock();
+        stats().acquisitions += locked ? 1 : 0;
+        return locked;
+    }
+
+    bool try_lock_shared() {
+        const bool locked = mutex_.try_lock_shared();
+        stats().acquisitions += locked ? 1 : 0;
+        return locked;
+    }
+
+    void unlock() { mutex_.unlock(); }
+    void unlock_shared() { mutex_.unlock_shared(); }
+
+private:
+    static LockSiteStats& stats() {
+        return profiling::threadProfile().locks[static_cast<size_t>(Site)];
+    }
+
+    static void recordWait(std::chrono::steady_clock::time_point begin) {
+        auto& site = stats();
+        site.contended++;
+        site.wait_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+    }
+
+    std::shared_mutex mutex_;
+};
+
+/**
+ * Mutex type for an instrumented lock site: plain std::shared_mutex unless
+ * the library is built with RTRV_PROFILING.
+ */
+#ifdef RTRV_PROFILING
+template <LockSite Site>
+using ProfiledSharedMutex = InstrumentedSharedMutex<Site>;
+#else
+template <LockSite Site>
+using ProfiledSharedMutex = std::shared_mutex;
+#endif
+
+}  // namespace rtrv_search_engine
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "profiling.hpp"
 #include "search_types.hpp"
 #include <atomic>
 #include <chrono>
@@ -43,6 +44,9 @@ public:
 
     CacheStatistics getStats() const;
 
+    // Approximate bytes held by cached result lists and LRU bookkeeping
+    size_t memoryUsage() const;
+
 private:
     struct Entry {
         std::vector<SearchResult> results;
@@ -56,7 +60,7 @@ private:
     void eraseEntry(std::unordered_map<QueryCacheKey, Entry, QueryCacheKeyHasher>::iterator it,
                     bool count_eviction);
 
-    mutable std::shared_mutex mutex_;
+    mutable ProfiledSharedMutex<LockSite::QUERY_CACHE> mutex_;
     std::unordered_map<QueryCacheKey, Entry, QueryCacheKeyHasher> entries_;
     std::list<QueryCacheKey> lru_order_;
     size_t max_entries_;
@@ -19,7 +19,8 @@ public:
         AND,
         OR,
         NOT,
-        PROXIMITY
+        PROXIMITY,
+        RANGE
     };
     
     virtual ~QueryNode() = default;
@@ -71,6 +72,27 @@ public:
     }
 };
 
+/**
+ * Range filter on a typed field (e.g., price:[10 TO 100], date:{2024-01-01 TO *]).
+ * Bounds are kept as text; the engine converts them once per query using
+ * the field's declared type. An empty bound is open ("*").
+ */
+class RangeNode : public QueryNode {
+public:
+    std::string field_name;
+    std::string lower;
+    std::string upper;
+    bool include_lower = true;   // '[' vs '{'
+    bool include_upper = true;   // ']' vs '}'
+    
+    RangeNode(std::string field, std::string lo, std::string hi, bool inc_lower, bool inc_upper)
+        : field_name(std::move(field)), lower(std::move(lo)), upper(std::move(hi)),
+          include_lower(inc_lower), include_upper(inc_upper) {}
+    
+    Type getType() const override { return Type::RANGE; }
+    std::string toString() const override;
+};
+
 /**
  * Boolean AND operator node
  */
@@ -130,6 +152,7 @@ enum class QueryTokenType {
     AND_OP,
     OR_OP,
     NOT_OP,
+    RANGE,      // Whole bracketed range, e.g. "[10 TO 100]"
     END
 };
 
@@ -160,12 +183,14 @@ public:
      * - Fielded: title:machine
      * - Nested: (machine OR ai) AND learning
      * - Proximity: "machine learning"~5
+     * - Ranges: price:[10 TO 100], price:{10 TO *] ('{'/'}' exclude the bound)
      * - Implicit AND: machine learning (treated as machine AND learning)
      */
     std::unique_ptr<QueryNode> parse(const std::string& query_string);
     
     /**
-     * Extract simple terms from query (backward compatibility)
+     * Extract simple terms from query (backward compatibility); range
+     * clauses are filters, not terms, and are skipped
      */
     std::vector<std::string> extractTerms(const std::string& query_string);
 
@@ -183,6 +208,7 @@ private:
     std::unique_ptr<QueryNode> parseAtom();
     std::unique_ptr<QueryNode> parsePhrase();
     std::unique_ptr<QueryNode> parseFieldedTerm();
+    std::unique_ptr<QueryNode> parseRange(std::string field_name);
     std::unique_ptr<QueryNode> parseTerm();
     
     // Helper methods
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "document.hpp"
+#include "top_k_heap.hpp"
+#include <functional>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -15,6 +17,10 @@ struct IndexStats {
     size_t total_docs;                                       // Total number of documents
     double avg_doc_length;                                   // Average document length
     std::unordered_map<std::string, size_t> doc_frequency;  // Document frequency per term
+    
+    // Indexed term frequency, consulted when a term does not occur in the
+    // document text (terms injected at index time, e.g. synonyms); unset = 0
+    std::function<uint32_t(const std::string&, uint64_t)> indexed_tf;
 };
 
 /**
@@ -22,6 +28,9 @@ struct IndexStats {
  */
 struct Query {
     std::vector<std::string> terms;
+    std::vector<double> weights;  // Per-term score multiplier (synonym alternatives); empty = all 1.0
+    
+    double weight(size_t i) const { return i < weights.size() ? weights[i] : 1.0; }
 };
 
 /**
@@ -133,6 +142,75 @@ private:
                                        const IndexStats& stats);
 };
 
+/**
+ * How HybridRanker combines the lexical and vector result lists
+ */
+enum class FusionMethod {
+    RRF,       // Reciprocal rank fusion: sum of weight / (rrf_k + rank)
+    WEIGHTED   // Min-max normalized scores, weighted sum
+};
+
+struct FusionParams {
+    FusionMethod method = FusionMethod::RRF;
+    double rrf_k = 60.0;          // RRF rank constant (Cormack et al.)
+    double lexical_weight = 1.0;
+    double vector_weight = 1.0;
+    size_t window_size = 100;     // Top-N taken from each retriever before fusing
+    bool exact_knn = false;       // Linear scan instead of the HNSW graph
+};
+
+/**
+ * One fused hit; ranks are 1-based, 0 = not retrieved by that side
+ */
+struct FusedDocument {
+    uint64_t doc_id;
+    double score;
+    size_t lexical_rank;
+    double lexical_score;
+    size_t vector_rank;
+    double vector_score;
+};
+
+/**
+ * Hybrid lexical + vector ranker
+ *
+ * Selected like any other ranker (SearchOptions::ranker_name). When the
+ * query carries an embedding (SearchOptions::query_vector) and vector
+ * search is enabled, SearchEngine retrieves the BM25 top-N and the kNN
+ * top-N concurrently and fuses them with fuse(). Without an embedding it
+ * scores documents with BM25 alone.
+ */
+class HybridRanker : public Ranker {
+public:
+    explicit HybridRanker(const std::string& name = "Hybrid-RRF", const FusionParams& params = {});
+    ~HybridRanker() override;
+    
+    /**
+     * Lexical (BM25) score; the vector side is only available to fuse()
+     */
+    double score(const Query& query, 
+                const Document& doc,
+                const IndexStats& stats) override;
+    
+    std::string getName() const override { return name_; }
+    
+    /**
+     * Fuse two ranked lists (best first) into the top `k` documents
+     */
+    std::vector<FusedDocument> fuse(const std::vector<ScoredDocument>& lexical,
+                                    const std::vector<ScoredDocument>& vector,
+                                    size_t k) const;
+    
+    void setParameters(const FusionParams& params) { params_ = params; }
+    const FusionParams& getParameters() const { return params_; }
+    Bm25Ranker& getLexicalRanker() { return lexical_; }
+    
+private:
+    std::string name_;
+    FusionParams params_;
+    Bm25Ranker lexical_;
+};
+
 /**
  * Ranker Registry - manages available ranking algorithms
  * Implements plugin pattern for hot-swappable rankers
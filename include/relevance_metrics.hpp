@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * Graded relevance judgments for one query: doc id -> grade (0 = not relevant)
+ */
+using Judgments = std::unordered_map<uint64_t, int>;
+
+/**
+ * Relevance judgments for a query set: query id -> judgments
+ */
+using Qrels = std::unordered_map<std::string, Judgments>;
+
+/**
+ * Ranking-quality metrics for comparing a result list against relevance
+ * judgments (NDCG, MRR, recall) or against a reference ranking (RBO).
+ * Rankings are doc ids in rank order, best first.
+ */
+namespace relevance {
+
+/**
+ * Parse TREC qrels ("<query_id> <iteration> <doc_id> <relevance>" per line).
+ * Lines with non-numeric doc ids are skipped.
+ */
+Qrels parseTrecQrels(std::istream& input);
+
+/**
+ * Load TREC qrels from a file. Throws std::runtime_error if it cannot be opened.
+ */
+Qrels loadTrecQrels(const std::string& filepath);
+
+/**
+ * Normalized discounted cumulative gain at depth k, with exponential gain
+ * (2^grade - 1). Returns 0 when the query has no relevant documents.
+ */
+double ndcgAtK(const std::vector<uint64_t>& ranking, const Judgments& judgments, size_t k);
+
+/**
+ * Reciprocal rank of the first relevant document (0 if none is retrieved).
+ */
+double reciprocalRank(const std::vector<uint64_t>& ranking, const Judgments& judgments);
+
+/**
+ * Fraction of relevant documents retrieved in the top k.
+ * Returns 0 when the query has no relevant documents.
+ */
+double recallAtK(const std::vector<uint64_t>& ranking, const Judgments& judgments, size_t k);
+
+/**
+ * Extrapolated rank-biased overlap (Webber et al., 2010) between two
+ * rankings, evaluated to the depth of the longer one. 1.0 = identical,
+ * 0.0 = disjoint; `persistence` (p) weights the top ranks more as it
+ * decreases (p = 0.9 puts ~86% of the weight on the top 10).
+ */
+double rankBiasedOverlap(const std::vector<uint64_t>& ranking,
+                         const std::vector<uint64_t>& reference,
+                         double persistence = 0.9);
+
+/**
+ * Number of documents with grade > 0
+ */
+size_t relevantCount(const Judgments& judgments);
+
+}  // namespace relevance
+
+}  // namespace rtrv_search_engine
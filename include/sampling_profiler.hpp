@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace rtrv_search_engine {
+
+/**
+ * Result of one profiling session
+ */
+struct ProfileResult {
+    std::string folded_stacks;  // "root;caller;leaf <count>" per line (flamegraph.pl input)
+    size_t samples = 0;         // Samples captured
+    size_t dropped = 0;         // Samples lost because the buffer was full
+};
+
+/**
+ * In-process CPU sampling profiler for live servers.
+ *
+ * setitimer(ITIMER_PROF) delivers SIGPROF at `frequency_hz` per second of
+ * process CPU time. The signal handler walks the interrupted thread's frame
+ * pointers (no libunwind, no allocation, no locks) and appends the return
+ * addresses to a fixed, preallocated sample buffer through an atomic cursor.
+ * Stacks are symbolized with dladdr() and folded when the session stops.
+ *
+ * Only one session can run per process. Stacks are complete only for code
+ * built with frame pointers (RTRV_FRAME_POINTERS, on by default); binaries
+ * must export their symbols (-rdynamic) for names instead of module offsets.
+ * Linux x86-64 and AArch64 only; elsewhere supported() is false.
+ */
+class SamplingProfiler {
+public:
+    static constexpr int kDefaultFrequencyHz = 99;
+    static constexpr size_t kMaxDepth = 64;
+
+    /**
+     * True when stack sampling is implemented for this platform.
+     */
+    static bool supported();
+
+    /**
+     * Install the SIGPROF handler and start the timer. Returns false if a
+     * session is already running or the platform is unsupported.
+     */
+    static bool start(int frequency_hz = kDefaultFrequencyHz);
+
+    /**
+     * Stop the timer, wait for in-flight samples and fold the collected
+     * stacks. Returns an empty result if no session is running.
+     */
+    static ProfileResult stop();
+
+    static bool isRunning();
+
+    /**
+     * Blocking convenience: start, sleep for `duration`, stop.
+     * Returns an empty result if a session could not be started.
+     */
+    static ProfileResult profileFor(std::chrono::milliseconds duration,
+                                    int frequency_hz = kDefaultFrequencyHz);
+};
+
+}  // namespace rtrv_search_engine
@@ -8,12 +8,24 @@
 #include "snippet_extractor.hpp"
 #include "fuzzy_search.hpp"
 #include "query_cache.hpp"
+#include "profiling.hpp"
 #include "search_types.hpp"
+#include "vector_index.hpp"
+#include "synonym_map.hpp"
+#include "doc_values.hpp"
+#include "filter_cache.hpp"
+#include "aggregations.hpp"
+#include "percolator.hpp"
+#include "subscriptions.hpp"
+#include "term_vectors.hpp"
 #include <chrono>
+#include <functional>
 #include <string>
 #include <vector>
 #include <memory>
 #include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace rtrv_search_engine {
 
@@ -39,6 +51,21 @@ public:
     PaginatedSearchResults searchPaginated(const std::string& query,
                                            const SearchOptions& options = {});
     
+    // Highlighted snippets for already-retrieved results (e.g. only the page
+    // being returned); search() and searchPaginated() call this when
+    // generate_snippets is set. Cached results never hold snippets.
+    void generateSnippets(std::vector<SearchResult>& results,
+                          const std::string& query,
+                          const SnippetOptions& options = {}) const;
+    
+    // Vector search: k nearest documents to `vector` by the configured
+    // metric (score = similarity, higher is better). `filter` restricts the
+    // candidates; `ef` = 0 uses the index default. Empty if vector search is
+    // not enabled or the dimension differs.
+    std::vector<SearchResult> knnSearch(const std::vector<float>& vector, size_t k = 10,
+                                        const std::function<bool(const Document&)>& filter = {},
+                                        size_t ef = 0) const;
+    
     // Overload for searching with specific ranker
     std::vector<SearchResult> search(const std::string& query,
                                      const std::string& ranker_name,
@@ -47,12 +74,25 @@ public:
     // Statistics
     IndexStatistics getStats() const;
     CacheStatistics getCacheStats() const;
+    
+    // Per-structure memory breakdown, computed by each component
+    MemoryUsage memoryUsage() const;
+    
+    // Index shape: posting-length histogram, longest lists, compression
+    // estimate and skip effectiveness (maintained incrementally)
+    IndexAnalysis analyzeIndex(size_t top_n = 10) const;
 
     // List documents (for browsing)
     std::vector<std::pair<uint64_t, Document>> getDocuments(size_t offset = 0, size_t limit = 10) const;
-    void clearCache();
+    void clearCache();  // Query result and filter caches
     void setCacheConfig(size_t max_entries, std::chrono::milliseconds ttl);
     
+    // Filter cache (SearchOptions::filters and range clauses of the query):
+    // byte budget, and how many of the last FilterCache::kHistorySize
+    // clause lookups must name a clause before it is cached
+    FilterCacheStatistics getFilterCacheStats() const;
+    void setFilterCacheConfig(size_t max_bytes, size_t min_frequency);
+    
     // Persistence
     bool saveSnapshot(const std::string& filepath);
     bool loadSnapshot(const std::string& filepath);
@@ -85,6 +125,92 @@ public:
     void enableSIMD(bool enabled) { if (tokenizer_) tokenizer_->enableSIMD(enabled); }
     void setStemmer(StemmerType type) { if (tokenizer_) tokenizer_->setStemmer(type); }
     void setRemoveStopwords(bool enabled) { if (tokenizer_) tokenizer_->setRemoveStopwords(enabled); }
+
+    // Index Document::vector in an HNSW graph of the given dimension.
+    // Existing documents with a vector of that dimension are indexed now;
+    // vectors of any other dimension are stored but not indexed. With
+    // params.quantization the index keeps the only copy of indexed vectors
+    // (stored documents drop theirs); enabling again rebuilds from that
+    // copy, at full precision only if the previous index had a vector_file.
+    void enableVectorSearch(size_t dimension, VectorMetric metric = VectorMetric::COSINE,
+                            const HnswParams& params = {});
+    const HnswIndex* getVectorIndex() const { return vector_index_.get(); }
+    
+    // Keep each document's token offsets so snippets are built from the
+    // query terms' positions instead of re-tokenizing the hit. Applies to
+    // documents indexed afterwards; others fall back to one tokenize per hit.
+    void setStoreTermOffsets(bool enabled);
+    bool storesTermOffsets() const { return store_term_offsets_; }
+    
+    // Keep each document's term vector (term id + frequency per distinct
+    // term) so moreLikeThis() reads the source document's terms instead of
+    // re-tokenizing it. Applies to documents indexed afterwards.
+    void setStoreTermVectors(bool enabled);
+    bool storesTermVectors() const { return store_term_vectors_; }
+    
+    // Field schema: KEYWORD fields keep a columnar doc-values copy of their
+    // (whole, untokenized) value for facets and sorting; INT64 / DOUBLE /
+    // DATE fields keep a typed key for range filters and sorting. Existing
+    // documents are back-filled. All fields stay full-text searchable.
+    void defineField(const std::string& field, FieldType type);
+    FieldType getFieldType(const std::string& field) const;
+    const DocValues& getDocValues() const { return doc_values_; }
+    
+    // Index sort: keep doc-values ordinals ordered by a declared field, so
+    // search() sorted on that field (same direction) stops after the first
+    // page of hits instead of scoring every candidate. Empty field = off;
+    // false if the field is not a keyword or numeric field.
+    bool setIndexSort(const std::string& field, bool descending = false);
+    
+    // Synonym dictionary (null = none). QUERY_TIME expands each query into
+    // a weighted OR of the matched entries' alternatives; INDEX_TIME indexes
+    // the alternatives with documents indexed afterwards, so queries pay
+    // nothing (keep the map installed: it also marks injected terms for
+    // scoring). Entries are matched against analyzed tokens.
+    void setSynonyms(std::shared_ptr<const SynonymMap> synonyms,
+                     SynonymMode mode = SynonymMode::QUERY_TIME);
+    std::shared_ptr<const SynonymMap> getSynonyms() const { return synonyms_; }
+    
+    // Percolator (reverse search): stored queries matched against incoming
+    // documents with boolean semantics. Queries are compiled with the
+    // current tokenizer and field schema (defineField recompiles them);
+    // false for an empty query. percolate() returns the ids of the stored
+    // queries `doc` matches, in ascending order, without indexing it.
+    bool registerQuery(uint64_t query_id, const std::string& query);
+    bool unregisterQuery(uint64_t query_id);
+    std::vector<uint64_t> percolate(const Document& doc, PercolateStats* stats = nullptr) const;
+    size_t registeredQueries() const;
+    
+    // Continuous queries: a subscription keeps the top
+    // `options.max_results` of search(query, options) up to date as
+    // documents are indexed, updated and deleted, and reports each change
+    // as a SubscriptionDelta: to `callback` (after the write, outside the
+    // engine lock) and to subscriptionDeltas() for polling. The first delta
+    // is a reset holding the initial results. A write is scored only
+    // against the subscriptions indexed under its terms or holding the
+    // document; a search runs again only when a full top-k loses a member.
+    // Members keep the score they were given (collection statistics drift
+    // until the next search). 0 for a query that selects nothing, or
+    // options with sort, collapse, a query vector or fuzzy matching.
+    uint64_t subscribe(const std::string& query, const SearchOptions& options = {},
+                       SubscriptionCallback callback = {});
+    bool unsubscribe(uint64_t subscription_id);
+    std::vector<SearchResult> subscriptionResults(uint64_t subscription_id) const;
+    std::vector<SubscriptionDelta> subscriptionDeltas(uint64_t subscription_id, uint64_t after_sequence = 0) const;
+    size_t subscriptionCount() const;
+    
+    // More like this: the `k` documents most similar to stored document
+    // `doc_id` (itself excluded), found with a disjunction of its top
+    // TF-IDF terms (see MoreLikeThisOptions), each weighted and scored with
+    // BM25 straight from the postings. Terms are evaluated best-first and
+    // once the k-th best partial score exceeds what the remaining terms
+    // could add, documents not seen yet are skipped: same top k as scoring
+    // every candidate. Empty for an unknown document.
+    std::vector<SearchResult> moreLikeThis(uint64_t doc_id, size_t k = 10,
+                                           const MoreLikeThisOptions& options = {}) const;
+    // The terms moreLikeThis() queries with and their weights, best first
+    std::vector<std::pair<std::string, double>> moreLikeThisTerms(uint64_t doc_id,
+                                                                  const MoreLikeThisOptions& options = {}) const;
     
     // Deprecated: Use registerCustomRanker() instead
     void setRanker(std::unique_ptr<Ranker> ranker);
@@ -92,8 +218,107 @@ public:
 private:
     friend class Persistence;
     
-    // Internal indexing without locking (caller must hold mutex_)
-    uint64_t indexDocumentInternal(const Document& doc);
+    // Internal indexing without locking (caller must hold mutex_); adds
+    // the terms indexed for the document to `indexed_terms`, if given
+    uint64_t indexDocumentInternal(const Document& doc, std::unordered_set<std::string>* indexed_terms = nullptr);
+
+    // Core search: retrieval, scoring and cache, without snippets (caller
+    // holds mutex_). With a `collector`, every hit is fed to its facet
+    // counter and aggregations in the scoring pass and the result cache is
+    // bypassed.
+    std::vector<SearchResult> searchInternal(const std::string& query, const SearchOptions& options,
+                                             HitCollector* collector = nullptr);
+    
+    // Hybrid search (caller holds mutex_): kNN top-N as (doc_id, similarity)
+    // among the documents `filter` accepts (all if empty), and the lexical
+    // top-N fused with it by `ranker`; every lexical match and kNN hit is
+    // fed to `hits`
+    std::vector<ScoredDocument> vectorTopN(const std::vector<float>& vector, size_t n,
+                                           bool exact, size_t ef,
+                                           const std::function<bool(uint64_t)>& filter = {}) const;
+    std::vector<SearchResult> fuseHybrid(HybridRanker& ranker, const Query& query,
+                                         const IndexStats& stats,
+                                         const std::unordered_set<uint64_t>& candidates,
+                                         const std::vector<ScoredDocument>& vector_ranked,
+                                         const SearchOptions& options, HitCollector* hits = nullptr);
+    
+    // Filter context (caller holds mutex_): the range clauses of `query`
+    // (unless they sit under an OR with scored clauses) and
+    // `options.filters`, one cached doc-ordinal set per top-level AND
+    // clause, smallest first; empty when there are none
+    std::vector<std::shared_ptr<const SegmentedDocIdSet>> compileFilters(const std::string& query,
+                                                                         const SearchOptions& options);
+    // Doc ordinals matching `node`, or null if it is not a filter. In
+    // `filter_context` keyword / numeric field terms are filters too and
+    // anything else matches nothing; in a query they are left to scoring.
+    std::unique_ptr<DocIdSetIterator> filterIterator(const QueryNode& node, bool filter_context) const;
+    // The same clause as a per-document test, into `filter`; false if it
+    // is not a filter
+    bool compileDocFilter(const QueryNode& node, bool filter_context, DocFilter& filter) const;
+    
+    // Top `options.max_results` hits in `options.sort` order (caller holds
+    // mutex_). `score` returns 0 for a non-hit. When the index sort is the
+    // primary key, ordinals are walked in index order and the walk stops
+    // once no later document can make the page; otherwise every id in
+    // `candidates` is scored.
+    std::vector<SearchResult> collectSorted(const SearchOptions& options, const std::vector<uint64_t>& candidates,
+                                            const std::function<double(uint64_t)>& score,
+                                            HitCollector* hits) const;
+
+    // Field collapsing (options.collapse_field): the top `options.max_results`
+    // groups of the hits in `candidates`, ranked by their best hits in
+    // `options.sort` order (score order if empty), each result carrying its
+    // group's best hits as inner_hits (caller holds mutex_)
+    std::vector<SearchResult> collectCollapsed(const SearchOptions& options, const std::vector<uint64_t>& candidates,
+                                               const std::function<double(uint64_t)>& score,
+                                               HitCollector* hits) const;
+    
+    // Ranker named by `options` (default, then BM25 if missing), and the
+    // statistics for scoring `terms`, whose first `original_terms` come
+    // from the query and the rest are synonym alternatives;
+    // `candidate_terms` receives the term whose postings stand for each
+    // (caller holds mutex_)
+    Ranker* selectRanker(const SearchOptions& options) const;
+    IndexStats queryStats(const std::vector<std::string>& terms, size_t original_terms,
+                          std::vector<std::string>& candidate_terms) const;
+    
+    // Tokenizer, schema and index frequencies for the percolator (caller holds mutex_)
+    Percolator::Context percolatorContext() const;
+    
+    // Continuous queries (caller holds mutex_). Deltas are delivered by
+    // notifySubscribers() once mutex_ is released.
+    using SubscriptionNotifications = std::vector<std::pair<SubscriptionCallback, SubscriptionDelta>>;
+    void analyzeSubscription(SubscriptionIndex::Subscription& subscription);
+    // Score of stored document `doc_id` for the subscription as search()
+    // would give it; 0 if it is not a hit
+    double subscriptionScore(const SubscriptionIndex::Subscription& subscription, uint64_t doc_id);
+    // Re-evaluate the subscriptions the written or deleted documents
+    // (id, indexed terms) may change; all of them search again if `resync`
+    SubscriptionNotifications updateSubscriptions(
+        const std::vector<std::pair<uint64_t, std::unordered_set<std::string>>>& writes, bool resync = false);
+    static void notifySubscribers(const SubscriptionNotifications& notifications);
+    
+    // More like this: the source document's selected terms (caller holds mutex_)
+    std::vector<std::pair<std::string, double>> interestingTerms(uint64_t doc_id,
+                                                                 const MoreLikeThisOptions& options) const;
+    
+    // Query-time synonyms: append the alternatives of the entries matched in
+    // `terms`, skipping those with a word absent from the index, and fill
+    // `weights` (caller holds mutex_)
+    void expandSynonyms(std::vector<std::string>& terms, std::vector<double>& weights,
+                        size_t max_expansions) const;
+    
+    // Snippets for `results` (caller holds mutex_)
+    void attachSnippets(std::vector<SearchResult>& results, const std::string& query,
+                        const SnippetOptions& options) const;
+    
+    // Pages with more document text than this are split across threads
+    static constexpr size_t kParallelSnippetBytes = 256 * 1024;
+    
+    // Sorted offsets of the (analyzed) query terms in a stored document's text
+    std::vector<TermOffset> matchOffsets(uint64_t doc_id, const std::string& text,
+                                         const std::unordered_set<std::string>& terms,
+                                         const TermMatcher& matcher) const;
     
     std::unique_ptr<Tokenizer> tokenizer_;
     std::unique_ptr<InvertedIndex> index_;
@@ -102,9 +327,21 @@ private:
     SnippetExtractor snippet_extractor_;
     FuzzySearch fuzzy_search_;
     QueryCache query_cache_;
+    FilterCache filter_cache_;
     std::unordered_map<uint64_t, Document> documents_;
+    std::unordered_map<uint64_t, std::vector<TermOffset>> term_offsets_;  // Indexed by token position
+    bool store_term_offsets_ = false;
+    TermVectors term_vectors_;
+    bool store_term_vectors_ = false;
+    std::unique_ptr<HnswIndex> vector_index_;  // Null until enableVectorSearch()
+    std::shared_ptr<const SynonymMap> synonyms_;
+    DocValues doc_values_;
+    Percolator percolator_;
+    SubscriptionIndex subscriptions_;
+    size_t total_term_count_ = 0;  // Sum of Document::term_count (average length for scoring)
+    SynonymMode synonym_mode_ = SynonymMode::QUERY_TIME;
     uint64_t next_doc_id_;
-    mutable std::shared_mutex mutex_;  // Thread safety for documents_ and next_doc_id_
+    mutable ProfiledSharedMutex<LockSite::SEARCH_ENGINE> mutex_;  // Thread safety for documents_ and next_doc_id_
 };
 
 } 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "document.hpp"
+#include "memory_usage.hpp"
 #include "snippet_extractor.hpp"
 #include <cstddef>
 #include <cstdint>
@@ -14,6 +15,39 @@ namespace rtrv_search_engine {
 /**
  * Search options
  */
+/**
+ * One sort key: a keyword or numeric doc-values field (see
+ * SearchEngine::defineField), or "_score". Documents without a value sort
+ * last in either direction.
+ */
+struct SortField {
+    std::string field;
+    bool descending = false;
+};
+
+/**
+ * One aggregation over a query's hits (SearchOptions::aggregations),
+ * computed from the doc-values columns while the hits are scored
+ */
+struct AggregationRequest {
+    enum Type {
+        TERMS,           // Top `size` values (keyword or numeric field)
+        HISTOGRAM,       // Fixed-width buckets of `interval` (numeric field)
+        DATE_HISTOGRAM,  // Calendar buckets of `date_interval` (DATE field, UTC)
+        STATS,           // Count, min, max, sum and average (numeric field)
+        CARDINALITY      // Distinct values, estimated (keyword or numeric field)
+    };
+    enum DateInterval { MINUTE, HOUR, DAY, WEEK, MONTH, QUARTER, YEAR };
+
+    std::string name;  // Result name; empty = the field
+    Type type = TERMS;
+    std::string field;
+    size_t size = 10;        // TERMS: buckets returned
+    double interval = 0.0;   // HISTOGRAM: bucket width (> 0)
+    DateInterval date_interval = DAY;  // DATE_HISTOGRAM (weeks start on Monday)
+    uint8_t precision = 14;  // CARDINALITY: HyperLogLog precision, 4-18 (error ~1.04 / sqrt(2^precision))
+};
+
 struct SearchOptions {
     std::string ranker_name = "";  // Empty = use default ranker
     size_t max_results = 10;
@@ -28,6 +62,42 @@ struct SearchOptions {
     bool fuzzy_enabled = false;     // Enable fuzzy matching for typo tolerance
     uint32_t max_edit_distance = 0; // 0 = auto (based on term length)
 
+    // Synonyms (query-time mode, see SearchEngine::setSynonyms)
+    bool expand_synonyms = true;
+    size_t max_synonym_expansions = 16;  // Alternatives added per query
+
+    // Hybrid search: query embedding for the Hybrid-* rankers (empty = lexical only)
+    std::vector<float> query_vector;
+    size_t knn_ef = 0;  // HNSW candidate list size; 0 = index default
+
+    // Facets: top values of these keyword fields over all hits
+    // (searchPaginated only; see SearchEngine::defineField)
+    std::vector<std::string> facets;
+    size_t facet_size = 10;  // Values returned per field
+
+    // Aggregations over all hits (searchPaginated only), collected in the
+    // scoring pass like facets
+    std::vector<AggregationRequest> aggregations;
+
+    // Filter context: clauses in query syntax (keyword "field:value",
+    // numeric "field:[lo TO hi]", AND / OR / NOT of those) that restrict
+    // the hits without scoring. Each one, and each top-level AND clause of
+    // it, is cached as a doc-ordinal set once it recurs. Anything else
+    // (e.g. a bare term) matches nothing.
+    std::vector<std::string> filters;
+
+    // Sort: order hits by these keys, then score, then doc id (empty = by
+    // score). Cursor pagination (search_after_*) only applies to score order.
+    std::vector<SortField> sort;
+
+    // Field collapsing: one result per value of this keyword or numeric
+    // field (its best hit in sort / score order), the groups ranked by
+    // their best hits; documents without a value are not collapsed. Up to
+    // `collapse_inner_hits` best hits of each group, the best one included,
+    // are returned in SearchResult::inner_hits (0 = none).
+    std::string collapse_field;
+    size_t collapse_inner_hits = 0;
+
     // Cache control
     bool use_cache = true;  // Enable query result caching
 
@@ -43,6 +113,19 @@ struct SearchOptions {
     RankingAlgorithm algorithm = BM25;  // For backward compatibility
 };
 
+/**
+ * How more-like-this picks the terms of its source document: the
+ * `max_query_terms` best by TF-IDF (log(1 + tf) * log(N / df)) among those
+ * passing the frequency limits
+ */
+struct MoreLikeThisOptions {
+    size_t max_query_terms = 25;
+    uint32_t min_term_freq = 1;   // Occurrences in the source document
+    size_t min_doc_freq = 2;      // Documents containing the term (1 = only the source)
+    double max_doc_freq = 0.5;    // Fraction of all documents; commoner terms are skipped
+    bool boost_terms = true;      // Weight each term by its TF-IDF relative to the best one
+};
+
 /**
  * Search result
  */
@@ -52,6 +135,7 @@ struct SearchResult {
     std::string explanation;                 // Optional score breakdown
     std::vector<std::string> snippets;       // Highlighted snippets (populated when generate_snippets=true)
     std::unordered_map<std::string, std::string> expanded_terms;  // Fuzzy: original -> corrected term
+    std::vector<SearchResult> inner_hits;    // Collapse: best hits of this result's group
 
     // Comparison operators for sorting and heap operations
     bool operator>(const SearchResult& other) const {
@@ -84,6 +168,22 @@ struct CacheStatistics {
     double hit_rate = 0.0;
 };
 
+/**
+ * Filter cache counters (SearchEngine::getFilterCacheStats). A refresh is
+ * a cached clause rebuilt after a write, reusing its untouched segments.
+ */
+struct FilterCacheStatistics {
+    size_t hit_count = 0;
+    size_t miss_count = 0;
+    size_t refresh_count = 0;
+    size_t segments_reused = 0;  // Over all refreshes
+    size_t eviction_count = 0;
+    size_t current_size = 0;     // Cached clauses
+    size_t memory_bytes = 0;
+    size_t max_bytes = 0;
+    double hit_rate = 0.0;
+};
+
 /**
  * Pagination metadata returned alongside search results
  */
@@ -94,12 +194,60 @@ struct PaginationInfo {
     bool has_next_page = false;  // Whether more results are available
 };
 
+/**
+ * Top values of one keyword field over a query's hits (SearchOptions::facets)
+ */
+struct FacetValue {
+    std::string value;
+    size_t count;
+};
+
+struct FacetResult {
+    std::string field;
+    std::vector<FacetValue> values;  // Count descending, then value
+    size_t other_count = 0;          // Hits with a value outside `values`
+    size_t missing_count = 0;        // Hits without a value
+};
+
+/**
+ * Result of one AggregationRequest. Histogram buckets are in key order and
+ * only non-empty buckets are listed; a bucket's key is its lower bound
+ * (ISO-8601 for dates).
+ */
+struct AggregationBucket {
+    std::string key;
+    double from = 0.0;  // Histograms: lower bound (dates: epoch millis)
+    size_t count = 0;
+};
+
+struct AggregationStats {
+    size_t count = 0;
+    double min = 0.0;  // 0 when count is 0
+    double max = 0.0;
+    double sum = 0.0;
+    double avg = 0.0;
+};
+
+struct AggregationResult {
+    std::string name;
+    AggregationRequest::Type type = AggregationRequest::TERMS;
+    std::string field;
+    std::vector<AggregationBucket> buckets;  // TERMS: count descending, then key
+    AggregationStats stats;                  // STATS
+    uint64_t cardinality = 0;                // CARDINALITY: estimated distinct values
+    std::vector<uint8_t> sketch;             // CARDINALITY: HyperLogLog::serialize(), to merge across shards
+    size_t other_count = 0;                  // TERMS: hits with a value outside `buckets`
+    size_t missing_count = 0;                // Hits without a value (HISTOGRAM: or without an int64 bucket)
+};
+
 /**
  * Paginated search results — wraps results with pagination metadata
  */
 struct PaginatedSearchResults {
     std::vector<SearchResult> results;
     PaginationInfo pagination;
+    std::vector<FacetResult> facets;  // One per SearchOptions::facets field
+    std::vector<AggregationResult> aggregations;  // One per SearchOptions::aggregations entry
 };
 
 } // namespace rtrv_search_engine
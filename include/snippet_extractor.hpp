@@ -1,5 +1,6 @@
 #pragma once
 
+#include "term_matcher.hpp"
 #include <string>
 #include <vector>
 #include <unordered_set>
@@ -21,7 +22,7 @@ struct SnippetOptions {
  * Generates context-aware text snippets with query term highlighting.
  *
  * Given a document's raw text and a set of query terms, the extractor:
- * 1. Finds text windows with the highest density of query terms.
+ * 1. Matches the terms in one pass (TermMatcher, Aho-Corasick) and finds text windows with the highest density of query terms.
  * 2. Extracts snippets that break on word boundaries.
  * 3. Wraps matched terms with configurable highlight markers.
  * 4. Prepends/appends ellipsis when the snippet is a substring of the document.
@@ -44,6 +45,30 @@ public:
         const std::vector<std::string>& query_terms,
         const SnippetOptions& options = {}) const;
 
+    /**
+     * Generate highlighted snippets with terms compiled once per query;
+     * reuse the matcher for every result of that query.
+     */
+    std::vector<std::string> generateSnippets(
+        const std::string& text,
+        const TermMatcher& matcher,
+        const SnippetOptions& options = {}) const;
+
+    /**
+     * Generate highlighted snippets from known match offsets instead of
+     * rescanning the text. Windows are chosen from the match list and only
+     * the selected windows are copied, so the cost is O(matches + snippet
+     * length) rather than O(document length).
+     *
+     * @param text     The document text the offsets refer to.
+     * @param matches  Query-term occurrences, sorted by start offset.
+     * @param options  Snippet configuration options.
+     */
+    std::vector<std::string> generateSnippetsFromOffsets(
+        const std::string& text,
+        const std::vector<TermOffset>& matches,
+        const SnippetOptions& options = {}) const;
+
     /**
      * Highlight all occurrences of query terms in a given text.
      * Case-insensitive matching, preserves original case.
@@ -71,23 +96,27 @@ private:
     };
 
     /**
-     * Find the best snippet windows in the document text.
+     * Find the best snippet windows from sorted match offsets: the densest
+     * runs of matches that fit `window_size`, centred in their window.
      */
     std::vector<Window> findBestWindows(
-        const std::string& text,
-        const std::vector<std::string>& query_terms,
+        const std::vector<TermOffset>& matches,
+        size_t text_size,
         size_t window_size,
         size_t num_windows) const;
 
     /**
-     * Snap window boundaries to word boundaries.
+     * Copy text[start, end) with the matches inside it wrapped in tags.
      */
-    void snapToWordBoundaries(const std::string& text, size_t& start, size_t& end) const;
+    static void appendHighlighted(std::string& out, const std::string& text,
+                                  size_t start, size_t end,
+                                  const std::vector<TermOffset>& matches,
+                                  const SnippetOptions& options);
 
     /**
-     * Convert a string to lowercase.
+     * Snap window boundaries to word boundaries.
      */
-    static std::string toLower(const std::string& str);
+    void snapToWordBoundaries(const std::string& text, size_t& start, size_t& end) const;
 
     /**
      * Check if a character is a word character (alphanumeric or apostrophe).
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "doc_values.hpp"
+#include "ranker.hpp"
+#include "search_types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * One change to a subscription's top-k results
+ */
+struct SubscriptionDelta {
+    uint64_t subscription_id = 0;
+    uint64_t sequence = 0;              // 1 for the initial results, then one more per delta
+    bool reset = false;                 // `upserts` is the whole top-k: replace, don't merge
+    std::vector<SearchResult> upserts;  // Entered the top-k or were re-scored, best first
+    std::vector<uint64_t> removed;      // Left the top-k
+};
+
+using SubscriptionCallback = std::function<void(const SubscriptionDelta&)>;
+
+/**
+ * A filter clause compiled to test one document at a time: bounds are
+ * parsed and keyword values normalized once, so a check reads the
+ * document's column values and nothing else
+ */
+struct DocFilter {
+    enum class Kind { NONE, RANGE, KEYWORD, AND, OR, NOT };
+
+    Kind kind = Kind::NONE;          // NONE matches nothing
+    std::string field;
+    int64_t lower = 0;               // RANGE: inclusive key bounds
+    int64_t upper = 0;
+    std::string value;               // KEYWORD: DocValues::normalizeKeyword() text
+    std::vector<DocFilter> children;
+
+    bool matches(const DocValues& doc_values, uint32_t ordinal) const;
+};
+
+/**
+ * Continuous queries: each subscription holds the current top-k of a
+ * search, kept up to date one written document at a time.
+ *
+ * Subscriptions are indexed by the words any hit must contain (a search
+ * hit contains one of the query's terms), like the percolator's
+ * pre-filter, so a write only reaches the subscriptions indexed under its
+ * terms, those whose top-k holds the document, and term-less (filter-only)
+ * ones. The owner scores the document for those and apply()s the result;
+ * when a full top-k loses or demotes a member, the replacement can only
+ * come from a new search, given to replace(). Each published delta is
+ * numbered and kept in a short log for polling.
+ *
+ * Not internally synchronized: SearchEngine guards it with its mutex.
+ */
+class SubscriptionIndex {
+public:
+    static constexpr size_t kRetainedDeltas = 256;  // Per subscription; older pollers get a reset
+
+    struct Subscription {
+        uint64_t id = 0;
+        std::string query;
+        SearchOptions options;               // max_results = k; never cached
+        Query scored;                        // Analyzed terms (and synonym alternatives)
+        size_t original_terms = 0;           // scored.terms before synonym alternatives
+        std::vector<DocFilter> filters;      // Range and filter clauses; a hit matches all
+        std::vector<std::string> index_terms;
+        std::vector<SearchResult> results;   // Current top-k, best first
+        SubscriptionCallback callback;
+        std::deque<SubscriptionDelta> log;   // Last kRetainedDeltas deltas
+        uint64_t sequence = 0;
+    };
+
+    Subscription& add(const std::string& query, const SearchOptions& options, SubscriptionCallback callback);
+    bool remove(uint64_t id);
+    Subscription* find(uint64_t id);
+    const Subscription* find(uint64_t id) const;
+    std::vector<uint64_t> ids() const;
+    size_t size() const { return subscriptions_.size(); }
+    bool empty() const { return subscriptions_.empty(); }
+
+    /**
+     * Set what `subscription` scores, and index it under the words a hit
+     * must contain one of: single-word query terms and the words of
+     * multi-word synonym alternatives (quoted phrases select no hits)
+     */
+    void analyze(Subscription& subscription, Query scored, size_t original_terms);
+
+    /**
+     * Subscriptions that written or deleted document `doc_id`, indexed
+     * with `terms`, may change, ascending
+     */
+    std::vector<uint64_t> candidates(uint64_t doc_id, const std::unordered_set<std::string>& terms) const;
+
+    /**
+     * Update the top-k for one document: `doc` is its stored copy if it is
+     * a hit with `score`, null otherwise (deleted, or no longer matching).
+     * False, and nothing changed, if only a new search can tell: a full
+     * top-k lost a member, or a member's score fell below the others'.
+     */
+    bool apply(Subscription& subscription, uint64_t doc_id, const Document* doc, double score,
+               SubscriptionDelta& delta);
+
+    /**
+     * Replace the top-k with a new search's `results`, recording the difference
+     */
+    void replace(Subscription& subscription, std::vector<SearchResult> results, SubscriptionDelta& delta);
+
+    /**
+     * Number `delta` and append it to the log; false (nothing published)
+     * if it carries no change
+     */
+    bool publish(Subscription& subscription, SubscriptionDelta& delta);
+
+    /**
+     * Published deltas after `after_sequence`; a reset with the current
+     * results if some of them already left the log
+     */
+    std::vector<SubscriptionDelta> deltas(uint64_t id, uint64_t after_sequence) const;
+
+    void clear();
+
+private:
+    void hold(uint64_t doc_id, uint64_t id);
+    void release(uint64_t doc_id, uint64_t id);
+    void unindex(const Subscription& subscription);
+
+    std::unordered_map<uint64_t, Subscription> subscriptions_;
+    std::unordered_map<std::string, std::vector<uint64_t>> postings_;  // Word -> subscriptions
+    std::vector<uint64_t> unindexed_;                                  // Checked for every write
+    std::unordered_map<uint64_t, std::vector<uint64_t>> holders_;      // Document -> subscriptions holding it
+    uint64_t next_id_ = 1;
+};
+
+}  // namespace rtrv_search_engine
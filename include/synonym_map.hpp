@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * When a SynonymMap is applied
+ */
+enum class SynonymMode {
+    QUERY_TIME,  // Queries are expanded; the index is unchanged
+    INDEX_TIME   // Alternatives are indexed with each document; queries pay nothing
+};
+
+/**
+ * One replacement for a matched span: space-separated lowercase words
+ */
+struct SynonymAlternative {
+    std::string text;
+    float weight = 1.0f;  // Relative to the original terms (1.0)
+};
+
+/**
+ * A dictionary entry found in a token sequence: tokens [start, start + length)
+ */
+struct SynonymMatch {
+    size_t start;
+    size_t length;
+    const std::vector<SynonymAlternative>* alternatives;  // Owned by the map
+};
+
+/**
+ * Synonym dictionary compiled into a token-level trie.
+ *
+ * Words are interned once, and the trie's edges live in a single
+ * open-addressing table keyed by (node, word id), so following one token
+ * is one string hash plus one probe. A lookup therefore costs
+ * O(tokens * longest entry) whatever the number of entries; the map is
+ * read-only once loaded and safe to share between threads.
+ *
+ * Entries are lowercase and may span several words ("new york city").
+ */
+class SynonymMap {
+public:
+    SynonymMap();
+
+    /**
+     * One-way rule: `from` is rewritten to each of `to` (entries of the
+     * same span are merged; a repeated alternative keeps the higher weight)
+     */
+    void addMapping(const std::string& from, const std::vector<std::string>& to, float weight = 1.0f);
+
+    /**
+     * Equivalence class: every phrase maps to all the others
+     */
+    void addEquivalent(const std::vector<std::string>& phrases, float weight = 1.0f);
+
+    /**
+     * Solr synonyms format, one rule per line:
+     *   couch, sofa, settee          (equivalence)
+     *   nyc, big apple => new york   (one-way)
+     * Blank lines and lines starting with '#' are skipped. An optional
+     * trailing "|weight" applies to the whole rule ("tv => television|0.8").
+     * Returns the number of rules loaded.
+     */
+    size_t load(std::istream& in);
+    bool loadFile(const std::string& path);
+
+    /**
+     * Non-overlapping entries of `tokens`, leftmost then longest first
+     */
+    std::vector<SynonymMatch> match(const std::vector<std::string>& tokens) const;
+
+    /**
+     * Alternatives of exactly `phrase` (null if it is not an entry)
+     */
+    const std::vector<SynonymAlternative>* lookup(const std::string& phrase) const;
+
+    size_t size() const { return outputs_.size(); }  // Entries (distinct source spans)
+    bool empty() const { return outputs_.empty(); }
+    size_t memoryUsage() const;
+
+    /**
+     * Lowercase and split on whitespace
+     */
+    static std::vector<std::string> splitWords(const std::string& phrase);
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+    static constexpr uint64_t kEmptyKey = UINT64_MAX;
+
+    struct Edge {
+        uint64_t key = kEmptyKey;  // node << 32 | word
+        uint32_t child = kNone;
+    };
+
+    static uint64_t edgeKey(uint32_t node, uint32_t word) {
+        return static_cast<uint64_t>(node) << 32 | word;
+    }
+    size_t slot(uint64_t key) const;
+    uint32_t child(uint32_t node, uint32_t word) const;
+    uint32_t addChild(uint32_t node, uint32_t word);
+    uint32_t wordId(const std::string& word) const;
+    void grow();
+
+    // Trie node of `words`, created on demand (null words = no-op)
+    uint32_t insertPath(const std::vector<std::string>& words);
+    void addAlternative(uint32_t node, const std::string& text, float weight);
+
+    std::unordered_map<std::string, uint32_t> word_ids_;
+    std::vector<Edge> edges_;       // Power-of-two open-addressing table
+    size_t edge_count_ = 0;
+    std::vector<uint32_t> output_;  // Node -> index into outputs_ (kNone = not an entry)
+    std::vector<std::vector<SynonymAlternative>> outputs_;
+};
+
+}  // namespace rtrv_search_engine
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace rtrv_search_engine {
+
+/**
+ * Byte range [start, end) of one query-term occurrence in a document's text,
+ * as reported by Token::start_offset / Token::end_offset.
+ */
+struct TermOffset {
+    uint32_t start;
+    uint32_t end;
+};
+
+/**
+ * Multi-pattern whole-word matcher (Aho-Corasick automaton over ASCII
+ * case-folded bytes).
+ *
+ * Compile the query terms once, then scan any number of texts in a single
+ * linear pass each: one table lookup per byte, no per-word allocation.
+ * Terms may contain spaces (quoted phrases). A match must start and end on
+ * word boundaries; with `match_prefixes` it may end inside a word and is
+ * then extended to the end of that word, so stemmed terms ("jump") find
+ * their surface forms ("Jumping", "jumped").
+ */
+class TermMatcher {
+public:
+    explicit TermMatcher(const std::vector<std::string>& terms, bool match_prefixes = false);
+
+    /**
+     * True when no (non-empty) term was compiled
+     */
+    bool empty() const { return patterns_ == 0; }
+
+    /**
+     * Append the non-overlapping matches in `text` to `out`, sorted by
+     * start offset (leftmost, then longest, wins).
+     */
+    void findMatches(const std::string& text, std::vector<TermOffset>& out) const;
+
+    /**
+     * Append `text` to `out` with every match wrapped in the tags.
+     * Reserves once; preserves the original case.
+     */
+    void highlight(const std::string& text, const std::string& open_tag,
+                   const std::string& close_tag, std::string& out) const;
+
+    static bool isWordChar(char c);
+
+private:
+    static constexpr uint32_t kNoState = UINT32_MAX;
+
+    uint32_t next(uint32_t state, unsigned char byte) const {
+        return transitions_[state * num_classes_ + byte_class_[byte]];
+    }
+
+    uint16_t byte_class_[256] = {};           // Byte -> alphabet class, both cases (0 = in no term)
+    uint32_t num_classes_ = 1;
+    std::vector<uint32_t> transitions_;       // Dense DFA: state * num_classes_ + class
+    std::vector<uint32_t> depth_;             // Trie depth = length of the term ending there
+    std::vector<bool> terminal_;              // A term ends in this state
+    std::vector<uint32_t> output_link_;       // Longest proper suffix state that is terminal
+    size_t patterns_ = 0;
+    bool match_prefixes_ = false;
+};
+
+}  // namespace rtrv_search_engine
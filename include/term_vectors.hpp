@@ -0,0 +1,52 @@
+#pragma once
+
+#include "tokenizer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * Per-document term vectors: the distinct terms of each stored document
+ * with their frequencies, so more-like-this reads a document's terms
+ * instead of re-tokenizing its text.
+ *
+ * Terms are numbered in a dictionary shared by all documents, making an
+ * entry 8 bytes (term id + tf); a vector is sorted by term id. Ids are
+ * never reused, so the dictionary keeps the terms of deleted documents.
+ *
+ * Not internally synchronized: SearchEngine guards it with its mutex.
+ */
+class TermVectors {
+public:
+    struct Entry {
+        uint32_t term;       // Id in the dictionary (see term())
+        uint32_t frequency;  // Occurrences in the document
+    };
+
+    /**
+     * Store (or replace) the vector of `doc_id` from its analyzed tokens
+     */
+    void add(uint64_t doc_id, const std::vector<Token>& tokens);
+    bool remove(uint64_t doc_id);
+
+    /**
+     * Stored vector of `doc_id`, or null
+     */
+    const std::vector<Entry>* find(uint64_t doc_id) const;
+
+    const std::string& term(uint32_t id) const { return terms_[id]; }
+    size_t size() const { return vectors_.size(); }
+    size_t memoryUsage() const;
+    void clear();
+
+private:
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::vector<std::string> terms_;  // Id -> term
+    std::unordered_map<uint64_t, std::vector<Entry>> vectors_;
+};
+
+}  // namespace rtrv_search_engine
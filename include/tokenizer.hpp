@@ -48,6 +48,13 @@ public:
      */
     std::vector<Token> tokenizeWithPositions(const std::string& text);
     
+    /**
+     * Analyze one word in place as tokenize() would (lowercase, stop
+     * words, stemming), without building a token list
+     * Returns false if the word is dropped as a stop word
+     */
+    bool analyzeWord(std::string& word);
+    
     /**
      * Enable/disable lowercase normalization
      */
@@ -67,6 +74,7 @@ public:
      * Set stemmer type
      */
     void setStemmer(StemmerType type);
+    StemmerType getStemmer() const { return stemmer_type_; }
     
     /**
      * Enable/disable SIMD acceleration
@@ -115,14 +123,14 @@ private:
     bool equalsScalar(const char* a, const char* b, size_t length);
     
     /**
-     * Apply stemming to a token
+     * Apply stemming to a token, in place
      */
-    std::string applyStemming(const std::string& token);
+    void applyStemming(std::string& token);
     
     /**
-     * Simple suffix stemmer (removes common suffixes)
+     * Simple suffix stemmer (removes common suffixes), in place
      */
-    std::string simpleStem(const std::string& token);
+    void simpleStem(std::string& token);
     
     /**
      * Initialize default English stop words
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rtrv_search_engine {
+
+/**
+ * Similarity used by a vector field
+ */
+enum class VectorMetric {
+    L2,      // Euclidean distance; score = 1 / (1 + distance)
+    DOT,     // Inner product; score = dot product
+    COSINE   // Cosine similarity; vectors are normalized on insert, score = cosine
+};
+
+/**
+ * Compact storage for indexed vectors
+ */
+enum class VectorQuantization {
+    NONE,   // float32, 4 bytes per dimension
+    INT8,   // Scalar: 1 byte per dimension (4x smaller)
+    PQ      // Product: 1 byte per subspace (8-32x smaller)
+};
+
+/**
+ * SIMD distance kernels, selected at compile time with the same ladder as
+ * the tokenizer (AVX2 -> SSE -> NEON -> scalar).
+ */
+namespace vector_kernels {
+
+float dotProduct(const float* a, const float* b, size_t dimension);
+float squaredL2(const float* a, const float* b, size_t dimension);
+
+/**
+ * Scale `v` to unit length in place (no-op for the zero vector)
+ */
+void normalize(float* v, size_t dimension);
+
+/**
+ * Asymmetric kernels against uint8 codes:
+ *   dotProductU8 = sum(w[i] * codes[i])
+ *   squaredL2U8  = sum((r[i] - step[i] * codes[i])^2)
+ *   lookupSum    = sum(table[i * stride + codes[i]]) for i < count (PQ)
+ */
+float dotProductU8(const float* w, const uint8_t* codes, size_t dimension);
+float squaredL2U8(const float* r, const float* step, const uint8_t* codes, size_t dimension);
+float lookupSum(const float* table, const uint8_t* codes, size_t count, size_t stride);
+
+/**
+ * Name of the compiled kernel ("avx2", "sse", "neon", "scalar")
+ */
+const char* simdLevel();
+
+}  // namespace vector_kernels
+
+/**
+ * HNSW construction and search parameters
+ */
+struct HnswParams {
+    size_t m = 16;                 // Links per node per layer (2*m on layer 0)
+    size_t ef_construction = 200;  // Candidate list size while inserting
+    size_t ef_search = 64;         // Default candidate list size while searching
+    uint64_t seed = 42;            // Level generator seed (deterministic builds)
+
+    // Quantization: vectors stay float32 until `train_size` are indexed (or
+    // HnswIndex::quantize()), then the quantizer is trained on them and
+    // every vector is replaced by its code
+    VectorQuantization quantization = VectorQuantization::NONE;
+    size_t pq_subspaces = 0;       // PQ code bytes per vector; 0 = dimension / 4 (16x)
+    size_t train_size = 10000;
+    size_t rescore_factor = 10;    // Candidates re-scored exactly per result
+    std::string vector_file;       // Full-precision copy, mmapped for re-scoring (empty = none)
+};
+
+/**
+ * Trained scalar (INT8) or product (PQ, 256 centroids per subspace)
+ * quantizer. Distances are asymmetric: the query stays float32 and is
+ * turned into a lookup table once, so each code costs one table pass.
+ */
+class VectorQuantizer {
+public:
+    /**
+     * Per-query lookup table; `l2` selects squared distance, otherwise
+     * the table yields an inner product
+     */
+    struct QueryTable {
+        std::vector<float> values;
+        float bias = 0.0f;
+        bool l2 = false;
+    };
+
+    /**
+     * Train on `count` row-major samples. PQ falls back to the largest
+     * subspace count <= `pq_subspaces` that divides the dimension.
+     */
+    void train(VectorQuantization type, size_t dimension, const float* samples, size_t count,
+               size_t pq_subspaces, uint64_t seed);
+
+    bool trained() const { return type_ != VectorQuantization::NONE; }
+    VectorQuantization type() const { return type_; }
+    size_t codeSize() const { return type_ == VectorQuantization::PQ ? subspaces_ : dimension_; }
+
+    void encode(const float* vector, uint8_t* code) const;
+    void decode(const uint8_t* code, float* vector) const;
+
+    void prepare(const float* query, bool l2, QueryTable& table) const;
+
+    /**
+     * Squared L2 distance or inner product (per `table.l2`) to a code
+     */
+    float evaluate(const QueryTable& table, const uint8_t* code) const;
+
+    size_t memoryUsage() const;
+    void save(std::ostream& out) const;
+
+    /**
+     * Fails on an unknown type or a dimension other than `expected_dimension`
+     */
+    bool load(std::istream& in, size_t expected_dimension);
+
+private:
+    VectorQuantization type_ = VectorQuantization::NONE;
+    size_t dimension_ = 0;
+    std::vector<float> min_;        // INT8: per-dimension lower bound
+    std::vector<float> step_;       // INT8: per-dimension bucket width
+    size_t subspaces_ = 0;          // PQ
+    size_t sub_dimension_ = 0;
+    std::vector<float> codebooks_;  // PQ: [subspace][256][sub_dimension]
+};
+
+/**
+ * Append-only float32 rows in a file mapped with mmap, so full-precision
+ * vectors live in the page cache instead of the heap. Grows by doubling.
+ */
+class MappedVectorFile {
+public:
+    MappedVectorFile() = default;
+    ~MappedVectorFile();
+    MappedVectorFile(MappedVectorFile&& other) noexcept;
+    MappedVectorFile& operator=(MappedVectorFile&& other) noexcept;
+    MappedVectorFile(const MappedVectorFile&) = delete;
+    MappedVectorFile& operator=(const MappedVectorFile&) = delete;
+
+    /**
+     * Create (truncate) `path` for rows of `dimension` floats
+     */
+    bool open(const std::string& path, size_t dimension);
+    void close();
+    bool isOpen() const { return data_ != nullptr; }
+
+    bool put(uint32_t row, const float* vector);
+    const float* row(uint32_t row) const { return data_ + static_cast<size_t>(row) * dimension_; }
+    size_t rows() const { return rows_; }
+
+private:
+    bool reserve(size_t rows);
+
+    int fd_ = -1;
+    float* data_ = nullptr;
+    size_t dimension_ = 0;
+    size_t capacity_ = 0;  // Mapped rows
+    size_t rows_ = 0;      // Rows written (high-water mark)
+};
+
+struct VectorSearchHit {
+    uint64_t doc_id;
+    float distance;  // Metric distance (lower is closer)
+};
+
+/**
+ * In-memory Hierarchical Navigable Small World graph over fixed-dimension
+ * float32 vectors (Malkov & Yashunin).
+ *
+ * Not internally synchronized: SearchEngine guards it with its own mutex
+ * (writers exclusive, searches shared). Removal tombstones the node; it
+ * keeps routing searches but is never returned.
+ *
+ * With quantization, traversal uses asymmetric distances to the codes;
+ * when `vector_file` is set the best rescore_factor * k candidates are
+ * re-scored against the mmapped full-precision rows.
+ */
+class HnswIndex {
+public:
+    HnswIndex(size_t dimension, VectorMetric metric, const HnswParams& params = {});
+
+    /**
+     * Insert (or replace) the vector of `doc_id`. Returns false if the
+     * dimension does not match.
+     */
+    bool add(uint64_t doc_id, const std::vector<float>& vector);
+
+    /**
+     * Tombstone the vector of `doc_id`. Returns false if it is not indexed.
+     */
+    bool remove(uint64_t doc_id);
+
+    /**
+     * Approximate k nearest neighbours, closest first. `ef` = 0 uses
+     * params().ef_search. With a `filter`, only accepted documents are
+     * returned; the graph is still traversed through rejected ones, and
+     * when the filter is too selective to fill k from the candidate list
+     * the accepted nodes are scanned exactly.
+     */
+    std::vector<VectorSearchHit> search(const std::vector<float>& query, size_t k, size_t ef = 0,
+                                        const std::function<bool(uint64_t)>& filter = {}) const;
+
+    /**
+     * Exact k nearest neighbours by linear scan (ground truth for recall)
+     */
+    std::vector<VectorSearchHit> exactSearch(const std::vector<float>& query, size_t k,
+                                             const std::function<bool(uint64_t)>& filter = {}) const;
+
+    /**
+     * Convert a distance to a score where higher is better
+     */
+    float score(float distance) const;
+
+    /**
+     * Train the configured quantizer on the vectors indexed so far and
+     * encode them (no-op without quantization or once trained)
+     */
+    void quantize();
+    bool quantized() const { return quantizer_.trained(); }
+
+    /**
+     * The indexed vector of `doc_id` (normalized for COSINE), into `out`:
+     * full precision while unquantized or from the mmapped rows, otherwise
+     * decoded from its code. Returns false if it is not indexed.
+     */
+    bool vector(uint64_t doc_id, std::vector<float>& out) const;
+
+    bool contains(uint64_t doc_id) const { return node_of_.count(doc_id) > 0; }
+    size_t size() const { return node_of_.size(); }
+    size_t dimension() const { return dimension_; }
+    VectorMetric metric() const { return metric_; }
+    const HnswParams& params() const { return params_; }
+
+    /**
+     * Heap bytes of vectors (or codes), links and the id map; the mmapped
+     * full-precision file is not counted
+     */
+    size_t memoryUsage() const;
+
+    void clear();
+
+    /**
+     * Binary graph serialization (vectors, levels, links, tombstones)
+     */
+    void save(std::ostream& out) const;
+    bool load(std::istream& in);
+
+private:
+    struct Node {
+        uint64_t doc_id;
+        bool deleted;
+        std::vector<std::vector<uint32_t>> links;  // links[level], level 0 first
+    };
+
+    using Candidate = std::pair<float, uint32_t>;  // (distance, node)
+
+    // A prepared query: the float32 point, plus its lookup table once quantized
+    struct QueryPoint {
+        std::vector<float> point;
+        VectorQuantizer::QueryTable table;
+    };
+
+    const float* vectorOf(uint32_t node) const { return &vectors_[static_cast<size_t>(node) * dimension_]; }
+    const uint8_t* codeOf(uint32_t node) const { return &codes_[static_cast<size_t>(node) * quantizer_.codeSize()]; }
+    float distance(const float* a, const float* b) const;
+    float distance(const QueryPoint& query, uint32_t node) const;
+    float distance(uint32_t a, uint32_t b) const;
+    QueryPoint prepare(const std::vector<float>& vector) const;
+    bool rescores() const { return quantizer_.trained() && full_precision_.isOpen(); }
+
+    // Best k of the sorted candidates, re-scored at full precision if enabled
+    std::vector<VectorSearchHit> collect(const QueryPoint& query, const std::vector<Candidate>& sorted,
+                                         size_t k) const;
+    size_t maxLinks(size_t level) const { return level == 0 ? 2 * params_.m : params_.m; }
+    int randomLevel();
+
+    // Best `ef` nodes of one layer reachable from `entry`, closest first
+    std::vector<Candidate> searchLayer(const QueryPoint& query, uint32_t entry, size_t ef, size_t level,
+                                       const std::function<bool(uint64_t)>* filter,
+                                       std::vector<Candidate>* accepted) const;
+
+    // Neighbour-selection heuristic: keep candidates closer to the new node
+    // than to any already-selected neighbour (diversifies the links)
+    std::vector<uint32_t> selectNeighbors(const std::vector<Candidate>& candidates, size_t max_links) const;
+
+    void link(uint32_t from, uint32_t to, size_t level);
+
+    size_t dimension_;
+    VectorMetric metric_;
+    HnswParams params_;
+    double level_multiplier_;
+    std::mt19937_64 level_rng_;
+
+    std::vector<float> vectors_;  // node * dimension_ (until quantized)
+    VectorQuantizer quantizer_;
+    std::vector<uint8_t> codes_;  // node * codeSize() (once quantized)
+    MappedVectorFile full_precision_;
+    std::vector<Node> nodes_;
+    std::unordered_map<uint64_t, uint32_t> node_of_;  // Live doc id -> node
+    uint32_t entry_point_ = 0;
+    int max_level_ = -1;
+};
+
+}  // namespace rtrv_search_engine
@@ -1,5 +1,6 @@
  #include "search_engine.hpp"
 #include "document_loader.hpp"
+#include "sampling_profiler.hpp"
 #include <drogon/drogon.h>
 #include <iostream>
 #include <string>
@@ -7,7 +8,13 @@
 #include <memory>
 #include <chrono>
 #include <vector>
+#include <unordered_map>
 #include <filesystem>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 using namespace rtrv_search_engine;
 using namespace drogon;
@@ -48,10 +55,20 @@ void handleSearch(const HttpRequestPtr& req,
     auto page_size_str = req->getParameter("page_size");
     auto search_after_score_str = req->getParameter("search_after_score");
     auto search_after_id_str = req->getParameter("search_after_id");
+    auto ranker_str = req->getParameter("ranker");
+    auto vector_str = req->getParameter("vector");
+    auto synonyms_str = req->getParameter("synonyms");
+    auto facets_str = req->getParameter("facets");
+    auto facet_size_str = req->getParameter("facet_size");
+    auto sort_str = req->getParameter("sort");
+    auto filter_str = req->getParameter("filter");
+    auto aggs_str = req->getParameter("aggs");
+    auto collapse_str = req->getParameter("collapse");
+    auto inner_hits_str = req->getParameter("inner_hits");
     
     Json::Value response;
     
-    if (query.empty()) {
+    if (query.empty() && filter_str.empty()) {
         response["error"] = "Missing query parameter";
         auto resp = HttpResponse::newHttpJsonResponse(response);
         resp->setStatusCode(k400BadRequest);
@@ -63,6 +80,9 @@ void handleSearch(const HttpRequestPtr& req,
     if (algorithm == "tfidf") {
         options.algorithm = SearchOptions::TF_IDF;
     }
+    if (!ranker_str.empty()) {
+        options.ranker_name = ranker_str;
+    }
     if (!max_results_str.empty()) {
         options.max_results = std::stoi(max_results_str);
     }
@@ -97,6 +117,90 @@ void handleSearch(const HttpRequestPtr& req,
         options.use_cache = !(cache_str == "false" || cache_str == "0");
     }
 
+    // Query-time synonym expansion (on whenever a dictionary is installed)
+    if (!synonyms_str.empty()) {
+        options.expand_synonyms = !(synonyms_str == "false" || synonyms_str == "0");
+    }
+
+    // Facets: comma-separated keyword fields. A search never changes the
+    // schema: fields are declared with POST /fields/<name>.
+    if (!facets_str.empty()) {
+        size_t start = 0;
+        while (start < facets_str.size()) {
+            size_t comma = facets_str.find(',', start);
+            if (comma == std::string::npos) comma = facets_str.size();
+            const std::string field = facets_str.substr(start, comma - start);
+            if (!field.empty()) {
+                if (g_engine->getFieldType(field) != FieldType::KEYWORD) {
+                    response["error"] = "Facet field is not a declared keyword field: " + field +
+                                        " (declare it with POST /fields/" + field +
+                                        "; use aggs for numeric fields)";
+                    auto resp = HttpResponse::newHttpJsonResponse(response);
+                    resp->setStatusCode(k400BadRequest);
+                    callback(resp);
+                    return;
+                }
+                options.facets.push_back(field);
+            }
+            start = comma + 1;
+        }
+    }
+    if (!facet_size_str.empty()) {
+        options.facet_size = std::stoul(facet_size_str);
+    }
+
+    // Aggregations: comma-separated [name=]type:field[:param] specs
+    if (!aggs_str.empty()) {
+        size_t start = 0;
+        while (start < aggs_str.size()) {
+            size_t comma = aggs_str.find(',', start);
+            if (comma == std::string::npos) comma = aggs_str.size();
+            const std::string spec = aggs_str.substr(start, comma - start);
+            AggregationRequest aggregation;
+            if (!spec.empty()) {
+                if (!AggregationCollector::parse(spec, aggregation)) {
+                    response["error"] = "Invalid aggregation: " + spec;
+                    auto resp = HttpResponse::newHttpJsonResponse(response);
+                    resp->setStatusCode(k400BadRequest);
+                    callback(resp);
+                    return;
+                }
+                options.aggregations.push_back(aggregation);
+            }
+            start = comma + 1;
+        }
+    }
+
+    // Sort: comma-separated field[:asc|:desc] keys (declared fields or _score)
+    if (!sort_str.empty()) {
+        size_t start = 0;
+        while (start < sort_str.size()) {
+            size_t comma = sort_str.find(',', start);
+            if (comma == std::string::npos) comma = sort_str.size();
+            std::string key = sort_str.substr(start, comma - start);
+            const size_t colon = key.rfind(':');
+            const bool descending = colon != std::string::npos && key.substr(colon + 1) == "desc";
+            if (colon != std::string::npos) key.resize(colon);
+            if (!key.empty()) {
+                options.sort.push_back({key, descending});
+            }
+            start = comma + 1;
+        }
+    }
+
+    // Field collapsing: one result per value of a keyword / numeric field
+    if (!collapse_str.empty()) {
+        options.collapse_field = collapse_str;
+    }
+    if (!inner_hits_str.empty()) {
+        options.collapse_inner_hits = std::stoul(inner_hits_str);
+    }
+
+    // Filter context: non-scoring clauses, cached once they recur
+    if (!filter_str.empty()) {
+        options.filters.push_back(filter_str);
+    }
+
     // Pagination options
     if (!offset_str.empty()) {
         options.offset = std::stoul(offset_str);
@@ -108,6 +212,17 @@ void handleSearch(const HttpRequestPtr& req,
         options.search_after_id = std::stoull(search_after_id_str);
     }
 
+    // Hybrid search: comma-separated query embedding
+    if (!vector_str.empty()) {
+        size_t start = 0;
+        while (start < vector_str.size()) {
+            size_t comma = vector_str.find(',', start);
+            if (comma == std::string::npos) comma = vector_str.size();
+            options.query_vector.push_back(std::stof(vector_str.substr(start, comma - start)));
+            start = comma + 1;
+        }
+    }
+
     auto paginated = g_engine->searchPaginated(query, options);
     
     Json::Value resultsArray(Json::arrayValue);
@@ -134,6 +249,19 @@ void handleSearch(const HttpRequestPtr& req,
             }
             item["expanded_terms"] = std::move(expanded);
         }
+
+        // Collapse: the best hits of this result's group
+        if (!result.inner_hits.empty()) {
+            Json::Value inner_hits(Json::arrayValue);
+            for (const auto& inner : result.inner_hits) {
+                Json::Value hit;
+                hit["score"] = inner.score;
+                hit["document"]["id"] = (Json::UInt64)inner.document.id;
+                hit["document"]["content"] = inner.document.getAllText();
+                inner_hits.append(hit);
+            }
+            item["inner_hits"] = std::move(inner_hits);
+        }
         resultsArray.append(item);
     }
     
@@ -147,6 +275,57 @@ void handleSearch(const HttpRequestPtr& req,
     pagination["page_size"] = (Json::UInt64)paginated.pagination.page_size;
     pagination["has_next_page"] = paginated.pagination.has_next_page;
     response["pagination"] = pagination;
+
+    if (!paginated.facets.empty()) {
+        Json::Value facets;
+        for (const auto& facet : paginated.facets) {
+            Json::Value values(Json::arrayValue);
+            for (const auto& value : facet.values) {
+                Json::Value item;
+                item["value"] = value.value;
+                item["count"] = (Json::UInt64)value.count;
+                values.append(item);
+            }
+            facets[facet.field]["values"] = values;
+            facets[facet.field]["other"] = (Json::UInt64)facet.other_count;
+            facets[facet.field]["missing"] = (Json::UInt64)facet.missing_count;
+        }
+        response["facets"] = facets;
+    }
+
+    if (!paginated.aggregations.empty()) {
+        static const char* kTypes[] = {"terms", "histogram", "date_histogram", "stats", "cardinality"};
+        Json::Value aggregations;
+        for (const auto& aggregation : paginated.aggregations) {
+            Json::Value item;
+            item["type"] = kTypes[aggregation.type];
+            item["field"] = aggregation.field;
+            if (aggregation.type == AggregationRequest::STATS) {
+                item["count"] = (Json::UInt64)aggregation.stats.count;
+                item["min"] = aggregation.stats.min;
+                item["max"] = aggregation.stats.max;
+                item["sum"] = aggregation.stats.sum;
+                item["avg"] = aggregation.stats.avg;
+            } else if (aggregation.type == AggregationRequest::CARDINALITY) {
+                item["value"] = (Json::UInt64)aggregation.cardinality;
+            } else {
+                Json::Value buckets(Json::arrayValue);
+                for (const auto& bucket : aggregation.buckets) {
+                    Json::Value entry;
+                    entry["key"] = bucket.key;
+                    entry["count"] = (Json::UInt64)bucket.count;
+                    buckets.append(entry);
+                }
+                item["buckets"] = buckets;
+            }
+            if (aggregation.type == AggregationRequest::TERMS) {
+                item["other"] = (Json::UInt64)aggregation.other_count;
+            }
+            item["missing"] = (Json::UInt64)aggregation.missing_count;
+            aggregations[aggregation.name] = item;
+        }
+        response["aggregations"] = aggregations;
+    }
     
     auto resp = HttpResponse::newHttpJsonResponse(response);
     callback(resp);
@@ -166,6 +345,86 @@ void handleStats(const HttpRequestPtr&,
     callback(resp);
 }
 
+// Memory breakdown endpoint handler
+void handleMemoryStats(const HttpRequestPtr&,
+                       std::function<void(const HttpResponsePtr&)>&& callback) {
+    auto usage = g_engine->memoryUsage();
+
+    Json::Value response;
+    response["term_dictionary_bytes"] = (Json::UInt64)usage.term_dictionary_bytes;
+    response["posting_doc_id_bytes"] = (Json::UInt64)usage.posting_doc_id_bytes;
+    response["posting_tf_bytes"] = (Json::UInt64)usage.posting_tf_bytes;
+    response["posting_position_bytes"] = (Json::UInt64)usage.posting_position_bytes;
+    response["skip_data_bytes"] = (Json::UInt64)usage.skip_data_bytes;
+    response["document_store_bytes"] = (Json::UInt64)usage.document_store_bytes;
+    response["fuzzy_index_bytes"] = (Json::UInt64)usage.fuzzy_index_bytes;
+    response["query_cache_bytes"] = (Json::UInt64)usage.query_cache_bytes;
+    response["filter_cache_bytes"] = (Json::UInt64)usage.filter_cache_bytes;
+    response["vector_index_bytes"] = (Json::UInt64)usage.vector_index_bytes;
+    response["doc_values_bytes"] = (Json::UInt64)usage.doc_values_bytes;
+    response["percolator_bytes"] = (Json::UInt64)usage.percolator_bytes;
+    response["allocator_slack_bytes"] = (Json::UInt64)usage.allocator_slack_bytes;
+    response["total_bytes"] = (Json::UInt64)usage.totalBytes();
+
+    auto resp = HttpResponse::newHttpJsonResponse(response);
+    callback(resp);
+}
+
+// Index analysis endpoint handler
+void handleIndexStats(const HttpRequestPtr& req,
+                      std::function<void(const HttpResponsePtr&)>&& callback) {
+    auto top_str = req->getParameter("top");
+    size_t top_n = 10;
+    if (!top_str.empty()) top_n = std::stoul(top_str);
+    if (top_n > 1000) top_n = 1000;
+
+    auto analysis = g_engine->analyzeIndex(top_n);
+
+    Json::Value response;
+    response["terms"] = (Json::UInt64)analysis.terms;
+    response["postings"] = (Json::UInt64)analysis.postings;
+    response["positions"] = (Json::UInt64)analysis.positions;
+    response["raw_bytes"] = (Json::UInt64)analysis.raw_bytes;
+    response["encoded_bytes"] = (Json::UInt64)analysis.encoded_bytes;
+    response["compression_ratio"] = analysis.compressionRatio();
+    response["position_share"] = analysis.positionShare();
+
+    Json::Value histogram(Json::arrayValue);
+    for (const auto& length_class : analysis.length_classes) {
+        Json::Value bucket;
+        bucket["min_length"] = (Json::UInt64)length_class.min_length;
+        bucket["max_length"] = (Json::UInt64)length_class.max_length;
+        bucket["lists"] = (Json::UInt64)length_class.lists;
+        bucket["postings"] = (Json::UInt64)length_class.postings;
+        bucket["positions"] = (Json::UInt64)length_class.positions;
+        bucket["raw_bytes"] = (Json::UInt64)length_class.raw_bytes;
+        bucket["encoded_bytes"] = (Json::UInt64)length_class.encoded_bytes;
+        bucket["compression_ratio"] = length_class.compressionRatio();
+        histogram.append(bucket);
+    }
+    response["posting_length_histogram"] = histogram;
+
+    Json::Value longest(Json::arrayValue);
+    for (const auto& entry : analysis.longest_lists) {
+        Json::Value item;
+        item["term"] = entry.term;
+        item["postings"] = (Json::UInt64)entry.postings;
+        longest.append(item);
+    }
+    response["longest_lists"] = longest;
+
+    Json::Value skips;
+    skips["intersections"] = (Json::UInt64)analysis.skips.intersections;
+    skips["skips_taken"] = (Json::UInt64)analysis.skips.skips_taken;
+    skips["postings_skipped"] = (Json::UInt64)analysis.skips.postings_skipped;
+    skips["postings_scanned"] = (Json::UInt64)analysis.skips.postings_scanned;
+    skips["skipped_fraction"] = analysis.skips.skippedFraction();
+    response["skips"] = skips;
+
+    auto resp = HttpResponse::newHttpJsonResponse(response);
+    callback(resp);
+}
+
 // List documents endpoint handler
 void handleListDocuments(const HttpRequestPtr& req,
                          std::function<void(const HttpResponsePtr&)>&& callback) {
@@ -211,6 +470,19 @@ void handleCacheStats(const HttpRequestPtr&,
     response["max_size"] = (Json::UInt64)stats.max_size;
     response["hit_rate"] = stats.hit_rate;
 
+    const auto filter_stats = g_engine->getFilterCacheStats();
+    Json::Value filter_cache;
+    filter_cache["hit_count"] = (Json::UInt64)filter_stats.hit_count;
+    filter_cache["miss_count"] = (Json::UInt64)filter_stats.miss_count;
+    filter_cache["refresh_count"] = (Json::UInt64)filter_stats.refresh_count;
+    filter_cache["segments_reused"] = (Json::UInt64)filter_stats.segments_reused;
+    filter_cache["eviction_count"] = (Json::UInt64)filter_stats.eviction_count;
+    filter_cache["current_size"] = (Json::UInt64)filter_stats.current_size;
+    filter_cache["memory_bytes"] = (Json::UInt64)filter_stats.memory_bytes;
+    filter_cache["max_bytes"] = (Json::UInt64)filter_stats.max_bytes;
+    filter_cache["hit_rate"] = filter_stats.hit_rate;
+    response["filter_cache"] = filter_cache;
+
     auto resp = HttpResponse::newHttpJsonResponse(response);
     callback(resp);
 }
@@ -245,6 +517,11 @@ void handleIndex(const HttpRequestPtr& req,
     std::string content = (*json)["content"].asString();
     
     Document doc{static_cast<uint32_t>(id), std::unordered_map<std::string, std::string>{{"content", content}}};
+    if (json->isMember("vector")) {
+        for (const auto& x : (*json)["vector"]) {
+            doc.vector.push_back(x.asFloat());
+        }
+    }
     g_engine->indexDocument(doc);
     
     response["success"] = true;
@@ -325,6 +602,391 @@ void handleLoad(const HttpRequestPtr& req,
     callback(resp);
 }
 
+// Synonym dictionary endpoint handler: body {"filename": "path"} or
+// {"rules": "Solr-format lines"}, optional "mode": "query" | "index"
+void handleSynonyms(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback) {
+    auto json = req->getJsonObject();
+    Json::Value response;
+    
+    auto synonyms = std::make_shared<SynonymMap>();
+    bool success = false;
+    if (json && json->isMember("filename")) {
+        success = synonyms->loadFile((*json)["filename"].asString());
+    } else if (json && json->isMember("rules")) {
+        std::istringstream rules((*json)["rules"].asString());
+        synonyms->load(rules);
+        success = true;
+    }
+    
+    if (!success) {
+        response["error"] = "Expected \"filename\" or \"rules\" in request body";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+    
+    const bool index_time = (*json)["mode"].asString() == "index";
+    response["entries"] = (Json::UInt64)synonyms->size();
+    response["memory_bytes"] = (Json::UInt64)synonyms->memoryUsage();
+    response["mode"] = index_time ? "index" : "query";
+    g_engine->setSynonyms(synonyms, index_time ? SynonymMode::INDEX_TIME : SynonymMode::QUERY_TIME);
+    
+    response["success"] = true;
+    auto resp = HttpResponse::newHttpJsonResponse(response);
+    callback(resp);
+}
+
+// Alternatives of one dictionary entry
+void handleSynonymLookup(const HttpRequestPtr&,
+                         std::function<void(const HttpResponsePtr&)>&& callback,
+                         const std::string& term) {
+    Json::Value response;
+    response["term"] = term;
+    
+    Json::Value alternatives(Json::arrayValue);
+    auto synonyms = g_engine->getSynonyms();
+    if (synonyms) {
+        if (const auto* entry = synonyms->lookup(term)) {
+            for (const auto& alternative : *entry) {
+                Json::Value item;
+                item["text"] = alternative.text;
+                item["weight"] = alternative.weight;
+                alternatives.append(item);
+            }
+        }
+    }
+    response["synonyms"] = alternatives;
+    
+    auto resp = HttpResponse::newHttpJsonResponse(response);
+    callback(resp);
+}
+
+// Field schema endpoint handler: body {"type": "text" | "keyword" | "int64" | "double" | "date"},
+// optional "index_sort": "asc" | "desc" to keep documents ordered by the field
+void handleDefineField(const HttpRequestPtr& req,
+                       std::function<void(const HttpResponsePtr&)>&& callback,
+                       const std::string& field) {
+    static const std::unordered_map<std::string, FieldType> kTypes = {
+        {"text", FieldType::TEXT}, {"keyword", FieldType::KEYWORD}, {"int64", FieldType::INT64},
+        {"double", FieldType::DOUBLE}, {"date", FieldType::DATE}};
+    auto json = req->getJsonObject();
+    Json::Value response;
+    
+    auto type = json ? kTypes.find((*json)["type"].asString()) : kTypes.end();
+    if (type == kTypes.end()) {
+        response["error"] = "Expected \"type\": text, keyword, int64, double or date";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+    
+    g_engine->defineField(field, type->second);  // Back-fills existing documents
+    if (json->isMember("index_sort")) {
+        const std::string direction = (*json)["index_sort"].asString();
+        if (!g_engine->setIndexSort(field, direction == "desc")) {
+            response["error"] = "index_sort needs a keyword or numeric field";
+            auto resp = HttpResponse::newHttpJsonResponse(response);
+            resp->setStatusCode(k400BadRequest);
+            callback(resp);
+            return;
+        }
+        response["index_sort"] = direction == "desc" ? "desc" : "asc";
+    }
+    response["success"] = true;
+    response["field"] = field;
+    response["type"] = type->first;
+    auto resp = HttpResponse::newHttpJsonResponse(response);
+    callback(resp);
+}
+
+// Stored query (percolator) endpoint handlers
+void handleRegisterQuery(const HttpRequestPtr& req,
+                         std::function<void(const HttpResponsePtr&)>&& callback,
+                         const std::string& id_str) {
+    auto json = req->getJsonObject();
+    Json::Value response;
+    
+    uint64_t id = 0;
+    try {
+        id = std::stoull(id_str);
+    } catch (const std::exception&) {
+        json.reset();
+    }
+    if (!json || !(*json)["query"].isString() || !g_engine->registerQuery(id, (*json)["query"].asString())) {
+        response["error"] = "Expected a numeric id and {\"query\": \"...\"} with at least one clause";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+    
+    response["success"] = true;
+    response["query_id"] = (Json::UInt64)id;
+    response["registered_queries"] = (Json::UInt64)g_engine->registeredQueries();
+    auto resp = HttpResponse::newHttpJsonResponse(response);
+    callback(resp);
+}
+
+void handleUnregisterQuery(const HttpRequestPtr&,
+                           std::function<void(const HttpResponsePtr&)>&& callback,
+                           const std::string& id_str) {
+    Json::Value response;
+    
+    try {
+        uint64_t id = std::stoull(id_str);
+        response["success"] = g_engine->unregisterQuery(id);
+        response["query_id"] = (Json::UInt64)id;
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        callback(resp);
+    } catch (const std::exception&) {
+        response["error"] = "Invalid query ID";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+    }
+}
+
+void handlePercolate(const HttpRequestPtr& req,
+                     std::function<void(const HttpResponsePtr&)>&& callback) {
+    auto json = req->getJsonObject();
+    Json::Value response;
+    
+    if (!json || !(*json)["fields"].isObject()) {
+        response["error"] = "Invalid request body. Expected {\"fields\": {\"name\": \"value\", ...}}";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+    
+    Document doc;
+    for (const auto& name : (*json)["fields"].getMemberNames()) {
+        doc.fields[name] = (*json)["fields"][name].asString();
+    }
+    PercolateStats stats;
+    Json::Value matches(Json::arrayValue);
+    for (uint64_t id : g_engine->percolate(doc, &stats)) {
+        matches.append((Json::UInt64)id);
+    }
+    response["matches"] = matches;
+    response["candidates"] = (Json::UInt64)stats.candidates;
+    response["registered_queries"] = (Json::UInt64)g_engine->registeredQueries();
+    auto resp = HttpResponse::newHttpJsonResponse(response);
+    callback(resp);
+}
+
+// Continuous query (subscription) endpoint handlers. Long polls wait for
+// the next delta in g_polls; the subscription callback, run by the writing
+// request after the engine lock is released, answers them.
+struct PendingPoll {
+    uint64_t after = 0;
+    std::function<void(const HttpResponsePtr&)> callback;
+    std::atomic<bool> answered{false};
+};
+static std::mutex g_polls_mutex;
+static std::unordered_map<uint64_t, std::vector<std::shared_ptr<PendingPoll>>> g_polls;
+
+static Json::Value deltasJson(uint64_t subscription_id, uint64_t after) {
+    Json::Value response;
+    Json::Value deltas(Json::arrayValue);
+    uint64_t sequence = after;
+    for (const auto& delta : g_engine->subscriptionDeltas(subscription_id, after)) {
+        Json::Value item;
+        item["sequence"] = (Json::UInt64)delta.sequence;
+        item["reset"] = delta.reset;
+        Json::Value upserts(Json::arrayValue);
+        for (const auto& result : delta.upserts) {
+            Json::Value hit;
+            hit["score"] = result.score;
+            hit["document"]["id"] = (Json::UInt64)result.document.id;
+            hit["document"]["content"] = result.document.getAllText();
+            upserts.append(hit);
+        }
+        item["upserts"] = std::move(upserts);
+        Json::Value removed(Json::arrayValue);
+        for (uint64_t id : delta.removed) {
+            removed.append((Json::UInt64)id);
+        }
+        item["removed"] = std::move(removed);
+        deltas.append(std::move(item));
+        sequence = delta.sequence;
+    }
+    response["subscription_id"] = (Json::UInt64)subscription_id;
+    response["deltas"] = std::move(deltas);
+    response["sequence"] = (Json::UInt64)sequence;  // Next poll's `after`
+    return response;
+}
+
+static void answerPoll(uint64_t subscription_id, const std::shared_ptr<PendingPoll>& poll) {
+    if (!poll->answered.exchange(true)) {
+        poll->callback(HttpResponse::newHttpJsonResponse(deltasJson(subscription_id, poll->after)));
+    }
+}
+
+static void wakePolls(uint64_t subscription_id) {
+    std::vector<std::shared_ptr<PendingPoll>> polls;
+    {
+        std::lock_guard<std::mutex> lock(g_polls_mutex);
+        auto it = g_polls.find(subscription_id);
+        if (it == g_polls.end()) return;
+        polls.swap(it->second);
+        g_polls.erase(it);
+    }
+    for (const auto& poll : polls) {
+        answerPoll(subscription_id, poll);
+    }
+}
+
+void handleSubscribe(const HttpRequestPtr& req,
+                     std::function<void(const HttpResponsePtr&)>&& callback) {
+    auto json = req->getJsonObject();
+    Json::Value response;
+    
+    SearchOptions options;
+    std::string query;
+    if (json) {
+        query = (*json)["q"].asString();
+        options.max_results = (*json).get("k", 10).asUInt();
+        options.ranker_name = (*json)["ranker"].asString();
+        if ((*json)["filter"].isString()) {
+            options.filters.push_back((*json)["filter"].asString());
+        }
+    }
+    const uint64_t id = json ? g_engine->subscribe(query, options, [](const SubscriptionDelta& delta) {
+        wakePolls(delta.subscription_id);
+    }) : 0;
+    if (id == 0) {
+        response["error"] = "Expected {\"q\": \"...\", \"k\": 10, \"filter\": \"...\"} selecting some documents";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+    
+    response = deltasJson(id, 0);  // The initial results, as a reset
+    auto resp = HttpResponse::newHttpJsonResponse(response);
+    callback(resp);
+}
+
+void handleUnsubscribe(const HttpRequestPtr&,
+                       std::function<void(const HttpResponsePtr&)>&& callback,
+                       const std::string& id_str) {
+    Json::Value response;
+    
+    try {
+        uint64_t id = std::stoull(id_str);
+        response["success"] = g_engine->unsubscribe(id);
+        response["subscription_id"] = (Json::UInt64)id;
+        wakePolls(id);  // Waiting polls get an empty answer
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        callback(resp);
+    } catch (const std::exception&) {
+        response["error"] = "Invalid subscription ID";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+    }
+}
+
+void handleSubscriptionDeltas(const HttpRequestPtr& req,
+                              std::function<void(const HttpResponsePtr&)>&& callback,
+                              const std::string& id_str) {
+    uint64_t id = 0;
+    uint64_t after = 0;
+    double wait_seconds = 0.0;
+    try {
+        id = std::stoull(id_str);
+        const auto after_str = req->getParameter("after");
+        const auto wait_str = req->getParameter("wait");
+        after = after_str.empty() ? 0 : std::stoull(after_str);
+        wait_seconds = wait_str.empty() ? 0.0 : std::min(std::stod(wait_str), 60.0);
+    } catch (const std::exception&) {
+        Json::Value response;
+        response["error"] = "Invalid subscription ID, after or wait";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+    
+    auto poll = std::make_shared<PendingPoll>();
+    poll->after = after;
+    poll->callback = std::move(callback);
+    if (wait_seconds > 0.0) {
+        // Park first, then look: a delta published in between still wakes it
+        {
+            std::lock_guard<std::mutex> lock(g_polls_mutex);
+            g_polls[id].push_back(poll);
+        }
+        app().getLoop()->runAfter(wait_seconds, [id, poll] {
+            {
+                std::lock_guard<std::mutex> lock(g_polls_mutex);
+                auto it = g_polls.find(id);
+                if (it != g_polls.end()) {
+                    auto& polls = it->second;
+                    polls.erase(std::remove(polls.begin(), polls.end(), poll), polls.end());
+                    if (polls.empty()) g_polls.erase(it);
+                }
+            }
+            answerPoll(id, poll);  // Timed out: no deltas
+        });
+        if (g_engine->subscriptionDeltas(id, after).empty()) {
+            return;
+        }
+    }
+    answerPoll(id, poll);
+}
+
+// More-like-this endpoint handler: documents similar to a stored one
+void handleSimilar(const HttpRequestPtr& req,
+                   std::function<void(const HttpResponsePtr&)>&& callback,
+                   const std::string& id_str) {
+    Json::Value response;
+    
+    uint64_t id = 0;
+    size_t k = 10;
+    MoreLikeThisOptions options;
+    try {
+        id = std::stoull(id_str);
+        const auto k_str = req->getParameter("k");
+        const auto terms_str = req->getParameter("max_terms");
+        if (!k_str.empty()) k = std::min<size_t>(std::stoul(k_str), 1000);
+        if (!terms_str.empty()) options.max_query_terms = std::stoul(terms_str);
+    } catch (const std::exception&) {
+        response["error"] = "Invalid document ID, k or max_terms";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+    
+    Json::Value terms(Json::arrayValue);
+    for (const auto& [term, weight] : g_engine->moreLikeThisTerms(id, options)) {
+        Json::Value item;
+        item["term"] = term;
+        item["weight"] = weight;
+        terms.append(item);
+    }
+    Json::Value results(Json::arrayValue);
+    for (const auto& result : g_engine->moreLikeThis(id, k, options)) {
+        Json::Value hit;
+        hit["score"] = result.score;
+        hit["document"]["id"] = (Json::UInt64)result.document.id;
+        hit["document"]["content"] = result.document.getAllText();
+        results.append(hit);
+    }
+    response["document_id"] = (Json::UInt64)id;
+    response["terms"] = terms;
+    response["results"] = results;
+    response["total_results"] = (Json::UInt)results.size();
+    
+    auto resp = HttpResponse::newHttpJsonResponse(response);
+    callback(resp);
+}
+
 // Skip pointer rebuild endpoint handler
 void handleSkipRebuild(const HttpRequestPtr&,
                        std::function<void(const HttpResponsePtr&)>&& callback,
@@ -380,15 +1042,77 @@ void handleSkipStats(const HttpRequestPtr& req,
     callback(resp);
 }
 
+// CPU profile endpoint handler: samples all threads for `seconds` and
+// returns folded stacks (input for flamegraph.pl / speedscope)
+void handlePprof(const HttpRequestPtr& req,
+                 std::function<void(const HttpResponsePtr&)>&& callback) {
+    auto seconds_str = req->getParameter("seconds");
+    auto hz_str = req->getParameter("hz");
+    Json::Value response;
+
+    int seconds = 30;
+    int hz = SamplingProfiler::kDefaultFrequencyHz;
+    try {
+        if (!seconds_str.empty()) seconds = std::stoi(seconds_str);
+        if (!hz_str.empty()) hz = std::stoi(hz_str);
+    } catch (const std::exception&) {
+        seconds = 0;
+    }
+    if (seconds < 1 || seconds > 300 || hz < 1 || hz > 1000) {
+        response["error"] = "seconds must be 1-300 and hz 1-1000";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+
+    if (!SamplingProfiler::supported()) {
+        response["error"] = "Sampling profiler not supported on this platform";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k501NotImplemented);
+        callback(resp);
+        return;
+    }
+
+    if (!SamplingProfiler::start(hz)) {
+        response["error"] = "A profile is already being collected";
+        auto resp = HttpResponse::newHttpJsonResponse(response);
+        resp->setStatusCode(k409Conflict);
+        callback(resp);
+        return;
+    }
+
+    // Sleep off the event loop; the callback may be invoked from any thread
+    std::thread([seconds, callback = std::move(callback)]() {
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        auto profile = SamplingProfiler::stop();
+
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setContentTypeCode(CT_TEXT_PLAIN);
+        resp->addHeader("X-Profile-Samples", std::to_string(profile.samples));
+        resp->addHeader("X-Profile-Dropped", std::to_string(profile.dropped));
+        resp->setBody(std::move(profile.folded_stacks));
+        callback(resp);
+    }).detach();
+}
+
 int main(int argc, char* argv[]) {
     // Parse command line arguments
     int port = 8080;
     if (argc > 1) {
         port = std::atoi(argv[1]);
     }
+    size_t vector_dimension = 0;
+    if (argc > 2) {
+        vector_dimension = std::stoul(argv[2]);
+    }
     
     // Initialize search engine
     g_engine = std::make_shared<SearchEngine>();
+    g_engine->setStoreTermVectors(true);  // /documents/<id>/similar reads them
+    if (vector_dimension > 0) {
+        g_engine->enableVectorSearch(vector_dimension);
+    }
     
     // Load sample data from file
     std::cout << "Loading sample data from wikipedia_sample.json...\n";
@@ -423,17 +1147,24 @@ int main(int argc, char* argv[]) {
     std::cout << "=== Rtrv REST Server (Drogon) ===\n";
     std::cout << "Server will listen on http://localhost:" << port << "\n";
     std::cout << "Endpoints:\n";
-    std::cout << "  GET    /search?q=<query>&algorithm=<bm25|tfidf>&max_results=<n>&use_top_k_heap=<true|false>&cache=<true|false>\n";
+    std::cout << "  GET    /search?q=<query>&algorithm=<bm25|tfidf>&ranker=<name>&vector=<f,f,...>&synonyms=<true|false>&facets=<field,...>&aggs=<spec,...>&collapse=<field>&inner_hits=<n>&max_results=<n>&use_top_k_heap=<true|false>&cache=<true|false>\n";
     std::cout << "  GET    /stats\n";
+    std::cout << "  GET    /stats/memory\n";
+    std::cout << "  GET    /stats/index?top=<n>\n";
     std::cout << "  GET    /cache/stats\n";
     std::cout << "  DELETE /cache\n";
-    std::cout << "  POST   /index - body: {\"id\": number, \"content\": \"text\"}\n";
+    std::cout << "  POST   /index - body: {\"id\": number, \"content\": \"text\", \"vector\": [optional floats]}\n";
     std::cout << "  DELETE /delete/<id>\n";
+    std::cout << "  GET    /documents/<id>/similar?k=<n>&max_terms=<n>\n";
     std::cout << "  POST   /save - body: {\"filename\": \"path\"}\n";
     std::cout << "  POST   /load - body: {\"filename\": \"path\"}\n";
+    std::cout << "  POST   /synonyms - body: {\"filename\" | \"rules\": ..., \"mode\": \"query\"|\"index\"}\n";
+    std::cout << "  GET    /synonyms/<term>\n";
+    std::cout << "  POST   /fields/<name> - body: {\"type\": \"keyword\"|\"int64\"|\"double\"|\"date\"|\"text\", \"index_sort\": \"asc\"|\"desc\"}\n";
     std::cout << "  POST   /skip/rebuild\n";
     std::cout << "  POST   /skip/rebuild/<term>\n";
     std::cout << "  GET    /skip/stats?term=<term>\n";
+    std::cout << "  GET    /debug/pprof?seconds=<n>&hz=<n> - folded CPU stacks\n";
     std::cout << "  GET    / (web UI)\n";
     std::cout << "Press Ctrl+C to stop\n\n";
     
@@ -480,6 +1211,8 @@ int main(int argc, char* argv[]) {
     // Register routes
     app().registerHandler("/search?q={query}", &handleSearch, {Get});
     app().registerHandler("/stats", &handleStats, {Get});
+    app().registerHandler("/stats/memory", &handleMemoryStats, {Get});
+    app().registerHandler("/stats/index", &handleIndexStats, {Get});
     app().registerHandler("/documents", &handleListDocuments, {Get});
     app().registerHandler("/cache/stats", &handleCacheStats, {Get});
     app().registerHandler("/", [ui_root](const HttpRequestPtr&, std::function<void(const HttpResponsePtr&)>&& callback) {
@@ -497,12 +1230,23 @@ int main(int argc, char* argv[]) {
     app().registerHandler("/cache", &handleCacheClear, {Delete});
     app().registerHandler("/save", &handleSave, {Post});
     app().registerHandler("/load", &handleLoad, {Post});
+    app().registerHandler("/synonyms", &handleSynonyms, {Post});
+    app().registerHandler("/synonyms/{term}", &handleSynonymLookup, {Get});
+    app().registerHandler("/fields/{name}", &handleDefineField, {Post});
+    app().registerHandler("/queries/{id}", &handleRegisterQuery, {Post});
+    app().registerHandler("/queries/{id}", &handleUnregisterQuery, {Delete});
+    app().registerHandler("/percolate", &handlePercolate, {Post});
+    app().registerHandler("/subscriptions", &handleSubscribe, {Post});
+    app().registerHandler("/subscriptions/{id}", &handleUnsubscribe, {Delete});
+    app().registerHandler("/subscriptions/{id}/deltas", &handleSubscriptionDeltas, {Get});
+    app().registerHandler("/documents/{id}/similar", &handleSimilar, {Get});
     app().registerHandler("/skip/rebuild", 
         [](const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback) {
             handleSkipRebuild(req, std::move(callback), "");
         }, {Post});
     app().registerHandler("/skip/rebuild/{term}", &handleSkipRebuild, {Post});
     app().registerHandler("/skip/stats", &handleSkipStats, {Get});
+    app().registerHandler("/debug/pprof", &handlePprof, {Get});
     
     // Handle OPTIONS for CORS preflight
     app().registerHandler("/*",
@@ -0,0 +1,338 @@
+#include "aggregations.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace rtrv_search_engine {
+
+namespace {
+
+constexpr int64_t kMillisPerMinute = 60 * 1000;
+constexpr int64_t kMillisPerHour = 60 * kMillisPerMinute;
+constexpr int64_t kMillisPerDay = 24 * kMillisPerHour;
+constexpr double kBucketLimit = 9223372036854775808.0;  // 2^63, exact as a double
+
+int64_t floorDiv(int64_t value, int64_t divisor) {
+    const int64_t quotient = value / divisor;
+    return quotient * divisor > value ? quotient - 1 : quotient;
+}
+
+double numericValue(const NumericColumn& column, uint32_t doc) {
+    const int64_t key = column.keys[doc];
+    return column.type == FieldType::DOUBLE ? DocValues::keyToDouble(key) : static_cast<double>(key);
+}
+
+}  // namespace
+
+AggregationCollector::AggregationCollector(const DocValues& doc_values,
+                                           const std::vector<AggregationRequest>& requests) {
+    aggregations_.reserve(requests.size());
+    for (const auto& request : requests) {
+        Aggregation aggregation;
+        aggregation.request = request;
+        aggregation.stats.min = std::numeric_limits<double>::infinity();
+        aggregation.stats.max = -std::numeric_limits<double>::infinity();
+
+        // A field of the wrong type leaves both columns null: every hit is missing
+        const NumericColumn* numeric = doc_values.numericColumn(request.field);
+        switch (request.type) {
+            case AggregationRequest::TERMS:
+                aggregation.keyword = doc_values.keywordColumn(request.field);
+                aggregation.numeric = numeric;
+                if (aggregation.keyword) {
+                    aggregation.value_counts.assign(aggregation.keyword->values.size(), 0);
+                }
+                break;
+            case AggregationRequest::HISTOGRAM:
+                aggregation.numeric = request.interval > 0.0 ? numeric : nullptr;
+                break;
+            case AggregationRequest::DATE_HISTOGRAM:
+                aggregation.numeric = numeric && numeric->type != FieldType::DOUBLE ? numeric : nullptr;
+                break;
+            case AggregationRequest::STATS:
+                aggregation.numeric = numeric;
+                break;
+            case AggregationRequest::CARDINALITY:
+                aggregation.sketch = HyperLogLog(request.precision);
+                aggregation.keyword = doc_values.keywordColumn(request.field);
+                aggregation.numeric = numeric;
+                if (aggregation.keyword && aggregation.keyword->values.size() <= kMaxOrdinalBits) {
+                    aggregation.seen_values.assign((aggregation.keyword->values.size() + 63) / 64, 0);
+                }
+                break;
+        }
+        aggregations_.push_back(std::move(aggregation));
+    }
+}
+
+void AggregationCollector::collect(Aggregation& aggregation, uint32_t doc) {
+    if (aggregation.keyword) {
+        const uint32_t value = aggregation.keyword->valueOrdinal(doc);
+        if (value == KeywordColumn::kMissing) {
+            ++aggregation.missing;
+        } else if (aggregation.request.type == AggregationRequest::TERMS) {
+            ++aggregation.value_counts[value];
+        } else if (!aggregation.seen_values.empty()) {
+            aggregation.seen_values[value >> 6] |= uint64_t{1} << (value & 63);
+        } else {
+            aggregation.sketch.add(HyperLogLog::hashString(aggregation.keyword->values[value]));
+        }
+        return;
+    }
+    if (!aggregation.numeric || !aggregation.numeric->has(doc)) {
+        ++aggregation.missing;
+        return;
+    }
+
+    const NumericColumn& column = *aggregation.numeric;
+    switch (aggregation.request.type) {
+        case AggregationRequest::TERMS:
+            ++aggregation.counts[column.keys[doc]];
+            break;
+        case AggregationRequest::HISTOGRAM: {
+            // A bucket index outside int64 (infinities, huge values over a
+            // small interval) has no key: such a value counts as missing
+            const double bucket = std::floor(numericValue(column, doc) / aggregation.request.interval);
+            if (!(bucket >= -kBucketLimit && bucket < kBucketLimit)) {
+                ++aggregation.missing;
+                break;
+            }
+            ++aggregation.counts[static_cast<int64_t>(bucket)];
+            break;
+        }
+        case AggregationRequest::DATE_HISTOGRAM: {
+            const int64_t millis = column.keys[doc];
+            if (millis < aggregation.bucket_start || millis >= aggregation.bucket_end) {
+                aggregation.bucket_start = dateBucket(millis, aggregation.request.date_interval, aggregation.bucket_end);
+            }
+            ++aggregation.counts[aggregation.bucket_start];
+            break;
+        }
+        case AggregationRequest::STATS: {
+            const double value = numericValue(column, doc);
+            AggregationStats& stats = aggregation.stats;
+            ++stats.count;
+            stats.sum += value;
+            stats.min = std::min(stats.min, value);
+            stats.max = std::max(stats.max, value);
+            break;
+        }
+        case AggregationRequest::CARDINALITY:
+            aggregation.sketch.add(HyperLogLog::hashInteger(static_cast<uint64_t>(column.keys[doc])));
+            break;
+    }
+}
+
+int64_t AggregationCollector::dateBucket(int64_t millis, AggregationRequest::DateInterval interval, int64_t& end) {
+    switch (interval) {
+        case AggregationRequest::MINUTE:
+            end = floorDiv(millis, kMillisPerMinute) * kMillisPerMinute + kMillisPerMinute;
+            return end - kMillisPerMinute;
+        case AggregationRequest::HOUR:
+            end = floorDiv(millis, kMillisPerHour) * kMillisPerHour + kMillisPerHour;
+            return end - kMillisPerHour;
+        case AggregationRequest::DAY:
+            end = floorDiv(millis, kMillisPerDay) * kMillisPerDay + kMillisPerDay;
+            return end - kMillisPerDay;
+        case AggregationRequest::WEEK: {
+            // 1970-01-01 was a Thursday: weeks start 3 days before an epoch day multiple of 7
+            const int64_t monday = floorDiv(floorDiv(millis, kMillisPerDay) + 3, 7) * 7 - 3;
+            end = (monday + 7) * kMillisPerDay;
+            return monday * kMillisPerDay;
+        }
+        default:
+            break;
+    }
+
+    int64_t year;
+    unsigned month, day;
+    DocValues::civilFromDays(floorDiv(millis, kMillisPerDay), year, month, day);
+    const unsigned months = interval == AggregationRequest::MONTH ? 1 : interval == AggregationRequest::QUARTER ? 3 : 12;
+    const unsigned first = (month - 1) / months * months + 1;
+    const unsigned next = first + months;
+    end = DocValues::daysFromCivil(next > 12 ? year + 1 : year, next > 12 ? next - 12 : next, 1) * kMillisPerDay;
+    return DocValues::daysFromCivil(year, first, 1) * kMillisPerDay;
+}
+
+void AggregationCollector::merge(const AggregationCollector& other) {
+    for (size_t a = 0; a < aggregations_.size() && a < other.aggregations_.size(); ++a) {
+        Aggregation& into = aggregations_[a];
+        const Aggregation& from = other.aggregations_[a];
+        for (size_t v = 0; v < into.value_counts.size() && v < from.value_counts.size(); ++v) {
+            into.value_counts[v] += from.value_counts[v];
+        }
+        for (const auto& [key, count] : from.counts) {
+            into.counts[key] += count;
+        }
+        for (size_t w = 0; w < into.seen_values.size() && w < from.seen_values.size(); ++w) {
+            into.seen_values[w] |= from.seen_values[w];
+        }
+        into.sketch.merge(from.sketch);
+        into.missing += from.missing;
+        into.stats.count += from.stats.count;
+        into.stats.sum += from.stats.sum;
+        into.stats.min = std::min(into.stats.min, from.stats.min);
+        into.stats.max = std::max(into.stats.max, from.stats.max);
+    }
+}
+
+std::vector<AggregationResult> AggregationCollector::results() const {
+    std::vector<AggregationResult> results;
+    results.reserve(aggregations_.size());
+    for (const auto& aggregation : aggregations_) {
+        const AggregationRequest& request = aggregation.request;
+        AggregationResult result;
+        result.name = request.name.empty() ? request.field : request.name;
+        result.type = request.type;
+        result.field = request.field;
+        result.missing_count = aggregation.missing;
+
+        if (request.type == AggregationRequest::CARDINALITY) {
+            HyperLogLog sketch = aggregation.sketch;
+            for (size_t w = 0; w < aggregation.seen_values.size(); ++w) {
+                for (uint64_t bits = aggregation.seen_values[w]; bits != 0; bits &= bits - 1) {
+                    const size_t value = w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+                    sketch.add(HyperLogLog::hashString(aggregation.keyword->values[value]));
+                }
+            }
+            result.cardinality = sketch.estimate();
+            result.sketch = sketch.serialize();
+        } else if (request.type == AggregationRequest::STATS) {
+            result.stats = aggregation.stats;
+            if (result.stats.count > 0) {
+                result.stats.avg = result.stats.sum / result.stats.count;
+            } else {
+                result.stats.min = result.stats.max = 0.0;
+            }
+        } else if (request.type == AggregationRequest::TERMS) {
+            // Non-empty buckets; only the top `size` are ordered
+            std::vector<AggregationBucket> buckets;
+            size_t total = 0;
+            if (aggregation.keyword) {
+                for (uint32_t v = 0; v < aggregation.value_counts.size(); ++v) {
+                    if (aggregation.value_counts[v] > 0) {
+                        buckets.push_back({aggregation.keyword->values[v], 0.0, aggregation.value_counts[v]});
+                    }
+                }
+            } else if (aggregation.numeric) {
+                for (const auto& [key, count] : aggregation.counts) {
+                    const double value = aggregation.numeric->type == FieldType::DOUBLE
+                                             ? DocValues::keyToDouble(key)
+                                             : static_cast<double>(key);
+                    buckets.push_back({DocValues::formatValue(aggregation.numeric->type, key), value, count});
+                }
+            }
+            for (const auto& bucket : buckets) {
+                total += bucket.count;
+            }
+            const bool numeric = !aggregation.keyword;
+            const auto by_count = [numeric](const AggregationBucket& a, const AggregationBucket& b) {
+                if (a.count != b.count) return a.count > b.count;
+                return numeric ? a.from < b.from : a.key < b.key;
+            };
+            const size_t kept = std::min(request.size, buckets.size());
+            std::partial_sort(buckets.begin(), buckets.begin() + kept, buckets.end(), by_count);
+            buckets.resize(kept);
+            for (const auto& bucket : buckets) {
+                total -= bucket.count;
+            }
+            result.buckets = std::move(buckets);
+            result.other_count = total;
+        } else {
+            std::vector<std::pair<int64_t, size_t>> sorted(aggregation.counts.begin(), aggregation.counts.end());
+            std::sort(sorted.begin(), sorted.end());
+            result.buckets.reserve(sorted.size());
+            for (const auto& [key, count] : sorted) {
+                AggregationBucket bucket;
+                bucket.count = count;
+                if (request.type == AggregationRequest::HISTOGRAM) {
+                    bucket.from = key * request.interval;
+                    bucket.key = DocValues::formatValue(FieldType::DOUBLE, DocValues::doubleToKey(bucket.from));
+                } else {
+                    bucket.from = static_cast<double>(key);
+                    bucket.key = DocValues::formatValue(FieldType::DATE, key);
+                }
+                result.buckets.push_back(std::move(bucket));
+            }
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+bool AggregationCollector::parse(const std::string& spec, AggregationRequest& request) {
+    request = AggregationRequest();
+    std::string rest = spec;
+    const size_t equals = rest.find('=');
+    if (equals != std::string::npos && equals < rest.find(':')) {
+        request.name = rest.substr(0, equals);
+        rest = rest.substr(equals + 1);
+    }
+
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (true) {
+        const size_t colon = rest.find(':', start);
+        parts.push_back(rest.substr(start, colon - start));
+        if (colon == std::string::npos) break;
+        start = colon + 1;
+    }
+    if (parts.size() < 2 || parts.size() > 3 || parts[1].empty()) {
+        return false;
+    }
+    request.field = parts[1];
+    const std::string param = parts.size() == 3 ? parts[2] : "";
+
+    const std::string& type = parts[0];
+    if (type == "terms") {
+        request.type = AggregationRequest::TERMS;
+        if (!param.empty()) {
+            char* end = nullptr;
+            const unsigned long size = std::strtoul(param.c_str(), &end, 10);
+            if (*end != '\0' || size == 0) return false;
+            request.size = size;
+        }
+        return true;
+    }
+    if (type == "histogram") {
+        request.type = AggregationRequest::HISTOGRAM;
+        char* end = nullptr;
+        request.interval = param.empty() ? 0.0 : std::strtod(param.c_str(), &end);
+        return request.interval > 0.0 && std::isfinite(request.interval) && *end == '\0';
+    }
+    if (type == "date_histogram") {
+        static const std::pair<const char*, AggregationRequest::DateInterval> kUnits[] = {
+            {"minute", AggregationRequest::MINUTE}, {"hour", AggregationRequest::HOUR},
+            {"day", AggregationRequest::DAY},       {"week", AggregationRequest::WEEK},
+            {"month", AggregationRequest::MONTH},   {"quarter", AggregationRequest::QUARTER},
+            {"year", AggregationRequest::YEAR}};
+        request.type = AggregationRequest::DATE_HISTOGRAM;
+        for (const auto& [unit, interval] : kUnits) {
+            if (param == unit) {
+                request.date_interval = interval;
+                return true;
+            }
+        }
+        return false;
+    }
+    if (type == "stats") {
+        request.type = AggregationRequest::STATS;
+        return param.empty();
+    }
+    if (type == "cardinality") {
+        request.type = AggregationRequest::CARDINALITY;
+        if (!param.empty()) {
+            char* end = nullptr;
+            const unsigned long precision = std::strtoul(param.c_str(), &end, 10);
+            if (*end != '\0' || precision < HyperLogLog::kMinPrecision || precision > HyperLogLog::kMaxPrecision) {
+                return false;
+            }
+            request.precision = static_cast<uint8_t>(precision);
+        }
+        return true;
+    }
+    return false;
+}
+
+}  // namespace rtrv_search_engine
@@ -0,0 +1,183 @@
+#include "doc_id_iterator.hpp"
+#include <algorithm>
+
+namespace rtrv_search_engine {
+
+// ==================== BitSet ====================
+
+size_t BitSet::count() const {
+    size_t total = 0;
+    for (uint64_t word : words_) {
+        total += static_cast<size_t>(__builtin_popcountll(word));
+    }
+    return total;
+}
+
+uint32_t BitSet::nextSetBit(uint32_t from) const {
+    if (from >= size_) {
+        return npos;
+    }
+    size_t w = from >> 6;
+    uint64_t word = words_[w] & (~uint64_t{0} << (from & 63));
+    while (word == 0) {
+        if (++w == words_.size()) {
+            return npos;
+        }
+        word = words_[w];
+    }
+    const uint32_t bit = static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+    return bit < size_ ? bit : npos;
+}
+
+BitSet DocIdSetIterator::toBitSet(size_t size) {
+    BitSet bits(size);
+    for (uint32_t doc = nextDoc(); doc < size; doc = nextDoc()) {
+        bits.set(doc);
+    }
+    return bits;
+}
+
+// ==================== Leaf iterators ====================
+//
+// advance() tolerates a target at or before the current document (returns
+// the current one), which keeps the combinators below simple.
+
+uint32_t SortedDocIdIterator::nextDoc() {
+    return doc_ = index_ < docs_.size() ? docs_[index_++] : NO_MORE_DOCS;
+}
+
+uint32_t SortedDocIdIterator::advance(uint32_t target) {
+    if (index_ > 0 && doc_ >= target) {
+        return doc_;
+    }
+    if (index_ >= docs_.size()) {
+        return doc_ = NO_MORE_DOCS;
+    }
+
+    // Gallop from the current position, then binary search the last step
+    size_t step = 1;
+    size_t low = index_;
+    size_t high = index_;
+    while (high < docs_.size() && docs_[high] < target) {
+        low = high + 1;
+        high += step;
+        step *= 2;
+    }
+    high = std::min(high, docs_.size());
+    index_ = static_cast<size_t>(std::lower_bound(docs_.begin() + low, docs_.begin() + high, target) - docs_.begin());
+    return nextDoc();
+}
+
+BitSetIterator::BitSetIterator(std::shared_ptr<const BitSet> bits, size_t cost)
+    : bits_(std::move(bits)), cost_(cost) {}
+
+uint32_t BitSetIterator::advance(uint32_t target) {
+    if (started_ && doc_ >= target) {
+        return doc_;
+    }
+    started_ = true;
+    doc_ = bits_->nextSetBit(target);  // npos == NO_MORE_DOCS
+    return doc_;
+}
+
+uint32_t AllDocsIterator::advance(uint32_t target) {
+    if (started_ && doc_ >= target) {
+        return doc_;
+    }
+    started_ = true;
+    doc_ = target < max_doc_ ? target : NO_MORE_DOCS;
+    return doc_;
+}
+
+// ==================== Combinators ====================
+
+ConjunctionIterator::ConjunctionIterator(std::vector<std::unique_ptr<DocIdSetIterator>> children)
+    : children_(std::move(children)) {
+    std::sort(children_.begin(), children_.end(),
+              [](const auto& a, const auto& b) { return a->cost() < b->cost(); });
+    lead_ = children_.front().get();
+}
+
+uint32_t ConjunctionIterator::align(uint32_t target) {
+    uint32_t doc = target;
+    while (doc != NO_MORE_DOCS) {
+        bool aligned = true;
+        for (size_t i = 1; i < children_.size(); ++i) {
+            const uint32_t other = children_[i]->advance(doc);
+            if (other != doc) {
+                // Leapfrog: the lead jumps to where the follower landed
+                doc = lead_->advance(other);
+                aligned = false;
+                break;
+            }
+        }
+        if (aligned) {
+            return doc;
+        }
+    }
+    return doc;
+}
+
+DisjunctionIterator::DisjunctionIterator(std::vector<std::unique_ptr<DocIdSetIterator>> children)
+    : children_(std::move(children)) {
+    for (const auto& child : children_) {
+        cost_ += child->cost();
+    }
+}
+
+namespace {
+
+// std heap functions build a max-heap; invert for the smallest docID on top
+bool laterDoc(const std::unique_ptr<DocIdSetIterator>& a, const std::unique_ptr<DocIdSetIterator>& b) {
+    return a->docID() > b->docID();
+}
+
+}  // namespace
+
+uint32_t DisjunctionIterator::top() const {
+    return children_.empty() ? NO_MORE_DOCS : children_.front()->docID();
+}
+
+uint32_t DisjunctionIterator::nextDoc() {
+    if (!started_) {
+        return advance(0);
+    }
+    if (doc_ == NO_MORE_DOCS) {
+        return doc_;
+    }
+    while (top() == doc_) {
+        std::pop_heap(children_.begin(), children_.end(), laterDoc);
+        children_.back()->nextDoc();
+        std::push_heap(children_.begin(), children_.end(), laterDoc);
+    }
+    return doc_ = top();
+}
+
+uint32_t DisjunctionIterator::advance(uint32_t target) {
+    if (started_ && doc_ >= target) {
+        return doc_;
+    }
+    if (!started_) {
+        started_ = true;
+        for (auto& child : children_) {
+            child->advance(target);
+        }
+        std::make_heap(children_.begin(), children_.end(), laterDoc);
+    } else {
+        while (top() < target) {
+            std::pop_heap(children_.begin(), children_.end(), laterDoc);
+            children_.back()->advance(target);
+            std::push_heap(children_.begin(), children_.end(), laterDoc);
+        }
+    }
+    return doc_ = top();
+}
+
+uint32_t ExclusionIterator::skipExcluded(uint32_t doc) {
+    while (doc != NO_MORE_DOCS && exclude_->advance(doc) == doc) {
+        doc = include_->nextDoc();
+    }
+    return doc;
+}
+
+}  // namespace rtrv_search_engine
@@ -0,0 +1,842 @@
+#include "doc_values.hpp"
+#include "memory_usage.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace rtrv_search_engine {
+
+// ==================== Schema ====================
+
+bool DocValues::defineField(const std::string& field, FieldType type) {
+    if (fieldType(field) == type) {
+        return false;
+    }
+    keyword_columns_.erase(field);
+    numeric_columns_.erase(field);
+    if (field == index_sort_.field) {
+        setIndexSort({});  // Its column is gone
+    }
+    if (type == FieldType::KEYWORD) {
+        keyword_columns_[field].ords.assign(doc_ids_.size(), KeywordColumn::kMissing);
+    } else if (isNumericType(type)) {
+        NumericColumn& column = numeric_columns_[field];
+        column.type = type;
+        column.keys.assign(doc_ids_.size(), 0);
+        column.present.assign(doc_ids_.size(), 0);
+    }
+    return true;
+}
+
+FieldType DocValues::fieldType(const std::string& field) const {
+    if (keyword_columns_.count(field) > 0) {
+        return FieldType::KEYWORD;
+    }
+    auto it = numeric_columns_.find(field);
+    return it != numeric_columns_.end() ? it->second.type : FieldType::TEXT;
+}
+
+const KeywordColumn* DocValues::keywordColumn(const std::string& field) const {
+    auto it = keyword_columns_.find(field);
+    return it != keyword_columns_.end() ? &it->second : nullptr;
+}
+
+const NumericColumn* DocValues::numericColumn(const std::string& field) const {
+    auto it = numeric_columns_.find(field);
+    return it != numeric_columns_.end() ? &it->second : nullptr;
+}
+
+// ==================== Value parsing ====================
+
+namespace {
+
+std::string trimmed(const std::string& text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) ++begin;
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) --end;
+    return text.substr(begin, end - begin);
+}
+
+bool parseInt64(const std::string& text, int64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    errno = 0;
+    char* end = nullptr;
+    const long long parsed = std::strtoll(text.c_str(), &end, 10);
+    if (errno != 0 || end != text.c_str() + text.size()) {
+        return false;
+    }
+    value = static_cast<int64_t>(parsed);
+    return true;
+}
+
+// Fixed-width decimal field at text[pos, pos + width)
+bool digits(const std::string& text, size_t pos, size_t width, int& value) {
+    if (pos + width > text.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = pos; i < pos + width; ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(text[i]))) return false;
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+// YYYY-MM-DD[(T| )HH:MM[:SS[.fff]]][Z|(+|-)HH:MM] -> epoch millis
+bool parseIsoDate(const std::string& text, int64_t& millis) {
+    static const int kDaysInMonth[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int year, month, day;
+    if (!digits(text, 0, 4, year) || text.size() < 10 || text[4] != '-' || !digits(text, 5, 2, month) ||
+        text[7] != '-' || !digits(text, 8, 2, day) || month < 1 || month > 12 || day < 1 ||
+        day > kDaysInMonth[month - 1]) {
+        return false;
+    }
+
+    int hour = 0, minute = 0, second = 0, fraction_ms = 0;
+    int64_t offset_minutes = 0;
+    size_t pos = 10;
+    if (pos < text.size() && (text[pos] == 'T' || text[pos] == ' ')) {
+        if (!digits(text, pos + 1, 2, hour) || pos + 3 >= text.size() || text[pos + 3] != ':' ||
+            !digits(text, pos + 4, 2, minute) || hour > 23 || minute > 59) {
+            return false;
+        }
+        pos += 6;
+        if (pos < text.size() && text[pos] == ':') {
+            if (!digits(text, pos + 1, 2, second) || second > 60) return false;
+            pos += 3;
+            if (pos < text.size() && text[pos] == '.') {
+                int scale = 100;
+                for (++pos; pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])); ++pos) {
+                    fraction_ms += (text[pos] - '0') * scale;
+                    scale /= 10;
+                }
+            }
+        }
+        if (pos < text.size() && text[pos] == 'Z') {
+            ++pos;
+        } else if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+            int offset_hours, offset_mins;
+            if (!digits(text, pos + 1, 2, offset_hours) || pos + 3 >= text.size() || text[pos + 3] != ':' ||
+                !digits(text, pos + 4, 2, offset_mins)) {
+                return false;
+            }
+            offset_minutes = (text[pos] == '-' ? -1 : 1) * (offset_hours * 60 + offset_mins);
+            pos += 6;
+        }
+    }
+    if (pos != text.size()) {
+        return false;
+    }
+
+    const int64_t seconds = DocValues::daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400 +
+                            hour * 3600 + minute * 60 + second - offset_minutes * 60;
+    millis = seconds * 1000 + fraction_ms;
+    return true;
+}
+
+}  // namespace
+
+// H. Hinnant's algorithms
+int64_t DocValues::daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void DocValues::civilFromDays(int64_t days, int64_t& y, unsigned& m, unsigned& d) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+std::string DocValues::formatValue(FieldType type, int64_t key) {
+    if (type == FieldType::DOUBLE) {
+        const double value = keyToDouble(key);
+        if (value == std::trunc(value) && std::fabs(value) < 1e15) {
+            return std::to_string(static_cast<int64_t>(value));
+        }
+        // Shortest form that reads back the same
+        char buffer[32];
+        for (int precision = 1; precision <= 17; ++precision) {
+            std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+            if (std::strtod(buffer, nullptr) == value) {
+                break;
+            }
+        }
+        return buffer;
+    }
+    if (type != FieldType::DATE) {
+        return std::to_string(key);
+    }
+
+    const int64_t kMillisPerDay = 86400000;
+    const int64_t days = key >= 0 ? key / kMillisPerDay : (key - kMillisPerDay + 1) / kMillisPerDay;
+    const int64_t millis = key - days * kMillisPerDay;
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+    char buffer[40];
+    if (millis == 0) {
+        std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u", static_cast<long long>(year), month, day);
+    } else {
+        const int64_t seconds = millis / 1000;
+        std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02uT%02d:%02d:%02d", static_cast<long long>(year), month,
+                      day, static_cast<int>(seconds / 3600), static_cast<int>(seconds / 60 % 60),
+                      static_cast<int>(seconds % 60));
+        std::string text = buffer;
+        if (millis % 1000 != 0) {
+            std::snprintf(buffer, sizeof(buffer), ".%03d", static_cast<int>(millis % 1000));
+            text += buffer;
+        }
+        return text + "Z";
+    }
+    return buffer;
+}
+
+int64_t DocValues::doubleToKey(double value) {
+    value += 0.0;  // -0.0 -> +0.0
+    int64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    // Negative doubles order backwards as integers: flip all but the sign bit
+    return bits ^ ((bits >> 63) & INT64_MAX);
+}
+
+bool DocValues::rangeKeys(FieldType type, const std::string& lower_text, bool include_lower,
+                          const std::string& upper_text, bool include_upper, int64_t& lower, int64_t& upper) {
+    lower = std::numeric_limits<int64_t>::min();
+    upper = std::numeric_limits<int64_t>::max();
+    if (!isNumericType(type) || (!lower_text.empty() && !parseValue(type, lower_text, lower)) ||
+        (!upper_text.empty() && !parseValue(type, upper_text, upper))) {
+        return false;
+    }
+    if (!lower_text.empty() && !include_lower) {
+        if (lower == std::numeric_limits<int64_t>::max()) {
+            return false;
+        }
+        ++lower;
+    }
+    if (!upper_text.empty() && !include_upper) {
+        if (upper == std::numeric_limits<int64_t>::min()) {
+            return false;
+        }
+        --upper;
+    }
+    return lower <= upper;
+}
+
+double DocValues::keyToDouble(int64_t key) {
+    const int64_t bits = key ^ ((key >> 63) & INT64_MAX);  // Self-inverse
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool DocValues::parseValue(FieldType type, const std::string& text, int64_t& key) {
+    const std::string value = trimmed(text);
+    switch (type) {
+        case FieldType::INT64:
+            return parseInt64(value, key);
+        case FieldType::DOUBLE: {
+            if (value.empty()) return false;
+            char* end = nullptr;
+            const double parsed = std::strtod(value.c_str(), &end);
+            if (end != value.c_str() + value.size() || std::isnan(parsed)) {
+                return false;
+            }
+            key = doubleToKey(parsed);
+            return true;
+        }
+        case FieldType::DATE:
+            return parseInt64(value, key) || parseIsoDate(value, key);  // Epoch millis or ISO-8601
+        default:
+            return false;
+    }
+}
+
+// ==================== Documents ====================
+
+uint32_t DocValues::assignOrdinal(uint64_t doc_id) {
+    const uint32_t existing = ordinal(doc_id);
+    if (existing != kNoOrdinal) {
+        return existing;
+    }
+
+    const uint32_t created = static_cast<uint32_t>(doc_ids_.size());
+    doc_ids_.push_back(doc_id);
+    if (doc_id < kDirectIds) {
+        if (doc_id >= direct_.size()) {
+            // Amortized growth: sequential ids must not resize on every insert
+            const size_t grown = std::max<size_t>(doc_id + 1, direct_.size() * 2);
+            direct_.resize(std::min<size_t>(grown, kDirectIds), kNoOrdinal);
+        }
+        direct_[doc_id] = created;
+    } else {
+        sparse_[doc_id] = created;
+    }
+
+    for (auto& [field, column] : keyword_columns_) {
+        column.ords.push_back(KeywordColumn::kMissing);
+    }
+    for (auto& [field, column] : numeric_columns_) {
+        column.keys.push_back(0);
+        column.present.push_back(0);
+    }
+    if (indexSort()) {
+        order_state_.push_back(kRemoved);  // markUnsorted() lists it once it has values
+    }
+    return created;
+}
+
+void DocValues::addDocument(uint64_t doc_id, const Document& doc) {
+    if (empty()) {
+        return;
+    }
+
+    const uint32_t row = assignOrdinal(doc_id);
+    touchSegment(row);
+    for (auto& [field, column] : keyword_columns_) {
+        auto it = doc.fields.find(field);
+        if (it == doc.fields.end() || it->second.empty()) {
+            column.ords[row] = KeywordColumn::kMissing;
+            continue;
+        }
+        const auto inserted = column.value_ids.try_emplace(it->second, static_cast<uint32_t>(column.values.size()));
+        if (inserted.second) {
+            column.values.push_back(it->second);
+        }
+        column.ords[row] = inserted.first->second;
+    }
+    for (auto& [field, column] : numeric_columns_) {
+        auto it = doc.fields.find(field);
+        int64_t key = 0;
+        column.present[row] = it != doc.fields.end() && parseValue(column.type, it->second, key);
+        column.keys[row] = key;
+        column.dirty |= column.present[row] != 0;
+    }
+
+    if (indexSort()) {
+        markUnsorted(row);
+        if (unsorted_.size() > kMinResort && unsorted_.size() * 8 > doc_ids_.size()) {
+            applyIndexSort();
+        }
+    }
+}
+
+void DocValues::removeDocument(uint64_t doc_id) {
+    const uint32_t doc = ordinal(doc_id);
+    if (doc == kNoOrdinal) {
+        return;
+    }
+    for (auto& [field, column] : keyword_columns_) {
+        column.ords[doc] = KeywordColumn::kMissing;
+    }
+    for (auto& [field, column] : numeric_columns_) {
+        column.present[doc] = 0;  // Its range-index entry is skipped from now on
+    }
+    if (inIndexOrder(doc)) {
+        order_state_[doc] = kRemoved;  // Its values no longer match its position
+    }
+    touchSegment(doc);
+}
+
+void DocValues::touchSegment(uint32_t ordinal) {
+    const size_t segment = ordinal >> kSegmentBits;
+    if (segment >= segment_epochs_.size()) {
+        segment_epochs_.resize(segment + 1, 0);
+    }
+    segment_epochs_[segment] = ++write_epoch_;
+}
+
+// ==================== Index sort ====================
+
+void DocValues::markUnsorted(uint32_t ordinal) {
+    if (order_state_[ordinal] != kUnsorted) {
+        order_state_[ordinal] = kUnsorted;
+        unsorted_.push_back(ordinal);
+    }
+}
+
+bool DocValues::setIndexSort(const SortField& sort) {
+    if (!sort.field.empty() && !keywordColumn(sort.field) && !numericColumn(sort.field)) {
+        return false;
+    }
+    index_sort_ = sort;
+    order_state_.clear();
+    unsorted_.clear();
+    if (indexSort()) {
+        applyIndexSort();
+    }
+    return true;
+}
+
+void DocValues::applyIndexSort() {
+    const uint32_t count = static_cast<uint32_t>(doc_ids_.size());
+    std::vector<uint32_t> order(count);  // New ordinal -> old ordinal
+    for (uint32_t i = 0; i < count; ++i) order[i] = i;
+    const FieldComparator comparator(*this, {index_sort_});
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return comparator({doc_ids_[a], a, 0.0}, {doc_ids_[b], b, 0.0});  // Ties by doc id
+    });
+
+    const auto permute = [&](auto& column) {
+        std::remove_reference_t<decltype(column)> permuted(column.size());
+        for (uint32_t i = 0; i < count; ++i) permuted[i] = column[order[i]];
+        column = std::move(permuted);
+    };
+    permute(doc_ids_);
+    for (auto& [field, column] : keyword_columns_) {
+        permute(column.ords);
+    }
+    for (auto& [field, column] : numeric_columns_) {
+        permute(column.keys);
+        permute(column.present);
+        column.dirty = true;  // The range index holds ordinals
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint64_t doc_id = doc_ids_[i];
+        if (doc_id < kDirectIds) {
+            direct_[doc_id] = i;
+        } else {
+            sparse_[doc_id] = i;
+        }
+    }
+
+    order_state_.assign(count, kInOrder);
+    unsorted_.clear();
+    ++ordinal_generation_;
+}
+
+// ==================== Ranges ====================
+
+std::unique_ptr<DocIdSetIterator> DocValues::rangeIterator(const std::string& field, int64_t lower,
+                                                           int64_t upper) const {
+    const NumericColumn* column = numericColumn(field);
+    if (!column || lower > upper) {
+        return std::make_unique<SortedDocIdIterator>(std::vector<uint32_t>{});
+    }
+
+    {
+        // Writers hold the engine lock exclusively, so only concurrent
+        // readers can race here, and only on the rebuild
+        std::lock_guard<std::mutex> lock(range_index_mutex_);
+        if (column->dirty) {
+            column->sorted.clear();
+            for (uint32_t doc = 0; doc < column->present.size(); ++doc) {
+                if (column->present[doc]) {
+                    column->sorted.emplace_back(column->keys[doc], doc);
+                }
+            }
+            std::sort(column->sorted.begin(), column->sorted.end());
+            column->dirty = false;
+        }
+    }
+
+    const auto& sorted = column->sorted;
+    const auto first = std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(lower, uint32_t{0}));
+    const auto last = std::upper_bound(first, sorted.end(), std::make_pair(upper, UINT32_MAX));
+    const size_t matches = static_cast<size_t>(last - first);
+
+    // Dense ranges: a bitset is smaller than the ordinal list and needs no sort
+    if (matches * 32 > doc_ids_.size()) {
+        auto bits = std::make_shared<BitSet>(doc_ids_.size());
+        for (auto it = first; it != last; ++it) {
+            if (column->present[it->second]) bits->set(it->second);
+        }
+        return std::make_unique<BitSetIterator>(std::move(bits), matches);
+    }
+
+    std::vector<uint32_t> docs;
+    docs.reserve(matches);
+    for (auto it = first; it != last; ++it) {
+        if (column->present[it->second]) docs.push_back(it->second);
+    }
+    std::sort(docs.begin(), docs.end());
+    return std::make_unique<SortedDocIdIterator>(std::move(docs));
+}
+
+// ==================== Keyword filters ====================
+
+std::string DocValues::normalizeKeyword(const std::string& text) {
+    std::string normalized;
+    normalized.reserve(text.size());
+    bool gap = false;
+    for (unsigned char ch : text) {
+        if (std::isalnum(ch) || ch == '_') {
+            if (gap && !normalized.empty()) {
+                normalized.push_back(' ');
+            }
+            normalized.push_back(static_cast<char>(std::tolower(ch)));
+            gap = false;
+        } else {
+            gap = true;
+        }
+    }
+    return normalized;
+}
+
+std::unique_ptr<DocIdSetIterator> DocValues::keywordIterator(const std::string& field,
+                                                             const std::string& value) const {
+    const KeywordColumn* column = keywordColumn(field);
+    if (!column) {
+        return std::make_unique<SortedDocIdIterator>(std::vector<uint32_t>{});
+    }
+
+    // Several stored spellings may normalize to the same value
+    const std::string wanted = normalizeKeyword(value);
+    std::vector<uint8_t> matching(column->values.size(), 0);
+    bool any = false;
+    for (size_t v = 0; v < column->values.size(); ++v) {
+        matching[v] = normalizeKeyword(column->values[v]) == wanted;
+        any |= matching[v] != 0;
+    }
+    if (!any) {
+        return std::make_unique<SortedDocIdIterator>(std::vector<uint32_t>{});
+    }
+
+    std::vector<uint32_t> docs;
+    for (uint32_t doc = 0; doc < column->ords.size(); ++doc) {
+        const uint32_t v = column->ords[doc];
+        if (v != KeywordColumn::kMissing && matching[v]) {
+            docs.push_back(doc);
+        }
+    }
+    if (docs.size() * 32 > doc_ids_.size()) {
+        auto bits = std::make_shared<BitSet>(doc_ids_.size());
+        for (uint32_t doc : docs) bits->set(doc);
+        return std::make_unique<BitSetIterator>(std::move(bits), docs.size());
+    }
+    return std::make_unique<SortedDocIdIterator>(std::move(docs));
+}
+
+size_t DocValues::memoryUsage() const {
+    using namespace memory_accounting;
+    size_t bytes = vectorUsedBytes(direct_) + hashTableBytes(sparse_) + vectorUsedBytes(doc_ids_) +
+                   hashTableBytes(keyword_columns_);
+    for (const auto& [field, column] : keyword_columns_) {
+        bytes += stringHeapBytes(field) + vectorUsedBytes(column.ords) + vectorUsedBytes(column.values) +
+                 hashTableBytes(column.value_ids);
+        for (const auto& value : column.values) {
+            bytes += 2 * stringHeapBytes(value);  // Dictionary entry + hash key
+        }
+    }
+    bytes += hashTableBytes(numeric_columns_);
+    for (const auto& [field, column] : numeric_columns_) {
+        bytes += stringHeapBytes(field) + vectorUsedBytes(column.keys) + vectorUsedBytes(column.present) +
+                 vectorUsedBytes(column.sorted);
+    }
+    return bytes + vectorUsedBytes(order_state_) + vectorUsedBytes(unsorted_) + vectorUsedBytes(segment_epochs_);
+}
+
+void DocValues::clear() {
+    for (auto& [field, column] : keyword_columns_) {
+        column = KeywordColumn();
+    }
+    for (auto& [field, column] : numeric_columns_) {
+        column.keys.clear();
+        column.present.clear();
+        column.sorted.clear();
+        column.dirty = false;
+    }
+    direct_.clear();
+    sparse_.clear();
+    doc_ids_.clear();
+    order_state_.clear();
+    unsorted_.clear();
+    segment_epochs_.clear();
+    ++ordinal_generation_;
+}
+
+// ==================== Sorting ====================
+
+FieldComparator::FieldComparator(const DocValues& doc_values, const std::vector<SortField>& sort) {
+    keys_.reserve(sort.size());
+    for (const auto& field : sort) {
+        Key key;
+        key.by_score = field.field == "_score";
+        key.numeric = doc_values.numericColumn(field.field);
+        key.keyword = doc_values.keywordColumn(field.field);
+        key.descending = field.descending;
+        keys_.push_back(key);  // Undeclared fields compare equal (all missing)
+    }
+}
+
+int FieldComparator::compare(const Key& key, const FieldHit& a, const FieldHit& b) {
+    int order = 0;
+    if (key.by_score) {
+        order = a.score < b.score ? -1 : (a.score > b.score ? 1 : 0);
+    } else if (key.numeric) {
+        const bool has_a = key.numeric->has(a.ordinal);
+        const bool has_b = key.numeric->has(b.ordinal);
+        if (!has_a || !has_b) {
+            return has_a == has_b ? 0 : (has_a ? -1 : 1);  // Missing last
+        }
+        const int64_t ka = key.numeric->keys[a.ordinal];
+        const int64_t kb = key.numeric->keys[b.ordinal];
+        order = ka < kb ? -1 : (ka > kb ? 1 : 0);
+    } else if (key.keyword) {
+        const uint32_t va = key.keyword->valueOrdinal(a.ordinal);
+        const uint32_t vb = key.keyword->valueOrdinal(b.ordinal);
+        if (va == vb) {
+            return 0;
+        }
+        if (va == KeywordColumn::kMissing || vb == KeywordColumn::kMissing) {
+            return va == KeywordColumn::kMissing ? 1 : -1;
+        }
+        order = key.keyword->values[va].compare(key.keyword->values[vb]);
+    }
+    return key.descending ? -order : order;
+}
+
+// ==================== Collapsing ====================
+
+TopGroupsCollector::TopGroupsCollector(FieldComparator comparator, const DocValues& doc_values,
+                                       const std::string& field, size_t k, size_t per_group)
+    : comparator_(std::move(comparator)),
+      keyword_(doc_values.keywordColumn(field)),
+      numeric_(doc_values.numericColumn(field)),
+      k_(k),
+      per_group_(std::max<size_t>(per_group, 1)) {}
+
+bool TopGroupsCollector::groupKey(uint32_t ordinal, int64_t& key) const {
+    if (keyword_) {
+        const uint32_t value = keyword_->valueOrdinal(ordinal);
+        key = value;
+        return value != KeywordColumn::kMissing;
+    }
+    if (numeric_ && numeric_->has(ordinal)) {
+        key = numeric_->keys[ordinal];
+        return true;
+    }
+    return false;  // Undeclared field: nothing collapses
+}
+
+void TopGroupsCollector::collect(const FieldHit& hit) {
+    if (k_ == 0) {
+        return;
+    }
+    int64_t key = 0;
+    const bool keyed = groupKey(hit.ordinal, key);
+    if (keyed) {
+        auto it = kept_.find(key);
+        if (it != kept_.end()) {
+            Slot& slot = slots_[it->second];
+            addHit(slot.group, hit);
+            if (comparator_(hit, slot.group.head)) {
+                slot.group.head = hit;
+                siftDown(slot.heap_index);  // Better now: away from the root
+            }
+            return;
+        }
+    }
+
+    size_t index;
+    const bool appended = heap_.size() < k_;
+    if (appended) {
+        index = slots_.size();
+        slots_.emplace_back();
+        slots_[index].heap_index = heap_.size();
+        heap_.push_back(index);
+    } else if (comparator_(hit, slots_[heap_.front()].group.head)) {
+        index = heap_.front();  // Displace the worst group
+        const Slot& evicted = slots_[index];
+        if (evicted.keyed) {
+            kept_.erase(evicted.key);
+            if (per_group_ > 1) {
+                dropped_.insert(evicted.key);
+            }
+        }
+    } else {
+        if (keyed && per_group_ > 1) {
+            dropped_.insert(key);
+        }
+        return;
+    }
+
+    Slot& slot = slots_[index];
+    slot.group.head = hit;
+    slot.group.hits.clear();
+    addHit(slot.group, hit);
+    slot.key = key;
+    slot.keyed = keyed;
+    slot.partial = keyed && dropped_.count(key) > 0;
+    if (keyed) {
+        kept_[key] = index;
+    }
+    if (appended) {
+        siftUp(slot.heap_index);
+    } else {
+        siftDown(slot.heap_index);  // Replaced the root
+    }
+}
+
+void TopGroupsCollector::addHit(Group& group, const FieldHit& hit) {
+    auto& hits = group.hits;
+    if (hits.size() < per_group_) {
+        hits.push_back(hit);
+        std::push_heap(hits.begin(), hits.end(), comparator_);
+    } else if (comparator_(hit, hits.front())) {
+        std::pop_heap(hits.begin(), hits.end(), comparator_);
+        hits.back() = hit;
+        std::push_heap(hits.begin(), hits.end(), comparator_);
+    }
+}
+
+bool TopGroupsCollector::worse(size_t a, size_t b) const {
+    return comparator_(slots_[heap_[b]].group.head, slots_[heap_[a]].group.head);
+}
+
+void TopGroupsCollector::swapHeap(size_t a, size_t b) {
+    std::swap(heap_[a], heap_[b]);
+    slots_[heap_[a]].heap_index = a;
+    slots_[heap_[b]].heap_index = b;
+}
+
+void TopGroupsCollector::siftUp(size_t pos) {
+    while (pos > 0) {
+        const size_t parent = (pos - 1) / 2;
+        if (!worse(pos, parent)) {
+            break;
+        }
+        swapHeap(pos, parent);
+        pos = parent;
+    }
+}
+
+void TopGroupsCollector::siftDown(size_t pos) {
+    for (;;) {
+        const size_t left = 2 * pos + 1;
+        if (left >= heap_.size()) {
+            break;
+        }
+        const size_t right = left + 1;
+        const size_t child = right < heap_.size() && worse(right, left) ? right : left;
+        if (!worse(child, pos)) {
+            break;
+        }
+        swapHeap(pos, child);
+        pos = child;
+    }
+}
+
+bool TopGroupsCollector::beginRecollect() {
+    bool any = false;
+    for (size_t index : heap_) {
+        if (slots_[index].partial) {
+            slots_[index].group.hits.clear();
+            any = true;
+        }
+    }
+    return any;
+}
+
+bool TopGroupsCollector::recollects(uint32_t ordinal) const {
+    int64_t key = 0;
+    if (!groupKey(ordinal, key)) {
+        return false;
+    }
+    auto it = kept_.find(key);
+    return it != kept_.end() && slots_[it->second].partial;
+}
+
+void TopGroupsCollector::recollect(const FieldHit& hit) {
+    int64_t key = 0;
+    if (groupKey(hit.ordinal, key)) {
+        auto it = kept_.find(key);
+        if (it != kept_.end()) {
+            addHit(slots_[it->second].group, hit);
+        }
+    }
+}
+
+std::vector<TopGroupsCollector::Group> TopGroupsCollector::sorted() {
+    std::vector<Group> groups;
+    groups.reserve(heap_.size());
+    for (size_t index : heap_) {
+        Group& group = slots_[index].group;
+        std::sort_heap(group.hits.begin(), group.hits.end(), comparator_);
+        groups.push_back(std::move(group));
+    }
+    std::sort(groups.begin(), groups.end(),
+              [this](const Group& a, const Group& b) { return comparator_(a.head, b.head); });
+    heap_.clear();
+    slots_.clear();
+    kept_.clear();
+    dropped_.clear();
+    return groups;
+}
+
+// ==================== Facets ====================
+
+FacetCounter::FacetCounter(const DocValues& doc_values, const std::vector<std::string>& fields)
+    : doc_values_(doc_values) {
+    facets_.reserve(fields.size());
+    for (const auto& field : fields) {
+        const KeywordColumn* column = doc_values.keywordColumn(field);
+        facets_.push_back({field, column, std::vector<uint32_t>(column ? column->values.size() : 0, 0)});
+    }
+}
+
+void FacetCounter::merge(const FacetCounter& other) {
+    for (size_t f = 0; f < facets_.size() && f < other.facets_.size(); ++f) {
+        auto& counts = facets_[f].counts;
+        const auto& other_counts = other.facets_[f].counts;
+        for (size_t v = 0; v < counts.size() && v < other_counts.size(); ++v) {
+            counts[v] += other_counts[v];
+        }
+        facets_[f].missing += other.facets_[f].missing;
+    }
+}
+
+std::vector<FacetResult> FacetCounter::results(size_t size) const {
+    std::vector<FacetResult> results;
+    results.reserve(facets_.size());
+    for (const auto& facet : facets_) {
+        FacetResult result;
+        result.field = facet.field;
+        result.missing_count = facet.missing;
+
+        std::vector<uint32_t> present;
+        size_t total = 0;
+        for (uint32_t v = 0; v < facet.counts.size(); ++v) {
+            if (facet.counts[v] > 0) {
+                present.push_back(v);
+                total += facet.counts[v];
+            }
+        }
+
+        // Only the top `size` values are ordered; the dictionary is not sorted
+        const auto by_count = [&](uint32_t a, uint32_t b) {
+            if (facet.counts[a] != facet.counts[b]) return facet.counts[a] > facet.counts[b];
+            return facet.column->values[a] < facet.column->values[b];
+        };
+        const size_t kept = std::min(size, present.size());
+        std::partial_sort(present.begin(), present.begin() + kept, present.end(), by_count);
+
+        for (size_t i = 0; i < kept; ++i) {
+            result.values.push_back({facet.column->values[present[i]], facet.counts[present[i]]});
+            total -= facet.counts[present[i]];
+        }
+        result.other_count = total;
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+}  // namespace rtrv_search_engine
@@ -1,4 +1,5 @@
 #include "document.hpp"
+#include "memory_usage.hpp"
 #include <sstream>
 
 namespace rtrv_search_engine {
@@ -30,4 +31,13 @@ std::string Document::getAllText() const {
     return oss.str();
 }
 
+size_t Document::memoryUsage() const {
+    using namespace memory_accounting;
+    size_t bytes = hashTableBytes(fields);
+    for (const auto& [field_name, field_value] : fields) {
+        bytes += stringHeapBytes(field_name) + stringHeapBytes(field_value);
+    }
+    return bytes + vector.capacity() * sizeof(float);
+}
+
 } // namespace rtrv_search_engine 
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "filter_cache.hpp"
+#include "memory_usage.hpp"
+#include <mutex>
+
+namespace rtrv_search_engine {
+
+// ==================== SegmentedDocIdSet ====================
+
+namespace {
+
+constexpr uint32_t kSegmentSize = uint32_t{1} << DocValues::kSegmentBits;
+
+class SegmentedDocIdSetIterator : public DocIdSetIterator {
+public:
+    explicit SegmentedDocIdSetIterator(std::shared_ptr<const SegmentedDocIdSet> set) : set_(std::move(set)) {}
+
+    uint32_t docID() const override { return doc_; }
+    uint32_t nextDoc() override { return advance(started_ ? doc_ + 1 : 0); }
+    uint32_t advance(uint32_t target) override {
+        if (started_ && doc_ >= target) {
+            return doc_;
+        }
+        started_ = true;
+        return doc_ = set_->nextDoc(target);
+    }
+    size_t cost() const override { return set_->cardinality(); }
+
+private:
+    std::shared_ptr<const SegmentedDocIdSet> set_;
+    uint32_t doc_ = 0;
+    bool started_ = false;
+};
+
+}  // namespace
+
+bool SegmentedDocIdSet::reusable(size_t segment, const DocValues& doc_values) const {
+    return generation_ == doc_values.ordinalGeneration() && segment < segments_.size() &&
+           segments_[segment].epoch == doc_values.segmentEpoch(segment);
+}
+
+std::shared_ptr<const SegmentedDocIdSet> SegmentedDocIdSet::build(DocIdSetIterator& docs,
+                                                                  const DocValues& doc_values,
+                                                                  const SegmentedDocIdSet* previous) {
+    auto set = std::make_shared<SegmentedDocIdSet>();
+    set->generation_ = doc_values.ordinalGeneration();
+    set->segments_.resize(doc_values.segments());
+
+    std::vector<uint16_t> offsets;
+    for (size_t s = 0; s < set->segments_.size(); ++s) {
+        Slot& slot = set->segments_[s];
+        slot.epoch = doc_values.segmentEpoch(s);
+        if (previous && previous->reusable(s, doc_values)) {
+            slot.docs = previous->segments_[s].docs;
+            set->reused_++;
+        } else {
+            // advance() only moves forward, so skipped (reused) segments cost nothing
+            const uint32_t base = static_cast<uint32_t>(s) << kSegmentBits;
+            offsets.clear();
+            for (uint32_t doc = docs.advance(base); doc - base < kSegmentSize; doc = docs.nextDoc()) {
+                offsets.push_back(static_cast<uint16_t>(doc - base));
+            }
+            if (!offsets.empty()) {
+                auto segment = std::make_shared<Segment>();
+                segment->cardinality = static_cast<uint32_t>(offsets.size());
+                if (offsets.size() > kMaxArray) {
+                    segment->bitmap.assign(kSegmentSize / 64, 0);
+                    for (uint16_t offset : offsets) {
+                        segment->bitmap[offset >> 6] |= uint64_t{1} << (offset & 63);
+                    }
+                } else {
+                    segment->array = offsets;
+                }
+                slot.docs = std::move(segment);
+            }
+        }
+        if (slot.docs) {
+            set->cardinality_ += slot.docs->cardinality;
+        }
+    }
+    return set;
+}
+
+std::unique_ptr<DocIdSetIterator> SegmentedDocIdSet::iterator(std::shared_ptr<const SegmentedDocIdSet> set) {
+    return std::make_unique<SegmentedDocIdSetIterator>(std::move(set));
+}
+
+uint32_t SegmentedDocIdSet::nextDoc(uint32_t target) const {
+    for (size_t s = target >> kSegmentBits; s < segments_.size(); ++s) {
+        if (!segments_[s].docs) {
+            continue;
+        }
+        const Segment& docs = *segments_[s].docs;
+        const uint32_t base = static_cast<uint32_t>(s) << kSegmentBits;
+        const uint32_t from = target > base ? target - base : 0;
+        if (docs.bitmap.empty()) {
+            auto it = std::lower_bound(docs.array.begin(), docs.array.end(), from);
+            if (it != docs.array.end()) {
+                return base + *it;
+            }
+            continue;
+        }
+        size_t w = from >> 6;
+        uint64_t word = docs.bitmap[w] & (~uint64_t{0} << (from & 63));
+        while (word == 0 && ++w < docs.bitmap.size()) {
+            word = docs.bitmap[w];
+        }
+        if (word != 0) {
+            return base + static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+        }
+    }
+    return DocIdSetIterator::NO_MORE_DOCS;
+}
+
+bool SegmentedDocIdSet::current(const DocValues& doc_values) const {
+    if (segments_.size() != doc_values.segments()) {
+        return false;
+    }
+    for (size_t s = 0; s < segments_.size(); ++s) {
+        if (!reusable(s, doc_values)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t SegmentedDocIdSet::memoryUsage() const {
+    using namespace memory_accounting;
+    size_t bytes = sizeof(*this) + vectorUsedBytes(segments_);
+    for (const auto& slot : segments_) {
+        if (slot.docs) {
+            bytes += sizeof(Segment) + vectorUsedBytes(slot.docs->array) + vectorUsedBytes(slot.docs->bitmap);
+        }
+    }
+    return bytes;
+}
+
+// ==================== FilterCache ====================
+
+FilterCache::FilterCache(size_t max_bytes, size_t min_frequency)
+    : max_bytes_(max_bytes), min_frequency_(min_frequency) {}
+
+bool FilterCache::recordUse(const std::string& key) {
+    const size_t hash = std::hash<std::string>{}(key);
+    if (history_.size() < kHistorySize) {
+        history_.push_back(hash);
+    } else {
+        // The oldest lookup leaves the window
+        auto oldest = frequency_.find(history_[history_next_]);
+        if (--oldest->second == 0) {
+            frequency_.erase(oldest);
+        }
+        history_[history_next_] = hash;
+        history_next_ = (history_next_ + 1) % kHistorySize;
+    }
+    return ++frequency_[hash] >= min_frequency_;
+}
+
+std::shared_ptr<const SegmentedDocIdSet> FilterCache::getOrCompute(const std::string& key,
+                                                                   const DocValues& doc_values,
+                                                                   const Compute& compute) {
+    bool admit;
+    std::shared_ptr<const SegmentedDocIdSet> previous;
+    {
+        std::unique_lock write_lock(mutex_);
+        admit = recordUse(key);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            lru_order_.splice(lru_order_.begin(), lru_order_, it->second.lru_it);
+            if (it->second.set->current(doc_values)) {
+                hit_count_.fetch_add(1, std::memory_order_relaxed);
+                return it->second.set;
+            }
+            previous = it->second.set;
+        }
+    }
+
+    // Evaluated outside the lock: concurrent readers of other clauses
+    // are not held up (two readers of the same clause may both build it)
+    auto docs = compute();
+    if (!docs) {
+        return nullptr;
+    }
+    auto set = SegmentedDocIdSet::build(*docs, doc_values, previous.get());
+    if (previous) {
+        refresh_count_.fetch_add(1, std::memory_order_relaxed);
+        segments_reused_.fetch_add(set->reusedSegments(), std::memory_order_relaxed);
+    } else {
+        miss_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!admit && !previous) {
+        return set;
+    }
+
+    std::unique_lock write_lock(mutex_);
+    const size_t bytes = entryBytes(key, *set);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        bytes_ -= it->second.bytes;
+        it->second.set = set;
+        it->second.bytes = bytes;
+    } else {
+        lru_order_.push_front(key);
+        entries_.emplace(key, Entry{set, bytes, lru_order_.begin()});
+    }
+    bytes_ += bytes;
+    evictIfNeeded();
+    return set;
+}
+
+void FilterCache::evictIfNeeded() {
+    while (bytes_ > max_bytes_ && !lru_order_.empty()) {
+        auto it = entries_.find(lru_order_.back());
+        bytes_ -= it->second.bytes;
+        entries_.erase(it);
+        lru_order_.pop_back();
+        eviction_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+size_t FilterCache::entryBytes(const std::string& key, const SegmentedDocIdSet& set) const {
+    using namespace memory_accounting;
+    // Key in the map and in the LRU list, plus the list node
+    return set.memoryUsage() + 2 * stringHeapBytes(key) + sizeof(std::string) + 2 * kNodeLinkBytes;
+}
+
+void FilterCache::clear() {
+    std::unique_lock write_lock(mutex_);
+    entries_.clear();
+    lru_order_.clear();
+    bytes_ = 0;
+}
+
+void FilterCache::configure(size_t max_bytes, size_t min_frequency) {
+    std::unique_lock write_lock(mutex_);
+    max_bytes_ = max_bytes;
+    min_frequency_ = min_frequency;
+    evictIfNeeded();
+}
+
+FilterCacheStatistics FilterCache::getStats() const {
+    std::shared_lock read_lock(mutex_);
+
+    FilterCacheStatistics stats;
+    stats.hit_count = hit_count_.load(std::memory_order_relaxed);
+    stats.miss_count = miss_count_.load(std::memory_order_relaxed);
+    stats.refresh_count = refresh_count_.load(std::memory_order_relaxed);
+    stats.segments_reused = segments_reused_.load(std::memory_order_relaxed);
+    stats.eviction_count = eviction_count_.load(std::memory_order_relaxed);
+    stats.current_size = entries_.size();
+    stats.memory_bytes = bytes_;
+    stats.max_bytes = max_bytes_;
+
+    const size_t total = stats.hit_count + stats.miss_count + stats.refresh_count;
+    stats.hit_rate = total > 0 ? static_cast<double>(stats.hit_count) / total : 0.0;
+    return stats;
+}
+
+size_t FilterCache::memoryUsage() const {
+    using namespace memory_accounting;
+    std::shared_lock read_lock(mutex_);
+    return bytes_ + hashTableBytes(entries_) + hashTableBytes(frequency_) + vectorUsedBytes(history_);
+}
+
+}  // namespace rtrv_search_engine
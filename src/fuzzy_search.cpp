@@ -1,4 +1,5 @@
 #include "fuzzy_search.hpp"
+#include "memory_usage.hpp"
 #include <algorithm>
 #include <cmath>
 #include <limits>
@@ -66,6 +67,21 @@ void FuzzySearch::clear() {
     index_built_ = false;
 }
 
+size_t FuzzySearch::memoryUsage() const {
+    using namespace memory_accounting;
+    size_t bytes = hashTableBytes(ngram_index_) + hashTableBytes(vocabulary_);
+    for (const auto& [ngram, terms] : ngram_index_) {
+        bytes += stringHeapBytes(ngram) + hashTableBytes(terms);
+        for (const auto& term : terms) {
+            bytes += stringHeapBytes(term);
+        }
+    }
+    for (const auto& term : vocabulary_) {
+        bytes += stringHeapBytes(term);
+    }
+    return bytes;
+}
+
 // ============================================================================
 // N-gram Extraction
 // ============================================================================
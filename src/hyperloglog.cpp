@@ -0,0 +1,306 @@
+#include "hyperloglog.hpp"
+#include "memory_usage.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace rtrv_search_engine {
+
+namespace {
+
+constexpr uint8_t kSerialVersion = 1;
+constexpr uint32_t kMaxSparseRank = 64 - HyperLogLog::kSparsePrecision + 1;
+
+uint32_t sparseEntry(uint64_t hash) {
+    const uint32_t index = static_cast<uint32_t>(hash >> (64 - HyperLogLog::kSparsePrecision));
+    const uint64_t rest = hash << HyperLogLog::kSparsePrecision;
+    const uint32_t rank = rest == 0 ? kMaxSparseRank : static_cast<uint32_t>(__builtin_clzll(rest)) + 1;
+    return index << 6 | rank;
+}
+
+// Rank of the first set bit among the top `width` bits of a `width`-bit
+// value, or 0 if there is none
+uint32_t leadingRank(uint32_t bits, uint32_t width) {
+    return bits == 0 ? 0 : static_cast<uint32_t>(__builtin_clz(bits)) - (32 - width) + 1;
+}
+
+// Sort and keep the highest rank per index (entries order by index, then rank)
+void normalize(std::vector<uint32_t>& entries) {
+    std::sort(entries.begin(), entries.end());
+    size_t kept = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (kept > 0 && entries[kept - 1] >> 6 == entries[i] >> 6) {
+            entries[kept - 1] = entries[i];
+        } else {
+            entries[kept++] = entries[i];
+        }
+    }
+    entries.resize(kept);
+}
+
+// Ertl's sigma and tau series (Algorithm 6)
+double sigma(double x) {
+    if (x == 1.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double y = 1.0;
+    double z = x;
+    double previous;
+    do {
+        x *= x;
+        previous = z;
+        z += x * y;
+        y += y;
+    } while (z != previous);
+    return z;
+}
+
+double tau(double x) {
+    if (x == 0.0 || x == 1.0) {
+        return 0.0;
+    }
+    double y = 1.0;
+    double z = 1.0 - x;
+    double previous;
+    do {
+        x = std::sqrt(x);
+        previous = z;
+        y *= 0.5;
+        z -= (1.0 - x) * (1.0 - x) * y;
+    } while (z != previous);
+    return z / 3.0;
+}
+
+}  // namespace
+
+HyperLogLog::HyperLogLog(uint8_t precision)
+    : precision_(std::clamp(precision, kMinPrecision, kMaxPrecision)) {}
+
+void HyperLogLog::add(uint64_t hash) {
+    if (!registers_.empty()) {
+        const uint64_t rest = hash << precision_;
+        const uint8_t rank = rest == 0 ? static_cast<uint8_t>(65 - precision_)
+                                       : static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+        uint8_t& reg = registers_[hash >> (64 - precision_)];
+        reg = std::max(reg, rank);
+        return;
+    }
+    buffer_.push_back(sparseEntry(hash));
+    if (buffer_.size() * sizeof(uint32_t) >= (size_t{1} << precision_) / 4) {
+        flushBuffer();
+    }
+}
+
+void HyperLogLog::flushBuffer() {
+    if (buffer_.empty()) {
+        return;
+    }
+    sparse_.insert(sparse_.end(), buffer_.begin(), buffer_.end());
+    buffer_.clear();
+    normalize(sparse_);
+    // Dense once the entries take more than its one byte per register
+    if (sparse_.size() * sizeof(uint32_t) > (size_t{1} << precision_)) {
+        toDense();
+    }
+}
+
+std::vector<uint32_t> HyperLogLog::sparseEntries() const {
+    std::vector<uint32_t> entries = sparse_;
+    if (!buffer_.empty()) {
+        entries.insert(entries.end(), buffer_.begin(), buffer_.end());
+        normalize(entries);
+    }
+    return entries;
+}
+
+void HyperLogLog::toDense() {
+    const std::vector<uint32_t> entries = sparseEntries();
+    registers_.assign(size_t{1} << precision_, 0);
+    for (uint32_t entry : entries) {
+        addEntry(entry);
+    }
+    sparse_ = std::vector<uint32_t>();  // Release the capacity
+    buffer_ = std::vector<uint32_t>();
+}
+
+void HyperLogLog::addEntry(uint32_t entry) {
+    // The index bits below `precision_` lead the dense register's bit string
+    const uint32_t extra = kSparsePrecision - precision_;
+    const uint32_t index = entry >> 6;
+    const uint32_t low = index & ((uint32_t{1} << extra) - 1);
+    const uint32_t rank = low != 0 ? leadingRank(low, extra) : (entry & 63) + extra;
+    uint8_t& reg = registers_[index >> extra];
+    reg = std::max(reg, static_cast<uint8_t>(rank));
+}
+
+void HyperLogLog::reduce(uint8_t precision) {
+    if (precision >= precision_) {
+        return;
+    }
+    if (registers_.empty()) {
+        // Sparse entries do not depend on the precision, only the threshold does
+        precision_ = precision;
+        flushBuffer();
+        if (registers_.empty() && sparse_.size() * sizeof(uint32_t) > (size_t{1} << precision_)) {
+            toDense();
+        }
+        return;
+    }
+    const uint32_t dropped = precision_ - precision;
+    std::vector<uint8_t> reduced(size_t{1} << precision, 0);
+    for (uint32_t index = 0; index < registers_.size(); ++index) {
+        if (registers_[index] == 0) {
+            continue;
+        }
+        const uint32_t low = index & ((uint32_t{1} << dropped) - 1);
+        const uint32_t rank = low != 0 ? leadingRank(low, dropped) : registers_[index] + dropped;
+        uint8_t& reg = reduced[index >> dropped];
+        reg = std::max(reg, static_cast<uint8_t>(rank));
+    }
+    registers_ = std::move(reduced);
+    precision_ = precision;
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.precision_ > precision_) {
+        HyperLogLog reduced = other;
+        reduced.reduce(precision_);
+        merge(reduced);
+        return;
+    }
+    reduce(other.precision_);
+
+    if (other.registers_.empty()) {
+        if (registers_.empty()) {
+            buffer_.insert(buffer_.end(), other.sparse_.begin(), other.sparse_.end());
+            buffer_.insert(buffer_.end(), other.buffer_.begin(), other.buffer_.end());
+            flushBuffer();
+        } else {
+            for (uint32_t entry : other.sparse_) addEntry(entry);
+            for (uint32_t entry : other.buffer_) addEntry(entry);
+        }
+        return;
+    }
+    if (registers_.empty()) {
+        toDense();
+    }
+    for (size_t i = 0; i < registers_.size(); ++i) {
+        registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+}
+
+uint64_t HyperLogLog::estimate() const {
+    if (registers_.empty()) {
+        // Linear counting over the 2^25 sparse registers
+        const double m = static_cast<double>(uint64_t{1} << kSparsePrecision);
+        const double occupied = static_cast<double>(sparseEntries().size());
+        return static_cast<uint64_t>(std::llround(m * std::log(m / (m - occupied))));
+    }
+
+    const uint32_t q = 64 - precision_;
+    std::vector<uint32_t> histogram(q + 2, 0);
+    for (uint8_t reg : registers_) {
+        ++histogram[reg];
+    }
+    const double m = static_cast<double>(registers_.size());
+    double z = m * tau((m - histogram[q + 1]) / m);
+    for (uint32_t k = q; k >= 1; --k) {
+        z = 0.5 * (z + histogram[k]);
+    }
+    z += m * sigma(histogram[0] / m);
+    if (std::isinf(z)) {
+        return 0;  // Every register empty
+    }
+    constexpr double kAlphaInfinity = 0.7213475204444817;  // 1 / (2 ln 2)
+    return static_cast<uint64_t>(std::llround(kAlphaInfinity * m * m / z));
+}
+
+size_t HyperLogLog::memoryUsage() const {
+    using namespace memory_accounting;
+    return sizeof(*this) + vectorUsedBytes(sparse_) + vectorSlackBytes(sparse_) + vectorUsedBytes(buffer_) +
+           vectorSlackBytes(buffer_) + vectorUsedBytes(registers_) + vectorSlackBytes(registers_);
+}
+
+// ==================== Serialization ====================
+
+std::vector<uint8_t> HyperLogLog::serialize() const {
+    std::vector<uint8_t> bytes;
+    bytes.reserve(3 + (registers_.empty() ? 4 + 4 * (sparse_.size() + buffer_.size()) : registers_.size()));
+    bytes.push_back(kSerialVersion);
+    bytes.push_back(precision_);
+    bytes.push_back(registers_.empty() ? 0 : 1);
+    if (!registers_.empty()) {
+        bytes.insert(bytes.end(), registers_.begin(), registers_.end());
+        return bytes;
+    }
+    const std::vector<uint32_t> entries = sparseEntries();
+    const uint32_t count = static_cast<uint32_t>(entries.size());
+    for (int shift = 0; shift < 32; shift += 8) bytes.push_back(static_cast<uint8_t>(count >> shift));
+    for (uint32_t entry : entries) {
+        for (int shift = 0; shift < 32; shift += 8) bytes.push_back(static_cast<uint8_t>(entry >> shift));
+    }
+    return bytes;
+}
+
+bool HyperLogLog::deserialize(const std::vector<uint8_t>& bytes, HyperLogLog& sketch) {
+    if (bytes.size() < 3 || bytes[0] != kSerialVersion || bytes[1] < kMinPrecision || bytes[1] > kMaxPrecision ||
+        bytes[2] > 1) {
+        return false;
+    }
+    HyperLogLog parsed(bytes[1]);
+    if (bytes[2] == 1) {
+        if (bytes.size() != 3 + (size_t{1} << parsed.precision_)) {
+            return false;
+        }
+        parsed.registers_.assign(bytes.begin() + 3, bytes.end());
+        for (uint8_t reg : parsed.registers_) {
+            if (reg > 65 - parsed.precision_) return false;
+        }
+    } else {
+        const auto word = [&](size_t pos) {
+            return static_cast<uint32_t>(bytes[pos]) | static_cast<uint32_t>(bytes[pos + 1]) << 8 |
+                   static_cast<uint32_t>(bytes[pos + 2]) << 16 | static_cast<uint32_t>(bytes[pos + 3]) << 24;
+        };
+        if (bytes.size() < 7) {
+            return false;
+        }
+        const size_t count = word(3);
+        if (bytes.size() != 7 + 4 * count) {
+            return false;
+        }
+        parsed.sparse_.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t entry = word(7 + 4 * i);
+            const uint32_t rank = entry & 63;
+            if (entry >> (6 + kSparsePrecision) != 0 || rank == 0 || rank > kMaxSparseRank ||
+                (!parsed.sparse_.empty() && parsed.sparse_.back() >> 6 >= entry >> 6)) {
+                return false;  // Out of range, or not sorted by index
+            }
+            parsed.sparse_.push_back(entry);
+        }
+    }
+    sketch = std::move(parsed);
+    return true;
+}
+
+// ==================== Hashing ====================
+
+uint64_t HyperLogLog::hashInteger(uint64_t value) {
+    // splitmix64 finalizer
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+uint64_t HyperLogLog::hashString(const std::string& text) {
+    // FNV-1a, then mixed: FNV alone leaves the high bits (the register
+    // index) poorly distributed for short strings
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    return hashInteger(hash);
+}
+
+}  // namespace rtrv_search_engine
@@ -1,9 +1,65 @@
 #include "inverted_index.hpp"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <tuple>
 
 namespace rtrv_search_engine {
 
+namespace {
+
+// Process-wide skip counters, flushed once per intersection
+std::atomic<uint64_t> skip_intersections{0};
+std::atomic<uint64_t> skip_jumps{0};
+std::atomic<uint64_t> skip_postings_skipped{0};
+std::atomic<uint64_t> skip_postings_scanned{0};
+
+// Doc id + term frequency as stored in a Posting, excluding positions
+constexpr size_t kPostingPayloadBytes = sizeof(Posting::doc_id) + sizeof(Posting::term_frequency);
+
+size_t varintBytes(uint64_t value) {
+    size_t bytes = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++bytes;
+    }
+    return bytes;
+}
+
+// Delta from the previous value, or the value itself if out of order
+size_t deltaBytes(uint64_t previous, uint64_t value) {
+    return varintBytes(value >= previous ? value - previous : value);
+}
+
+// Posting-length class: floor(log2(length)), length >= 1
+size_t lengthClass(size_t length) {
+    size_t length_class = 0;
+    while (length >>= 1) {
+        ++length_class;
+    }
+    return length_class;
+}
+
+// Positions and delta + varint encoded size of a whole list
+std::pair<size_t, size_t> countListPayload(const std::vector<Posting>& postings) {
+    size_t positions = 0;
+    size_t encoded_bytes = 0;
+    uint64_t previous_doc = 0;
+    for (const auto& posting : postings) {
+        encoded_bytes += deltaBytes(previous_doc, posting.doc_id) + varintBytes(posting.term_frequency);
+        previous_doc = posting.doc_id;
+        uint32_t previous_position = 0;
+        for (uint32_t position : posting.positions) {
+            encoded_bytes += deltaBytes(previous_position, position);
+            previous_position = position;
+        }
+        positions += posting.positions.size();
+    }
+    return {positions, encoded_bytes};
+}
+
+}  // anonymous namespace
+
 Posting::Posting(uint64_t doc_id, uint32_t term_frequency)
     : doc_id(doc_id), term_frequency(term_frequency) {
 }
@@ -69,6 +125,19 @@ std::vector<uint64_t> intersectWithSkips(
     std::vector<uint64_t> result;
     size_t i = 0, j = 0;
     
+    // Counted locally, published once per call
+    uint64_t jumps = 0, skipped = 0, scanned = 0;
+    auto advance = [&](size_t& cursor, size_t skip_pos) {
+        if (skip_pos > cursor + 1) {
+            ++jumps;
+            skipped += skip_pos - cursor - 1;
+            cursor = skip_pos;
+        } else {
+            ++cursor;
+        }
+        ++scanned;
+    };
+    
     while (i < list1.postings.size() && j < list2.postings.size()) {
         uint64_t doc_id1 = list1.postings[i].doc_id;
         uint64_t doc_id2 = list2.postings[j].doc_id;
@@ -77,28 +146,39 @@ std::vector<uint64_t> intersectWithSkips(
             result.push_back(doc_id1);
             ++i;
             ++j;
+            scanned += 2;
         } else if (doc_id1 < doc_id2) {
             // Try to skip ahead in list1
-            if (!list1.skip_pointers.empty()) {
-                size_t skip_pos = list1.findSkipTarget(doc_id2);
-                i = std::max(i + 1, skip_pos);
-            } else {
-                ++i;
-            }
+            advance(i, list1.skip_pointers.empty() ? 0 : list1.findSkipTarget(doc_id2));
         } else {
             // Try to skip ahead in list2
-            if (!list2.skip_pointers.empty()) {
-                size_t skip_pos = list2.findSkipTarget(doc_id1);
-                j = std::max(j + 1, skip_pos);
-            } else {
-                ++j;
-            }
+            advance(j, list2.skip_pointers.empty() ? 0 : list2.findSkipTarget(doc_id1));
         }
     }
     
+    skip_intersections.fetch_add(1, std::memory_order_relaxed);
+    skip_jumps.fetch_add(jumps, std::memory_order_relaxed);
+    skip_postings_skipped.fetch_add(skipped, std::memory_order_relaxed);
+    skip_postings_scanned.fetch_add(scanned, std::memory_order_relaxed);
     return result;
 }
 
+SkipStatistics skipStatistics() {
+    SkipStatistics stats;
+    stats.intersections = skip_intersections.load(std::memory_order_relaxed);
+    stats.skips_taken = skip_jumps.load(std::memory_order_relaxed);
+    stats.postings_skipped = skip_postings_skipped.load(std::memory_order_relaxed);
+    stats.postings_scanned = skip_postings_scanned.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void resetSkipStatistics() {
+    skip_intersections.store(0, std::memory_order_relaxed);
+    skip_jumps.store(0, std::memory_order_relaxed);
+    skip_postings_skipped.store(0, std::memory_order_relaxed);
+    skip_postings_scanned.store(0, std::memory_order_relaxed);
+}
+
 // ==================== InvertedIndex Implementation ====================
 
 InvertedIndex::InvertedIndex() = default;
@@ -108,7 +188,11 @@ InvertedIndex::~InvertedIndex() = default;
 void InvertedIndex::addTerm(const std::string& term, uint64_t doc_id, uint32_t position) {
     std::unique_lock lock(mutex_);
     
-    auto& posting_list = index_[term];
+    auto& entry = *index_.try_emplace(term).first;
+    auto& posting_list = entry.second;
+    const size_t before_postings = posting_list.postings.size();
+    const size_t before_positions = posting_list.position_count_;
+    const size_t before_encoded = posting_list.encoded_bytes_;
     
     // Find if document already exists in posting list [using lambda]
     auto it = std::find_if(posting_list.postings.begin(), posting_list.postings.end(),
@@ -116,14 +200,21 @@ void InvertedIndex::addTerm(const std::string& term, uint64_t doc_id, uint32_t p
     
     if (it != posting_list.postings.end()) {
         // Document already exists, increment frequency and add position
+        posting_list.encoded_bytes_ += varintBytes(it->term_frequency + 1) - varintBytes(it->term_frequency);
         it->term_frequency++;
         if (position > 0) {
+            posting_list.encoded_bytes_ += deltaBytes(it->positions.empty() ? 0 : it->positions.back(), position);
+            posting_list.position_count_++;
             it->positions.push_back(position);
         }
     } else {
         // New document, create posting
+        const uint64_t previous_doc = posting_list.postings.empty() ? 0 : posting_list.postings.back().doc_id;
+        posting_list.encoded_bytes_ += deltaBytes(previous_doc, doc_id) + varintBytes(1);
         Posting posting(doc_id, 1);
         if (position > 0) {
+            posting_list.encoded_bytes_ += varintBytes(position);
+            posting_list.position_count_++;
             posting.positions.push_back(position);
         }
         posting_list.addPosting(posting);
@@ -131,6 +222,7 @@ void InvertedIndex::addTerm(const std::string& term, uint64_t doc_id, uint32_t p
     
     // Mark skip pointers as dirty (will rebuild on next query if needed)
     posting_list.markSkipsDirty();
+    updateAnalysis(entry, before_postings, before_positions, before_encoded);
 }
 
 std::vector<Posting> InvertedIndex::getPostings(const std::string& term) const {
@@ -144,6 +236,50 @@ std::vector<Posting> InvertedIndex::getPostings(const std::string& term) const {
     return std::vector<Posting>();
 }
 
+void InvertedIndex::forEachPosting(const std::string& term,
+                                   const std::function<void(const Posting&)>& visit) const {
+    std::shared_lock lock(mutex_);
+    
+    auto it = index_.find(term);
+    if (it == index_.end()) {
+        return;
+    }
+    for (const auto& posting : it->second.postings) {
+        visit(posting);
+    }
+}
+
+std::vector<uint32_t> InvertedIndex::getPositions(const std::string& term, uint64_t doc_id) const {
+    std::shared_lock lock(mutex_);
+
+    auto it = index_.find(term);
+    if (it == index_.end()) {
+        return {};
+    }
+
+    // Postings are in doc-id order unless documents were re-indexed with
+    // lower ids, so try a binary search before scanning
+    const auto& postings = it->second.postings;
+    auto posting = std::lower_bound(postings.begin(), postings.end(), doc_id,
+        [](const Posting& p, uint64_t id) { return p.doc_id < id; });
+    if (posting == postings.end() || posting->doc_id != doc_id) {
+        posting = std::find_if(postings.begin(), postings.end(),
+                               [doc_id](const Posting& p) { return p.doc_id == doc_id; });
+        if (posting == postings.end()) {
+            return {};
+        }
+    }
+
+    // Position 0 is counted in term_frequency but not stored
+    std::vector<uint32_t> positions;
+    positions.reserve(posting->term_frequency);
+    if (posting->term_frequency > posting->positions.size()) {
+        positions.push_back(0);
+    }
+    positions.insert(positions.end(), posting->positions.begin(), posting->positions.end());
+    return positions;
+}
+
 PostingList InvertedIndex::getPostingList(const std::string& term) const {
     std::shared_lock lock(mutex_);
     
@@ -167,14 +303,23 @@ void InvertedIndex::removeDocument(uint64_t doc_id) {
     std::unique_lock lock(mutex_);
     
     // Iterate through all terms and remove postings for this document
-    for (auto& [term, posting_list] : index_) {
+    for (auto& entry : index_) {
+        auto& posting_list = entry.second;
         auto& postings = posting_list.postings;
+        const size_t before_postings = postings.size();
         postings.erase(
             std::remove_if(postings.begin(), postings.end(),
                           [doc_id](const Posting& p) { return p.doc_id == doc_id; }),
             postings.end()
         );
         
+        if (postings.size() != before_postings) {
+            const size_t before_positions = posting_list.position_count_;
+            const size_t before_encoded = posting_list.encoded_bytes_;
+            std::tie(posting_list.position_count_, posting_list.encoded_bytes_) = countListPayload(postings);
+            updateAnalysis(entry, before_postings, before_positions, before_encoded);
+        }
+        
         // Mark skip pointers as dirty if we removed any postings
         if (!postings.empty()) {
             posting_list.markSkipsDirty();
@@ -210,6 +355,7 @@ size_t InvertedIndex::getTermCount() const {
 void InvertedIndex::clear() {
     std::unique_lock lock(mutex_);
     index_.clear();
+    length_classes_.clear();
 }
 
 void InvertedIndex::rebuildSkipPointers() {
@@ -247,4 +393,128 @@ bool InvertedIndex::hasTerm(const std::string& term) const {
     return index_.count(term) > 0;
 }
 
+void InvertedIndex::accumulateMemoryUsage(MemoryUsage& usage) const {
+    using namespace memory_accounting;
+    std::shared_lock lock(mutex_);
+    
+    usage.term_dictionary_bytes += hashTableBytes(index_);
+    
+    constexpr size_t posting_field_bytes = sizeof(Posting::doc_id) +
+                                           sizeof(Posting::term_frequency) +
+                                           sizeof(Posting::positions);
+    
+    for (const auto& [term, posting_list] : index_) {
+        usage.term_dictionary_bytes += stringHeapBytes(term);
+        usage.allocator_slack_bytes += stringSlackBytes(term);
+        
+        const auto& postings = posting_list.postings;
+        usage.posting_doc_id_bytes += postings.size() * sizeof(Posting::doc_id);
+        usage.posting_tf_bytes += postings.size() * sizeof(Posting::term_frequency);
+        usage.posting_position_bytes += postings.size() * sizeof(Posting::positions);
+        // Struct padding between fields is allocated but carries no data
+        usage.allocator_slack_bytes += postings.size() * (sizeof(Posting) - posting_field_bytes);
+        usage.allocator_slack_bytes += vectorSlackBytes(postings);
+        
+        for (const auto& posting : postings) {
+            usage.posting_position_bytes += vectorUsedBytes(posting.positions);
+            usage.allocator_slack_bytes += vectorSlackBytes(posting.positions);
+        }
+        
+        usage.skip_data_bytes += vectorUsedBytes(posting_list.skip_pointers);
+        usage.allocator_slack_bytes += vectorSlackBytes(posting_list.skip_pointers);
+    }
+    
+    // Length-class membership kept for analyze()
+    for (const auto& totals : length_classes_) {
+        usage.term_dictionary_bytes += hashTableBytes(totals.entries);
+    }
+    usage.term_dictionary_bytes += vectorUsedBytes(length_classes_);
+    usage.allocator_slack_bytes += vectorSlackBytes(length_classes_);
+}
+
+// ==================== Index Analysis ====================
+
+void InvertedIndex::updateAnalysis(const IndexEntry& entry, size_t before_postings,
+                                   size_t before_positions, size_t before_encoded) {
+    const PostingList& list = entry.second;
+    const size_t after_postings = list.postings.size();
+    
+    if (before_postings > 0) {
+        auto& totals = length_classes_[lengthClass(before_postings)];
+        totals.lists--;
+        totals.postings -= before_postings;
+        totals.positions -= before_positions;
+        totals.encoded_bytes -= before_encoded;
+    }
+    if (after_postings > 0) {
+        const size_t after_class = lengthClass(after_postings);
+        if (after_class >= length_classes_.size()) {
+            length_classes_.resize(after_class + 1);
+        }
+        auto& totals = length_classes_[after_class];
+        totals.lists++;
+        totals.postings += after_postings;
+        totals.positions += list.position_count_;
+        totals.encoded_bytes += list.encoded_bytes_;
+    }
+    
+    // Membership only changes when the length crosses a power of two
+    const bool was_listed = before_postings > 0;
+    const bool is_listed = after_postings > 0;
+    if (was_listed && is_listed && lengthClass(before_postings) == lengthClass(after_postings)) {
+        return;
+    }
+    if (was_listed) {
+        length_classes_[lengthClass(before_postings)].entries.erase(&entry);
+    }
+    if (is_listed) {
+        length_classes_[lengthClass(after_postings)].entries.insert(&entry);
+    }
+}
+
+IndexAnalysis InvertedIndex::analyze(size_t top_n) const {
+    std::shared_lock lock(mutex_);
+    
+    IndexAnalysis analysis;
+    analysis.terms = index_.size();
+    for (size_t c = 0; c < length_classes_.size(); ++c) {
+        const auto& totals = length_classes_[c];
+        if (totals.lists == 0) {
+            continue;
+        }
+        PostingLengthClass length_class;
+        length_class.min_length = size_t(1) << c;
+        length_class.max_length = (size_t(1) << (c + 1)) - 1;
+        length_class.lists = totals.lists;
+        length_class.postings = totals.postings;
+        length_class.positions = totals.positions;
+        length_class.raw_bytes = totals.postings * kPostingPayloadBytes + totals.positions * sizeof(uint32_t);
+        length_class.encoded_bytes = totals.encoded_bytes;
+        
+        analysis.postings += length_class.postings;
+        analysis.positions += length_class.positions;
+        analysis.raw_bytes += length_class.raw_bytes;
+        analysis.encoded_bytes += length_class.encoded_bytes;
+        analysis.length_classes.push_back(length_class);
+    }
+    
+    // Longest lists: only the highest classes holding top_n lists are read
+    std::vector<TermPostingCount> candidates;
+    for (size_t c = length_classes_.size(); c-- > 0 && candidates.size() < top_n;) {
+        for (const IndexEntry* entry : length_classes_[c].entries) {
+            candidates.push_back({entry->first, entry->second.postings.size()});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const TermPostingCount& a, const TermPostingCount& b) {
+                  return a.postings != b.postings ? a.postings > b.postings : a.term < b.term;
+              });
+    if (candidates.size() > top_n) {
+        candidates.resize(top_n);
+    }
+    analysis.longest_lists = std::move(candidates);
+    analysis.skips = skipStatistics();
+    return analysis;
+}
+
 } 
@@ -0,0 +1,560 @@
+#include "percolator.hpp"
+#include "memory_usage.hpp"
+#include "query_parser.hpp"
+#include <algorithm>
+
+namespace rtrv_search_engine {
+
+// A document as seen by verification: its terms, and its fields tokenized
+// on first use
+struct Percolator::DocumentView {
+    const Document& doc;
+    const Context& context;
+    const Percolator& percolator;
+    MemoryIndex all;
+    std::unordered_map<std::string, MemoryIndex> fields;
+
+    DocumentView(const Document& d, const Context& c, const Percolator& p) : doc(d), context(c), percolator(p) {
+        addText(doc.getAllText(), all);
+        // Keyword and numeric values as field-qualified terms
+        for (const auto& [field, value] : doc.fields) {
+            const FieldType type = context.schema.fieldType(field);
+            int64_t key = 0;
+            if (type == FieldType::KEYWORD) {
+                addTerm(fieldTerm(field, DocValues::normalizeKeyword(value)));
+            } else if (isNumericType(type) && DocValues::parseValue(type, value, key)) {
+                addTerm(fieldTerm(field, std::to_string(key)));
+            }
+        }
+    }
+
+    const MemoryIndex& field(const std::string& name) {
+        auto it = fields.find(name);
+        if (it == fields.end()) {
+            it = fields.emplace(name, MemoryIndex()).first;
+            auto value = doc.fields.find(name);
+            if (value != doc.fields.end()) {
+                addText(value->second, it->second);
+            }
+        }
+        return it->second;
+    }
+
+    // Only terms some stored query names are kept
+    void addText(const std::string& text, MemoryIndex& index) {
+        for (const auto& token : context.tokenizer.tokenizeWithPositions(text)) {
+            auto id = percolator.term_ids_.find(token.text);
+            if (id != percolator.term_ids_.end()) {
+                index.positions[id->second].push_back(token.position);
+            }
+        }
+    }
+
+    void addTerm(const std::string& term) {
+        auto id = percolator.term_ids_.find(term);
+        if (id != percolator.term_ids_.end()) {
+            all.positions[id->second];
+        }
+    }
+};
+
+std::string Percolator::fieldTerm(const std::string& field, const std::string& value) {
+    // \x01 never survives tokenization, so these cannot collide with words
+    return "\x01" + field + "\x01" + value;
+}
+
+uint32_t Percolator::termId(const std::string& term) {
+    auto [it, inserted] = term_ids_.emplace(term, 0);
+    if (inserted) {
+        if (free_terms_.empty()) {
+            it->second = static_cast<uint32_t>(term_text_.size());
+            term_text_.push_back(term);
+            postings_.emplace_back();
+            term_refs_.push_back(0);
+        } else {
+            it->second = free_terms_.back();
+            free_terms_.pop_back();
+            term_text_[it->second] = term;
+        }
+    }
+    ++term_refs_[it->second];
+    return it->second;
+}
+
+void Percolator::releaseTerms(const StoredQuery& query) {
+    // One reference per termId() call: each TERM node's id and each entry
+    // of `terms` (PHRASE / FIELD)
+    const auto release = [this](uint32_t term) {
+        if (--term_refs_[term] > 0) {
+            return;
+        }
+        // No query is indexed under a term none of them names
+        term_ids_.erase(term_text_[term]);
+        std::string().swap(term_text_[term]);
+        std::vector<uint32_t>().swap(postings_[term]);
+        free_terms_.push_back(term);
+    };
+    for (const auto& node : query.nodes) {
+        if (node.kind == Node::TERM) {
+            release(node.arg);
+        }
+    }
+    for (uint32_t term : query.terms) {
+        release(term);
+    }
+
+    // Trailing free ids shrink the dictionary instead of waiting for reuse
+    size_t size = term_text_.size();
+    while (size > 0 && term_refs_[size - 1] == 0) {
+        --size;
+    }
+    if (size < term_text_.size()) {
+        term_text_.resize(size);
+        postings_.resize(size);
+        term_refs_.resize(size);
+        free_terms_.erase(std::remove_if(free_terms_.begin(), free_terms_.end(),
+                                         [size](uint32_t term) { return term >= size; }),
+                          free_terms_.end());
+    }
+}
+
+// ==================== Compilation ====================
+
+bool Percolator::addQuery(uint64_t id, const std::string& query, const Context& context) {
+    StoredQuery stored;
+    stored.id = id;
+    stored.text = query;
+    if (!compile(stored, context)) {
+        releaseTerms(stored);
+        return false;
+    }
+    removeQuery(id);
+    const uint32_t slot = static_cast<uint32_t>(slots_.size());
+    slots_.push_back(std::move(stored));
+    slot_of_[id] = slot;
+    index(slot);
+    return true;
+}
+
+bool Percolator::compile(StoredQuery& query, const Context& context) {
+    QueryParser parser;
+    const auto root = parser.parse(query.text);
+    compileNode(*root, query, context);
+    if (query.nodes.front().kind == Node::ALL) {
+        return false;  // Empty, or nothing but stop words
+    }
+
+    double cost = 0.0;
+    if (requiredTerms(query, 0, context, query.indexed, cost)) {
+        std::sort(query.indexed.begin(), query.indexed.end());
+        query.indexed.erase(std::unique(query.indexed.begin(), query.indexed.end()), query.indexed.end());
+    } else {
+        query.indexed.clear();
+        query.always_checked = true;
+    }
+    return true;
+}
+
+void Percolator::compileNode(const QueryNode& node, StoredQuery& query, const Context& context) {
+    const size_t at = query.nodes.size();
+    query.nodes.emplace_back();
+    switch (node.getType()) {
+        case QueryNode::Type::TERM:
+            analyzeWords({static_cast<const TermNode&>(node).term}, query, at, context);
+            break;
+        case QueryNode::Type::PHRASE: {
+            const auto& phrase = static_cast<const PhraseNode&>(node);
+            analyzeWords(phrase.terms, query, at, context);
+            query.nodes[at].slop = phrase.max_distance;
+            break;
+        }
+        case QueryNode::Type::FIELD: {
+            const auto& field = static_cast<const FieldNode&>(node);
+            std::vector<std::string> words;
+            int32_t slop = 0;
+            if (field.query->getType() == QueryNode::Type::TERM) {
+                words.push_back(static_cast<const TermNode&>(*field.query).term);
+            } else if (field.query->getType() == QueryNode::Type::PHRASE) {
+                words = static_cast<const PhraseNode&>(*field.query).terms;
+                slop = static_cast<const PhraseNode&>(*field.query).max_distance;
+            }
+            std::string value;
+            for (const auto& word : words) {
+                value += (value.empty() ? "" : " ") + word;
+            }
+            const FieldType type = context.schema.fieldType(field.field_name);
+            int64_t key = 0;
+            if (words.empty()) {
+                query.nodes[at].kind = Node::NONE;
+            } else if (type == FieldType::KEYWORD) {
+                query.nodes[at].kind = Node::TERM;
+                query.nodes[at].arg = termId(fieldTerm(field.field_name, DocValues::normalizeKeyword(value)));
+            } else if (isNumericType(type)) {
+                const bool parsed = DocValues::parseValue(type, value, key);
+                query.nodes[at].kind = parsed ? Node::TERM : Node::NONE;
+                query.nodes[at].arg = parsed ? termId(fieldTerm(field.field_name, std::to_string(key))) : 0;
+            } else {
+                analyzeWords(words, query, at, context);
+                if (query.nodes[at].kind == Node::TERM) {
+                    // One word: still a position list lookup in the field
+                    query.terms.push_back(query.nodes[at].arg);
+                    query.nodes[at].arg = static_cast<uint32_t>(query.terms.size() - 1);
+                }
+                if (query.nodes[at].kind != Node::ALL) {
+                    query.nodes[at].kind = Node::FIELD;
+                    query.nodes[at].field = static_cast<uint32_t>(query.values.size());
+                    query.nodes[at].slop = slop;
+                    query.values.push_back(field.field_name);
+                }
+            }
+            break;
+        }
+        case QueryNode::Type::RANGE: {
+            const auto& range = static_cast<const RangeNode&>(node);
+            const FieldType type = context.schema.fieldType(range.field_name);
+            int64_t lower = 0;
+            int64_t upper = 0;
+            const bool valid = DocValues::rangeKeys(type, range.lower, range.include_lower, range.upper,
+                                                    range.include_upper, lower, upper);
+            Node& compiled = query.nodes[at];
+            compiled.kind = valid ? Node::RANGE : Node::NONE;
+            compiled.type = static_cast<uint8_t>(type);
+            compiled.arg = static_cast<uint32_t>(query.keys.size());
+            compiled.field = static_cast<uint32_t>(query.values.size());
+            query.keys.push_back(lower);
+            query.keys.push_back(upper);
+            query.values.push_back(range.field_name);
+            break;
+        }
+        case QueryNode::Type::AND:
+        case QueryNode::Type::OR: {
+            const auto& children = node.getType() == QueryNode::Type::AND
+                                       ? static_cast<const AndNode&>(node).children
+                                       : static_cast<const OrNode&>(node).children;
+            query.nodes[at].kind = node.getType() == QueryNode::Type::AND ? Node::AND : Node::OR;
+            query.nodes[at].count = static_cast<uint32_t>(children.size());
+            for (const auto& child : children) {
+                compileNode(*child, query, context);
+            }
+            break;
+        }
+        case QueryNode::Type::NOT:
+            query.nodes[at].kind = Node::NOT;
+            query.nodes[at].count = 1;
+            compileNode(*static_cast<const NotNode&>(node).child, query, context);
+            break;
+        default:
+            query.nodes[at].kind = Node::NONE;
+            break;
+    }
+    query.nodes[at].span = static_cast<uint32_t>(query.nodes.size() - at);
+}
+
+void Percolator::analyzeWords(const std::vector<std::string>& words, StoredQuery& query, size_t node,
+                              const Context& context) {
+    // Words go through the indexing tokenizer: case, stemming, stop words
+    std::vector<uint32_t> ids;
+    for (const auto& word : words) {
+        for (const auto& token : context.tokenizer.tokenize(word)) {
+            ids.push_back(termId(token));
+        }
+    }
+    Node& compiled = query.nodes[node];
+    if (ids.empty()) {
+        compiled.kind = Node::ALL;
+    } else if (ids.size() == 1) {
+        compiled.kind = Node::TERM;
+        compiled.arg = ids.front();
+        compiled.count = 1;
+    } else {
+        compiled.kind = Node::PHRASE;
+        compiled.arg = static_cast<uint32_t>(query.terms.size());
+        compiled.count = static_cast<uint32_t>(ids.size());
+        query.terms.insert(query.terms.end(), ids.begin(), ids.end());
+    }
+}
+
+// ==================== Pre-filter ====================
+
+double Percolator::termCost(uint32_t term, const Context& context) const {
+    const std::string& text = term_text_[term];
+    if (!text.empty() && text.front() == '\x01') {
+        // Keyword value: average documents per value; numeric value: rare
+        const KeywordColumn* column = context.schema.keywordColumn(text.substr(1, text.find('\x01', 1) - 1));
+        return column && !column->values.empty()
+                   ? static_cast<double>(column->ords.size()) / static_cast<double>(column->values.size())
+                   : 1.0;
+    }
+    // Without frequencies, longer words are the better guess
+    const double df = context.document_frequency ? static_cast<double>(context.document_frequency(text)) : 0.0;
+    return df + 1.0 / static_cast<double>(1 + text.size());
+}
+
+bool Percolator::requiredTerms(const StoredQuery& query, size_t node, const Context& context,
+                               std::vector<uint32_t>& terms, double& cost) const {
+    const Node& compiled = query.nodes[node];
+    switch (compiled.kind) {
+        case Node::NONE:
+            terms.clear();  // Never matches: never a candidate
+            cost = 0.0;
+            return true;
+        case Node::TERM:
+            terms.assign(1, compiled.arg);
+            cost = termCost(compiled.arg, context);
+            return true;
+        case Node::PHRASE:
+        case Node::FIELD: {
+            // Every word is required: the rarest one will do
+            terms.assign(1, query.terms[compiled.arg]);
+            cost = termCost(terms.front(), context);
+            for (uint32_t i = 1; i < compiled.count; ++i) {
+                const uint32_t term = query.terms[compiled.arg + i];
+                const double term_cost = termCost(term, context);
+                if (term_cost < cost) {
+                    terms.assign(1, term);
+                    cost = term_cost;
+                }
+            }
+            return true;
+        }
+        case Node::AND: {
+            bool found = false;
+            std::vector<uint32_t> child_terms;
+            double child_cost = 0.0;
+            size_t child = node + 1;
+            for (uint32_t i = 0; i < compiled.count; ++i, child += query.nodes[child].span) {
+                if (requiredTerms(query, child, context, child_terms, child_cost) && (!found || child_cost < cost)) {
+                    terms.swap(child_terms);
+                    cost = child_cost;
+                    found = true;
+                }
+            }
+            return found;
+        }
+        case Node::OR: {
+            terms.clear();
+            cost = 0.0;
+            std::vector<uint32_t> child_terms;
+            double child_cost = 0.0;
+            size_t child = node + 1;
+            for (uint32_t i = 0; i < compiled.count; ++i, child += query.nodes[child].span) {
+                if (!requiredTerms(query, child, context, child_terms, child_cost)) {
+                    return false;
+                }
+                terms.insert(terms.end(), child_terms.begin(), child_terms.end());
+                cost += child_cost;
+            }
+            return true;
+        }
+        default:
+            return false;  // ALL, RANGE, NOT
+    }
+}
+
+void Percolator::index(uint32_t slot) {
+    const StoredQuery& query = slots_[slot];
+    if (query.always_checked) {
+        unindexed_.push_back(slot);
+    }
+    for (uint32_t term : query.indexed) {
+        postings_[term].push_back(slot);
+    }
+}
+
+void Percolator::unindex(uint32_t slot) {
+    const auto erase = [slot](std::vector<uint32_t>& slots) {
+        auto it = std::find(slots.begin(), slots.end(), slot);
+        if (it != slots.end()) {
+            *it = slots.back();
+            slots.pop_back();
+        }
+        if (slots.empty()) {
+            std::vector<uint32_t>().swap(slots);  // Drop the empty list's capacity
+        }
+    };
+    const StoredQuery& query = slots_[slot];
+    if (query.always_checked) {
+        erase(unindexed_);
+    }
+    for (uint32_t term : query.indexed) {
+        erase(postings_[term]);
+    }
+}
+
+bool Percolator::removeQuery(uint64_t id) {
+    auto it = slot_of_.find(id);
+    if (it == slot_of_.end()) {
+        return false;
+    }
+    const uint32_t slot = it->second;
+    const uint32_t last = static_cast<uint32_t>(slots_.size() - 1);
+    slot_of_.erase(it);
+    unindex(slot);
+    releaseTerms(slots_[slot]);
+    if (slot != last) {
+        unindex(last);
+        slots_[slot] = std::move(slots_[last]);
+        slot_of_[slots_[slot].id] = slot;
+        index(slot);
+    }
+    slots_.pop_back();
+    return true;
+}
+
+void Percolator::rebuild(const Context& context) {
+    std::vector<std::pair<uint64_t, std::string>> queries;
+    queries.reserve(slots_.size());
+    for (auto& query : slots_) {
+        queries.emplace_back(query.id, std::move(query.text));
+    }
+    clear();
+    for (const auto& [id, text] : queries) {
+        addQuery(id, text, context);
+    }
+}
+
+void Percolator::clear() {
+    slots_.clear();
+    slot_of_.clear();
+    term_ids_.clear();
+    term_text_.clear();
+    postings_.clear();
+    term_refs_.clear();
+    free_terms_.clear();
+    unindexed_.clear();
+}
+
+// ==================== Matching ====================
+
+std::vector<uint64_t> Percolator::percolate(const Document& doc, const Context& context, PercolateStats* stats) const {
+    DocumentView view(doc, context, *this);
+    std::vector<uint32_t> candidates = unindexed_;
+    for (const auto& entry : view.all.positions) {
+        const auto& slots = postings_[entry.first];
+        candidates.insert(candidates.end(), slots.begin(), slots.end());
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    return verify(candidates, view, stats);
+}
+
+std::vector<uint64_t> Percolator::percolateExhaustive(const Document& doc, const Context& context) const {
+    DocumentView view(doc, context, *this);
+    std::vector<uint32_t> all(slots_.size());
+    for (uint32_t slot = 0; slot < all.size(); ++slot) {
+        all[slot] = slot;
+    }
+    return verify(all, view, nullptr);
+}
+
+std::vector<uint64_t> Percolator::verify(const std::vector<uint32_t>& slots, DocumentView& doc,
+                                         PercolateStats* stats) const {
+    std::vector<uint64_t> ids;
+    for (uint32_t slot : slots) {
+        if (matches(slots_[slot], 0, doc)) {
+            ids.push_back(slots_[slot].id);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    if (stats) {
+        stats->candidates = slots.size();
+        stats->matches = ids.size();
+    }
+    return ids;
+}
+
+bool Percolator::matches(const StoredQuery& query, size_t node, DocumentView& doc) const {
+    const Node& compiled = query.nodes[node];
+    switch (compiled.kind) {
+        case Node::ALL:
+            return true;
+        case Node::NONE:
+            return false;
+        case Node::TERM:
+            return doc.all.positions.count(compiled.arg) > 0;
+        case Node::PHRASE:
+        case Node::FIELD: {
+            const MemoryIndex& index =
+                compiled.kind == Node::FIELD ? doc.field(query.values[compiled.field]) : doc.all;
+            std::vector<const std::vector<uint32_t>*> positions;
+            positions.reserve(compiled.count);
+            for (uint32_t i = 0; i < compiled.count; ++i) {
+                auto it = index.positions.find(query.terms[compiled.arg + i]);
+                if (it == index.positions.end()) {
+                    return false;
+                }
+                positions.push_back(&it->second);
+            }
+            return phraseMatches(positions, compiled.slop);
+        }
+        case Node::RANGE: {
+            auto value = doc.doc.fields.find(query.values[compiled.field]);
+            int64_t key = 0;
+            return value != doc.doc.fields.end() &&
+                   DocValues::parseValue(static_cast<FieldType>(compiled.type), value->second, key) &&
+                   key >= query.keys[compiled.arg] && key <= query.keys[compiled.arg + 1];
+        }
+        case Node::AND:
+        case Node::OR: {
+            const bool all = compiled.kind == Node::AND;
+            size_t child = node + 1;
+            for (uint32_t i = 0; i < compiled.count; ++i, child += query.nodes[child].span) {
+                if (matches(query, child, doc) != all) {
+                    return !all;
+                }
+            }
+            return all;
+        }
+        case Node::NOT:
+            return !matches(query, node + 1, doc);
+    }
+    return false;
+}
+
+bool Percolator::phraseMatches(const std::vector<const std::vector<uint32_t>*>& positions, int32_t slop) {
+    // In order, each word at its earliest position after the previous one,
+    // within (words - 1 + slop) positions of the first
+    const uint32_t window = static_cast<uint32_t>(positions.size() - 1) + static_cast<uint32_t>(std::max(slop, 0));
+    for (uint32_t start : *positions.front()) {
+        uint32_t previous = start;
+        bool complete = true;
+        for (size_t i = 1; i < positions.size(); ++i) {
+            auto next = std::upper_bound(positions[i]->begin(), positions[i]->end(), previous);
+            if (next == positions[i]->end()) {
+                return false;  // Later starts cannot do better
+            }
+            previous = *next;
+            if (previous - start > window) {
+                complete = false;
+                break;
+            }
+        }
+        if (complete) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Percolator::memoryUsage() const {
+    using namespace memory_accounting;
+    size_t bytes = sizeof(*this) + vectorUsedBytes(slots_) + hashTableBytes(slot_of_) + hashTableBytes(term_ids_) +
+                   vectorUsedBytes(term_text_) + vectorUsedBytes(postings_) + vectorUsedBytes(term_refs_) +
+                   vectorUsedBytes(free_terms_) + vectorUsedBytes(unindexed_);
+    for (const auto& query : slots_) {
+        bytes += stringHeapBytes(query.text) + vectorUsedBytes(query.nodes) + vectorUsedBytes(query.terms) +
+                 vectorUsedBytes(query.keys) + vectorUsedBytes(query.values) + vectorUsedBytes(query.indexed);
+        for (const auto& value : query.values) {
+            bytes += stringHeapBytes(value);
+        }
+    }
+    for (const auto& [term, id] : term_ids_) {
+        bytes += 2 * stringHeapBytes(term);  // Key and term_text_ copy
+    }
+    for (const auto& slots : postings_) {
+        bytes += vectorUsedBytes(slots);
+    }
+    return bytes;
+}
+
+}  // namespace rtrv_search_engine
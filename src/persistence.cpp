@@ -39,6 +39,11 @@ bool Persistence::save(const SearchEngine& engine, const std::string& filepath)
             file.write(reinterpret_cast<const char*>(&val_len), sizeof(val_len));
             file.write(value.data(), val_len);
         }
+        
+        // Write vector
+        size_t vector_len = doc.vector.size();
+        file.write(reinterpret_cast<const char*>(&vector_len), sizeof(vector_len));
+        file.write(reinterpret_cast<const char*>(doc.vector.data()), vector_len * sizeof(float));
     }
     
     // Write inverted index
@@ -70,6 +75,23 @@ bool Persistence::save(const SearchEngine& engine, const std::string& filepath)
         }
     }
     
+    // Write vector index (graph included, so loading does not rebuild it)
+    const uint8_t has_vector_index = engine.vector_index_ ? 1 : 0;
+    file.write(reinterpret_cast<const char*>(&has_vector_index), sizeof(has_vector_index));
+    if (engine.vector_index_) {
+        const auto& vector_index = *engine.vector_index_;
+        const uint64_t dimension = vector_index.dimension();
+        const uint32_t metric = static_cast<uint32_t>(vector_index.metric());
+        const HnswParams& params = vector_index.params();
+        const uint64_t hnsw_params[] = {params.m, params.ef_construction, params.ef_search, params.seed,
+                                        static_cast<uint64_t>(params.quantization), params.pq_subspaces,
+                                        params.train_size, params.rescore_factor};
+        file.write(reinterpret_cast<const char*>(&dimension), sizeof(dimension));
+        file.write(reinterpret_cast<const char*>(&metric), sizeof(metric));
+        file.write(reinterpret_cast<const char*>(hnsw_params), sizeof(hnsw_params));
+        vector_index.save(file);
+    }
+    
     return file.good();
 }
 
@@ -82,12 +104,15 @@ bool Persistence::load(SearchEngine& engine, const std::string& filepath) {
     // Read and validate header
     SnapshotHeader header;
     file.read(reinterpret_cast<char*>(&header), sizeof(header));
-    if (header.magic != 0x53454152 || header.version != 1) {
+    if (header.magic != 0x53454152 || header.version < 1 || header.version > 3) {
         return false;  // Invalid file format
     }
     
     // Clear existing state
     engine.documents_.clear();
+    engine.term_offsets_.clear();  // Not persisted; snippets re-tokenize hits
+    engine.term_vectors_.clear();  // Not persisted; more-like-this re-tokenizes its source
+    engine.doc_values_.clear();    // Rebuilt below from the stored fields
     engine.index_->clear();
     
     // Read next_doc_id
@@ -123,7 +148,16 @@ bool Persistence::load(SearchEngine& engine, const std::string& filepath) {
         // Create and store document
         Document doc{static_cast<uint32_t>(doc_id), fields};
         doc.term_count = term_count;
+        
+        // Read vector
+        if (header.version >= 2) {
+            size_t vector_len;
+            file.read(reinterpret_cast<char*>(&vector_len), sizeof(vector_len));
+            doc.vector.resize(vector_len);
+            file.read(reinterpret_cast<char*>(doc.vector.data()), vector_len * sizeof(float));
+        }
         engine.documents_[doc_id] = doc;
+        engine.doc_values_.addDocument(doc_id, doc);
     }
     
     // Read inverted index
@@ -162,6 +196,54 @@ bool Persistence::load(SearchEngine& engine, const std::string& filepath) {
         }
     }
     
+    // Read vector index
+    uint8_t has_vector_index = 0;
+    if (header.version >= 2) {
+        file.read(reinterpret_cast<char*>(&has_vector_index), sizeof(has_vector_index));
+    }
+    if (has_vector_index) {
+        uint64_t dimension;
+        uint32_t metric;
+        uint64_t hnsw_params[8] = {};
+        const size_t param_count = header.version >= 3 ? 8 : 4;  // v3 adds quantization
+        file.read(reinterpret_cast<char*>(&dimension), sizeof(dimension));
+        file.read(reinterpret_cast<char*>(&metric), sizeof(metric));
+        file.read(reinterpret_cast<char*>(hnsw_params), param_count * sizeof(uint64_t));
+        
+        HnswParams params;
+        params.m = hnsw_params[0];
+        params.ef_construction = hnsw_params[1];
+        params.ef_search = hnsw_params[2];
+        params.seed = hnsw_params[3];
+        if (param_count == 8) {
+            params.quantization = static_cast<VectorQuantization>(hnsw_params[4]);
+            params.pq_subspaces = hnsw_params[5];
+            params.train_size = hnsw_params[6];
+            params.rescore_factor = hnsw_params[7];
+        }
+        // The full-precision file is deployment configuration, not index
+        // state: keep the path of the engine's configured index, if any
+        if (engine.vector_index_) {
+            params.vector_file = engine.vector_index_->params().vector_file;
+        }
+        engine.vector_index_.reset();  // Unmap before the file is reopened
+        engine.vector_index_ = std::make_unique<HnswIndex>(
+            dimension, static_cast<VectorMetric>(metric), params);
+        if (!engine.vector_index_->load(file)) {
+            engine.vector_index_.reset();
+            return false;
+        }
+    } else if (engine.vector_index_) {
+        // Keep the configured index, filled from the loaded documents
+        engine.vector_index_->clear();
+        const bool quantizes = engine.vector_index_->params().quantization != VectorQuantization::NONE;
+        for (auto& [doc_id, doc] : engine.documents_) {
+            if (engine.vector_index_->add(doc_id, doc.vector) && quantizes) {
+                std::vector<float>().swap(doc.vector);  // As indexDocument() does
+            }
+        }
+    }
+    
     return file.good();
 }
 
@@ -0,0 +1,123 @@
+#include "profiling.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace rtrv_search_engine {
+
+namespace {
+
+// Constant-initialized, so it is safe to touch from operator new on any
+// thread, including during thread start-up and shutdown
+thread_local ThreadProfile thread_profile;
+
+}  // anonymous namespace
+
+ThreadProfile& ThreadProfile::operator+=(const ThreadProfile& other) {
+    for (size_t i = 0; i < NUM_LOCK_SITES; ++i) {
+        locks[i].acquisitions += other.locks[i].acquisitions;
+        locks[i].contended += other.locks[i].contended;
+        locks[i].wait_ns += other.locks[i].wait_ns;
+    }
+    allocations += other.allocations;
+    allocated_bytes += other.allocated_bytes;
+    return *this;
+}
+
+namespace profiling {
+
+ThreadProfile& threadProfile() {
+    return thread_profile;
+}
+
+void resetThreadProfile() {
+    thread_profile = ThreadProfile{};
+}
+
+const char* lockSiteName(LockSite site) {
+    switch (site) {
+        case LockSite::SEARCH_ENGINE: return "search_engine";
+        case LockSite::INVERTED_INDEX: return "inverted_index";
+        case LockSite::QUERY_CACHE: return "query_cache";
+        case LockSite::FILTER_CACHE: return "filter_cache";
+    }
+    return "unknown";
+}
+
+}  // namespace profiling
+
+}  // namespace rtrv_search_engine
+
+#ifdef RTRV_PROFILING
+
+// ==================== Allocation Counting ====================
+// Replaces the global allocation functions for every binary linked against
+// the profiling build. Array and nothrow forms forward to these, and the
+// std::align_val_t forms (over-aligned types such as SIMD buffers) count
+// the same way.
+
+void* operator new(std::size_t size) {
+    auto& profile = rtrv_search_engine::profiling::threadProfile();
+    profile.allocations++;
+    profile.allocated_bytes += size;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    auto& profile = rtrv_search_engine::profiling::threadProfile();
+    profile.allocations++;
+    profile.allocated_bytes += size;
+    // aligned_alloc wants a non-zero multiple of the alignment
+    const auto align = static_cast<std::size_t>(alignment);
+    const std::size_t rounded = size ? (size + align - 1) / align * align : align;
+    if (void* ptr = std::aligned_alloc(align, rounded)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return ::operator new(size, alignment, std::nothrow);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+#endif  // RTRV_PROFILING
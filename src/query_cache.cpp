@@ -1,4 +1,5 @@
 #include "query_cache.hpp"
+#include "memory_usage.hpp"
 
 namespace rtrv_search_engine {
 
@@ -101,6 +102,37 @@ CacheStatistics QueryCache::getStats() const {
     return stats;
 }
 
+size_t QueryCache::memoryUsage() const {
+    using namespace memory_accounting;
+    std::shared_lock read_lock(mutex_);
+
+    // std::list node: value + prev/next pointers
+    size_t bytes = hashTableBytes(entries_) +
+                   lru_order_.size() * (sizeof(QueryCacheKey) + 2 * kNodeLinkBytes);
+    for (const auto& key : lru_order_) {
+        bytes += stringHeapBytes(key.normalized_query);
+    }
+
+    for (const auto& [key, entry] : entries_) {
+        bytes += stringHeapBytes(key.normalized_query);
+        bytes += entry.results.capacity() * sizeof(SearchResult);
+        for (const auto& result : entry.results) {
+            bytes += result.document.memoryUsage();
+            bytes += stringHeapBytes(result.explanation);
+            bytes += result.snippets.capacity() * sizeof(std::string);
+            for (const auto& snippet : result.snippets) {
+                bytes += stringHeapBytes(snippet);
+            }
+            bytes += hashTableBytes(result.expanded_terms);
+            for (const auto& [original, corrected] : result.expanded_terms) {
+                bytes += stringHeapBytes(original) + stringHeapBytes(corrected);
+            }
+        }
+    }
+
+    return bytes;
+}
+
 bool QueryCache::isExpired(const Entry& entry, std::chrono::steady_clock::time_point now) const {
     if (ttl_.count() <= 0) {
         return false;
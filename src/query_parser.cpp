@@ -43,6 +43,11 @@ std::string OrNode::toString() const {
     return result;
 }
 
+std::string RangeNode::toString() const {
+    return field_name + ":" + (include_lower ? "[" : "{") + (lower.empty() ? "*" : lower) + " TO " +
+           (upper.empty() ? "*" : upper) + (include_upper ? "]" : "}");
+}
+
 // ============================================================================
 // QueryParser implementation
 // ============================================================================
@@ -101,6 +106,16 @@ void QueryParser::tokenizeQuery(const std::string& query_string) {
             continue;
         }
         
+        // Ranges: kept whole (bounds such as dates contain ':' and '-'),
+        // split by parseRange
+        if (c == '[' || c == '{') {
+            size_t end = query_string.find_first_of("]}", i);
+            end = (end == std::string::npos) ? query_string.length() : end + 1;
+            tokens_.emplace_back(QueryTokenType::RANGE, query_string.substr(i, end - i));
+            i = end;
+            continue;
+        }
+        
         // Numbers
         if (std::isdigit(c)) {
             std::string number;
@@ -131,6 +146,9 @@ void QueryParser::tokenizeQuery(const std::string& query_string) {
                 tokens_.emplace_back(QueryTokenType::OR_OP, word);
             } else if (word_upper == "NOT") {
                 tokens_.emplace_back(QueryTokenType::NOT_OP, word);
+            } else if (i < query_string.length() && query_string[i] == ':') {
+                // Field names are matched against the schema as written
+                tokens_.emplace_back(QueryTokenType::WORD, word);
             } else {
                 // Convert to lowercase for terms
                 std::transform(word.begin(), word.end(), word.begin(), ::tolower);
@@ -352,16 +370,46 @@ std::unique_ptr<QueryNode> QueryParser::parseFieldedTerm() {
         throw std::runtime_error("Expected colon after field name");
     }
     
+    if (peek().type == QueryTokenType::RANGE) {
+        return parseRange(std::move(field_name));
+    }
+    
     std::unique_ptr<QueryNode> query;
     if (peek().type == QueryTokenType::QUOTE) {
         query = parsePhrase();
+    } else if (peek().type == QueryTokenType::NUMBER) {
+        query = std::make_unique<TermNode>(advance().value);  // e.g. year:2024
     } else {
         query = parseTerm();
     }
+    if (!query) {
+        throw std::runtime_error("Expected term after field name");
+    }
     
     return std::make_unique<FieldNode>(field_name, std::move(query));
 }
 
+std::unique_ptr<QueryNode> QueryParser::parseRange(std::string field_name) {
+    // range ::= ('[' | '{') bound 'TO' bound (']' | '}'),  bound ::= value | '*'
+    
+    const std::string text = advance().value;
+    if (text.size() < 2 || (text.back() != ']' && text.back() != '}')) {
+        throw std::runtime_error("Expected closing bracket in range");
+    }
+    
+    std::istringstream parts(text.substr(1, text.size() - 2));
+    std::string lower, to, upper, extra;
+    parts >> lower >> to >> upper;
+    std::string to_upper = to;
+    std::transform(to_upper.begin(), to_upper.end(), to_upper.begin(), ::toupper);
+    if (lower.empty() || upper.empty() || to_upper != "TO" || (parts >> extra)) {
+        throw std::runtime_error("Expected 'lower TO upper' in range");
+    }
+    
+    return std::make_unique<RangeNode>(std::move(field_name), lower == "*" ? "" : lower,
+                                       upper == "*" ? "" : upper, text.front() == '[', text.back() == ']');
+}
+
 std::unique_ptr<QueryNode> QueryParser::parseTerm() {
     // term ::= word
     
@@ -393,6 +441,18 @@ std::vector<std::string> QueryParser::extractTerms(const std::string& query_stri
             continue;
         }
         
+        // Range clause (field:[..] or field:{..}): drop it together with its
+        // field name. Other brackets split words like any punctuation.
+        if (c == ':' && !current_term.empty() && i + 1 < query_string.length() &&
+            (query_string[i + 1] == '[' || query_string[i + 1] == '{')) {
+            const size_t close = query_string.find_first_of("]}", i + 2);
+            if (close != std::string::npos) {
+                current_term.clear();
+                i = close;
+                continue;
+            }
+        }
+        
         // Outside quotes, split on whitespace and punctuation
         if (std::isspace(c) || std::ispunct(c)) {
             if (!current_term.empty()) {
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cctype>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace rtrv_search_engine {
 
@@ -23,7 +24,9 @@ double TfIdfRanker::score(const Query& query,
     
     double score = 0.0;
     
-    for (const auto& query_term : query.terms) {
+    for (size_t i = 0; i < query.terms.size(); ++i) {
+        const auto& query_term = query.terms[i];
+        
         // Get term frequency in document (simplified)
         uint32_t tf = 0;
         size_t pos = 0;
@@ -38,6 +41,9 @@ double TfIdfRanker::score(const Query& query,
             tf++;
             pos += lower_term.length();
         }
+        if (tf == 0 && stats.indexed_tf) {
+            tf = stats.indexed_tf(query_term, doc.id);
+        }
         
         if (tf > 0) {
             // Get document frequency
@@ -50,7 +56,7 @@ double TfIdfRanker::score(const Query& query,
             double tf_component = std::log(1.0 + tf);
             double idf_component = std::log(static_cast<double>(stats.total_docs) / df);
             
-            score += tf_component * idf_component;
+            score += query.weight(i) * tf_component * idf_component;
         }
     }
     
@@ -76,7 +82,9 @@ double Bm25Ranker::score(const Query& query,
     
     double score = 0.0;
     
-    for (const auto& query_term : query.terms) {
+    for (size_t i = 0; i < query.terms.size(); ++i) {
+        const auto& query_term = query.terms[i];
+        
         // Get term frequency in document (simplified)
         uint32_t tf = 0;
         size_t pos = 0;
@@ -91,6 +99,9 @@ double Bm25Ranker::score(const Query& query,
             tf++;
             pos += lower_term.length();
         }
+        if (tf == 0 && stats.indexed_tf) {
+            tf = stats.indexed_tf(query_term, doc.id);
+        }
         
         if (tf > 0) {
             // Get document frequency
@@ -109,7 +120,7 @@ double Bm25Ranker::score(const Query& query,
             double normalized_length = 1.0 - b_ + b_ * (doc_length / stats.avg_doc_length);
             double tf_component = (tf * (k1_ + 1.0)) / (tf + k1_ * normalized_length);
             
-            score += idf * tf_component;
+            score += query.weight(i) * idf * tf_component;
         }
     }
     
@@ -196,6 +207,72 @@ double CustomMLRanker::score(const Query& query,
     return score;
 }
 
+// ============================================================================
+// Hybrid Ranker Implementation
+// ============================================================================
+
+HybridRanker::HybridRanker(const std::string& name, const FusionParams& params)
+    : name_(name), params_(params) {
+}
+
+HybridRanker::~HybridRanker() = default;
+
+double HybridRanker::score(const Query& query, 
+                           const Document& doc,
+                           const IndexStats& stats) {
+    return lexical_.score(query, doc, stats);
+}
+
+std::vector<FusedDocument> HybridRanker::fuse(const std::vector<ScoredDocument>& lexical,
+                                              const std::vector<ScoredDocument>& vector,
+                                              size_t k) const {
+    std::unordered_map<uint64_t, FusedDocument> fused;
+    fused.reserve(lexical.size() + vector.size());
+    
+    // Min-max range of one list (WEIGHTED); a single distinct score maps to 1
+    auto normalizer = [](const std::vector<ScoredDocument>& list) {
+        double lo = list.empty() ? 0.0 : list.front().score;
+        double hi = lo;
+        for (const auto& entry : list) {
+            lo = std::min(lo, entry.score);
+            hi = std::max(hi, entry.score);
+        }
+        return [lo, hi](double score) { return hi > lo ? (score - lo) / (hi - lo) : 1.0; };
+    };
+    
+    auto accumulate = [&](const std::vector<ScoredDocument>& list, double weight, bool is_lexical) {
+        const auto normalize = normalizer(list);
+        for (size_t i = 0; i < list.size(); ++i) {
+            const size_t rank = i + 1;
+            auto& entry = fused.try_emplace(list[i].doc_id,
+                                            FusedDocument{list[i].doc_id, 0.0, 0, 0.0, 0, 0.0}).first->second;
+            if (is_lexical) {
+                entry.lexical_rank = rank;
+                entry.lexical_score = list[i].score;
+            } else {
+                entry.vector_rank = rank;
+                entry.vector_score = list[i].score;
+            }
+            entry.score += params_.method == FusionMethod::RRF
+                               ? weight / (params_.rrf_k + static_cast<double>(rank))
+                               : weight * normalize(list[i].score);
+        }
+    };
+    accumulate(lexical, params_.lexical_weight, true);
+    accumulate(vector, params_.vector_weight, false);
+    
+    BoundedPriorityQueue<ScoredDocument> top_k(k);
+    for (const auto& [doc_id, entry] : fused) {
+        top_k.push({doc_id, entry.score});
+    }
+    
+    std::vector<FusedDocument> results;
+    for (const auto& scored : top_k.getSorted()) {
+        results.push_back(fused.at(scored.doc_id));
+    }
+    return results;
+}
+
 // ============================================================================
 // Ranker Registry Implementation
 // ============================================================================
@@ -206,6 +283,10 @@ RankerRegistry::RankerRegistry()
     registerRanker(std::make_unique<TfIdfRanker>());
     registerRanker(std::make_unique<Bm25Ranker>());
     registerRanker(std::make_unique<CustomMLRanker>());
+    registerRanker(std::make_unique<HybridRanker>("Hybrid-RRF"));
+    FusionParams weighted;
+    weighted.method = FusionMethod::WEIGHTED;
+    registerRanker(std::make_unique<HybridRanker>("Hybrid-Weighted", weighted));
 }
 
 RankerRegistry::~RankerRegistry() = default;
@@ -0,0 +1,140 @@
+#include "relevance_metrics.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace rtrv_search_engine {
+namespace relevance {
+
+Qrels parseTrecQrels(std::istream& input) {
+    Qrels qrels;
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        std::string query_id, iteration, doc_id;
+        int grade = 0;
+        if (!(fields >> query_id >> iteration >> doc_id >> grade)) {
+            continue;  // Blank or malformed line
+        }
+        if (!std::all_of(doc_id.begin(), doc_id.end(),
+                         [](unsigned char c) { return std::isdigit(c); })) {
+            continue;  // Engine doc ids are numeric
+        }
+        qrels[query_id][std::stoull(doc_id)] = grade;
+    }
+    return qrels;
+}
+
+Qrels loadTrecQrels(const std::string& filepath) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filepath);
+    }
+    return parseTrecQrels(file);
+}
+
+size_t relevantCount(const Judgments& judgments) {
+    return static_cast<size_t>(std::count_if(judgments.begin(), judgments.end(),
+                                             [](const auto& entry) { return entry.second > 0; }));
+}
+
+namespace {
+
+double gain(int grade) {
+    return grade > 0 ? std::pow(2.0, grade) - 1.0 : 0.0;
+}
+
+int gradeOf(const Judgments& judgments, uint64_t doc_id) {
+    auto it = judgments.find(doc_id);
+    return it != judgments.end() ? it->second : 0;
+}
+
+}  // anonymous namespace
+
+double ndcgAtK(const std::vector<uint64_t>& ranking, const Judgments& judgments, size_t k) {
+    double dcg = 0.0;
+    const size_t depth = std::min(k, ranking.size());
+    for (size_t i = 0; i < depth; ++i) {
+        dcg += gain(gradeOf(judgments, ranking[i])) / std::log2(static_cast<double>(i) + 2.0);
+    }
+
+    // Ideal DCG: judged documents sorted by grade
+    std::vector<int> grades;
+    grades.reserve(judgments.size());
+    for (const auto& [doc_id, grade] : judgments) {
+        if (grade > 0) {
+            grades.push_back(grade);
+        }
+    }
+    std::sort(grades.begin(), grades.end(), std::greater<int>());
+
+    double ideal = 0.0;
+    for (size_t i = 0; i < std::min(k, grades.size()); ++i) {
+        ideal += gain(grades[i]) / std::log2(static_cast<double>(i) + 2.0);
+    }
+    return ideal > 0.0 ? dcg / ideal : 0.0;
+}
+
+double reciprocalRank(const std::vector<uint64_t>& ranking, const Judgments& judgments) {
+    for (size_t i = 0; i < ranking.size(); ++i) {
+        if (gradeOf(judgments, ranking[i]) > 0) {
+            return 1.0 / static_cast<double>(i + 1);
+        }
+    }
+    return 0.0;
+}
+
+double recallAtK(const std::vector<uint64_t>& ranking, const Judgments& judgments, size_t k) {
+    const size_t relevant = relevantCount(judgments);
+    if (relevant == 0) {
+        return 0.0;
+    }
+    size_t retrieved = 0;
+    for (size_t i = 0; i < std::min(k, ranking.size()); ++i) {
+        if (gradeOf(judgments, ranking[i]) > 0) {
+            ++retrieved;
+        }
+    }
+    return static_cast<double>(retrieved) / relevant;
+}
+
+double rankBiasedOverlap(const std::vector<uint64_t>& ranking,
+                         const std::vector<uint64_t>& reference,
+                         double persistence) {
+    const size_t depth = std::max(ranking.size(), reference.size());
+    if (depth == 0) {
+        return 1.0;  // Two empty rankings agree
+    }
+
+    // RBO_ext = X_k/k * p^k + (1-p)/p * sum_{d=1..k} X_d/d * p^d
+    std::unordered_set<uint64_t> seen_ranking, seen_reference;
+    size_t overlap = 0;
+    double weighted_agreement = 0.0;
+    double p_power = 1.0;
+    for (size_t d = 0; d < depth; ++d) {
+        if (d < ranking.size()) {
+            const uint64_t doc_id = ranking[d];
+            if (seen_ranking.insert(doc_id).second && seen_reference.count(doc_id)) {
+                ++overlap;
+            }
+        }
+        if (d < reference.size()) {
+            const uint64_t doc_id = reference[d];
+            if (seen_reference.insert(doc_id).second && seen_ranking.count(doc_id)) {
+                ++overlap;
+            }
+        }
+        p_power *= persistence;
+        weighted_agreement += static_cast<double>(overlap) / (d + 1) * p_power;
+    }
+
+    const double agreement_at_depth = static_cast<double>(overlap) / depth;
+    return agreement_at_depth * p_power + (1.0 - persistence) / persistence * weighted_agreement;
+}
+
+}  // namespace relevance
+}  // namespace rtrv_search_engine
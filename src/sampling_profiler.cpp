@@ -0,0 +1,274 @@
+#include "sampling_profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define RTRV_SAMPLING_PROFILER 1
+#include <cerrno>
+#include <csignal>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+namespace rtrv_search_engine {
+
+namespace {
+
+// Sample buffer: records of [depth, pc_0 (leaf), ..., pc_{depth-1}] appended
+// through an atomic cursor. A zero header marks the end of written records.
+constexpr size_t kBufferWords = size_t(1) << 20;  // 8 MiB, ~50K samples at depth 20
+
+std::atomic<uintptr_t*> active_buffer{nullptr};
+
+#ifdef RTRV_SAMPLING_PROFILER
+
+std::mutex session_mutex;  // Serializes start()/stop(); never taken in the handler
+std::unique_ptr<uintptr_t[]> sample_buffer;
+std::atomic<size_t> buffer_cursor{0};
+std::atomic<size_t> sample_count{0};
+std::atomic<size_t> dropped_count{0};
+std::atomic<int> handlers_in_flight{0};
+pid_t profiled_pid = 0;
+bool handler_installed = false;
+
+// Reads another frame without faulting on a bad frame pointer:
+// process_vm_readv reports EFAULT instead of raising SIGSEGV
+bool readWords(uintptr_t address, uintptr_t* out, size_t count) {
+    iovec local{out, count * sizeof(uintptr_t)};
+    iovec remote{reinterpret_cast<void*>(address), count * sizeof(uintptr_t)};
+    return process_vm_readv(profiled_pid, &local, 1, &remote, 1, 0) ==
+           static_cast<ssize_t>(count * sizeof(uintptr_t));
+}
+
+size_t walkStack(const ucontext_t* context, uintptr_t* frames) {
+#if defined(__x86_64__)
+    uintptr_t pc = static_cast<uintptr_t>(context->uc_mcontext.gregs[REG_RIP]);
+    uintptr_t fp = static_cast<uintptr_t>(context->uc_mcontext.gregs[REG_RBP]);
+    const uintptr_t sp = static_cast<uintptr_t>(context->uc_mcontext.gregs[REG_RSP]);
+#else
+    uintptr_t pc = static_cast<uintptr_t>(context->uc_mcontext.pc);
+    uintptr_t fp = static_cast<uintptr_t>(context->uc_mcontext.regs[29]);
+    const uintptr_t sp = static_cast<uintptr_t>(context->uc_mcontext.sp);
+#endif
+    size_t depth = 0;
+    frames[depth++] = pc;
+
+    // Frame record: [saved frame pointer, return address]. Callers live at
+    // higher addresses, so a non-increasing chain means we left the stack.
+    while (depth < SamplingProfiler::kMaxDepth) {
+        if (fp == 0 || fp < sp || (fp & (sizeof(uintptr_t) - 1)) != 0) {
+            break;
+        }
+        uintptr_t record[2];
+        if (!readWords(fp, record, 2) || record[1] == 0) {
+            break;
+        }
+        frames[depth++] = record[1];
+        if (record[0] <= fp) {
+            break;
+        }
+        fp = record[0];
+    }
+    return depth;
+}
+
+void onSigprof(int, siginfo_t*, void* context) {
+    const int saved_errno = errno;
+    handlers_in_flight.fetch_add(1);
+
+    uintptr_t* buffer = active_buffer.load();
+    if (buffer != nullptr) {
+        uintptr_t frames[SamplingProfiler::kMaxDepth];
+        const size_t depth = walkStack(static_cast<const ucontext_t*>(context), frames);
+        const size_t begin = buffer_cursor.fetch_add(depth + 1, std::memory_order_relaxed);
+        if (begin + depth + 1 <= kBufferWords) {
+            std::copy(frames, frames + depth, buffer + begin + 1);
+            buffer[begin] = depth;
+            sample_count.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            dropped_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    handlers_in_flight.fetch_sub(1);
+    errno = saved_errno;
+}
+
+bool setTimer(int frequency_hz) {
+    itimerval timer{};
+    if (frequency_hz > 0) {
+        timer.it_interval.tv_usec = std::max(1, 1000000 / frequency_hz);
+        timer.it_value = timer.it_interval;
+    }
+    return setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+}
+
+std::string symbolize(uintptr_t pc) {
+    std::ostringstream name;
+    Dl_info info{};
+    if (dladdr(reinterpret_cast<void*>(pc), &info) != 0) {
+        if (info.dli_sname != nullptr) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            name << (status == 0 && demangled != nullptr ? demangled : info.dli_sname);
+            std::free(demangled);
+            return name.str();
+        }
+        if (info.dli_fname != nullptr) {
+            std::string module = info.dli_fname;
+            module = module.substr(module.find_last_of('/') + 1);
+            name << module << "+0x" << std::hex << (pc - reinterpret_cast<uintptr_t>(info.dli_fbase));
+            return name.str();
+        }
+    }
+    name << "0x" << std::hex << pc;
+    return name.str();
+}
+
+// Fold records into "root;...;leaf count" lines, most frequent first
+std::string foldStacks(const uintptr_t* buffer, size_t words) {
+    std::map<std::vector<uintptr_t>, size_t> stacks;
+    for (size_t pos = 0; pos < words && buffer[pos] != 0; pos += buffer[pos] + 1) {
+        const size_t depth = buffer[pos];
+        if (pos + depth + 1 > words) {
+            break;
+        }
+        stacks[std::vector<uintptr_t>(buffer + pos + 1, buffer + pos + 1 + depth)]++;
+    }
+
+    std::unordered_map<uintptr_t, std::string> names;
+    auto nameOf = [&names](uintptr_t pc) -> const std::string& {
+        auto it = names.find(pc);
+        if (it == names.end()) {
+            it = names.emplace(pc, symbolize(pc)).first;
+        }
+        return it->second;
+    };
+
+    // Stacks that differ only in pcs within the same functions fold together
+    std::unordered_map<std::string, size_t> folded_counts;
+    for (const auto& [frames, count] : stacks) {
+        std::string line;
+        for (size_t i = frames.size(); i-- > 0;) {
+            // Return addresses point after the call; look up the call itself
+            line += nameOf(i == 0 ? frames[i] : frames[i] - 1);
+            if (i > 0) {
+                line += ';';
+            }
+        }
+        folded_counts[line] += count;
+    }
+
+    std::vector<std::pair<std::string, size_t>> lines(folded_counts.begin(), folded_counts.end());
+    std::sort(lines.begin(), lines.end(),
+              [](const auto& a, const auto& b) {
+                  return a.second != b.second ? a.second > b.second : a.first < b.first;
+              });
+
+    std::string folded;
+    for (const auto& [line, count] : lines) {
+        folded += line + ' ' + std::to_string(count) + '\n';
+    }
+    return folded;
+}
+
+#endif  // RTRV_SAMPLING_PROFILER
+
+}  // anonymous namespace
+
+bool SamplingProfiler::supported() {
+#ifdef RTRV_SAMPLING_PROFILER
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SamplingProfiler::start(int frequency_hz) {
+#ifdef RTRV_SAMPLING_PROFILER
+    std::lock_guard<std::mutex> lock(session_mutex);
+    if (active_buffer.load() != nullptr || frequency_hz <= 0) {
+        return false;
+    }
+
+    // The handler stays installed after stop(): a SIGPROF still pending
+    // then is a no-op instead of the default action (terminate)
+    if (!handler_installed) {
+        struct sigaction action {};
+        action.sa_sigaction = &onSigprof;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, nullptr) != 0) {
+            return false;
+        }
+        handler_installed = true;
+    }
+
+    profiled_pid = getpid();
+    sample_buffer.reset(new uintptr_t[kBufferWords]());
+    buffer_cursor.store(0);
+    sample_count.store(0);
+    dropped_count.store(0);
+    active_buffer.store(sample_buffer.get());
+
+    if (!setTimer(frequency_hz)) {
+        active_buffer.store(nullptr);
+        sample_buffer.reset();
+        return false;
+    }
+    return true;
+#else
+    (void)frequency_hz;
+    return false;
+#endif
+}
+
+ProfileResult SamplingProfiler::stop() {
+    ProfileResult result;
+#ifdef RTRV_SAMPLING_PROFILER
+    std::lock_guard<std::mutex> lock(session_mutex);
+    if (active_buffer.load() == nullptr) {
+        return result;
+    }
+
+    setTimer(0);
+    active_buffer.store(nullptr);
+    while (handlers_in_flight.load() > 0) {
+        std::this_thread::yield();
+    }
+
+    result.samples = sample_count.load();
+    result.dropped = dropped_count.load();
+    result.folded_stacks = foldStacks(sample_buffer.get(), std::min(buffer_cursor.load(), kBufferWords));
+    sample_buffer.reset();
+#endif
+    return result;
+}
+
+bool SamplingProfiler::isRunning() {
+    return active_buffer.load() != nullptr;
+}
+
+ProfileResult SamplingProfiler::profileFor(std::chrono::milliseconds duration, int frequency_hz) {
+    if (!start(frequency_hz)) {
+        return ProfileResult{};
+    }
+    std::this_thread::sleep_for(duration);
+    return stop();
+}
+
+}  // namespace rtrv_search_engine
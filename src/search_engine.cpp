@@ -2,8 +2,12 @@
 #include "persistence.hpp"
 #include "top_k_heap.hpp"
 #include "snippet_extractor.hpp"
+#include <algorithm>
 #include <cctype>
+#include <cmath>
+#include <future>
 #include <limits>
+#include <thread>
 
 namespace {
 
@@ -35,6 +39,20 @@ size_t hashCombine(size_t seed, size_t value) {
     return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
 }
 
+// Documents in every filter, in ordinal order: leapfrogs the filters with advance()
+std::unique_ptr<rtrv_search_engine::DocIdSetIterator> intersectFilters(
+    const std::vector<std::shared_ptr<const rtrv_search_engine::SegmentedDocIdSet>>& filters) {
+    using rtrv_search_engine::SegmentedDocIdSet;
+    if (filters.size() == 1) {
+        return SegmentedDocIdSet::iterator(filters.front());
+    }
+    std::vector<std::unique_ptr<rtrv_search_engine::DocIdSetIterator>> iterators;
+    for (const auto& filter : filters) {
+        iterators.push_back(SegmentedDocIdSet::iterator(filter));
+    }
+    return std::make_unique<rtrv_search_engine::ConjunctionIterator>(std::move(iterators));
+}
+
 size_t hashSearchOptions(const rtrv_search_engine::SearchOptions& options) {
     size_t seed = 0;
     seed = hashCombine(seed, std::hash<std::string>{}(options.ranker_name));
@@ -42,13 +60,37 @@ size_t hashSearchOptions(const rtrv_search_engine::SearchOptions& options) {
     seed = hashCombine(seed, std::hash<size_t>{}(options.max_results));
     seed = hashCombine(seed, std::hash<bool>{}(options.explain_scores));
     seed = hashCombine(seed, std::hash<bool>{}(options.use_top_k_heap));
-    seed = hashCombine(seed, std::hash<bool>{}(options.generate_snippets));
-    seed = hashCombine(seed, std::hash<size_t>{}(options.snippet_options.max_snippet_length));
-    seed = hashCombine(seed, std::hash<size_t>{}(options.snippet_options.num_snippets));
-    seed = hashCombine(seed, std::hash<std::string>{}(options.snippet_options.highlight_open));
-    seed = hashCombine(seed, std::hash<std::string>{}(options.snippet_options.highlight_close));
+    // Snippet options are not hashed: cached results never hold snippets
     seed = hashCombine(seed, std::hash<bool>{}(options.fuzzy_enabled));
     seed = hashCombine(seed, std::hash<uint32_t>{}(options.max_edit_distance));
+    for (const auto& field : options.facets) {
+        seed = hashCombine(seed, std::hash<std::string>{}(field));
+    }
+    seed = hashCombine(seed, std::hash<size_t>{}(options.facet_size));
+    for (const auto& aggregation : options.aggregations) {
+        seed = hashCombine(seed, std::hash<std::string>{}(aggregation.name));
+        seed = hashCombine(seed, static_cast<size_t>(aggregation.type));
+        seed = hashCombine(seed, std::hash<std::string>{}(aggregation.field));
+        seed = hashCombine(seed, std::hash<size_t>{}(aggregation.size));
+        seed = hashCombine(seed, std::hash<double>{}(aggregation.interval));
+        seed = hashCombine(seed, static_cast<size_t>(aggregation.date_interval));
+        seed = hashCombine(seed, static_cast<size_t>(aggregation.precision));
+    }
+    for (const auto& filter : options.filters) {
+        seed = hashCombine(seed, std::hash<std::string>{}(filter));
+    }
+    for (const auto& key : options.sort) {
+        seed = hashCombine(seed, std::hash<std::string>{}(key.field));
+        seed = hashCombine(seed, std::hash<bool>{}(key.descending));
+    }
+    seed = hashCombine(seed, std::hash<std::string>{}(options.collapse_field));
+    seed = hashCombine(seed, std::hash<size_t>{}(options.collapse_inner_hits));
+    seed = hashCombine(seed, std::hash<bool>{}(options.expand_synonyms));
+    seed = hashCombine(seed, std::hash<size_t>{}(options.max_synonym_expansions));
+    for (float x : options.query_vector) {
+        seed = hashCombine(seed, std::hash<float>{}(x));
+    }
+    seed = hashCombine(seed, std::hash<size_t>{}(options.knn_ef));
     seed = hashCombine(seed, std::hash<size_t>{}(options.offset));
     if (options.search_after_score.has_value()) {
         seed = hashCombine(seed, std::hash<double>{}(options.search_after_score.value()));
@@ -79,45 +121,119 @@ SearchEngine::~SearchEngine() = default;
 
 uint64_t SearchEngine::indexDocument(const Document& doc) {
     std::unique_lock lock(mutex_);
-    const auto doc_id = indexDocumentInternal(doc);
+    std::unordered_set<std::string> terms;
+    const auto doc_id = indexDocumentInternal(doc, subscriptions_.empty() ? nullptr : &terms);
     query_cache_.clear();
+    const auto notifications = updateSubscriptions({{doc_id, std::move(terms)}});
+    lock.unlock();
+    notifySubscribers(notifications);
     return doc_id;
 }
 
-uint64_t SearchEngine::indexDocumentInternal(const Document& doc) {
+uint64_t SearchEngine::indexDocumentInternal(const Document& doc, std::unordered_set<std::string>* indexed_terms) {
     // Use provided doc ID or generate new one
     uint64_t doc_id = (doc.id > 0) ? doc.id : next_doc_id_++;
     
-    // Create mutable copy of document
-    Document indexed_doc = doc;
+    // Store document first: offsets refer to the stored copy's getAllText()
+    Document& indexed_doc = documents_[doc_id];
+    total_term_count_ -= indexed_doc.term_count;  // Re-indexed id: its old length no longer counts
+    indexed_doc = doc;
     indexed_doc.id = doc_id;
     
     // Tokenize document content
-    auto tokens = tokenizer_->tokenize(doc.getAllText());
+    auto tokens = tokenizer_->tokenizeWithPositions(indexed_doc.getAllText());
     indexed_doc.term_count = tokens.size();
+    total_term_count_ += tokens.size();
+    
+    // Index-time synonyms: each alternative's words are indexed at the
+    // positions of the span they stand for (injected[position])
+    std::vector<std::vector<std::string>> injected;
+    if (synonyms_ && synonym_mode_ == SynonymMode::INDEX_TIME) {
+        std::vector<std::string> words;
+        words.reserve(tokens.size());
+        for (const auto& token : tokens) {
+            words.push_back(token.text);
+        }
+        for (const auto& match : synonyms_->match(words)) {
+            if (injected.empty()) {
+                injected.resize(tokens.size());
+            }
+            for (const auto& alternative : *match.alternatives) {
+                const auto alternative_words = SynonymMap::splitWords(alternative.text);
+                for (size_t i = 0; i < alternative_words.size(); ++i) {
+                    // Longer alternatives stack on the span's last position
+                    const size_t at = match.start + std::min(i, match.length - 1);
+                    injected[at].push_back(alternative_words[i]);
+                }
+            }
+        }
+    }
     
     // Add terms to inverted index with positions
     uint32_t position = 0;
-    for (const auto& term : tokens) {
-        index_->addTerm(term, doc_id, position++);
+    for (const auto& token : tokens) {
+        if (!injected.empty()) {
+            for (const auto& word : injected[position]) {
+                index_->addTerm(word, doc_id, position);
+                if (indexed_terms) {
+                    indexed_terms->insert(word);
+                }
+            }
+        }
+        index_->addTerm(token.text, doc_id, position++);
+        if (indexed_terms) {
+            indexed_terms->insert(token.text);
+        }
         // Incrementally update fuzzy n-gram index
         if (fuzzy_search_.isIndexBuilt()) {
-            fuzzy_search_.addTerm(term);
+            fuzzy_search_.addTerm(token.text);
         }
     }
     
-    // Store document
-    documents_[doc_id] = indexed_doc;
+    if (store_term_offsets_) {
+        auto& offsets = term_offsets_[doc_id];
+        offsets.clear();
+        offsets.reserve(tokens.size());
+        for (const auto& token : tokens) {
+            offsets.push_back({token.start_offset, token.end_offset});
+        }
+    } else {
+        term_offsets_.erase(doc_id);
+    }
+    if (store_term_vectors_) {
+        term_vectors_.add(doc_id, tokens);
+    } else {
+        term_vectors_.remove(doc_id);
+    }
+    
+    doc_values_.addDocument(doc_id, indexed_doc);
+    
+    if (vector_index_) {
+        if (!vector_index_->add(doc_id, indexed_doc.vector)) {
+            vector_index_->remove(doc_id);  // No (or mismatched) vector: drop a previous one
+        } else if (vector_index_->params().quantization != VectorQuantization::NONE) {
+            // The index holds the only copy (codes, plus the mmapped file if configured)
+            std::vector<float>().swap(indexed_doc.vector);
+        }
+    }
     
     return doc_id;
 }
 
 void SearchEngine::indexDocuments(const std::vector<Document>& docs) {
     std::unique_lock lock(mutex_);
+    std::vector<std::pair<uint64_t, std::unordered_set<std::string>>> writes;
     for (const auto& doc : docs) {
-        indexDocumentInternal(doc);
+        std::unordered_set<std::string> terms;
+        const auto doc_id = indexDocumentInternal(doc, subscriptions_.empty() ? nullptr : &terms);
+        if (!subscriptions_.empty()) {
+            writes.emplace_back(doc_id, std::move(terms));
+        }
     }
     query_cache_.clear();
+    const auto notifications = updateSubscriptions(writes);  // One delta per subscription for the batch
+    lock.unlock();
+    notifySubscribers(notifications);
 }
 
 bool SearchEngine::updateDocument(uint64_t doc_id, const Document& doc) {
@@ -136,9 +252,13 @@ bool SearchEngine::updateDocument(uint64_t doc_id, const Document& doc) {
     updated_doc.id = doc_id;
     
     // Re-index with same ID (using internal method — lock already held)
-    indexDocumentInternal(updated_doc);
+    std::unordered_set<std::string> terms;
+    indexDocumentInternal(updated_doc, subscriptions_.empty() ? nullptr : &terms);
     
     query_cache_.clear();
+    const auto notifications = updateSubscriptions({{doc_id, std::move(terms)}});
+    lock.unlock();
+    notifySubscribers(notifications);
     return true;
 }
 
@@ -155,9 +275,19 @@ bool SearchEngine::deleteDocument(uint64_t doc_id) {
     index_->removeDocument(doc_id);
     
     // Remove from document store
+    total_term_count_ -= it->second.term_count;
     documents_.erase(it);
+    term_offsets_.erase(doc_id);
+    term_vectors_.remove(doc_id);
+    doc_values_.removeDocument(doc_id);
+    if (vector_index_) {
+        vector_index_->remove(doc_id);
+    }
     
     query_cache_.clear();
+    const auto notifications = updateSubscriptions({{doc_id, {}}});
+    lock.unlock();
+    notifySubscribers(notifications);
     return true;
 }
 
@@ -165,8 +295,18 @@ std::vector<SearchResult> SearchEngine::search(const std::string& query,
                                                const SearchOptions& options) {
     std::shared_lock lock(mutex_);
     
+    auto results = searchInternal(query, options);
+    if (options.generate_snippets) {
+        attachSnippets(results, query, options.snippet_options);
+    }
+    return results;
+}
+
+std::vector<SearchResult> SearchEngine::searchInternal(const std::string& query,
+                                                       const SearchOptions& options,
+                                                       HitCollector* collector) {
     std::vector<SearchResult> results;
-    const bool use_cache = options.use_cache;
+    const bool use_cache = options.use_cache && !collector;  // Counts need every hit scored
     QueryCacheKey cache_key;
 
     if (use_cache) {
@@ -179,9 +319,62 @@ std::vector<SearchResult> SearchEngine::search(const std::string& query,
         }
     }
     
+    // Filter context (range clauses, options.filters): cached sets that
+    // restrict the hits; the remaining terms score
+    const auto filters = compileFilters(query, options);
+    const auto passesFilters = [&](uint64_t doc_id) {
+        const uint32_t doc = doc_values_.ordinal(doc_id);
+        for (const auto& filter : filters) {
+            if (!filter->contains(doc)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    
     // Extract query terms
     auto query_terms = query_parser_->extractTerms(query);
-    if (query_terms.empty()) {
+    // A hybrid query with an embedding and no terms is vector-only: the
+    // kNN leg runs below and is fused with an empty lexical ranking
+    const bool vector_only = query_terms.empty() && vector_index_ && !options.query_vector.empty() &&
+                             dynamic_cast<HybridRanker*>(selectRanker(options));
+    if (query_terms.empty() && !vector_only) {
+        if (filters.empty()) {
+            return results;
+        }
+        // Filter only: every live matching document, constant score, in
+        // sort order or else ordinal order
+        auto matches = intersectFilters(filters);
+        if (!options.sort.empty() || !options.collapse_field.empty()) {
+            std::vector<uint64_t> matching_ids;
+            for (uint32_t doc = matches->nextDoc(); doc != DocIdSetIterator::NO_MORE_DOCS; doc = matches->nextDoc()) {
+                matching_ids.push_back(doc_values_.docId(doc));
+            }
+            const auto score = [&](uint64_t doc_id) {
+                return passesFilters(doc_id) && documents_.count(doc_id) ? 1.0 : 0.0;
+            };
+            results = options.collapse_field.empty() ? collectSorted(options, matching_ids, score, collector)
+                                                     : collectCollapsed(options, matching_ids, score, collector);
+        } else {
+            for (uint32_t doc = matches->nextDoc();
+                 doc != DocIdSetIterator::NO_MORE_DOCS && results.size() < options.max_results;
+                 doc = matches->nextDoc()) {
+                auto doc_it = documents_.find(doc_values_.docId(doc));
+                if (doc_it == documents_.end()) {
+                    continue;
+                }
+                if (collector) {
+                    collector->collect(doc_it->first);
+                }
+                SearchResult result;
+                result.document = doc_it->second;
+                result.score = 1.0;
+                results.push_back(std::move(result));
+            }
+        }
+        if (use_cache && !cache_key.normalized_query.empty()) {
+            query_cache_.put(cache_key, results);
+        }
         return results;
     }
     
@@ -234,60 +427,141 @@ std::vector<SearchResult> SearchEngine::search(const std::string& query,
         query_terms = expanded_terms;
     }
     
-    // Create Query object
-    Query q;
-    q.terms = query_terms;
+    // Query-time synonyms: a weighted OR of the original terms and the
+    // alternatives of every dictionary entry they contain
+    std::vector<double> term_weights;
+    const size_t original_terms = query_terms.size();
+    if (synonyms_ && synonym_mode_ == SynonymMode::QUERY_TIME && options.expand_synonyms) {
+        expandSynonyms(query_terms, term_weights, options.max_synonym_expansions);
+    }
     
-    // Prepare index statistics
-    IndexStats stats;
-    stats.total_docs = documents_.size();
+    // Select ranker (plugin architecture)
+    Ranker* ranker_to_use = selectRanker(options);
     
-    // Calculate average document length
-    if (!documents_.empty()) {
-        size_t total_length = 0;
-        for (const auto& [id, doc] : documents_) {
-            total_length += doc.term_count;
-        }
-        stats.avg_doc_length = static_cast<double>(total_length) / documents_.size();
-    } else {
-        stats.avg_doc_length = 0.0;
+    // Hybrid ranker with a query embedding: the kNN side runs on another
+    // thread while this one does the lexical side, so latency is close to
+    // max(lexical, vector) instead of the sum
+    HybridRanker* hybrid = nullptr;
+    std::future<std::vector<ScoredDocument>> vector_top_n;
+    if (vector_index_ && !options.query_vector.empty()) {
+        hybrid = dynamic_cast<HybridRanker*>(ranker_to_use);
     }
-    
-    // Get document frequencies for query terms
-    for (const auto& term : query_terms) {
-        stats.doc_frequency[term] = index_->getDocumentFrequency(term);
+    // The kNN side only returns documents that pass the filters, so the
+    // fused window is filled with matching documents
+    std::function<bool(uint64_t)> vector_filter;
+    if (!filters.empty()) {
+        vector_filter = passesFilters;
+    }
+    if (hybrid) {
+        vector_top_n = std::async(std::launch::async, [this, hybrid, &options, &vector_filter] {
+            return vectorTopN(options.query_vector, hybrid->getParameters().window_size,
+                              hybrid->getParameters().exact_knn, options.knn_ef, vector_filter);
+        });
     }
     
+    // Create Query object
+    Query q;
+    q.terms = query_terms;
+    q.weights = std::move(term_weights);
+    
+    // Index statistics; multi-word synonym alternatives are candidates
+    // through their rarest word
+    std::vector<std::string> candidate_terms;
+    const IndexStats stats = queryStats(query_terms, original_terms, candidate_terms);
+    
     // Collect candidate documents from posting lists
     std::unordered_set<uint64_t> candidate_doc_ids;
-    for (const auto& term : query_terms) {
+    for (const auto& term : candidate_terms) {
         auto postings = index_->getPostings(term);
         for (const auto& posting : postings) {
             candidate_doc_ids.insert(posting.doc_id);
         }
     }
-    
-    // Select ranker (plugin architecture)
-    Ranker* ranker_to_use = nullptr;
-    
-    if (!options.ranker_name.empty()) {
-        // Use specified ranker
-        ranker_to_use = ranker_registry_->getRanker(options.ranker_name);
-    } else if (options.algorithm == SearchOptions::TF_IDF) {
-        // Backward compatibility: use algorithm enum
-        ranker_to_use = ranker_registry_->getRanker("TF-IDF");
-    } else {
-        // Use default ranker
-        ranker_to_use = ranker_registry_->getDefaultRanker();
-    }
-    
-    if (!ranker_to_use) {
-        // Fallback to BM25 if ranker not found
-        ranker_to_use = ranker_registry_->getRanker("BM25");
+    if (!filters.empty() && filters.front()->cardinality() * 8 < candidate_doc_ids.size()) {
+        // Selective filters drive: their intersection is walked with
+        // advance() and each match is looked up among the candidates
+        std::unordered_set<uint64_t> filtered;
+        auto matches = intersectFilters(filters);
+        for (uint32_t doc = matches->nextDoc(); doc != DocIdSetIterator::NO_MORE_DOCS; doc = matches->nextDoc()) {
+            const uint64_t doc_id = doc_values_.docId(doc);
+            if (candidate_doc_ids.count(doc_id)) {
+                filtered.insert(doc_id);
+            }
+        }
+        candidate_doc_ids = std::move(filtered);
+    } else if (!filters.empty()) {
+        // One set probe per candidate and filter; no posting is traversed
+        for (auto it = candidate_doc_ids.begin(); it != candidate_doc_ids.end();) {
+            it = passesFilters(*it) ? std::next(it) : candidate_doc_ids.erase(it);
+        }
     }
     
-    // Branch: Use Top-K heap or traditional sorting
-    if (options.use_top_k_heap) {
+    // Branch: hybrid fusion, Top-K heap or traditional sorting
+    if (hybrid) {
+        results = fuseHybrid(*hybrid, q, stats, candidate_doc_ids, vector_top_n.get(), options, collector);
+        if (!options.sort.empty() && options.collapse_field.empty()) {
+            // Top-k of every fused document by the sort keys; a zero
+            // weighted-fusion score is still a hit
+            std::vector<uint64_t> window;
+            std::unordered_map<uint64_t, SearchResult> fused;
+            for (auto& result : results) {
+                window.push_back(result.document.id);
+                fused.emplace(result.document.id, std::move(result));
+            }
+            results = collectSorted(options, window, [&](uint64_t doc_id) {
+                return std::max(fused.at(doc_id).score, std::numeric_limits<double>::min());
+            }, nullptr);
+            for (auto& result : results) {
+                const SearchResult& source = fused.at(result.document.id);
+                result.score = source.score;
+                if (options.explain_scores) {
+                    result.explanation = source.explanation + ", " + result.explanation;
+                }
+            }
+        }
+        if (!options.collapse_field.empty()) {
+            // Groups of every fused document, keeping the fused scores
+            std::vector<uint64_t> window;
+            std::unordered_map<uint64_t, double> fused;
+            for (const auto& result : results) {
+                window.push_back(result.document.id);
+                fused[result.document.id] = result.score;
+            }
+            results = collectCollapsed(options, window, [&](uint64_t doc_id) { return fused[doc_id]; }, nullptr);
+        }
+        
+    } else if (!options.collapse_field.empty()) {
+        // Field collapsing: top groups by their best hit
+        const std::vector<uint64_t> candidates(candidate_doc_ids.begin(), candidate_doc_ids.end());
+        results = collectCollapsed(options, candidates, [&](uint64_t doc_id) {
+            auto doc_it = documents_.find(doc_id);
+            return doc_it != documents_.end() ? ranker_to_use->score(q, doc_it->second, stats) : 0.0;
+        }, collector);
+        if (options.explain_scores) {
+            for (auto& result : results) {
+                result.explanation = "Ranker: " + ranker_to_use->getName() + ", Score: " + std::to_string(result.score) +
+                                     ", " + result.explanation;
+            }
+        }
+        
+    } else if (!options.sort.empty()) {
+        // Field sort: top-k by the sort keys instead of by score
+        const std::vector<uint64_t> candidates(candidate_doc_ids.begin(), candidate_doc_ids.end());
+        results = collectSorted(options, candidates, [&](uint64_t doc_id) {
+            if (!candidate_doc_ids.count(doc_id)) {
+                return 0.0;
+            }
+            auto doc_it = documents_.find(doc_id);
+            return doc_it != documents_.end() ? ranker_to_use->score(q, doc_it->second, stats) : 0.0;
+        }, collector);
+        if (options.explain_scores) {
+            for (auto& result : results) {
+                result.explanation = "Ranker: " + ranker_to_use->getName() + ", Score: " + std::to_string(result.score) +
+                                     ", " + result.explanation;
+            }
+        }
+        
+    } else if (options.use_top_k_heap) {
         // ============================================================
         // TOP-K HEAP APPROACH: O(N log K) time, O(K) space
         // ============================================================
@@ -300,6 +574,9 @@ std::vector<SearchResult> SearchEngine::search(const std::string& query,
                 double score = ranker_to_use->score(q, doc_it->second, stats);
                 
                 if (score > 0.0) {
+                    if (collector) {
+                        collector->collect(doc_id);
+                    }
                     // Only add if better than worst in heap (or heap not full)
                     if (!top_k.isFull() || score > top_k.minScore()) {
                         top_k.push({doc_id, score});
@@ -341,6 +618,9 @@ std::vector<SearchResult> SearchEngine::search(const std::string& query,
                 double score = ranker_to_use->score(q, doc_it->second, stats);
                 
                 if (score > 0.0) {
+                    if (collector) {
+                        collector->collect(doc_id);
+                    }
                     SearchResult result;
                     result.document = doc_it->second;
                     result.score = score;
@@ -368,15 +648,6 @@ std::vector<SearchResult> SearchEngine::search(const std::string& query,
         }
     }
     
-    // Post-process: generate snippets if requested
-    if (options.generate_snippets && !results.empty()) {
-        for (auto& result : results) {
-            std::string doc_text = result.document.getAllText();
-            result.snippets = snippet_extractor_.generateSnippets(
-                doc_text, query_terms, options.snippet_options);
-        }
-    }
-    
     // Post-process: apply fuzzy scoring penalty and attach expansion info
     if (options.fuzzy_enabled && !fuzzy_expansions.empty()) {
         // Apply a scoring penalty proportional to the number of fuzzy-expanded terms
@@ -386,6 +657,9 @@ std::vector<SearchResult> SearchEngine::search(const std::string& query,
         for (auto& result : results) {
             result.score *= penalty;
             result.expanded_terms = fuzzy_expansions;
+            for (auto& inner : result.inner_hits) {
+                inner.score *= penalty;
+            }
         }
     }
     
@@ -396,6 +670,61 @@ std::vector<SearchResult> SearchEngine::search(const std::string& query,
     return results;
 }
 
+Ranker* SearchEngine::selectRanker(const SearchOptions& options) const {
+    Ranker* ranker = nullptr;
+    if (!options.ranker_name.empty()) {
+        // Use specified ranker
+        ranker = ranker_registry_->getRanker(options.ranker_name);
+    } else if (options.algorithm == SearchOptions::TF_IDF) {
+        // Backward compatibility: use algorithm enum
+        ranker = ranker_registry_->getRanker("TF-IDF");
+    } else {
+        // Use default ranker
+        ranker = ranker_registry_->getDefaultRanker();
+    }
+    // Fallback to BM25 if ranker not found
+    return ranker ? ranker : ranker_registry_->getRanker("BM25");
+}
+
+IndexStats SearchEngine::queryStats(const std::vector<std::string>& terms, size_t original_terms,
+                                    std::vector<std::string>& candidate_terms) const {
+    IndexStats stats;
+    stats.total_docs = documents_.size();
+    stats.avg_doc_length = documents_.empty() ? 0.0 : static_cast<double>(total_term_count_) / documents_.size();
+    
+    // Get document frequencies for query terms
+    for (const auto& term : terms) {
+        stats.doc_frequency[term] = index_->getDocumentFrequency(term);
+    }
+    
+    // Multi-word synonym alternatives are not index terms: their rarest
+    // word stands in for df and candidates, and the ranker's text scan
+    // only scores documents that contain the whole phrase
+    candidate_terms = terms;
+    for (size_t i = original_terms; i < terms.size(); ++i) {
+        if (terms[i].find(' ') == std::string::npos) {
+            continue;
+        }
+        size_t rarest_df = std::numeric_limits<size_t>::max();
+        for (const auto& word : SynonymMap::splitWords(terms[i])) {
+            const size_t df = index_->getDocumentFrequency(word);
+            if (df < rarest_df) {
+                rarest_df = df;
+                candidate_terms[i] = word;
+            }
+        }
+        stats.doc_frequency[terms[i]] = rarest_df;
+    }
+    
+    // Terms injected by index-time synonyms are absent from the text
+    if (synonyms_ && synonym_mode_ == SynonymMode::INDEX_TIME) {
+        stats.indexed_tf = [this](const std::string& term, uint64_t doc_id) {
+            return static_cast<uint32_t>(index_->getPositions(term, doc_id).size());
+        };
+    }
+    return stats;
+}
+
 PaginatedSearchResults SearchEngine::searchPaginated(const std::string& query,
                                                       const SearchOptions& options) {
     PaginatedSearchResults paginated;
@@ -414,27 +743,46 @@ PaginatedSearchResults SearchEngine::searchPaginated(const std::string& query,
 
     // Ask for a large number so we get all candidates.
     internal_opts.max_results = std::numeric_limits<size_t>::max();
+    // Snippets are generated below for the returned page only
+    internal_opts.generate_snippets = false;
     internal_opts.offset = 0;
     internal_opts.search_after_score = std::nullopt;
     internal_opts.search_after_id = std::nullopt;
     // Disable top-k heap so we get full sorted list for pagination
     internal_opts.use_top_k_heap = false;
 
-    auto all_results = search(query, internal_opts);
+    std::vector<SearchResult> all_results;
+    {
+        std::shared_lock lock(mutex_);
+        if (options.facets.empty() && options.aggregations.empty()) {
+            all_results = searchInternal(query, internal_opts);
+        } else {
+            FacetCounter facets(doc_values_, options.facets);
+            AggregationCollector aggregations(doc_values_, options.aggregations);
+            HitCollector collector{doc_values_, options.facets.empty() ? nullptr : &facets,
+                                   options.aggregations.empty() ? nullptr : &aggregations};
+            all_results = searchInternal(query, internal_opts, &collector);
+            paginated.facets = facets.results(options.facet_size);
+            paginated.aggregations = aggregations.results();
+        }
+    }
 
-    // Ensure deterministic order: sort by score descending, then doc_id ascending
-    std::sort(all_results.begin(), all_results.end(),
-              [](const SearchResult& a, const SearchResult& b) {
-                  if (a.score != b.score) return a.score > b.score;
-                  return a.document.id < b.document.id;
-              });
+    // Ensure deterministic order: sort by score descending, then doc_id
+    // ascending (field-sorted results are already in their final order)
+    if (options.sort.empty()) {
+        std::sort(all_results.begin(), all_results.end(),
+                  [](const SearchResult& a, const SearchResult& b) {
+                      if (a.score != b.score) return a.score > b.score;
+                      return a.document.id < b.document.id;
+                  });
+    }
 
     const size_t total_hits = all_results.size();
     paginated.pagination.total_hits = total_hits;
     paginated.pagination.page_size = requested_page_size;
 
     // Cursor-based pagination (search_after)
-    if (search_after_score.has_value() && search_after_id.has_value()) {
+    if (search_after_score.has_value() && search_after_id.has_value() && options.sort.empty()) {
         double cursor_score = search_after_score.value();
         uint64_t cursor_id = search_after_id.value();
 
@@ -485,6 +833,9 @@ PaginatedSearchResults SearchEngine::searchPaginated(const std::string& query,
     }
 
     paginated.pagination.page_size = paginated.results.size();
+    if (options.generate_snippets) {
+        generateSnippets(paginated.results, query, options.snippet_options);
+    }
     return paginated;
 }
 
@@ -495,16 +846,7 @@ IndexStatistics SearchEngine::getStats() const {
     stats.total_documents = documents_.size();
     stats.total_terms = index_->getTermCount();
     
-    // Calculate average document length
-    if (!documents_.empty()) {
-        size_t total_length = 0;
-        for (const auto& [id, doc] : documents_) {
-            total_length += doc.term_count;
-        }
-        stats.avg_doc_length = static_cast<double>(total_length) / documents_.size();
-    } else {
-        stats.avg_doc_length = 0.0;
-    }
+    stats.avg_doc_length = documents_.empty() ? 0.0 : static_cast<double>(total_term_count_) / documents_.size();
     
     return stats;
 }
@@ -513,6 +855,1057 @@ CacheStatistics SearchEngine::getCacheStats() const {
     return query_cache_.getStats();
 }
 
+void SearchEngine::generateSnippets(std::vector<SearchResult>& results,
+                                    const std::string& query,
+                                    const SnippetOptions& options) const {
+    std::shared_lock lock(mutex_);
+    attachSnippets(results, query, options);
+}
+
+void SearchEngine::attachSnippets(std::vector<SearchResult>& results,
+                                  const std::string& query,
+                                  const SnippetOptions& options) const {
+    if (results.empty()) {
+        return;
+    }
+    
+    // Match the terms as the index stores them (stemmed, no stopwords),
+    // plus the corrections fuzzy search substituted for them
+    std::vector<std::string> query_terms = query_parser_->extractTerms(query);
+    for (const auto& result : results) {
+        for (const auto& [original, corrected] : result.expanded_terms) {
+            query_terms.push_back(corrected);
+        }
+    }
+    std::unordered_set<std::string> analyzed_terms;
+    for (const auto& term : query_terms) {
+        for (auto& analyzed : tokenizer_->tokenize(term)) {
+            analyzed_terms.insert(std::move(analyzed));
+        }
+    }
+    // Compiled once for all results; stemmed terms also match their
+    // longer surface forms ("jump" -> "Jumping")
+    const TermMatcher matcher({analyzed_terms.begin(), analyzed_terms.end()},
+                              tokenizer_->getStemmer() != StemmerType::NONE);
+    
+    auto snippetRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            auto& result = results[i];
+            auto doc_it = documents_.find(result.document.id);
+            if (doc_it == documents_.end()) {
+                continue;  // Deleted since it was scored
+            }
+            const std::string doc_text = doc_it->second.getAllText();
+            result.snippets = snippet_extractor_.generateSnippetsFromOffsets(
+                doc_text, matchOffsets(doc_it->first, doc_text, analyzed_terms, matcher), options);
+        }
+    };
+    
+    // Spread large pages over worker threads; for typical pages (a few KB
+    // of text) starting threads costs more than the snippets themselves
+    size_t page_bytes = 0;
+    for (const auto& result : results) {
+        page_bytes += result.document.memoryUsage();
+    }
+    const size_t workers = std::min<size_t>(
+        {results.size(), std::max(1u, std::thread::hardware_concurrency()),
+         page_bytes / kParallelSnippetBytes + 1});
+    if (workers <= 1) {
+        snippetRange(0, results.size());
+        return;
+    }
+    
+    // The caller's shared lock covers the workers: they only read
+    std::vector<std::future<void>> tasks;
+    const size_t chunk = (results.size() + workers - 1) / workers;
+    for (size_t begin = chunk; begin < results.size(); begin += chunk) {
+        tasks.push_back(std::async(std::launch::async, snippetRange,
+                                   begin, std::min(begin + chunk, results.size())));
+    }
+    snippetRange(0, chunk);
+    for (auto& task : tasks) {
+        task.get();
+    }
+}
+
+std::vector<TermOffset> SearchEngine::matchOffsets(
+        uint64_t doc_id, const std::string& text,
+        const std::unordered_set<std::string>& terms,
+        const TermMatcher& matcher) const {
+    std::vector<TermOffset> matches;
+    
+    auto stored = term_offsets_.find(doc_id);
+    if (stored != term_offsets_.end()) {
+        // Positions of just the query terms, mapped to their offsets
+        const auto& offsets = stored->second;
+        for (const auto& term : terms) {
+            for (uint32_t position : index_->getPositions(term, doc_id)) {
+                if (position < offsets.size()) {
+                    matches.push_back(offsets[position]);
+                }
+            }
+        }
+        std::sort(matches.begin(), matches.end(),
+                  [](const TermOffset& a, const TermOffset& b) { return a.start < b.start; });
+    } else {
+        // Not stored: one automaton pass over the hit
+        matcher.findMatches(text, matches);
+        if (tokenizer_->getStemmer() != StemmerType::NONE) {
+            // Prefix candidates ("jump" in "jumpsuit") must analyze to a
+            // term. A one-word match is analyzed in place in a reused buffer.
+            std::string word;
+            matches.erase(std::remove_if(matches.begin(), matches.end(),
+                [&](const TermOffset& match) {
+                    word.assign(text, match.start, match.end - match.start);
+                    if (std::all_of(word.begin(), word.end(), TermMatcher::isWordChar)) {
+                        return !tokenizer_->analyzeWord(word) || terms.count(word) == 0;
+                    }
+                    auto tokens = tokenizer_->tokenize(word);  // A phrase
+                    return std::none_of(tokens.begin(), tokens.end(),
+                        [&terms](const std::string& token) { return terms.count(token) > 0; });
+                }), matches.end());
+        }
+    }
+    
+    return matches;
+}
+
+void SearchEngine::enableVectorSearch(size_t dimension, VectorMetric metric,
+                                      const HnswParams& params) {
+    std::unique_lock lock(mutex_);
+    if (vector_index_) {
+        // A quantized index held the only copy of its documents' vectors
+        for (auto& [doc_id, doc] : documents_) {
+            if (doc.vector.empty()) {
+                vector_index_->vector(doc_id, doc.vector);
+            }
+        }
+        vector_index_.reset();  // Unmap before the file is reopened
+    }
+    vector_index_ = std::make_unique<HnswIndex>(dimension, metric, params);
+    for (auto& [doc_id, doc] : documents_) {
+        if (vector_index_->add(doc_id, doc.vector) && params.quantization != VectorQuantization::NONE) {
+            std::vector<float>().swap(doc.vector);
+        }
+    }
+}
+
+std::vector<SearchResult> SearchEngine::knnSearch(const std::vector<float>& vector, size_t k,
+                                                  const std::function<bool(const Document&)>& filter,
+                                                  size_t ef) const {
+    std::shared_lock lock(mutex_);
+    
+    std::vector<SearchResult> results;
+    if (!vector_index_) {
+        return results;
+    }
+    
+    std::function<bool(uint64_t)> doc_filter;
+    if (filter) {
+        doc_filter = [this, &filter](uint64_t doc_id) {
+            auto it = documents_.find(doc_id);
+            return it != documents_.end() && filter(it->second);
+        };
+    }
+    
+    for (const auto& hit : vector_index_->search(vector, k, ef, doc_filter)) {
+        auto doc_it = documents_.find(hit.doc_id);
+        if (doc_it != documents_.end()) {
+            SearchResult result;
+            result.document = doc_it->second;
+            result.score = vector_index_->score(hit.distance);
+            results.push_back(std::move(result));
+        }
+    }
+    return results;
+}
+
+std::vector<ScoredDocument> SearchEngine::vectorTopN(const std::vector<float>& vector, size_t n,
+                                                     bool exact, size_t ef,
+                                                     const std::function<bool(uint64_t)>& filter) const {
+    auto hits = exact ? vector_index_->exactSearch(vector, n, filter)
+                      : vector_index_->search(vector, n, ef, filter);
+    
+    std::vector<ScoredDocument> ranked;
+    ranked.reserve(hits.size());
+    for (const auto& hit : hits) {
+        ranked.push_back({hit.doc_id, vector_index_->score(hit.distance)});
+    }
+    return ranked;
+}
+
+std::vector<SearchResult> SearchEngine::fuseHybrid(HybridRanker& ranker, const Query& query,
+                                                   const IndexStats& stats,
+                                                   const std::unordered_set<uint64_t>& candidates,
+                                                   const std::vector<ScoredDocument>& vector_ranked,
+                                                   const SearchOptions& options, HitCollector* hits) {
+    const FusionParams& params = ranker.getParameters();
+    
+    // Lexical top-N over the posting-list candidates. The hits (facets and
+    // aggregations) are every lexical match plus the kNN window, not only
+    // the documents that make it into the fused windows.
+    BoundedPriorityQueue<ScoredDocument> lexical_top_n(params.window_size);
+    std::unordered_set<uint64_t> lexical_hits;
+    for (uint64_t doc_id : candidates) {
+        auto doc_it = documents_.find(doc_id);
+        if (doc_it != documents_.end()) {
+            double score = ranker.score(query, doc_it->second, stats);
+            if (score > 0.0) {
+                lexical_top_n.push({doc_id, score});
+                if (hits) {
+                    hits->collect(doc_id);
+                    lexical_hits.insert(doc_id);
+                }
+            }
+        }
+    }
+    if (hits) {
+        for (const auto& ranked : vector_ranked) {
+            if (!lexical_hits.count(ranked.doc_id) && documents_.count(ranked.doc_id)) {
+                hits->collect(ranked.doc_id);
+            }
+        }
+    }
+    
+    // Only the page of the fused ranking is returned; a field sort or
+    // collapsing takes every fused document and picks the page itself
+    const auto lexical_ranked = lexical_top_n.getSorted();
+    const auto all_fused = ranker.fuse(lexical_ranked, vector_ranked, lexical_ranked.size() + vector_ranked.size());
+    const size_t page = options.sort.empty() && options.collapse_field.empty() ? options.max_results : all_fused.size();
+    
+    std::vector<SearchResult> results;
+    for (const auto& fused : all_fused) {
+        if (results.size() >= page) {
+            break;
+        }
+        auto doc_it = documents_.find(fused.doc_id);
+        if (doc_it == documents_.end()) {
+            continue;
+        }
+        SearchResult result;
+        result.document = doc_it->second;
+        result.score = fused.score;
+        
+        if (options.explain_scores) {
+            auto side = [](size_t rank, double score) {
+                return rank == 0 ? std::string("-")
+                                 : "#" + std::to_string(rank) + " (" + std::to_string(score) + ")";
+            };
+            result.explanation = "Ranker: " + ranker.getName() +
+                                 ", Score: " + std::to_string(fused.score) +
+                                 ", Lexical: " + side(fused.lexical_rank, fused.lexical_score) +
+                                 ", Vector: " + side(fused.vector_rank, fused.vector_score) +
+                                 ", Method: " + (params.method == FusionMethod::RRF ? "RRF" : "Weighted") +
+                                 " fusion of top " + std::to_string(params.window_size);
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+void SearchEngine::setStoreTermOffsets(bool enabled) {
+    std::unique_lock lock(mutex_);
+    store_term_offsets_ = enabled;
+    if (!enabled) {
+        term_offsets_.clear();
+    }
+}
+
+void SearchEngine::setStoreTermVectors(bool enabled) {
+    std::unique_lock lock(mutex_);
+    store_term_vectors_ = enabled;
+    if (!enabled) {
+        term_vectors_.clear();
+    }
+}
+
+void SearchEngine::defineField(const std::string& field, FieldType type) {
+    std::unique_lock lock(mutex_);
+    if (doc_values_.defineField(field, type) && type != FieldType::TEXT) {
+        for (const auto& [doc_id, doc] : documents_) {
+            doc_values_.addDocument(doc_id, doc);
+        }
+    }
+    query_cache_.clear();
+    filter_cache_.clear();  // Cached clauses may name the redefined field
+    percolator_.rebuild(percolatorContext());
+    const auto notifications = updateSubscriptions({}, true);  // Their filters may name it too
+    lock.unlock();
+    notifySubscribers(notifications);
+}
+
+FieldType SearchEngine::getFieldType(const std::string& field) const {
+    std::shared_lock lock(mutex_);
+    return doc_values_.fieldType(field);
+}
+
+// ==================== Percolator ====================
+
+Percolator::Context SearchEngine::percolatorContext() const {
+    return {*tokenizer_, doc_values_, [this](const std::string& term) { return index_->getDocumentFrequency(term); }};
+}
+
+bool SearchEngine::registerQuery(uint64_t query_id, const std::string& query) {
+    std::unique_lock lock(mutex_);
+    return percolator_.addQuery(query_id, query, percolatorContext());
+}
+
+bool SearchEngine::unregisterQuery(uint64_t query_id) {
+    std::unique_lock lock(mutex_);
+    return percolator_.removeQuery(query_id);
+}
+
+std::vector<uint64_t> SearchEngine::percolate(const Document& doc, PercolateStats* stats) const {
+    std::shared_lock lock(mutex_);
+    return percolator_.percolate(doc, percolatorContext(), stats);
+}
+
+size_t SearchEngine::registeredQueries() const {
+    std::shared_lock lock(mutex_);
+    return percolator_.size();
+}
+
+// ==================== Subscriptions ====================
+
+uint64_t SearchEngine::subscribe(const std::string& query, const SearchOptions& options,
+                                 SubscriptionCallback callback) {
+    if (!options.sort.empty() || !options.collapse_field.empty() || !options.query_vector.empty() ||
+        options.fuzzy_enabled || options.max_results == 0) {
+        return 0;  // Results that one document's score can't update
+    }
+    std::unique_lock lock(mutex_);
+    auto& subscription = subscriptions_.add(query, options, std::move(callback));
+    analyzeSubscription(subscription);
+    if (subscription.scored.terms.empty() && subscription.filters.empty()) {
+        const uint64_t id = subscription.id;
+        subscriptions_.remove(id);
+        return 0;
+    }
+    SubscriptionDelta delta;
+    subscriptions_.replace(subscription, searchInternal(query, subscription.options), delta);
+    delta.reset = true;
+    subscriptions_.publish(subscription, delta);
+    
+    const uint64_t id = subscription.id;
+    const SubscriptionCallback notify = subscription.callback;
+    lock.unlock();
+    if (notify) {
+        notify(delta);
+    }
+    return id;
+}
+
+bool SearchEngine::unsubscribe(uint64_t subscription_id) {
+    std::unique_lock lock(mutex_);
+    return subscriptions_.remove(subscription_id);
+}
+
+std::vector<SearchResult> SearchEngine::subscriptionResults(uint64_t subscription_id) const {
+    std::shared_lock lock(mutex_);
+    const auto* subscription = subscriptions_.find(subscription_id);
+    return subscription ? subscription->results : std::vector<SearchResult>();
+}
+
+std::vector<SubscriptionDelta> SearchEngine::subscriptionDeltas(uint64_t subscription_id,
+                                                                uint64_t after_sequence) const {
+    std::shared_lock lock(mutex_);
+    return subscriptions_.deltas(subscription_id, after_sequence);
+}
+
+size_t SearchEngine::subscriptionCount() const {
+    std::shared_lock lock(mutex_);
+    return subscriptions_.size();
+}
+
+void SearchEngine::analyzeSubscription(SubscriptionIndex::Subscription& subscription) {
+    // The terms searchInternal() scores
+    Query scored;
+    scored.terms = query_parser_->extractTerms(subscription.query);
+    const size_t original_terms = scored.terms.size();
+    if (synonyms_ && synonym_mode_ == SynonymMode::QUERY_TIME && subscription.options.expand_synonyms) {
+        expandSynonyms(scored.terms, scored.weights, subscription.options.max_synonym_expansions);
+    }
+    // The clauses compileFilters() would give, compiled once for testing
+    // written documents
+    subscription.filters.clear();
+    const auto addFilter = [&](const QueryNode& root, bool filter_context) {
+        DocFilter filter;
+        if (compileDocFilter(root, filter_context, filter)) {
+            subscription.filters.push_back(std::move(filter));
+        }
+    };
+    if (subscription.query.find_first_of("[{") != std::string::npos) {
+        QueryParser parser;
+        addFilter(*parser.parse(subscription.query), false);
+    }
+    for (const auto& filter : subscription.options.filters) {
+        if (filter.find_first_not_of(" \t") != std::string::npos) {
+            QueryParser parser;
+            addFilter(*parser.parse(filter), true);
+        }
+    }
+    subscriptions_.analyze(subscription, std::move(scored), original_terms);
+}
+
+double SearchEngine::subscriptionScore(const SubscriptionIndex::Subscription& subscription, uint64_t doc_id) {
+    auto doc_it = documents_.find(doc_id);
+    if (doc_it == documents_.end()) {
+        return 0.0;
+    }
+    const uint32_t ordinal = doc_values_.ordinal(doc_id);
+    for (const auto& filter : subscription.filters) {
+        if (!filter.matches(doc_values_, ordinal)) {
+            return 0.0;
+        }
+    }
+    if (subscription.scored.terms.empty()) {
+        return subscription.filters.empty() ? 0.0 : 1.0;  // Filter only: constant score
+    }
+    // A hit is in the postings of one of the candidate terms
+    std::vector<std::string> candidate_terms;
+    const IndexStats stats = queryStats(subscription.scored.terms, subscription.original_terms, candidate_terms);
+    const bool candidate = std::any_of(candidate_terms.begin(), candidate_terms.end(), [&](const std::string& term) {
+        return !index_->getPositions(term, doc_id).empty();
+    });
+    if (!candidate) {
+        return 0.0;
+    }
+    const double score = selectRanker(subscription.options)->score(subscription.scored, doc_it->second, stats);
+    return score > 0.0 ? score : 0.0;
+}
+
+SearchEngine::SubscriptionNotifications SearchEngine::updateSubscriptions(
+    const std::vector<std::pair<uint64_t, std::unordered_set<std::string>>>& writes, bool resync) {
+    if (subscriptions_.empty()) {
+        return {};
+    }
+    std::unordered_map<uint64_t, SubscriptionDelta> deltas;
+    std::unordered_set<uint64_t> stale;
+    if (resync) {
+        for (uint64_t id : subscriptions_.ids()) {
+            analyzeSubscription(*subscriptions_.find(id));
+            stale.insert(id);
+        }
+    }
+    for (const auto& [doc_id, terms] : writes) {
+        for (uint64_t id : subscriptions_.candidates(doc_id, terms)) {
+            if (stale.count(id)) {
+                continue;  // Searches again below
+            }
+            auto& subscription = *subscriptions_.find(id);
+            const double score = subscriptionScore(subscription, doc_id);
+            const Document* doc = score > 0.0 ? &documents_.find(doc_id)->second : nullptr;
+            if (!subscriptions_.apply(subscription, doc_id, doc, score, deltas[id])) {
+                stale.insert(id);
+            }
+        }
+    }
+    for (uint64_t id : stale) {
+        auto& subscription = *subscriptions_.find(id);
+        subscriptions_.replace(subscription, searchInternal(subscription.query, subscription.options), deltas[id]);
+    }
+    
+    std::vector<uint64_t> changed;
+    for (const auto& [id, delta] : deltas) {
+        changed.push_back(id);
+    }
+    std::sort(changed.begin(), changed.end());
+    SubscriptionNotifications notifications;
+    for (uint64_t id : changed) {
+        auto& subscription = *subscriptions_.find(id);
+        if (subscriptions_.publish(subscription, deltas[id]) && subscription.callback) {
+            notifications.emplace_back(subscription.callback, std::move(deltas[id]));
+        }
+    }
+    return notifications;
+}
+
+void SearchEngine::notifySubscribers(const SubscriptionNotifications& notifications) {
+    for (const auto& [callback, delta] : notifications) {
+        callback(delta);
+    }
+}
+
+// ==================== More like this ====================
+
+std::vector<std::pair<std::string, double>> SearchEngine::interestingTerms(
+    uint64_t doc_id, const MoreLikeThisOptions& options) const {
+    auto doc_it = documents_.find(doc_id);
+    if (doc_it == documents_.end() || options.max_query_terms == 0) {
+        return {};
+    }
+    
+    // Term frequencies of the source: its stored vector, or one tokenize
+    std::vector<std::pair<std::string, uint32_t>> frequencies;
+    if (const auto* vector = term_vectors_.find(doc_id)) {
+        frequencies.reserve(vector->size());
+        for (const auto& entry : *vector) {
+            frequencies.emplace_back(term_vectors_.term(entry.term), entry.frequency);
+        }
+    } else {
+        std::unordered_map<std::string, uint32_t> counts;
+        for (const auto& token : tokenizer_->tokenizeWithPositions(doc_it->second.getAllText())) {
+            ++counts[token.text];
+        }
+        frequencies.assign(counts.begin(), counts.end());
+    }
+    
+    const double total_docs = static_cast<double>(documents_.size());
+    std::vector<std::pair<std::string, double>> terms;
+    for (auto& [term, tf] : frequencies) {
+        if (tf < options.min_term_freq) {
+            continue;
+        }
+        const size_t df = index_->getDocumentFrequency(term);
+        if (df == 0 || df < options.min_doc_freq || static_cast<double>(df) > options.max_doc_freq * total_docs) {
+            continue;
+        }
+        const double tf_idf = std::log(1.0 + tf) * std::log(total_docs / static_cast<double>(df));
+        if (tf_idf > 0.0) {
+            terms.emplace_back(std::move(term), tf_idf);
+        }
+    }
+    
+    const size_t kept = std::min(terms.size(), options.max_query_terms);
+    std::partial_sort(terms.begin(), terms.begin() + kept, terms.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    terms.resize(kept);
+    if (!terms.empty()) {
+        const double best = terms.front().second;
+        for (auto& term : terms) {
+            term.second = options.boost_terms ? term.second / best : 1.0;
+        }
+    }
+    return terms;
+}
+
+std::vector<std::pair<std::string, double>> SearchEngine::moreLikeThisTerms(
+    uint64_t doc_id, const MoreLikeThisOptions& options) const {
+    std::shared_lock lock(mutex_);
+    return interestingTerms(doc_id, options);
+}
+
+std::vector<SearchResult> SearchEngine::moreLikeThis(uint64_t doc_id, size_t k,
+                                                     const MoreLikeThisOptions& options) const {
+    std::shared_lock lock(mutex_);
+    const auto terms = interestingTerms(doc_id, options);
+    if (terms.empty() || k == 0) {
+        return {};
+    }
+    
+    // BM25 with the registered ranker's parameters
+    double k1 = 1.5;
+    double b = 0.75;
+    if (const auto* bm25 = dynamic_cast<const Bm25Ranker*>(ranker_registry_->getRanker("BM25"))) {
+        k1 = bm25->getK1();
+        b = bm25->getB();
+    }
+    const double total_docs = static_cast<double>(documents_.size());
+    const double avg_length = static_cast<double>(total_term_count_) / total_docs;
+    
+    // A term adds at most weight * (k1 + 1) to a score (tf -> infinity):
+    // evaluate the heaviest first, knowing what the ones after each can add
+    struct Clause {
+        const std::string* term;
+        double weight;  // Boost * idf
+        double bound;
+    };
+    std::vector<Clause> clauses;
+    clauses.reserve(terms.size());
+    for (const auto& [term, boost] : terms) {
+        const double df = static_cast<double>(index_->getDocumentFrequency(term));
+        const double weight = boost * std::log((total_docs - df + 0.5) / (df + 0.5) + 1.0);
+        clauses.push_back({&term, weight, weight * (k1 + 1.0)});
+    }
+    std::sort(clauses.begin(), clauses.end(), [](const Clause& a, const Clause& b) { return a.bound > b.bound; });
+    std::vector<double> remaining(clauses.size() + 1, 0.0);
+    for (size_t i = clauses.size(); i-- > 0;) {
+        remaining[i] = remaining[i + 1] + clauses[i].bound;
+    }
+    
+    // Term-at-a-time accumulation. A document first met at clause i scores
+    // at most remaining[i]: once k documents have more than that, no new
+    // one can enter the top k, and later clauses only update those already
+    // accumulating (their scores stay exact)
+    std::unordered_map<uint64_t, double> scores;
+    std::vector<double> partial;
+    bool admitting = true;
+    for (size_t i = 0; i < clauses.size(); ++i) {
+        if (admitting && scores.size() >= k) {
+            partial.clear();
+            for (const auto& [id, score] : scores) {
+                partial.push_back(score);
+            }
+            std::nth_element(partial.begin(), partial.begin() + (k - 1), partial.end(), std::greater<double>());
+            admitting = remaining[i] >= partial[k - 1];
+        }
+        
+        const Clause& clause = clauses[i];
+        index_->forEachPosting(*clause.term, [&](const Posting& posting) {
+            if (posting.doc_id == doc_id) {
+                return;
+            }
+            auto it = scores.find(posting.doc_id);
+            if (it == scores.end() && !admitting) {
+                return;
+            }
+            auto doc_it = documents_.find(posting.doc_id);
+            if (doc_it == documents_.end()) {
+                return;
+            }
+            if (it == scores.end()) {
+                it = scores.emplace(posting.doc_id, 0.0).first;
+            }
+            const double tf = posting.term_frequency;
+            const double length = static_cast<double>(doc_it->second.term_count);
+            it->second += clause.weight * tf * (k1 + 1.0) / (tf + k1 * (1.0 - b + b * length / avg_length));
+        });
+    }
+    
+    BoundedPriorityQueue<ScoredDocument> top_k(k);
+    for (const auto& [id, score] : scores) {
+        top_k.push({id, score});  // Ties go to the lower id, as if every candidate was scored
+    }
+    std::vector<SearchResult> results;
+    for (const auto& scored_doc : top_k.getSorted()) {
+        SearchResult result;
+        result.document = documents_.at(scored_doc.doc_id);
+        result.score = scored_doc.score;
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+bool SearchEngine::setIndexSort(const std::string& field, bool descending) {
+    std::unique_lock lock(mutex_);
+    query_cache_.clear();
+    filter_cache_.clear();  // Ordinals are renumbered
+    return doc_values_.setIndexSort({field, descending});
+}
+
+std::vector<SearchResult> SearchEngine::collectSorted(const SearchOptions& options,
+                                                      const std::vector<uint64_t>& candidates,
+                                                      const std::function<double(uint64_t)>& score,
+                                                      HitCollector* hits) const {
+    TopFieldCollector collector(FieldComparator(doc_values_, options.sort), options.max_results);
+    const auto collect = [&](uint64_t doc_id, uint32_t ordinal) {
+        const double hit_score = score(doc_id);
+        if (hit_score > 0.0) {
+            if (hits) {
+                hits->collect(doc_id);
+            }
+            collector.collect({doc_id, ordinal, hit_score});
+        }
+    };
+
+    // Facets and aggregations need every hit; a page as large as the
+    // candidates saves nothing
+    const SortField* index_sort = doc_values_.indexSort();
+    const bool early_termination = !hits && index_sort && index_sort->field == options.sort.front().field &&
+                                   index_sort->descending == options.sort.front().descending &&
+                                   candidates.size() > options.max_results;
+    size_t visited = 0;
+    if (early_termination) {
+        // Out-of-order candidates first (they may tighten the bound), then
+        // the others in ordinal order until the worst kept hit beats the
+        // next one on the primary key. Equal primary keys are still
+        // visited, since later keys, score and doc id may reorder them.
+        // A bitset over the ordinals: ordered in O(candidates + ordinals / 64)
+        std::vector<uint64_t> in_order((doc_values_.ordinals() + 63) / 64, 0);
+        for (uint64_t doc_id : candidates) {
+            const uint32_t ordinal = doc_values_.ordinal(doc_id);
+            if (doc_values_.inIndexOrder(ordinal)) {
+                in_order[ordinal >> 6] |= uint64_t{1} << (ordinal & 63);
+            } else {
+                collect(doc_id, ordinal);
+            }
+        }
+        const FieldComparator& comparator = collector.comparator();
+        bool done = false;
+        for (size_t w = 0; w < in_order.size() && !done; ++w) {
+            for (uint64_t word = in_order[w]; word != 0; word &= word - 1) {
+                const uint32_t ordinal = static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+                const uint64_t doc_id = doc_values_.docId(ordinal);
+                if (collector.full() && comparator.comparePrimary({doc_id, ordinal, 0.0}, collector.worst()) > 0) {
+                    done = true;
+                    break;
+                }
+                collect(doc_id, ordinal);
+                ++visited;
+            }
+        }
+    } else {
+        for (uint64_t doc_id : candidates) {
+            collect(doc_id, doc_values_.ordinal(doc_id));
+        }
+    }
+
+    std::vector<SearchResult> results;
+    for (const auto& hit : collector.sorted()) {
+        auto doc_it = documents_.find(hit.doc_id);
+        if (doc_it == documents_.end()) {
+            continue;
+        }
+        SearchResult result;
+        result.document = doc_it->second;
+        result.score = hit.score;
+        if (options.explain_scores) {
+            result.explanation = early_termination
+                                     ? "Method: Index-Sorted Walk (" + std::to_string(visited) + " of " +
+                                           std::to_string(candidates.size()) + " candidates visited)"
+                                     : "Method: Top-K Field Sort";
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+std::vector<SearchResult> SearchEngine::collectCollapsed(const SearchOptions& options,
+                                                         const std::vector<uint64_t>& candidates,
+                                                         const std::function<double(uint64_t)>& score,
+                                                         HitCollector* hits) const {
+    TopGroupsCollector groups(FieldComparator(doc_values_, options.sort), doc_values_, options.collapse_field,
+                              options.max_results, options.collapse_inner_hits);
+    for (uint64_t doc_id : candidates) {
+        const double hit_score = score(doc_id);
+        if (hit_score > 0.0) {
+            if (hits) {
+                hits->collect(doc_id);
+            }
+            groups.collect({doc_id, doc_values_.ordinal(doc_id), hit_score});
+        }
+    }
+    // Groups that fell out of the top and came back: rescore their hits only
+    size_t rescored = 0;
+    if (groups.beginRecollect()) {
+        for (uint64_t doc_id : candidates) {
+            const uint32_t ordinal = doc_values_.ordinal(doc_id);
+            if (groups.recollects(ordinal)) {
+                const double hit_score = score(doc_id);
+                if (hit_score > 0.0) {
+                    groups.recollect({doc_id, ordinal, hit_score});
+                    ++rescored;
+                }
+            }
+        }
+    }
+
+    const auto toResult = [&](const FieldHit& hit, SearchResult& result) {
+        auto doc_it = documents_.find(hit.doc_id);
+        if (doc_it == documents_.end()) {
+            return false;
+        }
+        result.document = doc_it->second;
+        result.score = hit.score;
+        return true;
+    };
+    std::vector<SearchResult> results;
+    for (const auto& group : groups.sorted()) {
+        SearchResult result;
+        if (!toResult(group.head, result)) {
+            continue;
+        }
+        if (options.collapse_inner_hits > 0) {
+            for (const auto& hit : group.hits) {
+                SearchResult inner;
+                if (toResult(hit, inner)) {
+                    result.inner_hits.push_back(std::move(inner));
+                }
+            }
+        }
+        if (options.explain_scores) {
+            result.explanation = "Method: Collapse on " + options.collapse_field + " (" + std::to_string(rescored) +
+                                 " hits rescored for inner hits)";
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+std::vector<std::shared_ptr<const SegmentedDocIdSet>> SearchEngine::compileFilters(const std::string& query,
+                                                                                   const SearchOptions& options) {
+    std::vector<std::shared_ptr<const SegmentedDocIdSet>> filters;
+    const auto addClause = [&](const QueryNode& clause, bool filter_context) {
+        const QueryNode::Type type = clause.getType();
+        if (!filter_context && type != QueryNode::Type::RANGE && type != QueryNode::Type::AND &&
+            type != QueryNode::Type::OR && type != QueryNode::Type::NOT) {
+            return;  // Scored
+        }
+        // The context is part of the key: an AND only drops scored clauses in a query
+        const std::string key = (filter_context ? "filter:" : "query:") + clause.toString();
+        auto set = filter_cache_.getOrCompute(key, doc_values_, [&] { return filterIterator(clause, filter_context); });
+        if (set) {
+            filters.push_back(std::move(set));
+        }
+    };
+    // Top-level AND clauses are cached one by one, so "a AND b" and
+    // "a AND c" share the set of a
+    const auto addClauses = [&](const QueryNode& root, bool filter_context) {
+        if (root.getType() == QueryNode::Type::AND) {
+            for (const auto& child : static_cast<const AndNode&>(root).children) {
+                addClause(*child, filter_context);
+            }
+        } else {
+            addClause(root, filter_context);
+        }
+    };
+
+    if (query.find_first_of("[{") != std::string::npos) {
+        QueryParser parser;  // parse() keeps token state: one parser per call
+        addClauses(*parser.parse(query), false);
+    }
+    for (const auto& filter : options.filters) {
+        if (filter.find_first_not_of(" \t") == std::string::npos) {
+            continue;
+        }
+        QueryParser parser;
+        addClauses(*parser.parse(filter), true);
+    }
+
+    std::sort(filters.begin(), filters.end(),
+              [](const auto& a, const auto& b) { return a->cardinality() < b->cardinality(); });
+    return filters;
+}
+
+namespace {
+
+std::unique_ptr<DocIdSetIterator> noDocs() {
+    return std::make_unique<SortedDocIdIterator>(std::vector<uint32_t>{});
+}
+
+// Inclusive keys of `range` on a field of `type`; false if it matches nothing
+bool rangeKeys(const RangeNode& range, FieldType type, int64_t& lower, int64_t& upper) {
+    return DocValues::rangeKeys(type, range.lower, range.include_lower, range.upper, range.include_upper, lower,
+                                upper);
+}
+
+// The value of field:value or field:"two words"
+std::string fieldValue(const FieldNode& field) {
+    std::string value;
+    if (field.query->getType() == QueryNode::Type::TERM) {
+        value = static_cast<const TermNode&>(*field.query).term;
+    } else if (field.query->getType() == QueryNode::Type::PHRASE) {
+        for (const auto& term : static_cast<const PhraseNode&>(*field.query).terms) {
+            value += (value.empty() ? "" : " ") + term;
+        }
+    }
+    return value;
+}
+
+}  // namespace
+
+std::unique_ptr<DocIdSetIterator> SearchEngine::filterIterator(const QueryNode& node, bool filter_context) const {
+    std::vector<std::unique_ptr<DocIdSetIterator>> children;
+    switch (node.getType()) {
+        case QueryNode::Type::RANGE: {
+            // Bounds are converted once here; documents are compared as keys
+            const auto& range = static_cast<const RangeNode&>(node);
+            int64_t lower = 0;
+            int64_t upper = 0;
+            if (!rangeKeys(range, doc_values_.fieldType(range.field_name), lower, upper)) {
+                return noDocs();
+            }
+            return doc_values_.rangeIterator(range.field_name, lower, upper);
+        }
+        case QueryNode::Type::FIELD: {
+            if (!filter_context) {
+                return nullptr;
+            }
+            // field:value on a keyword field, or an exact numeric value
+            const auto& field = static_cast<const FieldNode&>(node);
+            const std::string value = fieldValue(field);
+            const FieldType type = doc_values_.fieldType(field.field_name);
+            int64_t key = 0;
+            if (type == FieldType::KEYWORD) {
+                return doc_values_.keywordIterator(field.field_name, value);
+            }
+            if (isNumericType(type) && DocValues::parseValue(type, value, key)) {
+                return doc_values_.rangeIterator(field.field_name, key, key);
+            }
+            return noDocs();
+        }
+        case QueryNode::Type::AND:
+            // In a query, scored clauses are left to the ranker and filter
+            // clauses intersect
+            for (const auto& child : static_cast<const AndNode&>(node).children) {
+                if (auto iterator = filterIterator(*child, filter_context)) {
+                    children.push_back(std::move(iterator));
+                }
+            }
+            if (children.empty()) {
+                return nullptr;
+            }
+            if (children.size() == 1) {
+                return std::move(children.front());
+            }
+            return std::make_unique<ConjunctionIterator>(std::move(children));
+        case QueryNode::Type::OR:
+            for (const auto& child : static_cast<const OrNode&>(node).children) {
+                auto iterator = filterIterator(*child, filter_context);
+                if (!iterator) {
+                    return nullptr;  // A scored alternative: not a filter
+                }
+                children.push_back(std::move(iterator));
+            }
+            return std::make_unique<DisjunctionIterator>(std::move(children));
+        case QueryNode::Type::NOT: {
+            auto excluded = filterIterator(*static_cast<const NotNode&>(node).child, filter_context);
+            if (!excluded) {
+                return nullptr;
+            }
+            return std::make_unique<ExclusionIterator>(
+                std::make_unique<AllDocsIterator>(static_cast<uint32_t>(doc_values_.ordinals())), std::move(excluded));
+        }
+        default:
+            return filter_context ? noDocs() : nullptr;
+    }
+}
+
+bool SearchEngine::compileDocFilter(const QueryNode& node, bool filter_context, DocFilter& filter) const {
+    // Mirrors filterIterator(), clause for clause
+    switch (node.getType()) {
+        case QueryNode::Type::RANGE: {
+            const auto& range = static_cast<const RangeNode&>(node);
+            if (rangeKeys(range, doc_values_.fieldType(range.field_name), filter.lower, filter.upper)) {
+                filter.kind = DocFilter::Kind::RANGE;
+                filter.field = range.field_name;
+            }
+            return true;
+        }
+        case QueryNode::Type::FIELD: {
+            if (!filter_context) {
+                return false;
+            }
+            const auto& field = static_cast<const FieldNode&>(node);
+            const std::string value = fieldValue(field);
+            const FieldType type = doc_values_.fieldType(field.field_name);
+            if (type == FieldType::KEYWORD) {
+                filter.kind = DocFilter::Kind::KEYWORD;
+                filter.value = DocValues::normalizeKeyword(value);
+            } else if (isNumericType(type) && DocValues::parseValue(type, value, filter.lower)) {
+                filter.kind = DocFilter::Kind::RANGE;
+                filter.upper = filter.lower;
+            }
+            filter.field = field.field_name;
+            return true;
+        }
+        case QueryNode::Type::AND:
+            for (const auto& child : static_cast<const AndNode&>(node).children) {
+                DocFilter compiled;
+                if (compileDocFilter(*child, filter_context, compiled)) {
+                    filter.children.push_back(std::move(compiled));
+                }
+            }
+            if (filter.children.empty()) {
+                return false;
+            }
+            filter.kind = DocFilter::Kind::AND;
+            return true;
+        case QueryNode::Type::OR:
+            for (const auto& child : static_cast<const OrNode&>(node).children) {
+                DocFilter compiled;
+                if (!compileDocFilter(*child, filter_context, compiled)) {
+                    return false;  // A scored alternative: not a filter
+                }
+                filter.children.push_back(std::move(compiled));
+            }
+            filter.kind = DocFilter::Kind::OR;
+            return true;
+        case QueryNode::Type::NOT: {
+            DocFilter excluded;
+            if (!compileDocFilter(*static_cast<const NotNode&>(node).child, filter_context, excluded)) {
+                return false;
+            }
+            filter.kind = DocFilter::Kind::NOT;
+            filter.children.push_back(std::move(excluded));
+            return true;
+        }
+        default:
+            return filter_context;  // Matches nothing
+    }
+}
+
+void SearchEngine::setSynonyms(std::shared_ptr<const SynonymMap> synonyms, SynonymMode mode) {
+    std::unique_lock lock(mutex_);
+    synonyms_ = std::move(synonyms);
+    synonym_mode_ = mode;
+    query_cache_.clear();
+    const auto notifications = updateSubscriptions({}, true);  // Query-time alternatives changed
+    lock.unlock();
+    notifySubscribers(notifications);
+}
+
+void SearchEngine::expandSynonyms(std::vector<std::string>& terms, std::vector<double>& weights,
+                                  size_t max_expansions) const {
+    const auto matches = synonyms_->match(terms);
+    if (matches.empty()) {
+        return;
+    }
+    
+    // Pruning: an alternative with a word no document contains cannot
+    // match, so it never becomes a term (and never costs a posting scan)
+    std::unordered_set<std::string> seen(terms.begin(), terms.end());
+    weights.assign(terms.size(), 1.0);
+    const size_t limit = terms.size() + max_expansions;
+    for (const auto& match : matches) {
+        for (const auto& alternative : *match.alternatives) {
+            if (terms.size() >= limit) {
+                return;
+            }
+            if (seen.count(alternative.text) > 0) {
+                continue;
+            }
+            bool indexed = true;
+            for (const auto& word : SynonymMap::splitWords(alternative.text)) {
+                if (index_->getDocumentFrequency(word) == 0) {
+                    indexed = false;
+                    break;
+                }
+            }
+            if (indexed) {
+                seen.insert(alternative.text);
+                terms.push_back(alternative.text);
+                weights.push_back(alternative.weight);
+            }
+        }
+    }
+}
+
+MemoryUsage SearchEngine::memoryUsage() const {
+    std::shared_lock lock(mutex_);
+    
+    MemoryUsage usage;
+    index_->accumulateMemoryUsage(usage);
+    
+    usage.document_store_bytes = memory_accounting::hashTableBytes(documents_);
+    for (const auto& [id, doc] : documents_) {
+        usage.document_store_bytes += doc.memoryUsage();
+    }
+    usage.document_store_bytes += memory_accounting::hashTableBytes(term_offsets_);
+    for (const auto& [id, offsets] : term_offsets_) {
+        usage.document_store_bytes += memory_accounting::vectorUsedBytes(offsets);
+    }
+    usage.document_store_bytes += term_vectors_.memoryUsage();
+    
+    usage.fuzzy_index_bytes = fuzzy_search_.memoryUsage();
+    usage.query_cache_bytes = query_cache_.memoryUsage();
+    usage.filter_cache_bytes = filter_cache_.memoryUsage();
+    usage.percolator_bytes = percolator_.memoryUsage();
+    if (vector_index_) {
+        usage.vector_index_bytes = vector_index_->memoryUsage();
+    }
+    if (!doc_values_.empty()) {
+        usage.doc_values_bytes = doc_values_.memoryUsage();
+    }
+    
+    return usage;
+}
+
+IndexAnalysis SearchEngine::analyzeIndex(size_t top_n) const {
+    return index_->analyze(top_n);
+}
+
 std::vector<std::pair<uint64_t, Document>> SearchEngine::getDocuments(size_t offset, size_t limit) const {
     std::shared_lock lock(mutex_);
     std::vector<std::pair<uint64_t, Document>> result;
@@ -531,6 +1924,7 @@ std::vector<std::pair<uint64_t, Document>> SearchEngine::getDocuments(size_t off
 
 void SearchEngine::clearCache() {
     query_cache_.clear();
+    filter_cache_.clear();
 }
 
 void SearchEngine::setCacheConfig(size_t max_entries, std::chrono::milliseconds ttl) {
@@ -538,6 +1932,14 @@ void SearchEngine::setCacheConfig(size_t max_entries, std::chrono::milliseconds
     query_cache_.setTtl(ttl);
 }
 
+FilterCacheStatistics SearchEngine::getFilterCacheStats() const {
+    return filter_cache_.getStats();
+}
+
+void SearchEngine::setFilterCacheConfig(size_t max_bytes, size_t min_frequency) {
+    filter_cache_.configure(max_bytes, min_frequency);
+}
+
 bool SearchEngine::saveSnapshot(const std::string& filepath) {
     std::shared_lock lock(mutex_);
     return Persistence::save(*this, filepath);
@@ -546,9 +1948,17 @@ bool SearchEngine::saveSnapshot(const std::string& filepath) {
 bool SearchEngine::loadSnapshot(const std::string& filepath) {
     std::unique_lock lock(mutex_);
     const bool loaded = Persistence::load(*this, filepath);
+    total_term_count_ = 0;
+    for (const auto& [doc_id, doc] : documents_) {
+        total_term_count_ += doc.term_count;
+    }
     if (loaded) {
         query_cache_.clear();
+        filter_cache_.clear();
     }
+    const auto notifications = updateSubscriptions({}, loaded);
+    lock.unlock();
+    notifySubscribers(notifications);
     return loaded;
 }
 
@@ -611,7 +2021,9 @@ void SearchEngine::setRanker(std::unique_ptr<Ranker> ranker) {
 }
 
 void SearchEngine::setTokenizer(std::unique_ptr<Tokenizer> tokenizer) {
+    std::unique_lock lock(mutex_);
     tokenizer_ = std::move(tokenizer);
+    percolator_.rebuild(percolatorContext());  // Stored queries were analyzed by the old one
 }
 
 } 
@@ -13,43 +13,58 @@ std::vector<std::string> SnippetExtractor::generateSnippets(
         const std::vector<std::string>& query_terms,
         const SnippetOptions& options) const {
 
+    if (text.empty() || query_terms.empty()) {
+        return {};
+    }
+    return generateSnippets(text, TermMatcher(query_terms), options);
+}
+
+std::vector<std::string> SnippetExtractor::generateSnippets(
+        const std::string& text,
+        const TermMatcher& matcher,
+        const SnippetOptions& options) const {
+
+    std::vector<TermOffset> matches;
+    matcher.findMatches(text, matches);
+    return generateSnippetsFromOffsets(text, matches, options);
+}
+
+std::vector<std::string> SnippetExtractor::generateSnippetsFromOffsets(
+        const std::string& text,
+        const std::vector<TermOffset>& matches,
+        const SnippetOptions& options) const {
+
     std::vector<std::string> snippets;
 
-    if (text.empty() || query_terms.empty()) {
+    if (text.empty()) {
         return snippets;
     }
 
-    // If the entire document is shorter than one snippet, just highlight the whole thing
+    std::vector<Window> windows;
     if (text.size() <= options.max_snippet_length) {
-        snippets.push_back(
-            highlightTerms(text, query_terms, options.highlight_open, options.highlight_close));
-        return snippets;
+        windows.push_back({0, text.size(), matches.size()});
+    } else if (matches.empty()) {
+        // No matches — a single snippet from the beginning
+        windows.push_back({0, options.max_snippet_length, 0});
+    } else {
+        windows = findBestWindows(matches, text.size(),
+                                  options.max_snippet_length, options.num_snippets);
     }
 
-    // Find the best windows with highest query-term density
-    auto windows = findBestWindows(text, query_terms,
-                                   options.max_snippet_length, options.num_snippets);
-
     for (auto& win : windows) {
-        // Snap to word boundaries
         snapToWordBoundaries(text, win.start, win.end);
 
-        // Extract raw substring
-        std::string raw = text.substr(win.start, win.end - win.start);
-
-        // Highlight terms inside the snippet
-        std::string highlighted = highlightTerms(raw, query_terms,
-                                                 options.highlight_open, options.highlight_close);
-
-        // Add ellipsis where applicable
+        std::string snippet;
+        snippet.reserve(win.end - win.start + 6 +
+                        win.match_count * (options.highlight_open.size() + options.highlight_close.size()));
         if (win.start > 0) {
-            highlighted = "..." + highlighted;
+            snippet += "...";
         }
+        appendHighlighted(snippet, text, win.start, win.end, matches, options);
         if (win.end < text.size()) {
-            highlighted = highlighted + "...";
+            snippet += "...";
         }
-
-        snippets.push_back(highlighted);
+        snippets.push_back(std::move(snippet));
     }
 
     return snippets;
@@ -65,142 +80,57 @@ std::string SnippetExtractor::highlightTerms(
         return text;
     }
 
-    // Build a set of lowercased query terms for fast lookup
-    std::unordered_set<std::string> term_set;
-    for (const auto& t : query_terms) {
-        term_set.insert(toLower(t));
-    }
-
     std::string result;
-    result.reserve(text.size() + query_terms.size() * (open_tag.size() + close_tag.size()) * 2);
-
-    size_t i = 0;
-    while (i < text.size()) {
-        // If we're at the start of a word, try to match a query term
-        if (isWordChar(text[i])) {
-            // Find the full word
-            size_t word_start = i;
-            while (i < text.size() && isWordChar(text[i])) {
-                ++i;
-            }
-            std::string word = text.substr(word_start, i - word_start);
-            std::string word_lower = toLower(word);
-
-            if (term_set.count(word_lower)) {
-                result += open_tag;
-                result += word;  // Preserve original case
-                result += close_tag;
-            } else {
-                result += word;
-            }
-        } else {
-            result += text[i];
-            ++i;
-        }
-    }
-
+    TermMatcher(query_terms).highlight(text, open_tag, close_tag, result);
     return result;
 }
 
 // ==================== Private Helpers ====================
 
 std::vector<SnippetExtractor::Window> SnippetExtractor::findBestWindows(
-        const std::string& text,
-        const std::vector<std::string>& query_terms,
+        const std::vector<TermOffset>& matches,
+        size_t text_size,
         size_t window_size,
         size_t num_windows) const {
 
-    // Build a set of lowercased query terms
-    std::unordered_set<std::string> term_set;
-    for (const auto& t : query_terms) {
-        term_set.insert(toLower(t));
-    }
-
-    // Tokenize the document text to find term positions
-    // We do a simple scan to find (start, end, lowered_word) tuples
-    struct WordPos {
-        size_t start;
-        size_t end;
-        std::string lower_word;
-    };
-
-    std::vector<WordPos> words;
-    size_t i = 0;
-    while (i < text.size()) {
-        if (isWordChar(text[i])) {
-            size_t ws = i;
-            while (i < text.size() && isWordChar(text[i])) ++i;
-            std::string w = text.substr(ws, i - ws);
-            words.push_back({ws, i, toLower(w)});
-        } else {
-            ++i;
+    // Window anchored at each match: it covers matches [i, last) whose
+    // starts fit in window_size (two pointers, O(M))
+    std::vector<Window> candidates;
+    candidates.reserve(matches.size());
+    size_t last = 0;
+    for (size_t i = 0; i < matches.size(); ++i) {
+        const size_t limit = static_cast<size_t>(matches[i].start) + window_size;
+        last = std::max(last, i + 1);
+        while (last < matches.size() && matches[last].start < limit) {
+            ++last;
         }
-    }
 
-    if (words.empty()) {
-        return {};
+        // Centre the covered matches so the snippet shows context on both sides
+        const size_t span = std::min<size_t>(matches[last - 1].end, limit) - matches[i].start;
+        const size_t lead = (window_size - std::min(span, window_size)) / 2;
+        size_t start = matches[i].start > lead ? matches[i].start - lead : 0;
+        const size_t end = std::min(start + window_size, text_size);
+        start = end > window_size ? std::min(start, end - window_size) : 0;
+        candidates.push_back({start, end, last - i});
     }
 
-    // Score every possible window of the given character width
-    // Use a sliding-window approach over word positions
-    struct ScoredWindow {
-        size_t start;
-        size_t end;
-        size_t score;
-    };
-
-    std::vector<ScoredWindow> scored_windows;
-
-    // Try window starting at each word position
-    for (size_t wi = 0; wi < words.size(); ++wi) {
-        size_t w_start = words[wi].start;
-        size_t w_end = std::min(w_start + window_size, text.size());
-
-        // Count query term matches inside [w_start, w_end)
-        size_t score = 0;
-        for (size_t wj = wi; wj < words.size() && words[wj].start < w_end; ++wj) {
-            if (term_set.count(words[wj].lower_word)) {
-                ++score;
-            }
-        }
-
-        if (score > 0) {
-            scored_windows.push_back({w_start, w_end, score});
-        }
-    }
-
-    if (scored_windows.empty()) {
-        // No matches at all — return a single snippet from the beginning
-        Window fallback;
-        fallback.start = 0;
-        fallback.end = std::min(window_size, text.size());
-        fallback.match_count = 0;
-        return {fallback};
-    }
-
-    // Sort by score descending, then by position ascending (prefer earlier text)
-    std::sort(scored_windows.begin(), scored_windows.end(),
-        [](const ScoredWindow& a, const ScoredWindow& b) {
-            if (a.score != b.score) return a.score > b.score;
-            return a.start < b.start;
-        });
+    std::stable_sort(candidates.begin(), candidates.end(),
+        [](const Window& a, const Window& b) { return a.match_count > b.match_count; });
 
     // Greedily pick non-overlapping windows
     std::vector<Window> result;
-    for (const auto& sw : scored_windows) {
+    for (const auto& candidate : candidates) {
         if (result.size() >= num_windows) break;
 
-        // Check overlap with already-selected windows
         bool overlaps = false;
         for (const auto& existing : result) {
-            if (sw.start < existing.end && sw.end > existing.start) {
+            if (candidate.start < existing.end && candidate.end > existing.start) {
                 overlaps = true;
                 break;
             }
         }
-
         if (!overlaps) {
-            result.push_back({sw.start, sw.end, sw.score});
+            result.push_back(candidate);
         }
     }
 
@@ -211,6 +141,27 @@ std::vector<SnippetExtractor::Window> SnippetExtractor::findBestWindows(
     return result;
 }
 
+void SnippetExtractor::appendHighlighted(std::string& out, const std::string& text,
+                                         size_t start, size_t end,
+                                         const std::vector<TermOffset>& matches,
+                                         const SnippetOptions& options) {
+    auto it = std::lower_bound(matches.begin(), matches.end(), start,
+        [](const TermOffset& match, size_t offset) { return match.start < offset; });
+
+    size_t cursor = start;
+    for (; it != matches.end() && it->end <= end; ++it) {
+        if (it->start < cursor) {
+            continue;  // Overlaps the previous match
+        }
+        out.append(text, cursor, it->start - cursor);
+        out += options.highlight_open;
+        out.append(text, it->start, it->end - it->start);
+        out += options.highlight_close;
+        cursor = it->end;
+    }
+    out.append(text, cursor, end - cursor);
+}
+
 void SnippetExtractor::snapToWordBoundaries(const std::string& text, size_t& start, size_t& end) const {
     // Snap start forward to the beginning of the next word if we're mid-word
     if (start > 0 && start < text.size() && isWordChar(text[start]) && isWordChar(text[start - 1])) {
@@ -239,16 +190,8 @@ void SnippetExtractor::snapToWordBoundaries(const std::string& text, size_t& sta
     }
 }
 
-std::string SnippetExtractor::toLower(const std::string& str) {
-    std::string result = str;
-    for (auto& c : result) {
-        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
-    }
-    return result;
-}
-
 bool SnippetExtractor::isWordChar(char c) {
-    return std::isalnum(static_cast<unsigned char>(c)) || c == '\'';
+    return TermMatcher::isWordChar(c);
 }
 
 } // namespace rtrv_search_engine
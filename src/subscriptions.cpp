@@ -0,0 +1,300 @@
+#include "subscriptions.hpp"
+#include "synonym_map.hpp"
+#include <algorithm>
+
+namespace rtrv_search_engine {
+
+namespace {
+
+void eraseId(std::vector<uint64_t>& ids, uint64_t id) {
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+}
+
+// Deltas accumulate every change of one write (or batch): a document's
+// latest state wins
+void recordUpsert(SubscriptionDelta& delta, const SearchResult& result) {
+    eraseId(delta.removed, result.document.id);
+    for (auto& upsert : delta.upserts) {
+        if (upsert.document.id == result.document.id) {
+            upsert = result;
+            return;
+        }
+    }
+    delta.upserts.push_back(result);
+}
+
+void recordRemoval(SubscriptionDelta& delta, uint64_t doc_id) {
+    delta.upserts.erase(std::remove_if(delta.upserts.begin(), delta.upserts.end(),
+                                       [&](const SearchResult& upsert) { return upsert.document.id == doc_id; }),
+                        delta.upserts.end());
+    if (std::find(delta.removed.begin(), delta.removed.end(), doc_id) == delta.removed.end()) {
+        delta.removed.push_back(doc_id);
+    }
+}
+
+// Best first; a newcomer goes after the results it ties with
+std::vector<SearchResult>::iterator insertionPoint(std::vector<SearchResult>& results, double score) {
+    return std::find_if(results.begin(), results.end(), [&](const SearchResult& result) { return result.score < score; });
+}
+
+}  // namespace
+
+bool DocFilter::matches(const DocValues& doc_values, uint32_t ordinal) const {
+    switch (kind) {
+        case Kind::RANGE: {
+            const NumericColumn* column = doc_values.numericColumn(field);
+            return column && column->has(ordinal) && column->keys[ordinal] >= lower && column->keys[ordinal] <= upper;
+        }
+        case Kind::KEYWORD: {
+            const KeywordColumn* column = doc_values.keywordColumn(field);
+            const uint32_t v = column ? column->valueOrdinal(ordinal) : KeywordColumn::kMissing;
+            return v != KeywordColumn::kMissing && DocValues::normalizeKeyword(column->values[v]) == value;
+        }
+        case Kind::AND:
+            return std::all_of(children.begin(), children.end(),
+                               [&](const DocFilter& child) { return child.matches(doc_values, ordinal); });
+        case Kind::OR:
+            return std::any_of(children.begin(), children.end(),
+                               [&](const DocFilter& child) { return child.matches(doc_values, ordinal); });
+        case Kind::NOT:
+            return !children.front().matches(doc_values, ordinal);
+        default:
+            return false;
+    }
+}
+
+// ==================== Subscriptions ====================
+
+SubscriptionIndex::Subscription& SubscriptionIndex::add(const std::string& query, const SearchOptions& options,
+                                                        SubscriptionCallback callback) {
+    const uint64_t id = next_id_++;
+    Subscription& subscription = subscriptions_[id];
+    subscription.id = id;
+    subscription.query = query;
+    subscription.options = options;
+    subscription.options.use_cache = false;
+    subscription.callback = std::move(callback);
+    return subscription;
+}
+
+bool SubscriptionIndex::remove(uint64_t id) {
+    auto it = subscriptions_.find(id);
+    if (it == subscriptions_.end()) {
+        return false;
+    }
+    unindex(it->second);
+    for (const auto& result : it->second.results) {
+        release(result.document.id, id);
+    }
+    subscriptions_.erase(it);
+    return true;
+}
+
+SubscriptionIndex::Subscription* SubscriptionIndex::find(uint64_t id) {
+    auto it = subscriptions_.find(id);
+    return it != subscriptions_.end() ? &it->second : nullptr;
+}
+
+const SubscriptionIndex::Subscription* SubscriptionIndex::find(uint64_t id) const {
+    auto it = subscriptions_.find(id);
+    return it != subscriptions_.end() ? &it->second : nullptr;
+}
+
+std::vector<uint64_t> SubscriptionIndex::ids() const {
+    std::vector<uint64_t> ids;
+    ids.reserve(subscriptions_.size());
+    for (const auto& [id, subscription] : subscriptions_) {
+        ids.push_back(id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+void SubscriptionIndex::analyze(Subscription& subscription, Query scored, size_t original_terms) {
+    unindex(subscription);
+    subscription.scored = std::move(scored);
+    subscription.original_terms = original_terms;
+    subscription.index_terms.clear();
+    for (size_t i = 0; i < subscription.scored.terms.size(); ++i) {
+        const std::string& term = subscription.scored.terms[i];
+        if (term.find(' ') == std::string::npos) {
+            subscription.index_terms.push_back(term);
+        } else if (i >= original_terms) {
+            // The search's candidate term is the rarest word, which changes
+            // with the index: any word will do, since a hit has them all
+            for (auto& word : SynonymMap::splitWords(term)) {
+                subscription.index_terms.push_back(std::move(word));
+            }
+        }
+    }
+    std::sort(subscription.index_terms.begin(), subscription.index_terms.end());
+    subscription.index_terms.erase(std::unique(subscription.index_terms.begin(), subscription.index_terms.end()),
+                                   subscription.index_terms.end());
+    if (subscription.index_terms.empty()) {
+        unindexed_.push_back(subscription.id);
+    }
+    for (const auto& term : subscription.index_terms) {
+        postings_[term].push_back(subscription.id);
+    }
+}
+
+void SubscriptionIndex::unindex(const Subscription& subscription) {
+    eraseId(unindexed_, subscription.id);
+    for (const auto& term : subscription.index_terms) {
+        auto it = postings_.find(term);
+        if (it != postings_.end()) {
+            eraseId(it->second, subscription.id);
+            if (it->second.empty()) {
+                postings_.erase(it);
+            }
+        }
+    }
+}
+
+std::vector<uint64_t> SubscriptionIndex::candidates(uint64_t doc_id,
+                                                    const std::unordered_set<std::string>& terms) const {
+    std::vector<uint64_t> ids = unindexed_;
+    for (const auto& term : terms) {
+        auto it = postings_.find(term);
+        if (it != postings_.end()) {
+            ids.insert(ids.end(), it->second.begin(), it->second.end());
+        }
+    }
+    auto held = holders_.find(doc_id);
+    if (held != holders_.end()) {
+        ids.insert(ids.end(), held->second.begin(), held->second.end());
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+void SubscriptionIndex::hold(uint64_t doc_id, uint64_t id) {
+    holders_[doc_id].push_back(id);
+}
+
+void SubscriptionIndex::release(uint64_t doc_id, uint64_t id) {
+    auto it = holders_.find(doc_id);
+    if (it != holders_.end()) {
+        eraseId(it->second, id);
+        if (it->second.empty()) {
+            holders_.erase(it);
+        }
+    }
+}
+
+// ==================== Top-k maintenance ====================
+
+bool SubscriptionIndex::apply(Subscription& subscription, uint64_t doc_id, const Document* doc, double score,
+                              SubscriptionDelta& delta) {
+    auto& results = subscription.results;
+    const bool full = results.size() >= subscription.options.max_results;
+    auto member = std::find_if(results.begin(), results.end(),
+                               [&](const SearchResult& result) { return result.document.id == doc_id; });
+
+    if (member != results.end()) {
+        // Anything outside a full top-k scores at most its last member
+        // did, so a member stays as long as it keeps up with the others
+        if (full && (!doc || (score < member->score && (member + 1 == results.end() || score < results.back().score)))) {
+            return false;
+        }
+        results.erase(member);
+        if (!doc) {
+            release(doc_id, subscription.id);
+            recordRemoval(delta, doc_id);
+            return true;
+        }
+    } else {
+        if (!doc || (full && !(score > results.back().score))) {
+            return true;
+        }
+        hold(doc_id, subscription.id);
+    }
+
+    SearchResult result;
+    result.document = *doc;
+    result.score = score;
+    recordUpsert(delta, result);
+    results.insert(insertionPoint(results, score), std::move(result));
+    if (results.size() > subscription.options.max_results) {
+        const uint64_t pushed_out = results.back().document.id;
+        results.pop_back();
+        release(pushed_out, subscription.id);
+        recordRemoval(delta, pushed_out);
+    }
+    return true;
+}
+
+void SubscriptionIndex::replace(Subscription& subscription, std::vector<SearchResult> results,
+                                SubscriptionDelta& delta) {
+    std::unordered_map<uint64_t, double> previous;
+    for (const auto& result : subscription.results) {
+        previous.emplace(result.document.id, result.score);
+        release(result.document.id, subscription.id);
+    }
+    for (const auto& result : results) {
+        hold(result.document.id, subscription.id);
+        auto it = previous.find(result.document.id);
+        if (it == previous.end() || it->second != result.score) {
+            recordUpsert(delta, result);
+        }
+        if (it != previous.end()) {
+            previous.erase(it);
+        }
+    }
+    for (const auto& [doc_id, score] : previous) {
+        recordRemoval(delta, doc_id);
+    }
+    subscription.results = std::move(results);
+}
+
+bool SubscriptionIndex::publish(Subscription& subscription, SubscriptionDelta& delta) {
+    if (!delta.reset && delta.upserts.empty() && delta.removed.empty()) {
+        return false;
+    }
+    if (delta.reset) {
+        delta.upserts = subscription.results;
+        delta.removed.clear();
+    }
+    std::stable_sort(delta.upserts.begin(), delta.upserts.end(),
+                     [](const SearchResult& a, const SearchResult& b) { return a.score > b.score; });
+    std::sort(delta.removed.begin(), delta.removed.end());
+    delta.subscription_id = subscription.id;
+    delta.sequence = ++subscription.sequence;
+    subscription.log.push_back(delta);
+    if (subscription.log.size() > kRetainedDeltas) {
+        subscription.log.pop_front();
+    }
+    return true;
+}
+
+std::vector<SubscriptionDelta> SubscriptionIndex::deltas(uint64_t id, uint64_t after_sequence) const {
+    const Subscription* subscription = find(id);
+    if (!subscription || after_sequence >= subscription->sequence) {
+        return {};
+    }
+    if (subscription->log.empty() || subscription->log.front().sequence > after_sequence + 1) {
+        SubscriptionDelta reset;
+        reset.subscription_id = id;
+        reset.sequence = subscription->sequence;
+        reset.reset = true;
+        reset.upserts = subscription->results;
+        return {reset};
+    }
+    std::vector<SubscriptionDelta> deltas;
+    for (const auto& delta : subscription->log) {
+        if (delta.sequence > after_sequence) {
+            deltas.push_back(delta);
+        }
+    }
+    return deltas;
+}
+
+void SubscriptionIndex::clear() {
+    subscriptions_.clear();
+    postings_.clear();
+    unindexed_.clear();
+    holders_.clear();
+}
+
+}  // namespace rtrv_search_engine
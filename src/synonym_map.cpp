@@ -0,0 +1,291 @@
+#include "synonym_map.hpp"
+#include "memory_usage.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+
+namespace rtrv_search_engine {
+
+namespace {
+
+std::string trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        item = trim(item);
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::string joinWords(const std::vector<std::string>& words) {
+    std::string text;
+    for (const auto& word : words) {
+        if (!text.empty()) {
+            text += ' ';
+        }
+        text += word;
+    }
+    return text;
+}
+
+}  // anonymous namespace
+
+SynonymMap::SynonymMap()
+    : edges_(64), output_(1, kNone) {}  // Node 0 = root
+
+std::vector<std::string> SynonymMap::splitWords(const std::string& phrase) {
+    std::vector<std::string> words;
+    std::string word;
+    for (char c : phrase) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            if (!word.empty()) {
+                words.push_back(std::move(word));
+                word.clear();
+            }
+        } else {
+            word += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+    }
+    if (!word.empty()) {
+        words.push_back(std::move(word));
+    }
+    return words;
+}
+
+// ==================== Trie ====================
+
+size_t SynonymMap::slot(uint64_t key) const {
+    // 64-bit finalizer (splitmix): node and word ids are small and dense
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return static_cast<size_t>(key) & (edges_.size() - 1);
+}
+
+uint32_t SynonymMap::child(uint32_t node, uint32_t word) const {
+    const uint64_t key = edgeKey(node, word);
+    for (size_t i = slot(key);; i = (i + 1) & (edges_.size() - 1)) {
+        if (edges_[i].key == key) {
+            return edges_[i].child;
+        }
+        if (edges_[i].key == kEmptyKey) {
+            return kNone;
+        }
+    }
+}
+
+void SynonymMap::grow() {
+    std::vector<Edge> old(edges_.size() * 2);
+    old.swap(edges_);
+    for (const auto& edge : old) {
+        if (edge.key != kEmptyKey) {
+            size_t i = slot(edge.key);
+            while (edges_[i].key != kEmptyKey) {
+                i = (i + 1) & (edges_.size() - 1);
+            }
+            edges_[i] = edge;
+        }
+    }
+}
+
+uint32_t SynonymMap::addChild(uint32_t node, uint32_t word) {
+    const uint32_t existing = child(node, word);
+    if (existing != kNone) {
+        return existing;
+    }
+    // Keep the load factor at or below 1/2 so probe sequences stay short
+    if ((edge_count_ + 1) * 2 > edges_.size()) {
+        grow();
+    }
+    const uint64_t key = edgeKey(node, word);
+    size_t i = slot(key);
+    while (edges_[i].key != kEmptyKey) {
+        i = (i + 1) & (edges_.size() - 1);
+    }
+    const uint32_t created = static_cast<uint32_t>(output_.size());
+    edges_[i] = {key, created};
+    ++edge_count_;
+    output_.push_back(kNone);
+    return created;
+}
+
+uint32_t SynonymMap::wordId(const std::string& word) const {
+    auto it = word_ids_.find(word);
+    return it != word_ids_.end() ? it->second : kNone;
+}
+
+uint32_t SynonymMap::insertPath(const std::vector<std::string>& words) {
+    uint32_t node = 0;
+    for (const auto& word : words) {
+        const uint32_t id = word_ids_.try_emplace(word, static_cast<uint32_t>(word_ids_.size())).first->second;
+        node = addChild(node, id);
+    }
+    return node;
+}
+
+void SynonymMap::addAlternative(uint32_t node, const std::string& text, float weight) {
+    if (output_[node] == kNone) {
+        output_[node] = static_cast<uint32_t>(outputs_.size());
+        outputs_.emplace_back();
+    }
+    auto& alternatives = outputs_[output_[node]];
+    for (auto& alternative : alternatives) {
+        if (alternative.text == text) {
+            alternative.weight = std::max(alternative.weight, weight);
+            return;
+        }
+    }
+    alternatives.push_back({text, weight});
+}
+
+// ==================== Building ====================
+
+void SynonymMap::addMapping(const std::string& from, const std::vector<std::string>& to, float weight) {
+    const auto from_words = splitWords(from);
+    if (from_words.empty()) {
+        return;
+    }
+    const std::string from_text = joinWords(from_words);
+
+    uint32_t node = kNone;
+    for (const auto& phrase : to) {
+        const std::string text = joinWords(splitWords(phrase));
+        if (text.empty() || text == from_text) {
+            continue;
+        }
+        if (node == kNone) {
+            node = insertPath(from_words);
+        }
+        addAlternative(node, text, weight);
+    }
+}
+
+void SynonymMap::addEquivalent(const std::vector<std::string>& phrases, float weight) {
+    for (const auto& phrase : phrases) {
+        addMapping(phrase, phrases, weight);
+    }
+}
+
+size_t SynonymMap::load(std::istream& in) {
+    size_t rules = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        float weight = 1.0f;
+        const size_t bar = line.rfind('|');
+        if (bar != std::string::npos) {
+            try {
+                weight = std::stof(line.substr(bar + 1));
+            } catch (const std::exception&) {
+                continue;  // Malformed weight: skip the rule
+            }
+            line = trim(line.substr(0, bar));
+        }
+
+        const size_t arrow = line.find("=>");
+        if (arrow != std::string::npos) {
+            const auto targets = splitList(line.substr(arrow + 2));
+            for (const auto& source : splitList(line.substr(0, arrow))) {
+                addMapping(source, targets, weight);
+            }
+        } else {
+            addEquivalent(splitList(line), weight);
+        }
+        ++rules;
+    }
+    return rules;
+}
+
+bool SynonymMap::loadFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    load(in);
+    return true;
+}
+
+// ==================== Lookup ====================
+
+std::vector<SynonymMatch> SynonymMap::match(const std::vector<std::string>& tokens) const {
+    std::vector<SynonymMatch> matches;
+    if (outputs_.empty()) {
+        return matches;
+    }
+
+    size_t start = 0;
+    while (start < tokens.size()) {
+        uint32_t node = 0;
+        size_t best_length = 0;
+        uint32_t best_output = kNone;
+        for (size_t i = start; i < tokens.size(); ++i) {
+            const uint32_t word = wordId(tokens[i]);
+            node = word == kNone ? kNone : child(node, word);
+            if (node == kNone) {
+                break;
+            }
+            if (output_[node] != kNone) {
+                best_length = i - start + 1;
+                best_output = output_[node];
+            }
+        }
+
+        if (best_output != kNone) {
+            matches.push_back({start, best_length, &outputs_[best_output]});
+            start += best_length;
+        } else {
+            ++start;
+        }
+    }
+    return matches;
+}
+
+const std::vector<SynonymAlternative>* SynonymMap::lookup(const std::string& phrase) const {
+    uint32_t node = 0;
+    for (const auto& word : splitWords(phrase)) {
+        const uint32_t id = wordId(word);
+        node = id == kNone ? kNone : child(node, id);
+        if (node == kNone) {
+            return nullptr;
+        }
+    }
+    return node != 0 && output_[node] != kNone ? &outputs_[output_[node]] : nullptr;
+}
+
+size_t SynonymMap::memoryUsage() const {
+    using namespace memory_accounting;
+    size_t bytes = hashTableBytes(word_ids_) + vectorUsedBytes(edges_) + vectorUsedBytes(output_) +
+                   vectorUsedBytes(outputs_);
+    for (const auto& [word, id] : word_ids_) {
+        bytes += stringHeapBytes(word);
+    }
+    for (const auto& alternatives : outputs_) {
+        bytes += vectorUsedBytes(alternatives);
+        for (const auto& alternative : alternatives) {
+            bytes += stringHeapBytes(alternative.text);
+        }
+    }
+    return bytes;
+}
+
+}  // namespace rtrv_search_engine
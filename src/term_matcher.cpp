@@ -0,0 +1,148 @@
+#include "term_matcher.hpp"
+#include <algorithm>
+#include <cctype>
+#include <deque>
+
+namespace rtrv_search_engine {
+
+TermMatcher::TermMatcher(const std::vector<std::string>& terms, bool match_prefixes)
+    : match_prefixes_(match_prefixes) {
+
+    // Alphabet: one class per distinct case-folded byte used by the terms
+    for (const auto& term : terms) {
+        for (unsigned char c : term) {
+            const unsigned char lower = static_cast<unsigned char>(std::tolower(c));
+            if (byte_class_[lower] == 0) {
+                byte_class_[lower] = static_cast<uint16_t>(num_classes_++);
+                byte_class_[std::toupper(lower)] = byte_class_[lower];
+            }
+        }
+    }
+
+    // Trie (state 0 = root); missing edges are filled in below
+    auto addState = [this](uint32_t depth) {
+        transitions_.resize(transitions_.size() + num_classes_, kNoState);
+        depth_.push_back(depth);
+        terminal_.push_back(false);
+        output_link_.push_back(kNoState);
+        return static_cast<uint32_t>(depth_.size() - 1);
+    };
+    addState(0);
+
+    for (const auto& term : terms) {
+        if (term.empty()) {
+            continue;
+        }
+        uint32_t state = 0;
+        for (unsigned char c : term) {
+            const size_t edge = state * num_classes_ + byte_class_[c];
+            if (transitions_[edge] == kNoState) {
+                const uint32_t child = addState(depth_[state] + 1);
+                transitions_[edge] = child;
+            }
+            state = transitions_[edge];
+        }
+        if (!terminal_[state]) {
+            terminal_[state] = true;
+            ++patterns_;
+        }
+    }
+
+    // Breadth-first: failure links, turning the trie into a DFA
+    std::vector<uint32_t> failure(depth_.size(), 0);
+    std::deque<uint32_t> queue;
+    for (uint32_t cls = 0; cls < num_classes_; ++cls) {
+        uint32_t& child = transitions_[cls];
+        if (child == kNoState) {
+            child = 0;
+        } else {
+            queue.push_back(child);
+        }
+    }
+    while (!queue.empty()) {
+        const uint32_t state = queue.front();
+        queue.pop_front();
+
+        const uint32_t fail = failure[state];
+        output_link_[state] = terminal_[fail] ? fail : output_link_[fail];
+
+        for (uint32_t cls = 0; cls < num_classes_; ++cls) {
+            uint32_t& child = transitions_[state * num_classes_ + cls];
+            const uint32_t fallback = transitions_[fail * num_classes_ + cls];
+            if (cls == 0) {
+                child = 0;  // Bytes in no term always return to the root
+            } else if (child == kNoState) {
+                child = fallback;
+            } else {
+                failure[child] = fallback;
+                queue.push_back(child);
+            }
+        }
+    }
+}
+
+void TermMatcher::findMatches(const std::string& text, std::vector<TermOffset>& out) const {
+    if (empty() || text.empty()) {
+        return;
+    }
+
+    const size_t first = out.size();
+    uint32_t state = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        state = next(state, static_cast<unsigned char>(text[i]));
+
+        for (uint32_t match = terminal_[state] ? state : output_link_[state];
+             match != kNoState; match = output_link_[match]) {
+            const size_t start = i + 1 - depth_[match];
+            size_t end = i + 1;
+            if (start > 0 && isWordChar(text[start - 1])) {
+                continue;
+            }
+            if (end < text.size() && isWordChar(text[end])) {
+                if (!match_prefixes_) {
+                    continue;
+                }
+                while (end < text.size() && isWordChar(text[end])) {
+                    ++end;
+                }
+            }
+            out.push_back({static_cast<uint32_t>(start), static_cast<uint32_t>(end)});
+        }
+    }
+
+    // Matches were found in end order: leftmost, then longest, wins
+    std::sort(out.begin() + first, out.end(),
+              [](const TermOffset& a, const TermOffset& b) {
+                  return a.start != b.start ? a.start < b.start : a.end > b.end;
+              });
+    size_t kept = first;
+    for (size_t i = first; i < out.size(); ++i) {
+        if (kept == first || out[i].start >= out[kept - 1].end) {
+            out[kept++] = out[i];
+        }
+    }
+    out.resize(kept);
+}
+
+void TermMatcher::highlight(const std::string& text, const std::string& open_tag,
+                            const std::string& close_tag, std::string& out) const {
+    std::vector<TermOffset> matches;
+    findMatches(text, matches);
+
+    out.reserve(out.size() + text.size() + matches.size() * (open_tag.size() + close_tag.size()));
+    size_t cursor = 0;
+    for (const auto& match : matches) {
+        out.append(text, cursor, match.start - cursor);
+        out += open_tag;
+        out.append(text, match.start, match.end - match.start);
+        out += close_tag;
+        cursor = match.end;
+    }
+    out.append(text, cursor, text.size() - cursor);
+}
+
+bool TermMatcher::isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '\'';
+}
+
+}  // namespace rtrv_search_engine
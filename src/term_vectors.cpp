@@ -0,0 +1,60 @@
+#include "term_vectors.hpp"
+#include "memory_usage.hpp"
+#include <algorithm>
+
+namespace rtrv_search_engine {
+
+void TermVectors::add(uint64_t doc_id, const std::vector<Token>& tokens) {
+    std::vector<Entry> entries;
+    entries.reserve(tokens.size());
+    for (const auto& token : tokens) {
+        auto [it, inserted] = ids_.try_emplace(token.text, static_cast<uint32_t>(terms_.size()));
+        if (inserted) {
+            terms_.push_back(token.text);
+        }
+        entries.push_back({it->second, 1});
+    }
+
+    // Merge repeated terms into one entry
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.term < b.term; });
+    size_t distinct = 0;
+    for (const auto& entry : entries) {
+        if (distinct > 0 && entries[distinct - 1].term == entry.term) {
+            ++entries[distinct - 1].frequency;
+        } else {
+            entries[distinct++] = entry;
+        }
+    }
+    entries.resize(distinct);
+    entries.shrink_to_fit();
+    vectors_[doc_id] = std::move(entries);
+}
+
+bool TermVectors::remove(uint64_t doc_id) {
+    return vectors_.erase(doc_id) > 0;
+}
+
+const std::vector<TermVectors::Entry>* TermVectors::find(uint64_t doc_id) const {
+    auto it = vectors_.find(doc_id);
+    return it != vectors_.end() ? &it->second : nullptr;
+}
+
+size_t TermVectors::memoryUsage() const {
+    using namespace memory_accounting;
+    size_t bytes = hashTableBytes(ids_) + vectorUsedBytes(terms_) + hashTableBytes(vectors_);
+    for (const auto& term : terms_) {
+        bytes += 2 * stringHeapBytes(term);  // Key and terms_ copy
+    }
+    for (const auto& [doc_id, entries] : vectors_) {
+        bytes += vectorUsedBytes(entries);
+    }
+    return bytes;
+}
+
+void TermVectors::clear() {
+    ids_.clear();
+    terms_.clear();
+    vectors_.clear();
+}
+
+}  // namespace rtrv_search_engine
@@ -93,12 +93,12 @@ std::vector<Token> Tokenizer::tokenizeWithPositions(const std::string& text) {
             } else if (!current_token.empty()) {  // End of token
                 // Apply post-processing
                 if (!remove_stopwords_ || !isStopword(current_token)) {
-                    std::string final_token = (stemmer_type_ != StemmerType::NONE) 
-                        ? applyStemming(current_token) 
-                        : current_token;
+                    if (stemmer_type_ != StemmerType::NONE) {
+                        applyStemming(current_token);
+                    }
                     
                     tokens.push_back({
-                        final_token,
+                        current_token,
                         position,
                         token_start,
                         static_cast<uint32_t>(i)
@@ -112,12 +112,12 @@ std::vector<Token> Tokenizer::tokenizeWithPositions(const std::string& text) {
         // Handle last token
         if (!current_token.empty()) {
             if (!remove_stopwords_ || !isStopword(current_token)) {
-                std::string final_token = (stemmer_type_ != StemmerType::NONE)
-                    ? applyStemming(current_token)
-                    : current_token;
+                if (stemmer_type_ != StemmerType::NONE) {
+                    applyStemming(current_token);
+                }
                 
                 tokens.push_back({
-                    final_token,
+                    current_token,
                     position,
                     token_start,
                     static_cast<uint32_t>(normalized_text.size())
@@ -144,12 +144,12 @@ std::vector<Token> Tokenizer::tokenizeWithPositions(const std::string& text) {
                 // End of token - apply post-processing
                 if (!remove_stopwords_ || !isStopword(current_token)) {
                     // Apply stemming if enabled
-                    std::string final_token = (stemmer_type_ != StemmerType::NONE) 
-                        ? applyStemming(current_token) 
-                        : current_token;
+                    if (stemmer_type_ != StemmerType::NONE) {
+                        applyStemming(current_token);
+                    }
                     
                     tokens.push_back({
-                        final_token,
+                        current_token,
                         position,
                         token_start,
                         char_offset
@@ -165,12 +165,12 @@ std::vector<Token> Tokenizer::tokenizeWithPositions(const std::string& text) {
         // Handle last token
         if (!current_token.empty()) {
             if (!remove_stopwords_ || !isStopword(current_token)) {
-                std::string final_token = (stemmer_type_ != StemmerType::NONE)
-                    ? applyStemming(current_token)
-                    : current_token;
+                if (stemmer_type_ != StemmerType::NONE) {
+                    applyStemming(current_token);
+                }
                 
                 tokens.push_back({
-                    final_token,
+                    current_token,
                     position,
                     token_start,
                     char_offset
@@ -567,46 +567,59 @@ bool Tokenizer::equalsSIMD(const char* a, const char* b, size_t length) {
 #endif
 }
 
-std::string Tokenizer::applyStemming(const std::string& token) {
+bool Tokenizer::analyzeWord(std::string& word) {
+    if (lowercase_enabled_) {
+        normalizeScalar(&word[0], word.size());
+    }
+    if (remove_stopwords_ && isStopword(word)) {
+        return false;
+    }
+    if (stemmer_type_ != StemmerType::NONE) {
+        applyStemming(word);
+    }
+    return true;
+}
+
+void Tokenizer::applyStemming(std::string& token) {
     switch (stemmer_type_) {
         case StemmerType::SIMPLE:
-            return simpleStem(token);
+            simpleStem(token);
+            break;
         case StemmerType::PORTER:
             // TODO: Implement Porter Stemmer
-            return token;
         case StemmerType::NONE:
         default:
-            return token;
+            break;
     }
 }
 
-std::string Tokenizer::simpleStem(const std::string& token) {
+void Tokenizer::simpleStem(std::string& token) {
     if (token.length() < 4) {
-        return token;  // Too short to stem
+        return;  // Too short to stem
     }
     
-    std::string result = token;
+    const auto endsWith = [&token](const char* suffix, size_t length) {
+        return token.length() > length && token.compare(token.length() - length, length, suffix) == 0;
+    };
     
     // Remove common suffixes (order matters - check more specific patterns first)
     // Note: "tional" must be checked before "ational" to avoid incorrect matching
-    if (result.length() > 6 && result.substr(result.length() - 6) == "tional") {
-        result = result.substr(0, result.length() - 6) + "tion";  // "national" -> "nation"
-    } else if (result.length() > 7 && result.substr(result.length() - 7) == "ational") {
-        result = result.substr(0, result.length() - 7) + "ate";  // "relational" -> "relate"
-    } else if (result.length() > 5 && result.substr(result.length() - 5) == "ional") {
-        result = result.substr(0, result.length() - 2);  // "educational" -> "education" (remove "al")
-    } else if (result.length() > 3 && result.substr(result.length() - 3) == "ing") {
-        result = result.substr(0, result.length() - 3);  // "running" -> "runn"
-    } else if (result.length() > 2 && result.substr(result.length() - 2) == "ed") {
-        result = result.substr(0, result.length() - 2);  // "walked" -> "walk"
-    } else if (result.length() > 2 && result.substr(result.length() - 2) == "ly") {
-        result = result.substr(0, result.length() - 2);  // "quickly" -> "quick"
-    } else if (result.length() > 1 && result[result.length() - 1] == 's' && 
-               result[result.length() - 2] != 's') {
-        result = result.substr(0, result.length() - 1);  // "cats" -> "cat"
+    if (endsWith("tional", 6)) {
+        token.replace(token.length() - 6, 6, "tion");  // "national" -> "nation"
+    } else if (endsWith("ational", 7)) {
+        token.replace(token.length() - 7, 7, "ate");  // "relational" -> "relate"
+    } else if (endsWith("ional", 5)) {
+        token.resize(token.length() - 2);  // "educational" -> "education" (remove "al")
+    } else if (endsWith("ing", 3)) {
+        token.resize(token.length() - 3);  // "running" -> "runn"
+    } else if (endsWith("ed", 2)) {
+        token.resize(token.length() - 2);  // "walked" -> "walk"
+    } else if (endsWith("ly", 2)) {
+        token.resize(token.length() - 2);  // "quickly" -> "quick"
+    } else if (token.length() > 1 && token[token.length() - 1] == 's' && 
+               token[token.length() - 2] != 's') {
+        token.pop_back();  // "cats" -> "cat"
     }
-    
-    return result;
 }
 
 void Tokenizer::setLowercase(bool enabled) {
@@ -0,0 +1,1149 @@
+#include "vector_index.hpp"
+#include "memory_usage.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <queue>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// SIMD headers (same selection as the tokenizer)
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+    #include <arm_neon.h>
+#endif
+
+namespace rtrv_search_engine {
+
+// ==================== Distance Kernels ====================
+
+namespace vector_kernels {
+
+float dotProduct(const float* a, const float* b, size_t dimension) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(__AVX2__)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= dimension; i += 16) {
+    #ifdef __FMA__
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    #else
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    #endif
+    }
+    acc0 = _mm256_add_ps(acc0, acc1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    sum = _mm_cvtss_f32(half);
+#elif defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= dimension; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+    sum = _mm_cvtss_f32(acc0);
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= dimension; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#endif
+    // Scalar tail (and scalar fallback)
+    for (; i < dimension; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+float squaredL2(const float* a, const float* b, size_t dimension) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    for (; i + 8 <= dimension; i += 8) {
+        const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    #ifdef __FMA__
+        acc = _mm256_fmadd_ps(diff, diff, acc);
+    #else
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(diff, diff));
+    #endif
+    }
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    sum = _mm_cvtss_f32(half);
+#elif defined(__SSE2__)
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= dimension; i += 4) {
+        const __m128 diff = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        acc = _mm_add_ps(acc, _mm_mul_ps(diff, diff));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sum = _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 4 <= dimension; i += 4) {
+        const float32x4_t diff = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+        acc = vmlaq_f32(acc, diff, diff);
+    }
+    sum = vaddvq_f32(acc);
+#endif
+    for (; i < dimension; ++i) {
+        const float diff = a[i] - b[i];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+void normalize(float* v, size_t dimension) {
+    const float norm = std::sqrt(dotProduct(v, v, dimension));
+    if (norm > 0.0f) {
+        const float inverse = 1.0f / norm;
+        for (size_t i = 0; i < dimension; ++i) {
+            v[i] *= inverse;
+        }
+    }
+}
+
+float dotProductU8(const float* w, const uint8_t* codes, size_t dimension) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    for (; i + 8 <= dimension; i += 8) {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + i));
+        const __m256 c = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+    #ifdef __FMA__
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(w + i), c, acc);
+    #else
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(w + i), c));
+    #endif
+    }
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    sum = _mm_cvtss_f32(half);
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= dimension; i += 8) {
+        // 8 bytes -> 8 x u16 -> 2 x (4 x i32) -> float
+        const __m128i words = _mm_unpacklo_epi8(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + i)), zero);
+        const __m128 c0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+        const __m128 c1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(w + i), c0));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(w + i + 4), c1));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+    sum = _mm_cvtss_f32(acc0);
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= dimension; i += 8) {
+        const uint16x8_t words = vmovl_u8(vld1_u8(codes + i));
+        acc0 = vmlaq_f32(acc0, vld1q_f32(w + i), vcvtq_f32_u32(vmovl_u16(vget_low_u16(words))));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(w + i + 4), vcvtq_f32_u32(vmovl_u16(vget_high_u16(words))));
+    }
+    sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#endif
+    for (; i < dimension; ++i) {
+        sum += w[i] * codes[i];
+    }
+    return sum;
+}
+
+float squaredL2U8(const float* r, const float* step, const uint8_t* codes, size_t dimension) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    for (; i + 8 <= dimension; i += 8) {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + i));
+        const __m256 c = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+        const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(r + i), _mm256_mul_ps(_mm256_loadu_ps(step + i), c));
+    #ifdef __FMA__
+        acc = _mm256_fmadd_ps(diff, diff, acc);
+    #else
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(diff, diff));
+    #endif
+    }
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    sum = _mm_cvtss_f32(half);
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 8 <= dimension; i += 8) {
+        const __m128i words = _mm_unpacklo_epi8(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + i)), zero);
+        const __m128 c0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+        const __m128 c1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero));
+        const __m128 d0 = _mm_sub_ps(_mm_loadu_ps(r + i), _mm_mul_ps(_mm_loadu_ps(step + i), c0));
+        const __m128 d1 = _mm_sub_ps(_mm_loadu_ps(r + i + 4), _mm_mul_ps(_mm_loadu_ps(step + i + 4), c1));
+        acc = _mm_add_ps(acc, _mm_add_ps(_mm_mul_ps(d0, d0), _mm_mul_ps(d1, d1)));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sum = _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 8 <= dimension; i += 8) {
+        const uint16x8_t words = vmovl_u8(vld1_u8(codes + i));
+        const float32x4_t c0 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(words)));
+        const float32x4_t c1 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(words)));
+        const float32x4_t d0 = vmlsq_f32(vld1q_f32(r + i), vld1q_f32(step + i), c0);
+        const float32x4_t d1 = vmlsq_f32(vld1q_f32(r + i + 4), vld1q_f32(step + i + 4), c1);
+        acc = vmlaq_f32(vmlaq_f32(acc, d0, d0), d1, d1);
+    }
+    sum = vaddvq_f32(acc);
+#endif
+    for (; i < dimension; ++i) {
+        const float diff = r[i] - step[i] * codes[i];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+float lookupSum(const float* table, const uint8_t* codes, size_t count, size_t stride) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(__AVX2__)
+    // Gather 8 subspaces at a time: index = subspace * stride + code
+    const __m256i lane = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                            _mm256_set1_epi32(static_cast<int>(stride)));
+    __m256 acc = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + i));
+        const __m256i index = _mm256_add_epi32(lane, _mm256_cvtepu8_epi32(bytes));
+        acc = _mm256_add_ps(acc, _mm256_i32gather_ps(table + i * stride, index, 4));
+    }
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    sum = _mm_cvtss_f32(half);
+#else
+    // Four independent accumulators hide the load latency of the lookups
+    float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (; i + 4 <= count; i += 4) {
+        acc[0] += table[i * stride + codes[i]];
+        acc[1] += table[(i + 1) * stride + codes[i + 1]];
+        acc[2] += table[(i + 2) * stride + codes[i + 2]];
+        acc[3] += table[(i + 3) * stride + codes[i + 3]];
+    }
+    sum = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+    for (; i < count; ++i) {
+        sum += table[i * stride + codes[i]];
+    }
+    return sum;
+}
+
+const char* simdLevel() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse";
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace vector_kernels
+
+// ==================== HNSW ====================
+
+namespace {
+
+// Per-thread visited marks: a node is visited when its mark equals the
+// current epoch, so searches neither allocate nor clear an O(N) bitmap
+struct VisitedMarks {
+    std::vector<uint32_t> marks;
+    uint32_t epoch = 0;
+
+    void reset(size_t size) {
+        if (marks.size() < size) {
+            marks.resize(size, 0);
+        }
+        if (++epoch == 0) {
+            std::fill(marks.begin(), marks.end(), 0);
+            epoch = 1;
+        }
+    }
+
+    // Returns true the first time a node is seen in this search
+    bool visit(uint32_t node) {
+        if (marks[node] == epoch) {
+            return false;
+        }
+        marks[node] = epoch;
+        return true;
+    }
+};
+
+thread_local VisitedMarks visited_marks;
+
+constexpr uint32_t kSnapshotMagic = 0x484e5357;    // "HNSW": float32 vectors only
+constexpr uint32_t kSnapshotMagicV2 = 0x484e5358;  // Adds quantized codes and full-precision rows
+
+constexpr size_t kCentroids = 256;      // One byte per PQ code
+constexpr size_t kKMeansIterations = 12;
+
+template <typename T>
+void writeValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readValue(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+// Lloyd's k-means over `count` points of `dimension` (row stride `stride`);
+// `centroids` receives kCentroids rows, duplicated when count < kCentroids
+void kMeans(const float* points, size_t count, size_t dimension, size_t stride,
+            std::mt19937_64& rng, float* centroids) {
+    const size_t clusters = std::min(count, kCentroids);
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    for (size_t c = 0; c < clusters; ++c) {
+        std::memcpy(centroids + c * dimension, points + order[c] * stride, dimension * sizeof(float));
+    }
+
+    std::vector<uint32_t> assignment(count, 0);
+    std::vector<double> sums(clusters * dimension);
+    std::vector<size_t> sizes(clusters);
+    for (size_t iteration = 0; iteration < kKMeansIterations; ++iteration) {
+        bool changed = false;
+        for (size_t p = 0; p < count; ++p) {
+            const float* point = points + p * stride;
+            uint32_t best = 0;
+            float best_distance = vector_kernels::squaredL2(point, centroids, dimension);
+            for (uint32_t c = 1; c < clusters; ++c) {
+                const float d = vector_kernels::squaredL2(point, centroids + c * dimension, dimension);
+                if (d < best_distance) {
+                    best_distance = d;
+                    best = c;
+                }
+            }
+            changed |= assignment[p] != best;
+            assignment[p] = best;
+        }
+        if (!changed && iteration > 0) {
+            break;
+        }
+
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(sizes.begin(), sizes.end(), 0);
+        for (size_t p = 0; p < count; ++p) {
+            const float* point = points + p * stride;
+            double* sum = &sums[assignment[p] * dimension];
+            for (size_t j = 0; j < dimension; ++j) {
+                sum[j] += point[j];
+            }
+            ++sizes[assignment[p]];
+        }
+        for (size_t c = 0; c < clusters; ++c) {
+            float* centroid = centroids + c * dimension;
+            if (sizes[c] == 0) {
+                // Empty cluster: restart it on a random point
+                std::memcpy(centroid, points + order[rng() % count] * stride, dimension * sizeof(float));
+                continue;
+            }
+            for (size_t j = 0; j < dimension; ++j) {
+                centroid[j] = static_cast<float>(sums[c * dimension + j] / sizes[c]);
+            }
+        }
+    }
+
+    for (size_t c = clusters; c < kCentroids; ++c) {
+        std::memcpy(centroids + c * dimension, centroids, dimension * sizeof(float));
+    }
+}
+
+}  // anonymous namespace
+
+// ==================== Quantizer ====================
+
+void VectorQuantizer::train(VectorQuantization type, size_t dimension, const float* samples,
+                            size_t count, size_t pq_subspaces, uint64_t seed) {
+    *this = VectorQuantizer();
+    if (type == VectorQuantization::NONE || dimension == 0 || count == 0) {
+        return;
+    }
+    type_ = type;
+    dimension_ = dimension;
+
+    if (type == VectorQuantization::INT8) {
+        min_.assign(samples, samples + dimension);
+        std::vector<float> max = min_;
+        for (size_t p = 1; p < count; ++p) {
+            const float* sample = samples + p * dimension;
+            for (size_t j = 0; j < dimension; ++j) {
+                min_[j] = std::min(min_[j], sample[j]);
+                max[j] = std::max(max[j], sample[j]);
+            }
+        }
+        step_.resize(dimension);
+        for (size_t j = 0; j < dimension; ++j) {
+            step_[j] = (max[j] - min_[j]) / 255.0f;
+        }
+        return;
+    }
+
+    subspaces_ = std::min(std::max<size_t>(pq_subspaces, 1), dimension);
+    while (dimension % subspaces_ != 0) {
+        --subspaces_;
+    }
+    sub_dimension_ = dimension / subspaces_;
+    codebooks_.resize(subspaces_ * kCentroids * sub_dimension_);
+
+    std::mt19937_64 rng(seed);
+    for (size_t m = 0; m < subspaces_; ++m) {
+        kMeans(samples + m * sub_dimension_, count, sub_dimension_, dimension, rng,
+               &codebooks_[m * kCentroids * sub_dimension_]);
+    }
+}
+
+void VectorQuantizer::encode(const float* vector, uint8_t* code) const {
+    if (type_ == VectorQuantization::INT8) {
+        for (size_t j = 0; j < dimension_; ++j) {
+            const float bucket = step_[j] > 0.0f ? (vector[j] - min_[j]) / step_[j] : 0.0f;
+            code[j] = static_cast<uint8_t>(std::min(std::max(std::lround(bucket), 0L), 255L));
+        }
+        return;
+    }
+    for (size_t m = 0; m < subspaces_; ++m) {
+        const float* sub = vector + m * sub_dimension_;
+        const float* codebook = &codebooks_[m * kCentroids * sub_dimension_];
+        size_t best = 0;
+        float best_distance = vector_kernels::squaredL2(sub, codebook, sub_dimension_);
+        for (size_t c = 1; c < kCentroids; ++c) {
+            const float d = vector_kernels::squaredL2(sub, codebook + c * sub_dimension_, sub_dimension_);
+            if (d < best_distance) {
+                best_distance = d;
+                best = c;
+            }
+        }
+        code[m] = static_cast<uint8_t>(best);
+    }
+}
+
+void VectorQuantizer::decode(const uint8_t* code, float* vector) const {
+    if (type_ == VectorQuantization::INT8) {
+        for (size_t j = 0; j < dimension_; ++j) {
+            vector[j] = min_[j] + step_[j] * code[j];
+        }
+        return;
+    }
+    for (size_t m = 0; m < subspaces_; ++m) {
+        std::memcpy(vector + m * sub_dimension_,
+                    &codebooks_[(m * kCentroids + code[m]) * sub_dimension_],
+                    sub_dimension_ * sizeof(float));
+    }
+}
+
+void VectorQuantizer::prepare(const float* query, bool l2, QueryTable& table) const {
+    table.l2 = l2;
+    table.bias = 0.0f;
+    if (type_ == VectorQuantization::INT8) {
+        // x = min + step * code, so q.x = q.min + (q * step).code and
+        // |q - x|^2 = |(q - min) - step * code|^2
+        table.values.resize(dimension_);
+        for (size_t j = 0; j < dimension_; ++j) {
+            table.values[j] = l2 ? query[j] - min_[j] : query[j] * step_[j];
+        }
+        if (!l2) {
+            table.bias = vector_kernels::dotProduct(query, min_.data(), dimension_);
+        }
+        return;
+    }
+    table.values.resize(subspaces_ * kCentroids);
+    for (size_t m = 0; m < subspaces_; ++m) {
+        const float* sub = query + m * sub_dimension_;
+        for (size_t c = 0; c < kCentroids; ++c) {
+            const float* centroid = &codebooks_[(m * kCentroids + c) * sub_dimension_];
+            table.values[m * kCentroids + c] = l2 ? vector_kernels::squaredL2(sub, centroid, sub_dimension_)
+                                                  : vector_kernels::dotProduct(sub, centroid, sub_dimension_);
+        }
+    }
+}
+
+float VectorQuantizer::evaluate(const QueryTable& table, const uint8_t* code) const {
+    if (type_ == VectorQuantization::INT8) {
+        return table.l2 ? vector_kernels::squaredL2U8(table.values.data(), step_.data(), code, dimension_)
+                        : table.bias + vector_kernels::dotProductU8(table.values.data(), code, dimension_);
+    }
+    return vector_kernels::lookupSum(table.values.data(), code, subspaces_, kCentroids);
+}
+
+size_t VectorQuantizer::memoryUsage() const {
+    return (min_.capacity() + step_.capacity() + codebooks_.capacity()) * sizeof(float);
+}
+
+void VectorQuantizer::save(std::ostream& out) const {
+    writeValue(out, static_cast<uint32_t>(type_));
+    writeValue(out, static_cast<uint64_t>(dimension_));
+    writeValue(out, static_cast<uint64_t>(subspaces_));
+    const auto& values = type_ == VectorQuantization::PQ ? codebooks_ : min_;
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+    if (type_ == VectorQuantization::INT8) {
+        out.write(reinterpret_cast<const char*>(step_.data()), step_.size() * sizeof(float));
+    }
+}
+
+bool VectorQuantizer::load(std::istream& in, size_t expected_dimension) {
+    *this = VectorQuantizer();
+    uint32_t type = 0;
+    uint64_t dimension = 0, subspaces = 0;
+    if (!readValue(in, type) || !readValue(in, dimension) || !readValue(in, subspaces)) {
+        return false;
+    }
+    // Checked before anything is sized from them
+    if ((type != static_cast<uint32_t>(VectorQuantization::INT8) &&
+         type != static_cast<uint32_t>(VectorQuantization::PQ)) ||
+        dimension != expected_dimension) {
+        return false;
+    }
+    type_ = static_cast<VectorQuantization>(type);
+    dimension_ = dimension;
+    if (type_ == VectorQuantization::INT8) {
+        min_.resize(dimension_);
+        step_.resize(dimension_);
+        in.read(reinterpret_cast<char*>(min_.data()), min_.size() * sizeof(float));
+        in.read(reinterpret_cast<char*>(step_.data()), step_.size() * sizeof(float));
+    } else if (type_ == VectorQuantization::PQ) {
+        if (subspaces == 0 || dimension % subspaces != 0) {
+            return false;
+        }
+        subspaces_ = subspaces;
+        sub_dimension_ = dimension_ / subspaces_;
+        codebooks_.resize(subspaces_ * kCentroids * sub_dimension_);
+        in.read(reinterpret_cast<char*>(codebooks_.data()), codebooks_.size() * sizeof(float));
+    }
+    return static_cast<bool>(in);
+}
+
+// ==================== Mapped Vector File ====================
+
+MappedVectorFile::~MappedVectorFile() {
+    close();
+}
+
+MappedVectorFile::MappedVectorFile(MappedVectorFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedVectorFile& MappedVectorFile::operator=(MappedVectorFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(fd_, other.fd_);
+        std::swap(data_, other.data_);
+        std::swap(dimension_, other.dimension_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(rows_, other.rows_);
+    }
+    return *this;
+}
+
+bool MappedVectorFile::open(const std::string& path, size_t dimension) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    dimension_ = dimension;
+    if (fd_ < 0 || dimension == 0 || !reserve(1024)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedVectorFile::close() {
+    if (data_ != nullptr) {
+        ::munmap(data_, capacity_ * dimension_ * sizeof(float));
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    data_ = nullptr;
+    capacity_ = 0;
+    rows_ = 0;
+}
+
+bool MappedVectorFile::reserve(size_t rows) {
+    if (rows <= capacity_) {
+        return true;
+    }
+    const size_t capacity = std::max(rows, capacity_ * 2);
+    const size_t bytes = capacity * dimension_ * sizeof(float);
+    if (::ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+        return false;
+    }
+    if (data_ != nullptr) {
+        ::munmap(data_, capacity_ * dimension_ * sizeof(float));
+        data_ = nullptr;
+    }
+    void* mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        capacity_ = 0;
+        return false;
+    }
+    data_ = static_cast<float*>(mapped);
+    capacity_ = capacity;
+    return true;
+}
+
+bool MappedVectorFile::put(uint32_t row, const float* vector) {
+    if (fd_ < 0 || !reserve(static_cast<size_t>(row) + 1)) {
+        return false;
+    }
+    std::memcpy(data_ + static_cast<size_t>(row) * dimension_, vector, dimension_ * sizeof(float));
+    rows_ = std::max(rows_, static_cast<size_t>(row) + 1);
+    return true;
+}
+
+// ==================== HNSW Index ====================
+
+HnswIndex::HnswIndex(size_t dimension, VectorMetric metric, const HnswParams& params)
+    : dimension_(dimension),
+      metric_(metric),
+      params_(params),
+      level_multiplier_(1.0 / std::log(static_cast<double>(std::max<size_t>(params.m, 2)))),
+      level_rng_(params.seed) {
+    if (params_.quantization != VectorQuantization::NONE && !params_.vector_file.empty()) {
+        full_precision_.open(params_.vector_file, dimension_);
+    }
+}
+
+float HnswIndex::distance(const float* a, const float* b) const {
+    switch (metric_) {
+        case VectorMetric::L2:
+            return vector_kernels::squaredL2(a, b, dimension_);
+        case VectorMetric::COSINE:
+            // Both sides are unit length
+            return 1.0f - vector_kernels::dotProduct(a, b, dimension_);
+        case VectorMetric::DOT:
+        default:
+            return -vector_kernels::dotProduct(a, b, dimension_);
+    }
+}
+
+float HnswIndex::distance(const QueryPoint& query, uint32_t node) const {
+    if (!quantizer_.trained()) {
+        return distance(query.point.data(), vectorOf(node));
+    }
+    const float raw = quantizer_.evaluate(query.table, codeOf(node));
+    switch (metric_) {
+        case VectorMetric::L2:
+            return raw;
+        case VectorMetric::COSINE:
+            return 1.0f - raw;
+        case VectorMetric::DOT:
+        default:
+            return -raw;
+    }
+}
+
+float HnswIndex::distance(uint32_t a, uint32_t b) const {
+    if (!quantizer_.trained()) {
+        return distance(vectorOf(a), vectorOf(b));
+    }
+    // Graph maintenance between two stored nodes: decode both
+    thread_local std::vector<float> decoded_a, decoded_b;
+    decoded_a.resize(dimension_);
+    decoded_b.resize(dimension_);
+    quantizer_.decode(codeOf(a), decoded_a.data());
+    quantizer_.decode(codeOf(b), decoded_b.data());
+    return distance(decoded_a.data(), decoded_b.data());
+}
+
+HnswIndex::QueryPoint HnswIndex::prepare(const std::vector<float>& vector) const {
+    QueryPoint query;
+    query.point = vector;
+    if (metric_ == VectorMetric::COSINE) {
+        vector_kernels::normalize(query.point.data(), dimension_);
+    }
+    if (quantizer_.trained()) {
+        quantizer_.prepare(query.point.data(), metric_ == VectorMetric::L2, query.table);
+    }
+    return query;
+}
+
+float HnswIndex::score(float distance) const {
+    switch (metric_) {
+        case VectorMetric::L2:
+            return 1.0f / (1.0f + std::sqrt(std::max(distance, 0.0f)));
+        case VectorMetric::COSINE:
+            return 1.0f - distance;
+        case VectorMetric::DOT:
+        default:
+            return -distance;
+    }
+}
+
+int HnswIndex::randomLevel() {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double draw = std::max(uniform(level_rng_), 1e-12);
+    return static_cast<int>(-std::log(draw) * level_multiplier_);
+}
+
+bool HnswIndex::add(uint64_t doc_id, const std::vector<float>& vector) {
+    if (vector.size() != dimension_ || dimension_ == 0) {
+        return false;
+    }
+    remove(doc_id);
+    if (params_.quantization != VectorQuantization::NONE && !quantized() &&
+        nodes_.size() >= params_.train_size) {
+        quantize();
+    }
+
+    const uint32_t node = static_cast<uint32_t>(nodes_.size());
+    const int level = randomLevel();
+    const QueryPoint point = prepare(vector);
+    nodes_.push_back({doc_id, false, std::vector<std::vector<uint32_t>>(level + 1)});
+    if (quantized()) {
+        codes_.resize(codes_.size() + quantizer_.codeSize());
+        quantizer_.encode(point.point.data(), &codes_[static_cast<size_t>(node) * quantizer_.codeSize()]);
+    } else {
+        vectors_.insert(vectors_.end(), point.point.begin(), point.point.end());
+    }
+    if (full_precision_.isOpen()) {
+        full_precision_.put(node, point.point.data());
+    }
+    node_of_[doc_id] = node;
+
+    if (max_level_ < 0) {
+        entry_point_ = node;
+        max_level_ = level;
+        return true;
+    }
+
+    uint32_t entry = entry_point_;
+
+    // Greedy descent through the layers above the new node's level
+    for (int layer = max_level_; layer > level; --layer) {
+        entry = searchLayer(point, entry, 1, layer, nullptr, nullptr).front().second;
+    }
+
+    for (int layer = std::min(level, max_level_); layer >= 0; --layer) {
+        auto candidates = searchLayer(point, entry, params_.ef_construction, layer, nullptr, nullptr);
+        auto neighbors = selectNeighbors(candidates, params_.m);
+        nodes_[node].links[layer] = neighbors;
+        for (uint32_t neighbor : neighbors) {
+            link(neighbor, node, layer);
+        }
+        entry = candidates.front().second;
+    }
+
+    if (level > max_level_) {
+        max_level_ = level;
+        entry_point_ = node;
+    }
+    return true;
+}
+
+void HnswIndex::link(uint32_t from, uint32_t to, size_t level) {
+    auto& links = nodes_[from].links[level];
+    links.push_back(to);
+    if (links.size() <= maxLinks(level)) {
+        return;
+    }
+
+    // Over capacity: re-select the node's links with the heuristic
+    std::vector<Candidate> candidates;
+    candidates.reserve(links.size());
+    for (uint32_t neighbor : links) {
+        candidates.emplace_back(distance(from, neighbor), neighbor);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    links = selectNeighbors(candidates, maxLinks(level));
+}
+
+std::vector<uint32_t> HnswIndex::selectNeighbors(const std::vector<Candidate>& candidates,
+                                                 size_t max_links) const {
+    std::vector<uint32_t> selected;
+    selected.reserve(max_links);
+    for (const auto& [candidate_distance, candidate] : candidates) {
+        if (selected.size() >= max_links) {
+            break;
+        }
+        bool diverse = true;
+        for (uint32_t kept : selected) {
+            if (distance(candidate, kept) < candidate_distance) {
+                diverse = false;
+                break;
+            }
+        }
+        if (diverse) {
+            selected.push_back(candidate);
+        }
+    }
+    // Top up with the closest pruned candidates so sparse regions stay connected
+    for (const auto& [candidate_distance, candidate] : candidates) {
+        if (selected.size() >= max_links) {
+            break;
+        }
+        if (std::find(selected.begin(), selected.end(), candidate) == selected.end()) {
+            selected.push_back(candidate);
+        }
+    }
+    return selected;
+}
+
+std::vector<HnswIndex::Candidate> HnswIndex::searchLayer(
+        const QueryPoint& query, uint32_t entry, size_t ef, size_t level,
+        const std::function<bool(uint64_t)>* filter,
+        std::vector<Candidate>* accepted) const {
+
+    auto& visited = visited_marks;
+    visited.reset(nodes_.size());
+
+    // Min-heap of nodes to expand; max-heap of the best ef found
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> frontier;
+    std::priority_queue<Candidate> best;
+
+    auto consider = [&](uint32_t node, float node_distance) {
+        if (accepted != nullptr && !nodes_[node].deleted && (*filter)(nodes_[node].doc_id)) {
+            accepted->emplace_back(node_distance, node);
+        }
+        frontier.emplace(node_distance, node);
+        best.emplace(node_distance, node);
+        if (best.size() > ef) {
+            best.pop();
+        }
+    };
+
+    visited.visit(entry);
+    consider(entry, distance(query, entry));
+
+    while (!frontier.empty()) {
+        const auto [current_distance, current] = frontier.top();
+        if (current_distance > best.top().first && best.size() >= ef) {
+            break;
+        }
+        frontier.pop();
+
+        for (uint32_t neighbor : nodes_[current].links[level]) {
+            if (!visited.visit(neighbor)) {
+                continue;
+            }
+            const float neighbor_distance = distance(query, neighbor);
+            if (best.size() < ef || neighbor_distance < best.top().first) {
+                consider(neighbor, neighbor_distance);
+            } else if (accepted != nullptr && !nodes_[neighbor].deleted &&
+                       (*filter)(nodes_[neighbor].doc_id)) {
+                accepted->emplace_back(neighbor_distance, neighbor);
+            }
+        }
+    }
+
+    std::vector<Candidate> result(best.size());
+    for (size_t i = result.size(); i-- > 0;) {
+        result[i] = best.top();
+        best.pop();
+    }
+    return result;
+}
+
+std::vector<VectorSearchHit> HnswIndex::search(const std::vector<float>& query, size_t k, size_t ef,
+                                               const std::function<bool(uint64_t)>& filter) const {
+    std::vector<VectorSearchHit> hits;
+    if (query.size() != dimension_ || max_level_ < 0 || k == 0) {
+        return hits;
+    }
+
+    const QueryPoint point = prepare(query);
+    uint32_t entry = entry_point_;
+    for (int layer = max_level_; layer > 0; --layer) {
+        entry = searchLayer(point, entry, 1, layer, nullptr, nullptr).front().second;
+    }
+
+    const size_t candidates = rescores() ? k * std::max<size_t>(params_.rescore_factor, 1) : k;
+    const size_t width = std::max(ef > 0 ? ef : params_.ef_search, candidates);
+    std::vector<Candidate> found;
+    if (filter) {
+        searchLayer(point, entry, width, 0, &filter, &found);
+        std::sort(found.begin(), found.end());
+        if (found.size() < k) {
+            // Selective filter: the neighbourhood holds too few matches
+            return exactSearch(query, k, filter);
+        }
+    } else {
+        found = searchLayer(point, entry, width, 0, nullptr, nullptr);
+    }
+    return collect(point, found, k);
+}
+
+std::vector<VectorSearchHit> HnswIndex::collect(const QueryPoint& query,
+                                                const std::vector<Candidate>& sorted, size_t k) const {
+    const size_t keep = rescores() ? k * std::max<size_t>(params_.rescore_factor, 1) : k;
+    std::vector<Candidate> best;
+    best.reserve(std::min(keep, sorted.size()));
+    for (const auto& candidate : sorted) {
+        if (best.size() >= keep) {
+            break;
+        }
+        if (!nodes_[candidate.second].deleted) {
+            best.push_back(candidate);
+        }
+    }
+
+    if (rescores()) {
+        // Exact distances from the mmapped float32 rows, only for the shortlist
+        for (auto& [candidate_distance, node] : best) {
+            candidate_distance = distance(query.point.data(), full_precision_.row(node));
+        }
+        const size_t top = std::min(k, best.size());
+        std::partial_sort(best.begin(), best.begin() + top, best.end());
+        best.resize(top);
+    }
+
+    std::vector<VectorSearchHit> hits;
+    hits.reserve(best.size());
+    for (const auto& [candidate_distance, node] : best) {
+        hits.push_back({nodes_[node].doc_id, candidate_distance});
+    }
+    return hits;
+}
+
+std::vector<VectorSearchHit> HnswIndex::exactSearch(const std::vector<float>& query, size_t k,
+                                                    const std::function<bool(uint64_t)>& filter) const {
+    std::vector<VectorSearchHit> hits;
+    if (query.size() != dimension_ || k == 0) {
+        return hits;
+    }
+
+    const QueryPoint point = prepare(query);
+    const size_t keep = rescores() ? k * std::max<size_t>(params_.rescore_factor, 1) : k;
+    std::priority_queue<Candidate> best;
+    for (uint32_t node = 0; node < nodes_.size(); ++node) {
+        if (nodes_[node].deleted || (filter && !filter(nodes_[node].doc_id))) {
+            continue;
+        }
+        const float node_distance = distance(point, node);
+        if (best.size() < keep || node_distance < best.top().first) {
+            best.emplace(node_distance, node);
+            if (best.size() > keep) {
+                best.pop();
+            }
+        }
+    }
+
+    std::vector<Candidate> sorted(best.size());
+    for (size_t i = sorted.size(); i-- > 0;) {
+        sorted[i] = best.top();
+        best.pop();
+    }
+    return collect(point, sorted, k);
+}
+
+void HnswIndex::quantize() {
+    if (params_.quantization == VectorQuantization::NONE || quantized() || nodes_.empty()) {
+        return;
+    }
+    const size_t samples = std::min(nodes_.size(), std::max<size_t>(params_.train_size, 1));
+    const size_t subspaces = params_.pq_subspaces > 0 ? params_.pq_subspaces : dimension_ / 4;
+    quantizer_.train(params_.quantization, dimension_, vectors_.data(), samples, subspaces, params_.seed);
+
+    const size_t code_size = quantizer_.codeSize();
+    codes_.resize(nodes_.size() * code_size);
+    for (uint32_t node = 0; node < nodes_.size(); ++node) {
+        quantizer_.encode(vectorOf(node), &codes_[static_cast<size_t>(node) * code_size]);
+    }
+    vectors_.clear();
+    vectors_.shrink_to_fit();
+}
+
+bool HnswIndex::vector(uint64_t doc_id, std::vector<float>& out) const {
+    auto it = node_of_.find(doc_id);
+    if (it == node_of_.end()) {
+        return false;
+    }
+    const uint32_t node = it->second;
+    out.resize(dimension_);
+    if (!quantized()) {
+        std::copy_n(vectorOf(node), dimension_, out.begin());
+    } else if (full_precision_.isOpen() && node < full_precision_.rows()) {
+        std::copy_n(full_precision_.row(node), dimension_, out.begin());
+    } else {
+        quantizer_.decode(codeOf(node), out.data());
+    }
+    return true;
+}
+
+bool HnswIndex::remove(uint64_t doc_id) {
+    auto it = node_of_.find(doc_id);
+    if (it == node_of_.end()) {
+        return false;
+    }
+    nodes_[it->second].deleted = true;
+    node_of_.erase(it);
+    return true;
+}
+
+size_t HnswIndex::memoryUsage() const {
+    using namespace memory_accounting;
+    size_t bytes = vectors_.capacity() * sizeof(float) + nodes_.capacity() * sizeof(Node) +
+                   codes_.capacity() + quantizer_.memoryUsage();
+    for (const auto& node : nodes_) {
+        bytes += node.links.capacity() * sizeof(std::vector<uint32_t>);
+        for (const auto& links : node.links) {
+            bytes += links.capacity() * sizeof(uint32_t);
+        }
+    }
+    return bytes + hashTableBytes(node_of_);
+}
+
+void HnswIndex::clear() {
+    vectors_.clear();
+    codes_.clear();
+    quantizer_ = VectorQuantizer();
+    nodes_.clear();
+    node_of_.clear();
+    entry_point_ = 0;
+    max_level_ = -1;
+    level_rng_.seed(params_.seed);
+}
+
+void HnswIndex::save(std::ostream& out) const {
+    writeValue(out, kSnapshotMagicV2);
+    writeValue(out, static_cast<uint64_t>(nodes_.size()));
+    writeValue(out, entry_point_);
+    writeValue(out, static_cast<int32_t>(max_level_));
+    writeValue(out, static_cast<uint8_t>(quantized()));
+    if (quantized()) {
+        quantizer_.save(out);
+        out.write(reinterpret_cast<const char*>(codes_.data()), codes_.size());
+    } else {
+        out.write(reinterpret_cast<const char*>(vectors_.data()), vectors_.size() * sizeof(float));
+    }
+
+    for (const auto& node : nodes_) {
+        writeValue(out, node.doc_id);
+        writeValue(out, static_cast<uint8_t>(node.deleted));
+        writeValue(out, static_cast<uint32_t>(node.links.size()));
+        for (const auto& links : node.links) {
+            writeValue(out, static_cast<uint32_t>(links.size()));
+            out.write(reinterpret_cast<const char*>(links.data()), links.size() * sizeof(uint32_t));
+        }
+    }
+
+    // Full-precision rows, so a loaded quantized index can still re-score
+    const uint8_t has_rows = rescores() ? 1 : 0;
+    writeValue(out, has_rows);
+    for (uint32_t node = 0; has_rows && node < nodes_.size(); ++node) {
+        out.write(reinterpret_cast<const char*>(full_precision_.row(node)), dimension_ * sizeof(float));
+    }
+}
+
+bool HnswIndex::load(std::istream& in) {
+    clear();
+
+    uint32_t magic = 0;
+    uint64_t num_nodes = 0;
+    int32_t max_level = -1;
+    if (!readValue(in, magic) || (magic != kSnapshotMagic && magic != kSnapshotMagicV2) ||
+        !readValue(in, num_nodes) || !readValue(in, entry_point_) || !readValue(in, max_level)) {
+        return false;
+    }
+
+    uint8_t quantized = 0;
+    if (magic == kSnapshotMagicV2 && !readValue(in, quantized)) {
+        return false;
+    }
+    if (quantized) {
+        if (!quantizer_.load(in, dimension_)) {
+            clear();
+            return false;
+        }
+        codes_.resize(num_nodes * quantizer_.codeSize());
+        in.read(reinterpret_cast<char*>(codes_.data()), codes_.size());
+    } else {
+        vectors_.resize(num_nodes * dimension_);
+        in.read(reinterpret_cast<char*>(vectors_.data()), vectors_.size() * sizeof(float));
+    }
+    nodes_.resize(num_nodes);
+    for (uint32_t i = 0; i < num_nodes && in; ++i) {
+        auto& node = nodes_[i];
+        uint8_t deleted = 0;
+        uint32_t levels = 0;
+        readValue(in, node.doc_id);
+        readValue(in, deleted);
+        readValue(in, levels);
+        node.deleted = deleted != 0;
+        node.links.resize(levels);
+        for (auto& links : node.links) {
+            uint32_t count = 0;
+            readValue(in, count);
+            links.resize(count);
+            in.read(reinterpret_cast<char*>(links.data()), count * sizeof(uint32_t));
+        }
+        if (!node.deleted) {
+            node_of_[node.doc_id] = i;
+        }
+    }
+
+    uint8_t has_rows = 0;
+    if (magic == kSnapshotMagicV2) {
+        readValue(in, has_rows);
+    }
+    std::vector<float> row(dimension_);
+    for (uint32_t node = 0; has_rows && node < num_nodes && in; ++node) {
+        in.read(reinterpret_cast<char*>(row.data()), row.size() * sizeof(float));
+        if (full_precision_.isOpen()) {
+            full_precision_.put(node, row.data());
+        }
+    }
+    if (quantized && !has_rows) {
+        full_precision_.close();  // Nothing to re-score against
+    }
+
+    // Searches follow links without bounds checks: reject a link or entry
+    // point to a missing node, or to a node without that layer
+    bool valid = num_nodes == 0 ? max_level < 0
+                                : entry_point_ < num_nodes && max_level >= 0 &&
+                                      nodes_[entry_point_].links.size() > static_cast<size_t>(max_level);
+    for (uint32_t i = 0; valid && i < num_nodes; ++i) {
+        const auto& levels = nodes_[i].links;
+        for (size_t level = 0; valid && level < levels.size(); ++level) {
+            valid = std::all_of(levels[level].begin(), levels[level].end(), [&](uint32_t neighbor) {
+                return neighbor < num_nodes && nodes_[neighbor].links.size() > level;
+            });
+        }
+    }
+    if (!in || !valid) {
+        clear();
+        return false;
+    }
+    max_level_ = max_level;
+    return true;
+}
+
+}  // namespace rtrv_search_engine
@@ -0,0 +1,264 @@
+#include <gtest/gtest.h>
+#include "aggregations.hpp"
+#include "search_engine.hpp"
+
+using namespace rtrv_search_engine;
+
+static AggregationRequest request(const std::string& spec) {
+    AggregationRequest parsed;
+    EXPECT_TRUE(AggregationCollector::parse(spec, parsed)) << spec;
+    return parsed;
+}
+
+static std::vector<std::pair<std::string, size_t>> buckets(const AggregationResult& result) {
+    std::vector<std::pair<std::string, size_t>> out;
+    for (const auto& bucket : result.buckets) out.emplace_back(bucket.key, bucket.count);
+    return out;
+}
+
+using Buckets = std::vector<std::pair<std::string, size_t>>;
+
+class AggregationsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        values.defineField("brand", FieldType::KEYWORD);
+        values.defineField("price", FieldType::DOUBLE);
+        values.defineField("stock", FieldType::INT64);
+        values.defineField("published", FieldType::DATE);
+        add(1, "Acme", "5.5", "3", "2024-01-15");
+        add(2, "Acme", "12", "3", "2024-01-31T23:59:59Z");
+        add(3, "Globex", "25", "7", "2024-02-01");
+        add(4, "Acme", "49.99", "", "2024-03-10");
+        add(5, "Initech", "50", "7", "2023-12-31");
+        add(6, "Globex", "", "1", "");
+        add(7, "", "100", "3", "2024-06-30");
+        add(8, "Acme", "0.5", "2", "2024-01-01T00:00:00.250Z");
+
+        requests = {request("terms:brand:2"),          request("stock_terms=terms:stock"),
+                    request("histogram:price:10"),     request("date_histogram:published:month"),
+                    request("by_quarter=date_histogram:published:quarter"),
+                    request("by_week=date_histogram:published:week"),
+                    request("stats:price"),            request("brand_stats=stats:brand")};
+    }
+
+    void add(uint32_t id, const char* brand, const char* price, const char* stock, const char* published) {
+        Document doc{id, {}};
+        if (*brand) doc.fields["brand"] = brand;
+        if (*price) doc.fields["price"] = price;
+        if (*stock) doc.fields["stock"] = stock;
+        if (*published) doc.fields["published"] = published;
+        values.addDocument(id, doc);
+    }
+
+    DocValues values;
+    std::vector<AggregationRequest> requests;
+};
+
+TEST_F(AggregationsTest, CollectsEveryTypeFromColumns) {
+    AggregationCollector collector(values, requests);
+    for (uint64_t id = 1; id <= 8; ++id) collector.collect(values.ordinal(id));
+    const auto results = collector.results();
+    ASSERT_EQ(results.size(), requests.size());
+
+    EXPECT_EQ(results[0].name, "brand");
+    EXPECT_EQ(buckets(results[0]), (Buckets{{"Acme", 4}, {"Globex", 2}}));
+    EXPECT_EQ(results[0].other_count, 1u);    // Initech
+    EXPECT_EQ(results[0].missing_count, 1u);
+
+    EXPECT_EQ(results[1].name, "stock_terms");
+    EXPECT_EQ(buckets(results[1]), (Buckets{{"3", 3}, {"7", 2}, {"1", 1}, {"2", 1}}));
+    EXPECT_EQ(results[1].missing_count, 1u);
+
+    EXPECT_EQ(buckets(results[2]), (Buckets{{"0", 2}, {"10", 1}, {"20", 1}, {"40", 1}, {"50", 1}, {"100", 1}}));
+    EXPECT_DOUBLE_EQ(results[2].buckets[3].from, 40.0);
+    EXPECT_EQ(results[2].missing_count, 1u);
+
+    EXPECT_EQ(buckets(results[3]), (Buckets{{"2023-12-01", 1}, {"2024-01-01", 3}, {"2024-02-01", 1},
+                                            {"2024-03-01", 1}, {"2024-06-01", 1}}));
+    EXPECT_EQ(buckets(results[4]), (Buckets{{"2023-10-01", 1}, {"2024-01-01", 5}, {"2024-04-01", 1}}));
+    // Mondays: 2024-01-01, 01-15 and 01-29 (the 31st is a Wednesday)
+    EXPECT_EQ(buckets(results[5]), (Buckets{{"2023-12-25", 1}, {"2024-01-01", 1}, {"2024-01-15", 1},
+                                            {"2024-01-29", 2}, {"2024-03-04", 1}, {"2024-06-24", 1}}));
+
+    const AggregationStats& stats = results[6].stats;
+    EXPECT_EQ(stats.count, 7u);
+    EXPECT_DOUBLE_EQ(stats.min, 0.5);
+    EXPECT_DOUBLE_EQ(stats.max, 100.0);
+    EXPECT_NEAR(stats.sum, 242.99, 1e-9);
+    EXPECT_NEAR(stats.avg, 242.99 / 7, 1e-9);
+    EXPECT_EQ(results[6].missing_count, 1u);
+
+    // Not a numeric field: every hit is missing
+    EXPECT_EQ(results[7].stats.count, 0u);
+    EXPECT_EQ(results[7].stats.min, 0.0);
+    EXPECT_EQ(results[7].missing_count, 8u);
+}
+
+TEST_F(AggregationsTest, HistogramValuesWithoutAnInt64BucketAreMissing) {
+    values.defineField("weight", FieldType::DOUBLE);
+    const char* const weights[] = {"inf", "-inf", "1e300", "-1e300", "15"};
+    for (uint32_t id = 11; id <= 15; ++id) {
+        values.addDocument(id, Document{id, {{"weight", weights[id - 11]}}});
+    }
+    AggregationCollector collector(values, {request("histogram:weight:10")});
+    for (uint64_t id = 11; id <= 15; ++id) collector.collect(values.ordinal(id));
+    const auto results = collector.results();
+    EXPECT_EQ(buckets(results[0]), (Buckets{{"10", 1}}));
+    EXPECT_EQ(results[0].missing_count, 4u);
+}
+
+TEST_F(AggregationsTest, PartialStatesMergeToTheSameResult) {
+    AggregationCollector whole(values, requests);
+    AggregationCollector first(values, requests);
+    AggregationCollector second(values, requests);
+    for (uint64_t id = 1; id <= 8; ++id) {
+        whole.collect(values.ordinal(id));
+        (id % 2 ? first : second).collect(values.ordinal(id));
+    }
+    first.merge(second);
+
+    const auto expected = whole.results();
+    const auto merged = first.results();
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(buckets(merged[i]), buckets(expected[i])) << expected[i].name;
+        EXPECT_EQ(merged[i].other_count, expected[i].other_count);
+        EXPECT_EQ(merged[i].missing_count, expected[i].missing_count);
+        EXPECT_EQ(merged[i].stats.count, expected[i].stats.count);
+        EXPECT_DOUBLE_EQ(merged[i].stats.min, expected[i].stats.min);
+        EXPECT_DOUBLE_EQ(merged[i].stats.max, expected[i].stats.max);
+    }
+}
+
+TEST_F(AggregationsTest, CardinalityFromOrdinalsAndHashes) {
+    const std::vector<AggregationRequest> distinct = {request("cardinality:brand"), request("cardinality:stock:10"),
+                                                      request("cardinality:undeclared")};
+    AggregationCollector first(values, distinct);
+    AggregationCollector second(values, distinct);
+    for (uint64_t id = 1; id <= 8; ++id) (id <= 4 ? first : second).collect(values.ordinal(id));
+    first.merge(second);
+    const auto results = first.results();
+
+    EXPECT_EQ(results[0].cardinality, 3u);  // Acme, Globex, Initech
+    EXPECT_EQ(results[0].missing_count, 1u);
+    EXPECT_EQ(results[1].cardinality, 4u);  // 1, 2, 3, 7
+    EXPECT_EQ(results[2].cardinality, 0u);
+    EXPECT_EQ(results[2].missing_count, 8u);
+
+    // Shards ship sketches: ordinals differ per shard, value hashes do not
+    DocValues shard;
+    shard.defineField("brand", FieldType::KEYWORD);
+    shard.addDocument(1, Document{1, {{"brand", "Umbrella"}}});
+    shard.addDocument(2, Document{2, {{"brand", "Acme"}}});
+    AggregationCollector other(shard, distinct);
+    other.collect(shard.ordinal(1));
+    other.collect(shard.ordinal(2));
+    HyperLogLog combined, remote;
+    ASSERT_TRUE(HyperLogLog::deserialize(results[0].sketch, combined));
+    ASSERT_TRUE(HyperLogLog::deserialize(other.results()[0].sketch, remote));
+    combined.merge(remote);
+    EXPECT_EQ(combined.estimate(), 4u);
+}
+
+TEST(AggregationsParseTest, SpecsAndDateKeys) {
+    AggregationRequest parsed;
+    ASSERT_TRUE(AggregationCollector::parse("top=terms:brand:5", parsed));
+    EXPECT_EQ(parsed.name, "top");
+    EXPECT_EQ(parsed.type, AggregationRequest::TERMS);
+    EXPECT_EQ(parsed.field, "brand");
+    EXPECT_EQ(parsed.size, 5u);
+    ASSERT_TRUE(AggregationCollector::parse("histogram:price:2.5", parsed));
+    EXPECT_DOUBLE_EQ(parsed.interval, 2.5);
+    ASSERT_TRUE(AggregationCollector::parse("date_histogram:published:year", parsed));
+    EXPECT_EQ(parsed.date_interval, AggregationRequest::YEAR);
+
+    EXPECT_FALSE(AggregationCollector::parse("terms", parsed));
+    EXPECT_FALSE(AggregationCollector::parse("terms:brand:0", parsed));
+    EXPECT_FALSE(AggregationCollector::parse("histogram:price", parsed));
+    EXPECT_FALSE(AggregationCollector::parse("histogram:price:-1", parsed));
+    EXPECT_FALSE(AggregationCollector::parse("date_histogram:published:fortnight", parsed));
+    EXPECT_FALSE(AggregationCollector::parse("stats:price:1", parsed));
+    EXPECT_FALSE(AggregationCollector::parse("median:price", parsed));
+    ASSERT_TRUE(AggregationCollector::parse("cardinality:author:16", parsed));
+    EXPECT_EQ(parsed.precision, 16);
+    EXPECT_FALSE(AggregationCollector::parse("cardinality:author:19", parsed));
+
+    // Bucket keys read back as the same value
+    for (const char* date : {"2024-01-31T23:59:59Z", "2024-01-01T00:00:00.250Z", "1969-12-31", "2024-02-29"}) {
+        int64_t key, again;
+        ASSERT_TRUE(DocValues::parseValue(FieldType::DATE, date, key));
+        const std::string text = DocValues::formatValue(FieldType::DATE, key);
+        ASSERT_TRUE(DocValues::parseValue(FieldType::DATE, text, again)) << text;
+        EXPECT_EQ(again, key) << text;
+    }
+    EXPECT_EQ(DocValues::formatValue(FieldType::DOUBLE, DocValues::doubleToKey(0.1)), "0.1");
+    EXPECT_EQ(DocValues::formatValue(FieldType::INT64, -42), "-42");
+}
+
+TEST(AggregationsEngineTest, PaginatedSearchAggregatesAllHits) {
+    SearchEngine engine;
+    engine.defineField("brand", FieldType::KEYWORD);
+    engine.defineField("price", FieldType::DOUBLE);
+    engine.defineField("published", FieldType::DATE);
+    for (uint32_t id = 1; id <= 30; ++id) {
+        engine.indexDocument(Document{id,
+                                      {{"content", id % 3 == 0 ? "phone review" : "laptop review"},
+                                       {"brand", id % 2 ? "Acme" : "Globex"},
+                                       {"price", std::to_string(id * 10)},
+                                       {"published", "2024-0" + std::to_string(id % 4 + 1) + "-15"}}});
+    }
+
+    SearchOptions options;
+    options.max_results = 5;
+    options.facets = {"brand"};
+    options.aggregations = {request("terms:brand"), request("stats:price"),
+                            request("date_histogram:published:month"), request("histogram:price:100")};
+    const auto paginated = engine.searchPaginated("laptop", options);
+    ASSERT_EQ(paginated.pagination.total_hits, 20u);
+    EXPECT_EQ(paginated.results.size(), 5u);
+    ASSERT_EQ(paginated.aggregations.size(), 4u);
+    ASSERT_EQ(paginated.facets.size(), 1u);
+
+    // Laptops are the ids not divisible by 3: 10 of each brand
+    EXPECT_EQ(buckets(paginated.aggregations[0]), (Buckets{{"Acme", 10}, {"Globex", 10}}));
+    EXPECT_EQ(paginated.facets[0].values.size(), 2u);
+    const AggregationStats& stats = paginated.aggregations[1].stats;
+    EXPECT_EQ(stats.count, 20u);
+    EXPECT_DOUBLE_EQ(stats.min, 10.0);
+    EXPECT_DOUBLE_EQ(stats.max, 290.0);
+    size_t months = 0;
+    for (const auto& bucket : paginated.aggregations[2].buckets) months += bucket.count;
+    EXPECT_EQ(months, 20u);
+    EXPECT_EQ(paginated.aggregations[3].buckets.front().key, "0");
+    EXPECT_EQ(paginated.aggregations[3].buckets.front().count, 6u);  // 10..80 without 30 and 60
+
+    // Filters narrow the aggregated hits too
+    options.filters = {"brand:acme"};
+    const auto filtered = engine.searchPaginated("laptop", options);
+    EXPECT_EQ(buckets(filtered.aggregations[0]), (Buckets{{"Acme", 10}}));
+    EXPECT_EQ(filtered.aggregations[1].stats.count, 10u);
+}
+
+TEST(AggregationTest, HybridAggregationsCoverEveryLexicalAndVectorHit) {
+    SearchEngine engine;
+    engine.enableVectorSearch(2, VectorMetric::COSINE);
+    engine.defineField("price", FieldType::INT64);
+    FusionParams params;
+    params.window_size = 3;  // Smaller than the lexical matches
+    engine.registerCustomRanker(std::make_unique<HybridRanker>("Hybrid-Small", params));
+    for (uint32_t id = 1; id <= 20; ++id) {
+        // Ids 1-10 match "laptop"; the nearest vectors are ids 18-20
+        Document doc{id, {{"content", id <= 10 ? "laptop review" : "phone review"}, {"price", std::to_string(id)}}};
+        doc.vector = {1.0f, 0.1f * static_cast<float>(20 - id)};
+        engine.indexDocument(doc);
+    }
+
+    SearchOptions options;
+    options.ranker_name = "Hybrid-Small";
+    options.query_vector = {1.0f, 0.0f};
+    options.max_results = 2;
+    options.aggregations = {request("stats:price")};
+    const auto paginated = engine.searchPaginated("laptop", options);
+    const AggregationStats& stats = paginated.aggregations.at(0).stats;
+    EXPECT_EQ(stats.count, 13u);
+    EXPECT_DOUBLE_EQ(stats.sum, 55.0 + 18 + 19 + 20);
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "doc_id_iterator.hpp"
+
+using namespace rtrv_search_engine;
+
+static std::vector<uint32_t> drain(DocIdSetIterator& iterator) {
+    std::vector<uint32_t> docs;
+    for (uint32_t doc = iterator.nextDoc(); doc != DocIdSetIterator::NO_MORE_DOCS; doc = iterator.nextDoc()) {
+        docs.push_back(doc);
+    }
+    return docs;
+}
+
+static std::unique_ptr<DocIdSetIterator> sorted(std::vector<uint32_t> docs) {
+    return std::make_unique<SortedDocIdIterator>(std::move(docs));
+}
+
+TEST(DocIdIteratorTest, LeafIteratorsAdvance) {
+    SortedDocIdIterator list({2, 5, 9, 40, 41, 100});
+    EXPECT_EQ(list.advance(6), 9u);
+    EXPECT_EQ(list.advance(9), 9u);  // Not past the current document
+    EXPECT_EQ(list.advance(41), 41u);
+    EXPECT_EQ(list.nextDoc(), 100u);
+    EXPECT_EQ(list.nextDoc(), DocIdSetIterator::NO_MORE_DOCS);
+
+    auto bits = std::make_shared<BitSet>(200);
+    for (uint32_t doc : {3u, 64u, 65u, 199u}) bits->set(doc);
+    EXPECT_EQ(bits->count(), 4u);
+    BitSetIterator bit_iterator(bits, bits->count());
+    EXPECT_EQ(bit_iterator.nextDoc(), 3u);
+    EXPECT_EQ(bit_iterator.advance(66), 199u);
+    EXPECT_EQ(bit_iterator.nextDoc(), DocIdSetIterator::NO_MORE_DOCS);
+}
+
+TEST(DocIdIteratorTest, BooleanCombinators) {
+    std::vector<std::unique_ptr<DocIdSetIterator>> and_children;
+    and_children.push_back(sorted({1, 3, 5, 7, 9, 11}));
+    and_children.push_back(sorted({3, 4, 5, 9, 10, 11}));
+    and_children.push_back(sorted({0, 5, 9, 11, 12}));
+    ConjunctionIterator conjunction(std::move(and_children));
+    EXPECT_EQ(drain(conjunction), (std::vector<uint32_t>{5, 9, 11}));
+
+    std::vector<std::unique_ptr<DocIdSetIterator>> or_children;
+    or_children.push_back(sorted({1, 8}));
+    or_children.push_back(sorted({2, 8, 20}));
+    or_children.push_back(sorted({}));
+    DisjunctionIterator disjunction(std::move(or_children));
+    EXPECT_EQ(drain(disjunction), (std::vector<uint32_t>{1, 2, 8, 20}));
+
+    ExclusionIterator exclusion(std::make_unique<AllDocsIterator>(6), sorted({0, 2, 3}));
+    EXPECT_EQ(exclusion.toBitSet(6).count(), 3u);
+}
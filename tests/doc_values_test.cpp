@@ -0,0 +1,446 @@
+#include <gtest/gtest.h>
+#include "doc_values.hpp"
+#include "search_engine.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <tuple>
+
+using namespace rtrv_search_engine;
+
+static Document makeDoc(uint32_t id, const std::string& content, const std::string& category,
+                        const std::string& lang = "") {
+    Document doc{id, {{"content", content}, {"category", category}}};
+    if (!lang.empty()) doc.fields["lang"] = lang;
+    return doc;
+}
+
+TEST(DocValuesTest, KeywordColumnsAreOrdinalEncoded) {
+    DocValues values;
+    EXPECT_TRUE(values.defineField("category", FieldType::KEYWORD));
+    EXPECT_FALSE(values.defineField("category", FieldType::KEYWORD));
+    EXPECT_EQ(values.fieldType("category"), FieldType::KEYWORD);
+    EXPECT_EQ(values.fieldType("content"), FieldType::TEXT);
+
+    values.addDocument(5, makeDoc(5, "a", "books"));
+    values.addDocument(9, makeDoc(9, "b", "music"));
+    values.addDocument(7, makeDoc(7, "c", "books"));
+    values.addDocument(1ull << 40, makeDoc(0, "d", "games"));  // Beyond the direct id table
+
+    const KeywordColumn* column = values.keywordColumn("category");
+    ASSERT_NE(column, nullptr);
+    EXPECT_EQ(column->values.size(), 3u);
+    EXPECT_EQ(column->valueOrdinal(values.ordinal(5)), column->valueOrdinal(values.ordinal(7)));
+    EXPECT_EQ(column->values[column->valueOrdinal(values.ordinal(9))], "music");
+    EXPECT_EQ(column->values[column->valueOrdinal(values.ordinal(1ull << 40))], "games");
+    EXPECT_EQ(values.docId(values.ordinal(9)), 9u);
+    EXPECT_EQ(values.ordinal(6), DocValues::kNoOrdinal);
+
+    // Removal clears the values; re-adding reuses the ordinal
+    const uint32_t ordinal = values.ordinal(9);
+    values.removeDocument(9);
+    EXPECT_EQ(column->valueOrdinal(ordinal), KeywordColumn::kMissing);
+    values.addDocument(9, makeDoc(9, "b", "books"));
+    EXPECT_EQ(values.ordinal(9), ordinal);
+    EXPECT_EQ(column->values[column->valueOrdinal(ordinal)], "books");
+    EXPECT_EQ(values.ordinals(), 4u);
+    EXPECT_GT(values.memoryUsage(), 0u);
+}
+
+TEST(DocValuesTest, FacetCounterRanksValuesAndMerges) {
+    DocValues values;
+    values.defineField("category", FieldType::KEYWORD);
+    const char* categories[] = {"books", "music", "books", "games", "books", "music", ""};
+    for (uint32_t id = 1; id <= 7; ++id) {
+        values.addDocument(id, makeDoc(id, "x", categories[id - 1]));
+    }
+
+    FacetCounter first(values, {"category", "undeclared"});
+    FacetCounter second(values, {"category", "undeclared"});
+    for (uint64_t id = 1; id <= 4; ++id) first.collect(id);
+    for (uint64_t id = 5; id <= 7; ++id) second.collect(id);
+    first.merge(second);
+
+    auto facets = first.results(2);
+    ASSERT_EQ(facets.size(), 2u);
+    ASSERT_EQ(facets[0].values.size(), 2u);
+    EXPECT_EQ(facets[0].values[0].value, "books");
+    EXPECT_EQ(facets[0].values[0].count, 3u);
+    EXPECT_EQ(facets[0].values[1].value, "music");
+    EXPECT_EQ(facets[0].other_count, 1u);    // games
+    EXPECT_EQ(facets[0].missing_count, 1u);  // Empty value
+    EXPECT_TRUE(facets[1].values.empty());
+    EXPECT_EQ(facets[1].missing_count, 7u);
+}
+
+TEST(DocValuesTest, EngineFacetsCountEveryHit) {
+    SearchEngine engine;
+    engine.indexDocument(makeDoc(1, "rust programming guide", "tutorials", "en"));
+    engine.indexDocument(makeDoc(2, "python programming basics", "tutorials", "en"));
+    engine.indexDocument(makeDoc(3, "programming news roundup", "articles", "de"));
+    engine.indexDocument(makeDoc(4, "cooking pasta", "recipes", "it"));
+
+    // Declared after indexing: existing documents are back-filled
+    engine.defineField("category", FieldType::KEYWORD);
+    engine.defineField("lang", FieldType::KEYWORD);
+
+    SearchOptions options;
+    options.max_results = 1;  // Facets cover all hits, not just the page
+    options.facets = {"category", "lang"};
+    auto page = engine.searchPaginated("programming", options);
+    EXPECT_EQ(page.results.size(), 1u);
+    EXPECT_EQ(page.pagination.total_hits, 3u);
+    ASSERT_EQ(page.facets.size(), 2u);
+    EXPECT_EQ(page.facets[0].field, "category");
+    ASSERT_EQ(page.facets[0].values.size(), 2u);
+    EXPECT_EQ(page.facets[0].values[0].value, "tutorials");
+    EXPECT_EQ(page.facets[0].values[0].count, 2u);
+    EXPECT_EQ(page.facets[1].values[0].value, "en");
+
+    engine.deleteDocument(2);
+    page = engine.searchPaginated("programming", options);
+    EXPECT_EQ(page.facets[0].values[0].count, 1u);
+    EXPECT_GT(engine.memoryUsage().doc_values_bytes, 0u);
+
+    // Rebuilt from the stored fields on load
+    const std::string path = "/tmp/rtrv_doc_values_test.bin";
+    ASSERT_TRUE(engine.saveSnapshot(path));
+    SearchEngine restored;
+    restored.defineField("category", FieldType::KEYWORD);
+    ASSERT_TRUE(restored.loadSnapshot(path));
+    std::remove(path.c_str());
+    options.facets = {"category"};
+    page = restored.searchPaginated("programming", options);
+    ASSERT_EQ(page.facets.size(), 1u);
+    EXPECT_EQ(page.facets[0].values.size(), 2u);
+}
+
+TEST(DocValuesTest, NumericKeysPreserveOrder) {
+    int64_t key = 0;
+    ASSERT_TRUE(DocValues::parseValue(FieldType::INT64, " -42 ", key));
+    EXPECT_EQ(key, -42);
+    EXPECT_FALSE(DocValues::parseValue(FieldType::INT64, "4.2", key));
+
+    std::vector<int64_t> keys;
+    for (const char* value : {"-1e300", "-2.5", "-0.0", "0", "1e-300", "2.5", "inf"}) {
+        ASSERT_TRUE(DocValues::parseValue(FieldType::DOUBLE, value, key)) << value;
+        keys.push_back(key);
+    }
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    EXPECT_EQ(keys[2], keys[3]);  // -0.0 == 0.0
+    EXPECT_DOUBLE_EQ(DocValues::keyToDouble(keys[1]), -2.5);
+    EXPECT_FALSE(DocValues::parseValue(FieldType::DOUBLE, "nan", key));
+
+    ASSERT_TRUE(DocValues::parseValue(FieldType::DATE, "2024-03-01", key));
+    EXPECT_EQ(key, 1709251200000);
+    ASSERT_TRUE(DocValues::parseValue(FieldType::DATE, "2024-03-01T01:30:00.250+01:00", key));
+    EXPECT_EQ(key, 1709251200000 + 30 * 60000 + 250);
+    ASSERT_TRUE(DocValues::parseValue(FieldType::DATE, "1709251200000", key));  // Epoch millis
+    EXPECT_FALSE(DocValues::parseValue(FieldType::DATE, "2024-02-30", key));
+
+    // Range bounds: exclusive = one key further, open ends, empty intervals
+    int64_t lower = 0;
+    int64_t upper = 0;
+    ASSERT_TRUE(DocValues::rangeKeys(FieldType::INT64, "10", false, "20", true, lower, upper));
+    EXPECT_EQ(lower, 11);
+    EXPECT_EQ(upper, 20);
+    ASSERT_TRUE(DocValues::rangeKeys(FieldType::INT64, "", false, "5", false, lower, upper));
+    EXPECT_EQ(lower, std::numeric_limits<int64_t>::min());
+    EXPECT_EQ(upper, 4);
+    EXPECT_FALSE(DocValues::rangeKeys(FieldType::INT64, "5", false, "6", false, lower, upper));
+    EXPECT_FALSE(DocValues::rangeKeys(FieldType::INT64, "x", true, "", true, lower, upper));
+    EXPECT_FALSE(DocValues::rangeKeys(FieldType::KEYWORD, "a", true, "b", true, lower, upper));
+}
+
+TEST(DocValuesTest, RangeFiltersUseTypedColumns) {
+    SearchEngine engine;
+    engine.defineField("price", FieldType::DOUBLE);
+    engine.defineField("published", FieldType::DATE);
+    const std::vector<std::pair<const char*, const char*>> rows = {
+        {"9.99", "2023-12-31"}, {"10", "2024-01-15"}, {"55.5", "2024-02-01T12:00:00Z"},
+        {"100", "2024-06-30"}, {"250", "2025-01-01"}, {"not a price", ""}};
+    for (uint32_t id = 1; id <= rows.size(); ++id) {
+        engine.indexDocument(Document{
+            id, {{"content", "laptop review"}, {"price", rows[id - 1].first}, {"published", rows[id - 1].second}}});
+    }
+    engine.indexDocument(Document{7, {{"content", "phone review"}, {"price", "20"}}});
+
+    const auto ids = [&](const std::string& query) {
+        std::vector<uint64_t> out;
+        for (const auto& result : engine.search(query)) out.push_back(result.document.id);
+        std::sort(out.begin(), out.end());
+        return out;
+    };
+
+    EXPECT_EQ(ids("laptop price:[10 TO 100]"), (std::vector<uint64_t>{2, 3, 4}));
+    EXPECT_EQ(ids("laptop price:{10 TO 100}"), (std::vector<uint64_t>{3}));
+    EXPECT_EQ(ids("review AND price:[* TO 20]"), (std::vector<uint64_t>{1, 2, 7}));
+    EXPECT_EQ(ids("price:[100 TO *]"), (std::vector<uint64_t>{4, 5}));  // Filter only
+    EXPECT_EQ(ids("review published:[2024-01-01 TO 2024-12-31]"), (std::vector<uint64_t>{2, 3, 4}));
+    EXPECT_EQ(ids("review AND (price:[* TO 10} OR price:[200 TO *])"), (std::vector<uint64_t>{1, 5}));
+    EXPECT_EQ(ids("review AND NOT price:[0 TO 50]"), (std::vector<uint64_t>{3, 4, 5, 6}));
+    EXPECT_TRUE(ids("laptop content:[a TO z]").empty());  // Not a numeric field
+
+    // Updates and deletes are reflected in the range index
+    engine.updateDocument(2, Document{2, {{"content", "laptop review"}, {"price", "500"}}});
+    engine.deleteDocument(3);
+    EXPECT_EQ(ids("laptop price:[10 TO 100]"), (std::vector<uint64_t>{4}));
+    EXPECT_EQ(ids("price:[400 TO 600]"), (std::vector<uint64_t>{2}));
+
+    // Brackets outside a field:[..] clause still split words
+    engine.indexDocument(Document{8, {{"content", "array draft"}}});
+    EXPECT_EQ(ids("array[0]"), (std::vector<uint64_t>{8}));
+    EXPECT_EQ(ids("{draft}"), (std::vector<uint64_t>{8}));
+}
+
+TEST(DocValuesTest, FieldSortOrdersHitsByColumns) {
+    SearchEngine engine;
+    engine.defineField("price", FieldType::INT64);
+    engine.defineField("brand", FieldType::KEYWORD);
+    const std::vector<std::pair<const char*, const char*>> rows = {
+        {"30", "acme"}, {"10", "zeta"}, {"", "acme"}, {"20", ""}, {"10", "beta"}};
+    for (uint32_t id = 1; id <= rows.size(); ++id) {
+        engine.indexDocument(
+            Document{id, {{"content", "laptop review"}, {"price", rows[id - 1].first}, {"brand", rows[id - 1].second}}});
+    }
+
+    const auto ids = [&](const std::vector<SortField>& sort, size_t k = 10) {
+        SearchOptions options;
+        options.sort = sort;
+        options.max_results = k;
+        std::vector<uint64_t> out;
+        for (const auto& result : engine.search("laptop", options)) out.push_back(result.document.id);
+        return out;
+    };
+
+    EXPECT_EQ(ids({{"price"}}), (std::vector<uint64_t>{2, 5, 4, 1, 3}));  // Ties by doc id, missing last
+    EXPECT_EQ(ids({{"price", true}}), (std::vector<uint64_t>{1, 4, 2, 5, 3}));
+    EXPECT_EQ(ids({{"price"}, {"brand", true}}), (std::vector<uint64_t>{2, 5, 4, 1, 3}));
+    EXPECT_EQ(ids({{"brand"}, {"price"}}, 3), (std::vector<uint64_t>{1, 3, 5}));
+    EXPECT_EQ(ids({{"price"}}, 2), (std::vector<uint64_t>{2, 5}));
+
+    // Pages follow the sort order
+    SearchOptions options;
+    options.sort = {{"price", true}};
+    options.max_results = 2;
+    options.offset = 2;
+    auto page = engine.searchPaginated("laptop", options);
+    ASSERT_EQ(page.results.size(), 2u);
+    EXPECT_EQ(page.results[0].document.id, 2u);
+    EXPECT_EQ(page.results[1].document.id, 5u);
+    EXPECT_EQ(page.pagination.total_hits, 5u);
+
+    // Filter-only queries sort too
+    options.offset = 0;
+    page = engine.searchPaginated("price:[10 TO 20]", options);
+    ASSERT_EQ(page.results.size(), 2u);
+    EXPECT_EQ(page.results[0].document.id, 4u);
+}
+
+TEST(DocValuesTest, IndexSortStopsAfterThePage) {
+    SearchEngine sorted_engine;
+    SearchEngine plain_engine;
+    for (SearchEngine* engine : {&sorted_engine, &plain_engine}) {
+        engine->defineField("published", FieldType::DATE);
+    }
+    const auto add = [&](uint32_t id) {
+        const std::string day = std::to_string(10 + (id * 7919) % 18);
+        const Document doc{id, {{"content", id % 3 ? "market news" : "sports news"},
+                                {"published", "2024-02-" + day + "T" + std::to_string(10 + id % 10) + ":00:00Z"}}};
+        sorted_engine.indexDocument(doc);
+        plain_engine.indexDocument(doc);
+    };
+    for (uint32_t id = 1; id <= 600; ++id) add(id);
+    EXPECT_FALSE(sorted_engine.setIndexSort("content", true));  // Not a doc-values field
+    ASSERT_TRUE(sorted_engine.setIndexSort("published", true));
+    for (uint32_t id = 601; id <= 650; ++id) add(id);  // Out of order until the next re-sort
+
+    SearchOptions options;
+    options.sort = {{"published", true}};
+    options.max_results = 10;
+    options.use_cache = false;
+    options.explain_scores = true;
+    for (const std::string query : {"market", "news"}) {
+        const auto expected = plain_engine.search(query, options);
+        const auto actual = sorted_engine.search(query, options);
+        ASSERT_EQ(actual.size(), expected.size()) << query;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(actual[i].document.id, expected[i].document.id) << query << " #" << i;
+        }
+        EXPECT_NE(actual[0].explanation.find("Index-Sorted Walk"), std::string::npos);
+        EXPECT_EQ(expected[0].explanation.find("Index-Sorted Walk"), std::string::npos);
+    }
+    // Only the query's own candidates are walked
+    const auto selective = sorted_engine.search("sports", options);
+    ASSERT_EQ(selective.size(), 10u);
+    EXPECT_NE(selective[0].explanation.find(" of 216 candidates visited"), std::string::npos)
+        << selective[0].explanation;
+
+    // Ascending queries cannot use a descending index sort
+    options.sort = {{"published"}};
+    EXPECT_EQ(sorted_engine.search("news", options)[0].document.id, plain_engine.search("news", options)[0].document.id);
+}
+
+TEST(DocValuesTest, TopGroupsMatchBruteForceGrouping) {
+    DocValues values;
+    values.defineField("brand", FieldType::KEYWORD);
+    values.defineField("stock", FieldType::INT64);
+    std::vector<FieldHit> hits;
+    uint64_t state = 12345;
+    const auto next = [&] { return (state = state * 6364136223846793005ULL + 1442695040888963407ULL) >> 33; };
+    for (uint32_t id = 1; id <= 2000; ++id) {
+        Document doc{id, {}};
+        const uint64_t brand = next() % 60;
+        if (brand > 0) doc.fields["brand"] = "brand-" + std::to_string(brand);  // 0: no value
+        doc.fields["stock"] = std::to_string(next() % 40);
+        values.addDocument(id, doc);
+        hits.push_back({id, values.ordinal(id), static_cast<double>(next() % 500 + 1)});  // Ties on purpose
+    }
+
+    for (const std::string field : {"brand", "stock", "undeclared"}) {
+        const FieldComparator comparator(values, {});
+        // Expected: every group's hits in order, groups by their best hit
+        std::vector<std::vector<FieldHit>> expected;
+        std::unordered_map<std::string, size_t> group_of;
+        std::vector<FieldHit> ordered = hits;
+        std::sort(ordered.begin(), ordered.end(), comparator);
+        for (const auto& hit : ordered) {
+            std::string key;
+            if (field == "brand") {
+                const uint32_t value = values.keywordColumn(field)->valueOrdinal(hit.ordinal);
+                key = value == KeywordColumn::kMissing ? "" : std::to_string(value);
+            } else if (field == "stock") {
+                key = std::to_string(values.numericColumn(field)->keys[hit.ordinal]);
+            }
+            if (key.empty()) {
+                expected.push_back({hit});
+                continue;
+            }
+            auto inserted = group_of.emplace(key, expected.size());
+            if (inserted.second) expected.emplace_back();
+            expected[inserted.first->second].push_back(hit);
+        }
+
+        for (const auto& [k, per_group] : std::vector<std::pair<size_t, size_t>>{{1, 1}, {5, 3}, {25, 4}, {1000, 2}}) {
+            TopGroupsCollector collector(comparator, values, field, k, per_group);
+            for (const auto& hit : hits) collector.collect(hit);
+            if (collector.beginRecollect()) {
+                for (const auto& hit : hits) {
+                    if (collector.recollects(hit.ordinal)) collector.recollect(hit);
+                }
+            }
+            const auto groups = collector.sorted();
+            ASSERT_EQ(groups.size(), std::min(k, expected.size())) << field;
+            for (size_t g = 0; g < groups.size(); ++g) {
+                EXPECT_EQ(groups[g].head.doc_id, expected[g][0].doc_id) << field << " group " << g;
+                const size_t inner = std::min(per_group, expected[g].size());
+                ASSERT_EQ(groups[g].hits.size(), inner) << field << " group " << g;
+                for (size_t i = 0; i < inner; ++i) {
+                    EXPECT_EQ(groups[g].hits[i].doc_id, expected[g][i].doc_id) << field << " group " << g;
+                }
+            }
+        }
+    }
+}
+
+TEST(DocValuesTest, EngineCollapsesResultsByField) {
+    SearchEngine engine;
+    engine.defineField("brand", FieldType::KEYWORD);
+    engine.defineField("price", FieldType::INT64);
+    const std::vector<std::tuple<const char*, const char*, const char*>> rows = {
+        {"laptop laptop laptop", "acme", "900"}, {"laptop laptop", "acme", "500"}, {"laptop", "acme", "300"},
+        {"laptop laptop", "zeta", "700"},        {"laptop", "zeta", "200"},        {"laptop laptop", "", "800"},
+        {"laptop", "", "100"}};
+    for (uint32_t id = 1; id <= rows.size(); ++id) {
+        const auto& [content, brand, price] = rows[id - 1];
+        Document doc{id, {{"content", content}, {"price", price}}};
+        if (*brand) doc.fields["brand"] = brand;
+        engine.indexDocument(doc);
+    }
+
+    const auto ids = [](const std::vector<SearchResult>& results) {
+        std::vector<uint64_t> out;
+        for (const auto& result : results) out.push_back(result.document.id);
+        return out;
+    };
+
+    SearchOptions options;
+    options.collapse_field = "brand";
+    options.collapse_inner_hits = 2;
+    auto results = engine.search("laptop", options);
+    // Docs without a brand stay apart (and, one token shorter, outscore their peers)
+    ASSERT_EQ(ids(results), (std::vector<uint64_t>{1, 6, 4, 7}));
+    EXPECT_EQ(ids(results[0].inner_hits), (std::vector<uint64_t>{1, 2}));
+    EXPECT_EQ(ids(results[1].inner_hits), (std::vector<uint64_t>{6}));
+    EXPECT_EQ(ids(results[2].inner_hits), (std::vector<uint64_t>{4, 5}));
+
+    // Groups ranked by their best hit in sort order
+    options.sort = {{"price"}};
+    options.collapse_inner_hits = 0;
+    results = engine.search("laptop", options);
+    EXPECT_EQ(ids(results), (std::vector<uint64_t>{7, 5, 3, 6}));
+    EXPECT_TRUE(results[0].inner_hits.empty());
+
+    // Pages and totals count groups; filter-only queries collapse too
+    options.sort.clear();
+    options.max_results = 2;
+    options.offset = 2;
+    auto page = engine.searchPaginated("laptop", options);
+    EXPECT_EQ(page.pagination.total_hits, 4u);
+    EXPECT_EQ(ids(page.results), (std::vector<uint64_t>{4, 7}));
+    options.offset = 0;
+    options.max_results = 10;
+    options.collapse_field = "price";
+    EXPECT_EQ(engine.search("price:[100 TO 500]", options).size(), 4u);
+    options.collapse_field = "brand";
+    EXPECT_EQ(ids(engine.search("price:[100 TO 500]", options)), (std::vector<uint64_t>{2, 5, 7}));
+}
+
+TEST(DocValuesTest, HybridCollapseFillsThePageWithGroups) {
+    SearchEngine engine;
+    engine.enableVectorSearch(2, VectorMetric::COSINE);
+    engine.defineField("brand", FieldType::KEYWORD);
+    for (uint32_t id = 1; id <= 12; ++id) {
+        // Fused ranking follows the id; brands come in runs of three
+        Document doc{id, {{"content", "laptop"}, {"brand", "b" + std::to_string((id - 1) / 3)}}};
+        doc.vector = {1.0f, 0.1f * static_cast<float>(id)};
+        engine.indexDocument(doc);
+    }
+
+    SearchOptions options;
+    options.ranker_name = "Hybrid-RRF";
+    options.query_vector = {1.0f, 0.0f};
+    options.collapse_field = "brand";
+    options.max_results = 3;
+    const auto results = engine.search("laptop", options);
+    std::vector<uint64_t> heads;
+    for (const auto& result : results) heads.push_back(result.document.id);
+    EXPECT_EQ(heads, (std::vector<uint64_t>{1, 4, 7}));
+}
+
+TEST(DocValuesTest, HybridSortPicksThePageFromEveryFusedDocument) {
+    SearchEngine engine;
+    engine.enableVectorSearch(2, VectorMetric::COSINE);
+    engine.defineField("price", FieldType::INT64);
+    for (uint32_t id = 1; id <= 12; ++id) {
+        // Fused ranking follows the id; the highest prices rank last
+        Document doc{id, {{"content", "laptop"}, {"price", std::to_string(id * 10)}}};
+        doc.vector = {1.0f, 0.1f * static_cast<float>(id)};
+        engine.indexDocument(doc);
+    }
+
+    SearchOptions options;
+    options.ranker_name = "Hybrid-RRF";
+    options.query_vector = {1.0f, 0.0f};
+    options.sort = {{"price", true}};
+    options.max_results = 3;
+    options.explain_scores = true;
+    const auto results = engine.search("laptop", options);
+    std::vector<uint64_t> ids;
+    for (const auto& result : results) ids.push_back(result.document.id);
+    EXPECT_EQ(ids, (std::vector<uint64_t>{12, 11, 10}));
+    ASSERT_FALSE(results.empty());
+    EXPECT_GT(results[0].score, 0.0);
+    EXPECT_NE(results[0].explanation.find("Vector: #"), std::string::npos);
+}
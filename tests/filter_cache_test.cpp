@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include "filter_cache.hpp"
+#include "search_engine.hpp"
+
+#include <algorithm>
+
+using namespace rtrv_search_engine;
+
+static std::vector<uint32_t> drain(DocIdSetIterator& iterator) {
+    std::vector<uint32_t> docs;
+    for (uint32_t doc = iterator.nextDoc(); doc != DocIdSetIterator::NO_MORE_DOCS; doc = iterator.nextDoc()) {
+        docs.push_back(doc);
+    }
+    return docs;
+}
+
+TEST(FilterCacheTest, SegmentedSetsRebuildOnlyTouchedSegments) {
+    // Three segments: "a" is dense in the first (bitmap), sparse elsewhere (arrays)
+    DocValues values;
+    values.defineField("tenant", FieldType::KEYWORD);
+    const uint32_t count = 2 * (1u << DocValues::kSegmentBits) + 1000;
+    std::vector<uint32_t> expected;
+    for (uint32_t id = 0; id < count; ++id) {
+        const bool a = id < (1u << DocValues::kSegmentBits) ? id % 3 == 0 : id % 1000 == 7;
+        values.addDocument(id, Document{id, {{"tenant", a ? "Acme Corp" : "other"}}});
+        if (a) expected.push_back(values.ordinal(id));
+    }
+    ASSERT_EQ(values.segments(), 3u);
+
+    auto docs = values.keywordIterator("tenant", "acme corp");
+    auto set = SegmentedDocIdSet::build(*docs, values);
+    EXPECT_EQ(set->cardinality(), expected.size());
+    EXPECT_TRUE(set->contains(0));
+    EXPECT_FALSE(set->contains(1));
+    EXPECT_TRUE(set->contains(70007));
+    EXPECT_FALSE(set->contains(count + 5));
+    EXPECT_EQ(set->nextDoc(65536), 66007u);
+    auto iterator = SegmentedDocIdSet::iterator(set);
+    EXPECT_EQ(drain(*iterator), expected);
+    EXPECT_TRUE(set->current(values));
+
+    // A write to the last segment leaves the first two reusable
+    values.addDocument(count - 1, Document{count - 1, {{"tenant", "acme-corp"}}});
+    EXPECT_FALSE(set->current(values));
+    docs = values.keywordIterator("tenant", "acme corp");
+    auto refreshed = SegmentedDocIdSet::build(*docs, values, set.get());
+    EXPECT_EQ(refreshed->reusedSegments(), 2u);
+    EXPECT_EQ(refreshed->cardinality(), expected.size() + 1);
+    EXPECT_TRUE(refreshed->contains(values.ordinal(count - 1)));
+    EXPECT_TRUE(refreshed->current(values));
+}
+
+TEST(FilterCacheTest, AdmitsRecurringClausesOnly) {
+    DocValues values;
+    values.defineField("lang", FieldType::KEYWORD);
+    for (uint32_t id = 1; id <= 10; ++id) {
+        values.addDocument(id, Document{id, {{"lang", id % 2 ? "en" : "fr"}}});
+    }
+
+    FilterCache cache(1 << 20, 2);
+    size_t computed = 0;
+    const auto lookup = [&](const std::string& value) {
+        return cache.getOrCompute("lang:" + value, values, [&] {
+            ++computed;
+            return values.keywordIterator("lang", value);
+        });
+    };
+
+    EXPECT_EQ(lookup("en")->cardinality(), 5u);  // First use: evaluated, not kept
+    EXPECT_EQ(cache.getStats().current_size, 0u);
+    lookup("en");                                // Second use: admitted
+    EXPECT_EQ(cache.getStats().current_size, 1u);
+    lookup("en");
+    lookup("en");
+    EXPECT_EQ(computed, 2u);
+    lookup("fr");
+    EXPECT_EQ(cache.getStats().current_size, 1u);
+
+    const auto stats = cache.getStats();
+    EXPECT_EQ(stats.hit_count, 2u);
+    EXPECT_EQ(stats.miss_count, 3u);
+    EXPECT_GT(stats.memory_bytes, 0u);
+
+    // A write refreshes the entry instead of dropping it
+    values.addDocument(11, Document{11, {{"lang", "en"}}});
+    EXPECT_EQ(lookup("en")->cardinality(), 6u);
+    EXPECT_EQ(cache.getStats().refresh_count, 1u);
+    EXPECT_EQ(lookup("en")->cardinality(), 6u);
+    EXPECT_EQ(cache.getStats().hit_count, 3u);
+
+    cache.configure(0, 2);  // No budget: everything is evicted
+    EXPECT_EQ(cache.getStats().current_size, 0u);
+    EXPECT_EQ(cache.getStats().eviction_count, 1u);
+}
+
+TEST(FilterCacheTest, EngineFiltersRestrictWithoutScoring) {
+    SearchEngine engine;
+    engine.defineField("tenant", FieldType::KEYWORD);
+    engine.defineField("lang", FieldType::KEYWORD);
+    engine.defineField("price", FieldType::INT64);
+    for (uint32_t id = 1; id <= 40; ++id) {
+        engine.indexDocument(Document{id,
+                                      {{"content", id % 4 == 0 ? "laptop review" : "phone review"},
+                                       {"tenant", id % 2 ? "Acme" : "Globex"},
+                                       {"lang", id % 5 == 0 ? "fr" : "en"},
+                                       {"price", std::to_string(id * 10)}}});
+    }
+
+    const auto ids = [&](const std::string& query, std::vector<std::string> filters) {
+        SearchOptions options;
+        options.max_results = 100;
+        options.filters = std::move(filters);
+        options.use_cache = false;  // Exercise the filter cache every time
+        std::vector<uint64_t> out;
+        for (const auto& result : engine.search(query, options)) out.push_back(result.document.id);
+        std::sort(out.begin(), out.end());
+        return out;
+    };
+
+    EXPECT_EQ(ids("laptop", {"tenant:globex", "lang:fr"}), (std::vector<uint64_t>{20, 40}));
+    EXPECT_EQ(ids("laptop", {"tenant:GLOBEX AND lang:fr"}), (std::vector<uint64_t>{20, 40}));
+    EXPECT_EQ(ids("review", {"lang:fr", "price:[0 TO 300]"}), (std::vector<uint64_t>{5, 10, 15, 20, 25, 30}));
+    EXPECT_EQ(ids("", {"lang:fr AND NOT tenant:acme"}), (std::vector<uint64_t>{10, 20, 30, 40}));  // Filter only
+    EXPECT_EQ(ids("laptop", {"price:80 OR price:120"}), (std::vector<uint64_t>{8, 12}));
+    EXPECT_TRUE(ids("laptop", {"laptop"}).empty());  // Not a filter clause
+    EXPECT_EQ(ids("laptop price:[100 TO 200]", {"tenant:globex"}), (std::vector<uint64_t>{12, 16, 20}));
+
+    // Filters do not change scores
+    SearchOptions filtered;
+    filtered.filters = {"tenant:globex"};
+    filtered.use_cache = false;
+    const auto plain = engine.search("laptop");
+    const auto restricted = engine.search("laptop", filtered);
+    ASSERT_FALSE(restricted.empty());
+    for (const auto& result : restricted) {
+        auto same = std::find_if(plain.begin(), plain.end(),
+                                 [&](const SearchResult& r) { return r.document.id == result.document.id; });
+        if (same != plain.end()) {
+            EXPECT_DOUBLE_EQ(same->score, result.score);
+        }
+    }
+
+    // Recurring clauses are served from the cache, and follow writes
+    const auto before = engine.getFilterCacheStats();
+    EXPECT_GT(before.current_size, 0u);
+    EXPECT_EQ(ids("laptop", {"tenant:globex", "lang:fr"}), (std::vector<uint64_t>{20, 40}));
+    EXPECT_GT(engine.getFilterCacheStats().hit_count, before.hit_count);
+    engine.updateDocument(40, Document{40, {{"content", "laptop review"}, {"tenant", "Acme"}, {"lang", "fr"}}});
+    EXPECT_EQ(ids("laptop", {"tenant:globex", "lang:fr"}), (std::vector<uint64_t>{20}));
+    EXPECT_GT(engine.getFilterCacheStats().refresh_count, 0u);
+    EXPECT_GT(engine.memoryUsage().filter_cache_bytes, 0u);
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "hyperloglog.hpp"
+
+#include <cmath>
+
+using namespace rtrv_search_engine;
+
+static double relativeError(uint64_t estimate, uint64_t actual) {
+    return std::fabs(static_cast<double>(estimate) - static_cast<double>(actual)) / static_cast<double>(actual);
+}
+
+static HyperLogLog sketchOf(uint64_t from, uint64_t to, uint8_t precision = 14) {
+    HyperLogLog sketch(precision);
+    for (uint64_t value = from; value < to; ++value) {
+        sketch.add(HyperLogLog::hashInteger(value));
+    }
+    return sketch;
+}
+
+TEST(HyperLogLogTest, SparseCountsAreNearExact) {
+    HyperLogLog sketch;
+    EXPECT_EQ(sketch.estimate(), 0u);
+    for (int round = 0; round < 3; ++round) {  // Duplicates change nothing
+        for (int i = 0; i < 3000; ++i) {
+            sketch.add(HyperLogLog::hashString("author-" + std::to_string(i)));
+        }
+    }
+    EXPECT_TRUE(sketch.sparse());
+    EXPECT_LE(relativeError(sketch.estimate(), 3000), 0.001);
+    EXPECT_LT(sketch.memoryUsage(), 2 * 16384u);  // Never far beyond the dense registers
+}
+
+TEST(HyperLogLogTest, DenseErrorWithinBounds) {
+    // Standard error at precision 14 is ~0.8%
+    for (uint64_t count : {20000u, 200000u, 2000000u}) {
+        const HyperLogLog sketch = sketchOf(0, count);
+        EXPECT_FALSE(sketch.sparse());
+        EXPECT_LE(relativeError(sketch.estimate(), count), 0.025) << count;
+    }
+    const HyperLogLog coarse = sketchOf(0, 100000, 10);
+    EXPECT_LE(relativeError(coarse.estimate(), 100000), 0.1);
+    EXPECT_LT(coarse.memoryUsage(), 2048u);
+}
+
+TEST(HyperLogLogTest, MergeEqualsSketchOfUnion) {
+    const HyperLogLog whole = sketchOf(0, 300000);
+
+    // Overlapping partitions, one still sparse
+    HyperLogLog merged = sketchOf(0, 200000);
+    merged.merge(sketchOf(150000, 300000));
+    merged.merge(sketchOf(299000, 300000));
+    EXPECT_EQ(merged.estimate(), whole.estimate());
+
+    HyperLogLog sparse_first = sketchOf(0, 500);
+    sparse_first.merge(sketchOf(0, 300000));
+    EXPECT_EQ(sparse_first.estimate(), whole.estimate());
+
+    HyperLogLog both_sparse = sketchOf(0, 1000);
+    both_sparse.merge(sketchOf(500, 2000));
+    EXPECT_TRUE(both_sparse.sparse());
+    EXPECT_EQ(both_sparse.estimate(), sketchOf(0, 2000).estimate());
+
+    // Different precisions: the lower one wins, as if built at it
+    HyperLogLog fine = sketchOf(0, 200000, 16);
+    fine.merge(sketchOf(150000, 300000, 12));
+    EXPECT_EQ(fine.precision(), 12);
+    EXPECT_EQ(fine.estimate(), sketchOf(0, 300000, 12).estimate());
+    HyperLogLog sparse_fine = sketchOf(0, 100, 16);
+    sparse_fine.merge(sketchOf(0, 300000, 12));
+    EXPECT_EQ(sparse_fine.estimate(), sketchOf(0, 300000, 12).estimate());
+}
+
+TEST(HyperLogLogTest, SerializeRoundTrips) {
+    for (uint64_t count : {0u, 700u, 100000u}) {
+        const HyperLogLog sketch = sketchOf(0, count, 12);
+        HyperLogLog restored;
+        ASSERT_TRUE(HyperLogLog::deserialize(sketch.serialize(), restored));
+        EXPECT_EQ(restored.precision(), 12);
+        EXPECT_EQ(restored.sparse(), sketch.sparse());
+        EXPECT_EQ(restored.estimate(), sketch.estimate());
+    }
+
+    HyperLogLog restored;
+    EXPECT_FALSE(HyperLogLog::deserialize({}, restored));
+    EXPECT_FALSE(HyperLogLog::deserialize({1, 30, 0}, restored));  // Precision out of range
+    auto truncated = sketchOf(0, 100000).serialize();
+    truncated.pop_back();
+    EXPECT_FALSE(HyperLogLog::deserialize(truncated, restored));
+    EXPECT_EQ(HyperLogLog::hashString("acme"), HyperLogLog::hashString("acme"));
+    EXPECT_NE(HyperLogLog::hashString("acme"), HyperLogLog::hashString("acmf"));
+}
@@ -408,3 +408,97 @@ TEST_F(InvertedIndexTest, SkipPointerAfterDocumentRemoval) {
     
     EXPECT_GT(result.size(), 0);
 }
+
+TEST_F(InvertedIndexTest, MemoryUsageBreakdown) {
+    MemoryUsage empty;
+    index.accumulateMemoryUsage(empty);
+    EXPECT_EQ(empty.posting_doc_id_bytes, 0u);
+    EXPECT_EQ(empty.posting_tf_bytes, 0u);
+    
+    for (uint64_t doc_id = 1; doc_id <= 100; ++doc_id) {
+        index.addTerm("common", doc_id, 1);
+        index.addTerm("common", doc_id, 2);
+    }
+    index.rebuildSkipPointers();
+    
+    MemoryUsage usage;
+    index.accumulateMemoryUsage(usage);
+    EXPECT_EQ(usage.posting_doc_id_bytes, 100 * sizeof(uint64_t));
+    EXPECT_EQ(usage.posting_tf_bytes, 100 * sizeof(uint32_t));
+    EXPECT_GE(usage.posting_position_bytes, 100 * 2 * sizeof(uint32_t));
+    EXPECT_EQ(usage.skip_data_bytes, 10 * sizeof(SkipPointer));
+    EXPECT_GT(usage.term_dictionary_bytes, 0u);
+    
+    // Removing documents shrinks the accounted postings
+    for (uint64_t doc_id = 1; doc_id <= 50; ++doc_id) {
+        index.removeDocument(doc_id);
+    }
+    MemoryUsage after_removal;
+    index.accumulateMemoryUsage(after_removal);
+    EXPECT_EQ(after_removal.posting_doc_id_bytes, 50 * sizeof(uint64_t));
+}
+
+TEST_F(InvertedIndexTest, AnalysisTracksListsIncrementally) {
+    // "common" in 8 docs (class 8-15), "rare" in 1 doc (class 1)
+    for (uint64_t doc_id = 1; doc_id <= 8; ++doc_id) {
+        index.addTerm("common", doc_id, 1);
+        index.addTerm("common", doc_id, 3);
+    }
+    index.addTerm("rare", 5, 2);
+    
+    auto analysis = index.analyze(1);
+    EXPECT_EQ(analysis.terms, 2u);
+    EXPECT_EQ(analysis.postings, 9u);
+    EXPECT_EQ(analysis.positions, 17u);
+    ASSERT_EQ(analysis.length_classes.size(), 2u);
+    EXPECT_EQ(analysis.length_classes[0].min_length, 1u);
+    EXPECT_EQ(analysis.length_classes[0].lists, 1u);
+    EXPECT_EQ(analysis.length_classes[1].min_length, 8u);
+    EXPECT_EQ(analysis.length_classes[1].max_length, 15u);
+    EXPECT_EQ(analysis.length_classes[1].postings, 8u);
+    ASSERT_EQ(analysis.longest_lists.size(), 1u);
+    EXPECT_EQ(analysis.longest_lists[0].term, "common");
+    EXPECT_EQ(analysis.longest_lists[0].postings, 8u);
+    
+    // 1-byte doc deltas, tfs and position deltas encode far below 12 B/posting
+    EXPECT_GT(analysis.compressionRatio(), 2.0);
+    EXPECT_GT(analysis.positionShare(), 0.0);
+    EXPECT_LT(analysis.positionShare(), 1.0);
+    
+    // Removing docs moves "common" down a class and drops "rare"
+    for (uint64_t doc_id = 5; doc_id <= 8; ++doc_id) {
+        index.removeDocument(doc_id);
+    }
+    analysis = index.analyze(5);
+    EXPECT_EQ(analysis.terms, 1u);
+    EXPECT_EQ(analysis.postings, 4u);
+    EXPECT_EQ(analysis.positions, 8u);
+    ASSERT_EQ(analysis.length_classes.size(), 1u);
+    EXPECT_EQ(analysis.length_classes[0].min_length, 4u);
+    ASSERT_EQ(analysis.longest_lists.size(), 1u);
+    EXPECT_EQ(analysis.longest_lists[0].postings, 4u);
+    
+    index.clear();
+    EXPECT_TRUE(index.analyze().length_classes.empty());
+}
+
+TEST_F(InvertedIndexTest, SkipStatisticsCountJumps) {
+    for (uint64_t doc_id = 1; doc_id <= 1000; ++doc_id) {
+        index.addTerm("dense", doc_id);
+    }
+    index.addTerm("sparse", 500);
+    index.addTerm("sparse", 999);
+    
+    PostingList dense = index.getPostingList("dense");
+    PostingList sparse = index.getPostingList("sparse");
+    
+    resetSkipStatistics();
+    auto result = intersectWithSkips(dense, sparse);
+    ASSERT_EQ(result.size(), 2u);
+    
+    auto stats = skipStatistics();
+    EXPECT_EQ(stats.intersections, 1u);
+    EXPECT_GT(stats.skips_taken, 0u);
+    EXPECT_GT(stats.postings_skipped, stats.postings_scanned);
+    EXPECT_GT(stats.skippedFraction(), 0.5);
+}
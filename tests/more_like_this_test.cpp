@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include "search_engine.hpp"
+#include <cmath>
+#include <map>
+
+using namespace rtrv_search_engine;
+
+using Ids = std::vector<uint64_t>;
+
+namespace {
+
+Ids idsOf(const std::vector<SearchResult>& results) {
+    Ids ids;
+    for (const auto& result : results) ids.push_back(result.document.id);
+    return ids;
+}
+
+// Documents of 5-40 words over a skewed vocabulary (low w<n> are common)
+std::vector<Document> randomCorpus(size_t count, uint64_t seed) {
+    uint64_t state = seed;
+    const auto next = [&](uint64_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 33) % bound;
+    };
+    std::vector<Document> docs;
+    for (uint32_t id = 1; id <= count; ++id) {
+        std::string text;
+        const size_t words = 5 + next(36);
+        for (size_t w = 0; w < words; ++w) text += "w" + std::to_string(next(1 + next(200))) + " ";
+        docs.push_back(Document{id, {{"content", text}}});
+    }
+    return docs;
+}
+
+}  // namespace
+
+TEST(MoreLikeThisTest, SelectsTopTfIdfTermsWithinFrequencyLimits) {
+    SearchEngine engine;
+    engine.indexDocument(Document{1, {{"content", "the solar solar solar panel panel inverter unique"}}});
+    engine.indexDocument(Document{2, {{"content", "the solar panel roof"}}});
+    engine.indexDocument(Document{3, {{"content", "the inverter warranty"}}});
+    engine.indexDocument(Document{4, {{"content", "the garden hose"}}});
+
+    // "unique" is only in the source, "the" in every document
+    const auto terms = engine.moreLikeThisTerms(1);
+    ASSERT_EQ(terms.size(), 3u);
+    EXPECT_EQ(terms[0].first, "solar");  // tf 3, df 2
+    EXPECT_DOUBLE_EQ(terms[0].second, 1.0);
+    EXPECT_EQ(terms[1].first, "panel");  // tf 2, df 2
+    EXPECT_EQ(terms[2].first, "inverter");
+    EXPECT_NEAR(terms[2].second, std::log(2.0) / std::log(4.0), 1e-12);
+
+    MoreLikeThisOptions options;
+    options.max_query_terms = 2;
+    options.min_term_freq = 2;
+    options.boost_terms = false;
+    const auto limited = engine.moreLikeThisTerms(1, options);
+    ASSERT_EQ(limited.size(), 2u);
+    EXPECT_EQ(limited[1].first, "panel");
+    EXPECT_DOUBLE_EQ(limited[1].second, 1.0);
+
+    EXPECT_EQ(idsOf(engine.moreLikeThis(1)), (Ids{2, 3}));
+    EXPECT_TRUE(engine.moreLikeThis(1, 0).empty());
+    EXPECT_TRUE(engine.moreLikeThis(4).empty());   // Nothing it shares passes the limits
+    EXPECT_TRUE(engine.moreLikeThis(99).empty());
+}
+
+TEST(MoreLikeThisTest, ScoresAreBm25OfTheWeightedTerms) {
+    SearchEngine engine;
+    const auto docs = randomCorpus(300, 3);
+    engine.indexDocuments(docs);
+    Tokenizer tokenizer;
+    const auto* index = engine.getIndex();
+    const double total_docs = static_cast<double>(docs.size());
+    const double avg_length = engine.getStats().avg_doc_length;
+
+    for (uint64_t source : {1, 17, 123, 250}) {
+        // Reference: every document scored, best first, ties by id
+        std::map<uint64_t, double> scores;
+        for (const auto& [term, boost] : engine.moreLikeThisTerms(source)) {
+            const double df = static_cast<double>(index->getDocumentFrequency(term));
+            const double idf = std::log((total_docs - df + 0.5) / (df + 0.5) + 1.0);
+            for (const auto& posting : index->getPostings(term)) {
+                if (posting.doc_id == source) continue;
+                const double length = tokenizer.tokenizeWithPositions(docs[posting.doc_id - 1].getAllText()).size();
+                const double tf = posting.term_frequency;
+                scores[posting.doc_id] += boost * idf * tf * 2.5 / (tf + 1.5 * (0.25 + 0.75 * length / avg_length));
+            }
+        }
+        std::vector<std::pair<double, uint64_t>> ranked;
+        for (const auto& [id, score] : scores) ranked.emplace_back(-score, id);
+        std::sort(ranked.begin(), ranked.end());
+
+        for (size_t k : {1, 5, 20}) {
+            const auto results = engine.moreLikeThis(source, k);
+            ASSERT_EQ(results.size(), std::min(k, ranked.size()));
+            for (size_t i = 0; i < results.size(); ++i) {
+                EXPECT_NEAR(results[i].score, -ranked[i].first, 1e-9) << "source " << source << " rank " << i;
+                if (i + 1 < ranked.size() && std::abs(ranked[i].first - ranked[i + 1].first) > 1e-9) {
+                    EXPECT_EQ(results[i].document.id, ranked[i].second) << "source " << source << " rank " << i;
+                }
+            }
+        }
+    }
+}
+
+TEST(MoreLikeThisTest, StoredTermVectorsMatchRetokenizing) {
+    SearchEngine stored;
+    SearchEngine retokenized;
+    stored.setStoreTermVectors(true);
+    EXPECT_TRUE(stored.storesTermVectors());
+    const auto docs = randomCorpus(200, 9);
+    stored.indexDocuments(docs);
+    retokenized.indexDocuments(docs);
+    EXPECT_GT(stored.memoryUsage().document_store_bytes, retokenized.memoryUsage().document_store_bytes);
+
+    // Writes after indexing keep the vectors current
+    const Document replacement{5, {{"content", "w1 w2 w3 w3 w40 w40 w40"}}};
+    stored.updateDocument(5, replacement);
+    retokenized.updateDocument(5, replacement);
+    stored.deleteDocument(6);
+    retokenized.deleteDocument(6);
+
+    for (uint64_t source = 1; source <= 200; source += 7) {
+        const auto expected = retokenized.moreLikeThis(source, 10);
+        const auto results = stored.moreLikeThis(source, 10);
+        ASSERT_EQ(idsOf(results), idsOf(expected)) << "source " << source;
+        for (size_t i = 0; i < results.size(); ++i) {
+            EXPECT_DOUBLE_EQ(results[i].score, expected[i].score);
+        }
+    }
+    EXPECT_TRUE(stored.moreLikeThis(6).empty());
+
+    stored.setStoreTermVectors(false);  // Falls back to tokenizing
+    EXPECT_EQ(idsOf(stored.moreLikeThis(5, 10)), idsOf(retokenized.moreLikeThis(5, 10)));
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include "percolator.hpp"
+#include "search_engine.hpp"
+
+using namespace rtrv_search_engine;
+
+using Ids = std::vector<uint64_t>;
+
+static Document makeDoc(const std::string& title, const std::string& body,
+                        std::vector<std::pair<std::string, std::string>> extra = {}) {
+    Document doc{0, {{"title", title}, {"body", body}}};
+    for (auto& [field, value] : extra) doc.fields[field] = value;
+    return doc;
+}
+
+TEST(PercolatorTest, StoredQueriesMatchWithBooleanSemantics) {
+    SearchEngine engine;
+    engine.defineField("brand", FieldType::KEYWORD);
+    engine.defineField("price", FieldType::DOUBLE);
+    const std::vector<std::string> queries = {
+        "laptop",                          // 1
+        "laptop AND charger",              // 2
+        "tablet OR charger",               // 3
+        "laptop NOT refurbished",          // 4
+        "\"usb charger\"",                 // 5
+        "\"usb charger\"~2",               // 6
+        "title:laptop",                    // 7
+        "brand:acme",                      // 8
+        "price:[10 TO 100]",               // 9
+        "price:{49.99 TO *] OR brand:zeta", // 10
+        "NOT refurbished",                 // 11
+        "Laptops laptop",                  // 12: implicit AND, analyzed like documents
+    };
+    for (size_t i = 0; i < queries.size(); ++i) {
+        EXPECT_TRUE(engine.registerQuery(i + 1, queries[i])) << queries[i];
+    }
+    EXPECT_FALSE(engine.registerQuery(99, "   "));
+    EXPECT_EQ(engine.registeredQueries(), queries.size());
+
+    const Document doc = makeDoc("Acme notebook", "A light laptop with a usb fast wall charger",
+                                 {{"brand", "ACME"}, {"price", "49.99"}});
+    EXPECT_EQ(engine.percolate(doc), (Ids{1, 2, 3, 4, 6, 8, 9, 11}));
+
+    const Document refurbished = makeDoc("Refurbished laptop", "usb charger included", {{"brand", "Zeta"}});
+    EXPECT_EQ(engine.percolate(refurbished), (Ids{1, 2, 3, 5, 6, 7, 10}));
+
+    // Replace, remove
+    EXPECT_TRUE(engine.registerQuery(1, "tablet"));
+    EXPECT_TRUE(engine.unregisterQuery(2));
+    EXPECT_FALSE(engine.unregisterQuery(2));
+    EXPECT_EQ(engine.percolate(refurbished), (Ids{3, 5, 6, 7, 10}));
+    EXPECT_GT(engine.memoryUsage().percolator_bytes, 0u);
+}
+
+TEST(PercolatorTest, RemovingQueriesFreesTheirTerms) {
+    SearchEngine engine;
+    engine.defineField("brand", FieldType::KEYWORD);
+    EXPECT_TRUE(engine.registerQuery(1, "laptop AND brand:acme"));
+    EXPECT_TRUE(engine.registerQuery(2, "\"usb charger\" OR tablet"));
+    const size_t baseline = engine.memoryUsage().percolator_bytes;
+
+    // Alert churn: every round stores queries over new terms, then drops them
+    size_t after_first_round = 0;
+    for (uint64_t round = 0; round < 5; ++round) {
+        for (uint64_t i = 0; i < 200; ++i) {
+            const std::string word = "w" + std::to_string(round) + "x" + std::to_string(i);
+            EXPECT_TRUE(engine.registerQuery(100 + i, word + " \"" + word + " laptop\" brand:" + word));
+        }
+        EXPECT_GT(engine.memoryUsage().percolator_bytes, baseline);
+        for (uint64_t i = 0; i < 200; ++i) {
+            EXPECT_TRUE(engine.unregisterQuery(100 + i));
+        }
+        const size_t usage = engine.memoryUsage().percolator_bytes;
+        if (round == 0) {
+            after_first_round = usage;
+        }
+        EXPECT_EQ(usage, after_first_round) << "round " << round;
+    }
+    // Only hash buckets are kept beyond the earlier level
+    EXPECT_LT(after_first_round - baseline, 8 * 1024u);
+
+    // Shared terms stay as long as a query names them
+    const Document doc = makeDoc("Acme laptop", "usb charger", {{"brand", "acme"}});
+    EXPECT_EQ(engine.percolate(doc), (Ids{1, 2}));
+    EXPECT_TRUE(engine.unregisterQuery(1));
+    EXPECT_EQ(engine.percolate(doc), (Ids{2}));
+    EXPECT_TRUE(engine.registerQuery(3, "brand:acme"));
+    EXPECT_EQ(engine.percolate(doc), (Ids{2, 3}));
+}
+
+TEST(PercolatorTest, PrefilterVerifiesOnlyCandidates) {
+    SearchEngine engine;
+    for (uint32_t id = 1; id <= 50; ++id) {
+        engine.indexDocument(Document{id, {{"content", "daily market news"}}});
+    }
+    // "news" is in every indexed document: the rare word is the pre-filter term
+    for (uint64_t id = 1; id <= 1000; ++id) {
+        ASSERT_TRUE(engine.registerQuery(id, "news AND ticker" + std::to_string(id)));
+    }
+    ASSERT_TRUE(engine.registerQuery(5000, "NOT sports"));  // Checked for every document
+
+    PercolateStats stats;
+    EXPECT_EQ(engine.percolate(Document{0, {{"content", "news about ticker42"}}}, &stats), (Ids{42, 5000}));
+    EXPECT_EQ(stats.candidates, 2u);
+    EXPECT_EQ(stats.matches, 2u);
+    EXPECT_EQ(engine.percolate(Document{0, {{"content", "ticker7 sports"}}}, &stats), Ids{});
+    EXPECT_EQ(stats.candidates, 2u);
+}
+
+TEST(PercolatorTest, PrefilterAgreesWithExhaustiveVerification) {
+    Tokenizer tokenizer;
+    DocValues schema;
+    schema.defineField("lang", FieldType::KEYWORD);
+    schema.defineField("year", FieldType::INT64);
+    const Percolator::Context context{tokenizer, schema, nullptr};
+
+    uint64_t state = 7;
+    const auto next = [&](uint64_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 33) % bound;
+    };
+    const auto word = [&] { return "w" + std::to_string(next(30)); };
+    std::function<std::string(int)> query = [&](int depth) -> std::string {
+        switch (depth > 2 ? next(5) : next(9)) {
+            case 0: case 1: return word();
+            case 2: return "\"" + word() + " " + word() + "\"" + (next(2) ? "~3" : "");
+            case 3: return "lang:" + std::string(next(2) ? "en" : "de");
+            case 4: return "year:[" + std::to_string(2000 + next(20)) + " TO " + std::to_string(2010 + next(20)) + "]";
+            case 5: return "(" + query(depth + 1) + " AND " + query(depth + 1) + ")";
+            case 6: return "(" + query(depth + 1) + " OR " + query(depth + 1) + ")";
+            case 7: return "(" + query(depth + 1) + " AND NOT " + query(depth + 1) + ")";
+            default: return query(depth + 1) + " " + query(depth + 1);
+        }
+    };
+
+    Percolator percolator;
+    for (uint64_t id = 1; id <= 600; ++id) {
+        ASSERT_TRUE(percolator.addQuery(id, query(0), context));
+    }
+    for (uint64_t id = 1; id <= 600; id += 7) {
+        ASSERT_TRUE(percolator.removeQuery(id));  // Moves other queries between slots
+    }
+    EXPECT_EQ(percolator.size(), 600u - 86u);
+
+    size_t matched = 0;
+    for (int i = 0; i < 200; ++i) {
+        std::string text;
+        for (int w = 0; w < 12; ++w) text += word() + " ";
+        const Document doc{0, {{"content", text}, {"lang", next(2) ? "EN" : "de"}, {"year", std::to_string(2000 + next(30))}}};
+        PercolateStats stats;
+        const auto ids = percolator.percolate(doc, context, &stats);
+        ASSERT_EQ(ids, percolator.percolateExhaustive(doc, context)) << text;
+        EXPECT_LT(stats.candidates, percolator.size());
+        matched += ids.size();
+    }
+    EXPECT_GT(matched, 0u);
+}
+
+TEST(PercolatorTest, SchemaChangesRecompileQueries) {
+    SearchEngine engine;
+    ASSERT_TRUE(engine.registerQuery(1, "price:[10 TO 100]"));
+    ASSERT_TRUE(engine.registerQuery(2, "sku:\"AB CD\""));
+    const Document doc{0, {{"price", "42"}, {"sku", "ab-cd"}}};
+    EXPECT_EQ(engine.percolate(doc), (Ids{2}));  // Untyped: no range; sku matches as text
+
+    engine.defineField("price", FieldType::INT64);
+    engine.defineField("sku", FieldType::KEYWORD);
+    EXPECT_EQ(engine.percolate(doc), (Ids{1, 2}));
+    EXPECT_EQ(engine.percolate(Document{0, {{"price", "420"}, {"sku", "ab cd x"}}}), Ids{});
+}
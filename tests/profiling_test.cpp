@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "profiling.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+using namespace rtrv_search_engine;
+
+static const LockSiteStats& cacheLockStats() {
+    return profiling::threadProfile().locks[static_cast<size_t>(LockSite::QUERY_CACHE)];
+}
+
+TEST(ProfilingTest, CountsUncontendedAcquisitions) {
+    InstrumentedSharedMutex<LockSite::QUERY_CACHE> mutex;
+    profiling::resetThreadProfile();
+
+    { std::unique_lock lock(mutex); }
+    { std::shared_lock lock(mutex); }
+    EXPECT_TRUE(mutex.try_lock_shared());
+    mutex.unlock_shared();
+
+    EXPECT_EQ(cacheLockStats().acquisitions, 3u);
+    EXPECT_EQ(cacheLockStats().contended, 0u);
+    EXPECT_EQ(cacheLockStats().wait_ns, 0u);
+}
+
+TEST(ProfilingTest, RecordsWaitTimeOfBlockedThread) {
+    InstrumentedSharedMutex<LockSite::QUERY_CACHE> mutex;
+    std::unique_lock writer(mutex);
+
+    LockSiteStats reader_stats;
+    std::thread reader([&]() {
+        profiling::resetThreadProfile();
+        { std::shared_lock lock(mutex); }
+        reader_stats = cacheLockStats();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    writer.unlock();
+    reader.join();
+
+    EXPECT_EQ(reader_stats.acquisitions, 1u);
+    EXPECT_EQ(reader_stats.contended, 1u);
+    EXPECT_GE(reader_stats.wait_ns, 10'000'000u);
+}
+
+TEST(ProfilingTest, MergesThreadProfiles) {
+    ThreadProfile total;
+    ThreadProfile thread;
+    thread.locks[static_cast<size_t>(LockSite::SEARCH_ENGINE)].wait_ns = 100;
+    thread.allocations = 3;
+    thread.allocated_bytes = 64;
+
+    total += thread;
+    total += thread;
+
+    EXPECT_EQ(total.locks[static_cast<size_t>(LockSite::SEARCH_ENGINE)].wait_ns, 200u);
+    EXPECT_EQ(total.allocations, 6u);
+    EXPECT_EQ(total.allocated_bytes, 128u);
+    EXPECT_STREQ(profiling::lockSiteName(LockSite::INVERTED_INDEX), "inverted_index");
+}
+
+#ifdef RTRV_PROFILING
+TEST(ProfilingTest, CountsOverAlignedAllocations) {
+    struct alignas(64) Block {
+        float lanes[16];
+    };
+    profiling::resetThreadProfile();
+    auto* block = new Block;
+    auto* blocks = new Block[3];
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(blocks) % 64, 0u);
+    delete block;
+    delete[] blocks;
+
+    EXPECT_EQ(profiling::threadProfile().allocations, 2u);
+    EXPECT_GE(profiling::threadProfile().allocated_bytes, 4 * sizeof(Block));
+}
+#endif
@@ -245,3 +245,41 @@ TEST_F(QueryParserTest, ComplexQuery) {
     std::string str = node->toString();
     EXPECT_FALSE(str.empty());
 }
+
+TEST_F(QueryParserTest, RangeQuery) {
+    auto node = parser.parse("laptop AND price:[10 TO 100] AND createdAt:{2024-01-01T00:00:00Z TO *]");
+    ASSERT_NE(node, nullptr);
+    auto* and_node = dynamic_cast<AndNode*>(node.get());
+    ASSERT_NE(and_node, nullptr);
+    ASSERT_EQ(and_node->children.size(), 3);
+
+    auto* price = dynamic_cast<RangeNode*>(and_node->children[1].get());
+    ASSERT_NE(price, nullptr);
+    EXPECT_EQ(price->field_name, "price");
+    EXPECT_EQ(price->lower, "10");
+    EXPECT_EQ(price->upper, "100");
+    EXPECT_TRUE(price->include_lower);
+    EXPECT_TRUE(price->include_upper);
+
+    auto* created = dynamic_cast<RangeNode*>(and_node->children[2].get());
+    ASSERT_NE(created, nullptr);
+    EXPECT_EQ(created->field_name, "createdAt");  // Field case is kept for ranges
+    EXPECT_EQ(created->lower, "2024-01-01T00:00:00Z");
+    EXPECT_TRUE(created->upper.empty());
+    EXPECT_FALSE(created->include_lower);
+    EXPECT_EQ(created->toString(), "createdAt:{2024-01-01T00:00:00Z TO *]");
+
+    // Range clauses are filters, not scored terms
+    auto terms = parser.extractTerms("laptop price:[10 TO 100] cheap");
+    ASSERT_EQ(terms.size(), 2);
+    EXPECT_EQ(terms[0], "laptop");
+    EXPECT_EQ(terms[1], "cheap");
+
+    // Brackets that do not follow `field:`, or are never closed, only split words
+    EXPECT_EQ(parser.extractTerms("array[0]"), (std::vector<std::string>{"array", "0"}));
+    EXPECT_EQ(parser.extractTerms("{draft} notes"), (std::vector<std::string>{"draft", "notes"}));
+    EXPECT_EQ(parser.extractTerms("price:[10 TO"), (std::vector<std::string>{"price", "10", "to"}));
+
+    // Malformed range falls back to a single term
+    EXPECT_EQ(parser.parse("price:[10 100]")->getType(), QueryNode::Type::TERM);
+}
@@ -188,3 +188,45 @@ TEST_F(RankerTest, Bm25LengthNormalization) {
     EXPECT_GT(bm25_ratio, 1.0);  // BM25 favors shorter doc
     EXPECT_LT(tfidf_ratio, bm25_ratio);  // TF-IDF less sensitive to length
 }
+
+TEST_F(RankerTest, HybridFusion) {
+    // Doc 2 is second on both sides, doc 1 and doc 3 top only one each
+    std::vector<ScoredDocument> lexical = {{1, 9.0}, {2, 5.0}, {4, 1.0}};
+    std::vector<ScoredDocument> vector = {{3, 0.95}, {2, 0.90}, {5, 0.10}};
+    
+    HybridRanker rrf;
+    auto fused = rrf.fuse(lexical, vector, 10);
+    ASSERT_EQ(fused.size(), 5u);
+    EXPECT_EQ(fused[0].doc_id, 2u);
+    EXPECT_DOUBLE_EQ(fused[0].score, 2.0 / 62.0);
+    EXPECT_EQ(fused[0].lexical_rank, 2u);
+    EXPECT_EQ(fused[0].vector_rank, 2u);
+    EXPECT_EQ(fused[1].doc_id, 1u);  // Tie with doc 3 broken by doc id
+    EXPECT_EQ(fused[1].vector_rank, 0u);
+    EXPECT_EQ(fused[2].doc_id, 3u);
+    EXPECT_EQ(rrf.fuse(lexical, vector, 2).size(), 2u);
+    
+    // Weighted: min-max normalized, so lexical 9 -> 1.0, vector 0.90 -> ~0.94
+    FusionParams params;
+    params.method = FusionMethod::WEIGHTED;
+    params.lexical_weight = 0.3;
+    params.vector_weight = 0.7;
+    HybridRanker weighted("Weighted", params);
+    fused = weighted.fuse(lexical, vector, 10);
+    ASSERT_EQ(fused.size(), 5u);
+    EXPECT_EQ(fused[0].doc_id, 2u);
+    EXPECT_EQ(fused[1].doc_id, 3u);
+    EXPECT_NEAR(fused[1].score, 0.7, 1e-9);
+    EXPECT_EQ(fused.back().score, 0.0);
+    
+    // Without a vector side it ranks like BM25
+    Document doc(1, {{"content", "quick brown fox"}});
+    doc.term_count = 3;
+    Query query;
+    query.terms = {"fox"};
+    IndexStats stats;
+    stats.total_docs = 10;
+    stats.avg_doc_length = 3.0;
+    stats.doc_frequency["fox"] = 2;
+    EXPECT_DOUBLE_EQ(rrf.score(query, doc, stats), bm25_ranker.score(query, doc, stats));
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "relevance_metrics.hpp"
+#include <cmath>
+#include <sstream>
+
+using namespace rtrv_search_engine;
+
+TEST(RelevanceMetricsTest, ParseTrecQrels) {
+    std::istringstream input(
+        "q1 0 10 2\n"
+        "q1 0 11 0\n"
+        "q2 0 20 1\n"
+        "\n"
+        "q2 0 doc-abc 1\n");   // Non-numeric doc id is skipped
+
+    Qrels qrels = relevance::parseTrecQrels(input);
+
+    ASSERT_EQ(qrels.size(), 2u);
+    EXPECT_EQ(qrels["q1"].size(), 2u);
+    EXPECT_EQ(qrels["q1"][10], 2);
+    EXPECT_EQ(relevance::relevantCount(qrels["q1"]), 1u);
+    EXPECT_EQ(qrels["q2"].size(), 1u);
+}
+
+TEST(RelevanceMetricsTest, LoadMissingQrelsThrows) {
+    EXPECT_THROW(relevance::loadTrecQrels("/nonexistent/qrels.txt"), std::runtime_error);
+}
+
+TEST(RelevanceMetricsTest, NdcgAtK) {
+    Judgments judgments{{1, 3}, {2, 2}, {3, 1}};
+
+    // Ideal order scores 1.0
+    EXPECT_DOUBLE_EQ(relevance::ndcgAtK({1, 2, 3}, judgments, 10), 1.0);
+
+    // Reversed order: DCG = 1 + 3/log2(3) + 7/2, IDCG = 7 + 3/log2(3) + 1/2
+    const double expected = (1.0 + 3.0 / std::log2(3.0) + 3.5) / (7.0 + 3.0 / std::log2(3.0) + 0.5);
+    EXPECT_NEAR(relevance::ndcgAtK({3, 2, 1}, judgments, 10), expected, 1e-12);
+
+    // Unjudged documents contribute no gain; no relevant docs gives 0
+    EXPECT_LT(relevance::ndcgAtK({99, 1, 2, 3}, judgments, 10), 1.0);
+    EXPECT_DOUBLE_EQ(relevance::ndcgAtK({1}, Judgments{{1, 0}}, 10), 0.0);
+}
+
+TEST(RelevanceMetricsTest, ReciprocalRankAndRecall) {
+    Judgments judgments{{5, 1}, {7, 1}, {9, 0}};
+
+    EXPECT_DOUBLE_EQ(relevance::reciprocalRank({9, 8, 7}, judgments), 1.0 / 3.0);
+    EXPECT_DOUBLE_EQ(relevance::reciprocalRank({1, 2}, judgments), 0.0);
+
+    EXPECT_DOUBLE_EQ(relevance::recallAtK({5, 9, 7}, judgments, 2), 0.5);
+    EXPECT_DOUBLE_EQ(relevance::recallAtK({5, 9, 7}, judgments, 3), 1.0);
+}
+
+TEST(RelevanceMetricsTest, RankBiasedOverlap) {
+    EXPECT_NEAR(relevance::rankBiasedOverlap({1, 2, 3, 4}, {1, 2, 3, 4}), 1.0, 1e-12);
+    EXPECT_DOUBLE_EQ(relevance::rankBiasedOverlap({1, 2, 3}, {4, 5, 6}), 0.0);
+    EXPECT_DOUBLE_EQ(relevance::rankBiasedOverlap({}, {}), 1.0);
+
+    // Swapping the top two hurts more than swapping the bottom two
+    const double top_swap = relevance::rankBiasedOverlap({2, 1, 3, 4}, {1, 2, 3, 4});
+    const double bottom_swap = relevance::rankBiasedOverlap({1, 2, 4, 3}, {1, 2, 3, 4});
+    EXPECT_LT(top_swap, bottom_swap);
+    EXPECT_LT(bottom_swap, 1.0);
+
+    // Missing results count as disagreement
+    EXPECT_LT(relevance::rankBiasedOverlap({1, 2}, {1, 2, 3, 4}), 1.0);
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include "sampling_profiler.hpp"
+
+#include <cmath>
+#include <ctime>
+#include <sstream>
+#include <string>
+
+using namespace rtrv_search_engine;
+
+// Spin for `seconds` of process CPU time (ITIMER_PROF only ticks on CPU time)
+static double burnCpu(double seconds) {
+    const std::clock_t begin = std::clock();
+    volatile double sink = 0.0;
+    while (static_cast<double>(std::clock() - begin) / CLOCKS_PER_SEC < seconds) {
+        for (int i = 1; i < 10000; ++i) {
+            sink = sink + std::sqrt(static_cast<double>(i));
+        }
+    }
+    return sink;
+}
+
+TEST(SamplingProfilerTest, OneSessionAtATime) {
+    if (!SamplingProfiler::supported()) {
+        GTEST_SKIP() << "Sampling profiler not supported on this platform";
+    }
+
+    EXPECT_FALSE(SamplingProfiler::isRunning());
+    ASSERT_TRUE(SamplingProfiler::start());
+    EXPECT_TRUE(SamplingProfiler::isRunning());
+    EXPECT_FALSE(SamplingProfiler::start());
+
+    SamplingProfiler::stop();
+    EXPECT_FALSE(SamplingProfiler::isRunning());
+
+    auto again = SamplingProfiler::stop();
+    EXPECT_EQ(again.samples, 0u);
+    EXPECT_TRUE(again.folded_stacks.empty());
+}
+
+TEST(SamplingProfilerTest, FoldsSampledStacks) {
+    if (!SamplingProfiler::supported()) {
+        GTEST_SKIP() << "Sampling profiler not supported on this platform";
+    }
+
+    ASSERT_TRUE(SamplingProfiler::start(500));
+    burnCpu(0.3);
+    auto result = SamplingProfiler::stop();
+
+    ASSERT_GT(result.samples, 0u);
+    EXPECT_EQ(result.dropped, 0u);
+
+    // "frame;frame;frame <count>" per line; counts add up to the samples
+    std::istringstream lines(result.folded_stacks);
+    std::string line;
+    size_t total = 0;
+    while (std::getline(lines, line)) {
+        const size_t space = line.find_last_of(' ');
+        ASSERT_NE(space, std::string::npos) << line;
+        ASSERT_GT(space, 0u) << line;
+        total += std::stoul(line.substr(space + 1));
+    }
+    EXPECT_EQ(total, result.samples);
+}
@@ -188,6 +188,40 @@ TEST_F(SearchEngineTest, Statistics) {
     EXPECT_LE(stats2.avg_doc_length, 5.0);
 }
 
+TEST_F(SearchEngineTest, MemoryUsageBreakdown) {
+    auto empty = engine.memoryUsage();
+    EXPECT_EQ(empty.posting_doc_id_bytes, 0u);
+    EXPECT_EQ(empty.query_cache_bytes, 0u);
+    
+    for (int i = 0; i < 20; ++i) {
+        Document doc{0, std::unordered_map<std::string, std::string>{
+            {"title", "memory accounting " + std::to_string(i)},
+            {"content", "per structure breakdown of the inverted index and document store"}}};
+        engine.indexDocument(doc);
+    }
+    
+    auto indexed = engine.memoryUsage();
+    EXPECT_GT(indexed.term_dictionary_bytes, 0u);
+    EXPECT_GT(indexed.posting_doc_id_bytes, 0u);
+    EXPECT_GT(indexed.posting_tf_bytes, 0u);
+    EXPECT_GT(indexed.posting_position_bytes, 0u);
+    EXPECT_GT(indexed.document_store_bytes, 0u);
+    EXPECT_EQ(indexed.fuzzy_index_bytes, 0u);
+    EXPECT_EQ(indexed.query_cache_bytes, 0u);
+    EXPECT_GT(indexed.totalBytes(), empty.totalBytes());
+    
+    // Searching populates the cache and (with fuzzy) the n-gram index
+    SearchOptions options;
+    options.fuzzy_enabled = true;
+    engine.search("acounting", options);
+    auto searched = engine.memoryUsage();
+    EXPECT_GT(searched.query_cache_bytes, 0u);
+    EXPECT_GT(searched.fuzzy_index_bytes, 0u);
+    
+    engine.clearCache();
+    EXPECT_LT(engine.memoryUsage().query_cache_bytes, searched.query_cache_bytes);
+}
+
 TEST_F(SearchEngineTest, QueryCacheIntegration) {
     Document doc1{0, std::unordered_map<std::string, std::string>{{"content", "cache test content"}}};
     engine.indexDocument(doc1);
@@ -201,6 +201,77 @@ TEST_F(SnippetExtractorTest, SnippetMultipleTermsHighlighted) {
     EXPECT_NE(snippets[0].find("<mark>intelligence</mark>"), std::string::npos);
 }
 
+TEST_F(SnippetExtractorTest, SnippetFromOffsetsPicksDensestWindow) {
+    std::string text;
+    for (int i = 0; i < 10; ++i) text += "filler words here. ";
+    const uint32_t lone = static_cast<uint32_t>(text.size());
+    text += "fox then ";
+    for (int i = 0; i < 10; ++i) text += "filler words here. ";
+    const uint32_t pair = static_cast<uint32_t>(text.size());
+    text += "fox and fox together. ";
+    for (int i = 0; i < 10; ++i) text += "filler words here. ";
+
+    std::vector<TermOffset> matches = {{lone, lone + 3}, {pair, pair + 3}, {pair + 8, pair + 11}};
+    SnippetOptions opts;
+    opts.max_snippet_length = 60;
+    opts.num_snippets = 1;
+
+    auto snippets = extractor.generateSnippetsFromOffsets(text, matches, opts);
+    ASSERT_EQ(snippets.size(), 1u);
+    EXPECT_NE(snippets[0].find("<mark>fox</mark> and <mark>fox</mark>"), std::string::npos) << snippets[0];
+    EXPECT_EQ(snippets[0].substr(0, 3), "...");
+    EXPECT_EQ(snippets[0].substr(snippets[0].size() - 3), "...");
+}
+
+TEST_F(SnippetExtractorTest, SnippetFromOffsetsMatchesTextScan) {
+    std::string text = "Machine learning is a branch of machine intelligence";
+    std::vector<TermOffset> matches = {{0, 7}, {32, 39}};
+
+    EXPECT_EQ(extractor.generateSnippetsFromOffsets(text, matches),
+              extractor.generateSnippets(text, {"machine"}));
+    EXPECT_EQ(extractor.generateSnippetsFromOffsets(text, {}),
+              std::vector<std::string>{text});
+}
+
+// ---- TermMatcher tests ----
+
+TEST(TermMatcherTest, MatchesWholeWordsCaseInsensitively) {
+    TermMatcher matcher({"fox", "DOG"});
+    std::string out;
+    matcher.highlight("Fox, foxes and the dog's dog.", "[", "]", out);
+    EXPECT_EQ(out, "[Fox], foxes and the dog's [dog].");
+}
+
+TEST(TermMatcherTest, PrefersLeftmostLongestMatch) {
+    TermMatcher matcher({"machine", "machine learning", "learning systems"});
+    std::vector<TermOffset> matches;
+    matcher.findMatches("machine learning systems", matches);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].start, 0u);
+    EXPECT_EQ(matches[0].end, 16u);
+}
+
+TEST(TermMatcherTest, PrefixModeExtendsToWordEnd) {
+    TermMatcher matcher({"jump"}, true);
+    std::vector<TermOffset> matches;
+    matcher.findMatches("Jumping, unjumped, jump", matches);
+    ASSERT_EQ(matches.size(), 2u);
+    EXPECT_EQ(matches[0].end, 7u);
+    EXPECT_EQ(matches[1].start, 19u);
+    EXPECT_TRUE(TermMatcher({"", ""}).empty());
+}
+
+TEST(TermMatcherTest, GivesEveryByteValueItsOwnClass) {
+    std::vector<std::string> terms;
+    for (int byte = 1; byte < 256; ++byte) terms.push_back(std::string(1, static_cast<char>(byte)) + "z");
+    TermMatcher matcher(terms);
+    std::vector<TermOffset> matches;
+    matcher.findMatches("\xfe" "z \xfd" "y", matches);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].start, 0u);
+    EXPECT_EQ(matches[0].end, 2u);
+}
+
 // =============================================================================
 // Integration tests: SearchEngine with snippet generation
 // =============================================================================
@@ -302,6 +373,71 @@ TEST_F(SearchEngineSnippetTest, BackwardCompatibilityNoSnippetField) {
     }
 }
 
+TEST_F(SearchEngineSnippetTest, CachedResultsHoldNoSnippets) {
+    SearchOptions opts;
+    opts.generate_snippets = true;
+    auto highlighted = engine.search("fox", opts);
+    ASSERT_EQ(highlighted.size(), 1u);
+    EXPECT_FALSE(highlighted[0].snippets.empty());
+
+    // Same cache entry, served without snippets
+    opts.generate_snippets = false;
+    auto plain = engine.search("fox", opts);
+    ASSERT_EQ(plain.size(), 1u);
+    EXPECT_TRUE(plain[0].snippets.empty());
+    EXPECT_EQ(engine.getCacheStats().hit_count, 1u);
+}
+
+TEST_F(SearchEngineSnippetTest, PaginatedSnippetsOnlyForReturnedPage) {
+    SearchOptions opts;
+    opts.generate_snippets = true;
+    opts.max_results = 1;
+    opts.offset = 1;
+    auto page = engine.searchPaginated("learning", opts);
+    EXPECT_EQ(page.pagination.total_hits, 2u);
+    ASSERT_EQ(page.results.size(), 1u);
+    ASSERT_FALSE(page.results[0].snippets.empty());
+    EXPECT_NE(page.results[0].snippets[0].find("<mark>learning</mark>"), std::string::npos);
+}
+
+TEST(SearchEngineOffsetSnippetTest, LargePageSnippetsInParallel) {
+    SearchEngine engine;
+    std::string filler;
+    for (int i = 0; i < 8000; ++i) filler += "padding words ";
+    for (int i = 0; i < 8; ++i) {
+        engine.indexDocument(Document{0, {{"content", filler + "needle " + std::to_string(i)}}});
+    }
+
+    SearchOptions opts;
+    opts.generate_snippets = true;
+    opts.max_results = 8;
+    auto results = engine.search("needle", opts);
+    ASSERT_EQ(results.size(), 8u);
+    for (const auto& r : results) {
+        ASSERT_EQ(r.snippets.size(), 1u);
+        EXPECT_NE(r.snippets[0].find("<mark>needle</mark>"), std::string::npos);
+    }
+}
+
+TEST(SearchEngineOffsetSnippetTest, StoredOffsetsHighlightStemmedForms) {
+    for (bool store_offsets : {false, true}) {
+        SearchEngine engine;
+        engine.setStemmer(StemmerType::SIMPLE);
+        engine.setStoreTermOffsets(store_offsets);
+        engine.indexDocument(Document{0, {{"content", "Jumping frogs jumped over the jumpsuit"}}});
+
+        SearchOptions opts;
+        opts.generate_snippets = true;
+        opts.use_cache = false;
+        auto results = engine.search("jump", opts);
+        ASSERT_EQ(results.size(), 1u);
+        ASSERT_EQ(results[0].snippets.size(), 1u);
+        EXPECT_EQ(results[0].snippets[0],
+                  "<mark>Jumping</mark> frogs <mark>jumped</mark> over the jumpsuit")
+            << "store_offsets=" << store_offsets;
+    }
+}
+
 // =============================================================================
 // Edge case tests
 // =============================================================================
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include "search_engine.hpp"
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+using namespace rtrv_search_engine;
+
+using Ids = std::vector<uint64_t>;
+
+namespace {
+
+// Occurrences of the query terms, ties broken by id: independent of
+// collection statistics, so kept results must equal a new search exactly
+class CountRanker : public Ranker {
+public:
+    double score(const Query& query, const Document& doc, const IndexStats&) override {
+        std::istringstream words(doc.getAllText());
+        double count = 0.0;
+        for (std::string word; words >> word;) {
+            count += static_cast<double>(std::count(query.terms.begin(), query.terms.end(), word));
+        }
+        return count > 0.0 ? count + doc.id * 1e-6 : 0.0;
+    }
+    std::string getName() const override { return "Count"; }
+};
+
+Ids idsOf(const std::vector<SearchResult>& results) {
+    Ids ids;
+    for (const auto& result : results) ids.push_back(result.document.id);
+    return ids;
+}
+
+// A subscriber's copy of the results, rebuilt from deltas
+struct Replica {
+    std::map<uint64_t, double> scores;
+    uint64_t sequence = 0;
+
+    void apply(const SubscriptionDelta& delta) {
+        EXPECT_EQ(delta.sequence, sequence + 1);
+        sequence = delta.sequence;
+        if (delta.reset) scores.clear();
+        for (uint64_t id : delta.removed) scores.erase(id);
+        for (const auto& upsert : delta.upserts) scores[upsert.document.id] = upsert.score;
+    }
+
+    Ids ids() const {
+        std::vector<std::pair<double, uint64_t>> ranked;
+        for (const auto& [id, score] : scores) ranked.emplace_back(-score, id);
+        std::sort(ranked.begin(), ranked.end());
+        Ids ids;
+        for (const auto& entry : ranked) ids.push_back(entry.second);
+        return ids;
+    }
+};
+
+}  // namespace
+
+TEST(SubscriptionTest, ResultsMatchSearchAfterEveryWrite) {
+    SearchEngine engine;
+    engine.registerCustomRanker(std::make_unique<CountRanker>());
+    engine.defineField("lang", FieldType::KEYWORD);
+    engine.defineField("year", FieldType::INT64);
+
+    uint64_t state = 11;
+    const auto next = [&](uint64_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 33) % bound;
+    };
+    const auto randomDoc = [&](uint32_t id) {
+        std::string text;
+        for (int w = 0; w < 6; ++w) text += "w" + std::to_string(next(25)) + " ";
+        return Document{id, {{"content", text},
+                             {"lang", next(3) ? "en" : "de"},
+                             {"year", std::to_string(2000 + next(6))}}};
+    };
+    for (uint32_t id = 1; id <= 100; ++id) engine.indexDocument(randomDoc(id));
+
+    struct Case {
+        std::string query;
+        SearchOptions options;
+        Replica replica;
+        uint64_t id = 0;
+    };
+    std::vector<Case> cases(4);
+    cases[0].query = "w1 w2";
+    cases[0].options.max_results = 5;
+    cases[1].query = "w3";
+    cases[1].options.max_results = 3;
+    cases[1].options.filters = {"lang:en"};
+    cases[2].query = "w4 OR w5 OR w6";
+    cases[2].options.max_results = 8;
+    cases[3].query = "w7 year:[2001 TO 2003]";
+    cases[3].options.max_results = 4;
+    cases[3].options.filters = {"lang:de OR year:2000", "NOT year:2002"};
+    for (auto& c : cases) {
+        c.options.ranker_name = "Count";
+        c.id = engine.subscribe(c.query, c.options, [&c](const SubscriptionDelta& delta) { c.replica.apply(delta); });
+        ASSERT_NE(c.id, 0u);
+        EXPECT_EQ(c.replica.sequence, 1u);
+    }
+    EXPECT_EQ(engine.subscriptionCount(), 4u);
+
+    for (int op = 0; op < 400; ++op) {
+        const uint32_t id = static_cast<uint32_t>(1 + next(150));
+        switch (next(4)) {
+            case 0: engine.deleteDocument(id); break;
+            case 1: engine.updateDocument(id, randomDoc(id)); break;
+            case 2: engine.indexDocuments({randomDoc(id), randomDoc(static_cast<uint32_t>(1 + next(150)))}); break;
+            default: engine.indexDocument(randomDoc(id)); break;
+        }
+        for (auto& c : cases) {
+            const auto expected = idsOf(engine.search(c.query, c.options));
+            ASSERT_EQ(idsOf(engine.subscriptionResults(c.id)), expected) << c.query << " after op " << op;
+            ASSERT_EQ(c.replica.ids(), expected) << c.query << " after op " << op;
+        }
+    }
+}
+
+TEST(SubscriptionTest, DeltasAreNumberedAndPolled) {
+    SearchEngine engine;
+    engine.indexDocument(Document{1, {{"content", "quarterly revenue report"}}});
+    engine.indexDocument(Document{2, {{"content", "revenue up"}}});
+
+    std::vector<SubscriptionDelta> pushed;
+    uint64_t id = 0;
+    SearchOptions options;
+    options.max_results = 2;
+    id = engine.subscribe("revenue", options, [&](const SubscriptionDelta& delta) {
+        pushed.push_back(delta);
+        EXPECT_EQ(engine.subscriptionCount(), 1u);  // Called outside the engine lock
+    });
+    ASSERT_NE(id, 0u);
+    ASSERT_EQ(pushed.size(), 1u);
+    EXPECT_TRUE(pushed[0].reset);
+    EXPECT_EQ(idsOf(pushed[0].upserts), idsOf(engine.search("revenue", options)));
+
+    engine.indexDocument(Document{3, {{"content", "weather forecast"}}});  // Not a hit: no delta
+    EXPECT_EQ(pushed.size(), 1u);
+    engine.indexDocument(Document{4, {{"content", "revenue"}}});  // Shortest: best score
+    ASSERT_EQ(pushed.size(), 2u);
+    EXPECT_EQ(pushed[1].sequence, 2u);
+    EXPECT_EQ(idsOf(pushed[1].upserts), Ids{4});
+    EXPECT_EQ(pushed[1].removed.size(), 1u);
+    EXPECT_EQ(idsOf(engine.subscriptionResults(id)), idsOf(engine.search("revenue", options)));
+
+    engine.deleteDocument(4);  // A full top-k lost a member: searched again
+    ASSERT_EQ(pushed.size(), 3u);
+    EXPECT_EQ(pushed[2].removed, Ids{4});
+    EXPECT_EQ(engine.subscriptionResults(id).size(), 2u);
+
+    EXPECT_EQ(engine.subscriptionDeltas(id, 0).size(), 3u);
+    EXPECT_EQ(engine.subscriptionDeltas(id, 2).size(), 1u);
+    EXPECT_TRUE(engine.subscriptionDeltas(id, 3).empty());
+
+    // Pollers behind the retained log get a reset with the current results
+    for (uint32_t doc = 10; doc < 10 + SubscriptionIndex::kRetainedDeltas; ++doc) {
+        engine.indexDocument(Document{doc, {{"content", "revenue"}}});
+        engine.deleteDocument(doc);
+    }
+    const auto behind = engine.subscriptionDeltas(id, 1);
+    ASSERT_EQ(behind.size(), 1u);
+    EXPECT_TRUE(behind[0].reset);
+    EXPECT_EQ(behind[0].sequence, pushed.back().sequence);
+    EXPECT_EQ(idsOf(behind[0].upserts), idsOf(engine.subscriptionResults(id)));
+
+    EXPECT_TRUE(engine.unsubscribe(id));
+    EXPECT_FALSE(engine.unsubscribe(id));
+    EXPECT_TRUE(engine.subscriptionDeltas(id, 0).empty());
+}
+
+TEST(SubscriptionTest, FiltersAndUnsupportedOptions) {
+    SearchEngine engine;
+    engine.defineField("status", FieldType::KEYWORD);
+    engine.indexDocument(Document{1, {{"content", "disk full"}, {"status", "open"}}});
+
+    SearchOptions options;
+    options.filters = {"status:open"};
+    const uint64_t open = engine.subscribe("", options);  // Filter only
+    ASSERT_NE(open, 0u);
+    EXPECT_EQ(idsOf(engine.subscriptionResults(open)), Ids{1});
+    engine.indexDocument(Document{2, {{"content", "cpu hot"}, {"status", "open"}}});
+    engine.updateDocument(1, Document{1, {{"content", "disk full"}, {"status", "closed"}}});
+    EXPECT_EQ(idsOf(engine.subscriptionResults(open)), Ids{2});
+
+    EXPECT_EQ(engine.subscribe("", {}), 0u);
+    SearchOptions sorted;
+    sorted.sort = {{"status", false}};
+    EXPECT_EQ(engine.subscribe("disk", sorted), 0u);
+    SearchOptions fuzzy;
+    fuzzy.fuzzy_enabled = true;
+    EXPECT_EQ(engine.subscribe("disk", fuzzy), 0u);
+    EXPECT_EQ(engine.subscriptionCount(), 1u);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "synonym_map.hpp"
+#include "search_engine.hpp"
+
+#include <sstream>
+
+using namespace rtrv_search_engine;
+
+static std::vector<std::string> texts(const std::vector<SynonymAlternative>* alternatives) {
+    std::vector<std::string> out;
+    if (alternatives) {
+        for (const auto& alternative : *alternatives) out.push_back(alternative.text);
+    }
+    return out;
+}
+
+TEST(SynonymMapTest, MatchesLeftmostLongestMultiWordEntries) {
+    SynonymMap map;
+    map.addMapping("new york", {"ny"});
+    map.addMapping("new york city", {"nyc"});
+    map.addMapping("city", {"town"});
+
+    auto matches = map.match({"cheap", "new", "york", "city", "hotels", "in", "new", "york"});
+    ASSERT_EQ(matches.size(), 2u);
+    EXPECT_EQ(matches[0].start, 1u);
+    EXPECT_EQ(matches[0].length, 3u);  // Longest wins over "new york" and "city"
+    EXPECT_EQ(texts(matches[0].alternatives), std::vector<std::string>{"nyc"});
+    EXPECT_EQ(matches[1].start, 6u);
+    EXPECT_EQ(matches[1].length, 2u);
+
+    // A prefix of an entry is not an entry
+    EXPECT_TRUE(map.match({"new"}).empty());
+    EXPECT_EQ(map.lookup("New  York"), map.match({"new", "york"})[0].alternatives);
+    EXPECT_EQ(map.lookup("york"), nullptr);
+}
+
+TEST(SynonymMapTest, LoadsSolrFormat) {
+    std::istringstream rules(
+        "# comment\n"
+        "\n"
+        "couch, sofa, Settee\n"
+        "nyc, big apple => new york\n"
+        "tv => television|0.5\n");
+
+    SynonymMap map;
+    EXPECT_EQ(map.load(rules), 3u);
+
+    EXPECT_EQ(texts(map.lookup("sofa")), (std::vector<std::string>{"couch", "settee"}));
+    EXPECT_EQ(texts(map.lookup("settee")), (std::vector<std::string>{"couch", "sofa"}));
+    EXPECT_EQ(texts(map.lookup("big apple")), std::vector<std::string>{"new york"});
+    EXPECT_EQ(map.lookup("new york"), nullptr);  // One-way
+
+    const auto* tv = map.lookup("tv");
+    ASSERT_NE(tv, nullptr);
+    EXPECT_FLOAT_EQ((*tv)[0].weight, 0.5f);
+    EXPECT_EQ(map.size(), 6u);
+}
+
+TEST(SynonymMapTest, LookupCostIsIndependentOfDictionarySize) {
+    // Many entries sharing first words: matching still follows one edge per token
+    SynonymMap map;
+    for (int i = 0; i < 50000; ++i) {
+        map.addMapping("w" + std::to_string(i % 100) + " x" + std::to_string(i), {"alt" + std::to_string(i)});
+    }
+    EXPECT_EQ(map.size(), 50000u);
+
+    auto matches = map.match({"w7", "x4207", "w8", "missing"});
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(texts(matches[0].alternatives), std::vector<std::string>{"alt4207"});
+    EXPECT_GT(map.memoryUsage(), 0u);
+}
+
+TEST(SynonymMapTest, QueryTimeExpansionIsWeightedOr) {
+    SearchEngine engine;
+    engine.indexDocument(Document{1, {{"content", "comfortable couch for the living room"}}});
+    engine.indexDocument(Document{2, {{"content", "leather sofa on sale"}}});
+    engine.indexDocument(Document{3, {{"content", "kitchen table"}}});
+    engine.indexDocument(Document{4, {{"content", "hotels in new york city"}}});
+
+    auto map = std::make_shared<SynonymMap>();
+    map->addMapping("couch", {"sofa"}, 0.5f);
+    map->addMapping("nyc", {"new york", "metropolis"});
+    engine.setSynonyms(map);
+
+    SearchOptions options;
+    options.explain_scores = true;
+    auto results = engine.search("couch", options);
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].document.id, 1u);  // The original term outranks the synonym
+    EXPECT_EQ(results[1].document.id, 2u);
+
+    // Multi-word alternative; "metropolis" is pruned (not in the index)
+    results = engine.search("nyc");
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0].document.id, 4u);
+
+    options.expand_synonyms = false;
+    EXPECT_EQ(engine.search("couch", options).size(), 1u);
+    EXPECT_TRUE(engine.search("nyc", options).empty());
+}
+
+TEST(SynonymMapTest, IndexTimeSynonymsNeedNoExpansion) {
+    SearchEngine engine;
+    auto map = std::make_shared<SynonymMap>();
+    map->addEquivalent({"car", "automobile"});
+    engine.setSynonyms(map, SynonymMode::INDEX_TIME);
+
+    engine.indexDocument(Document{1, {{"content", "a fast red car"}}});
+    engine.indexDocument(Document{2, {{"content", "vintage automobile museum"}}});
+    engine.indexDocument(Document{3, {{"content", "bicycle repair"}}});
+
+    EXPECT_EQ(engine.getIndex()->getDocumentFrequency("automobile"), 2u);
+    EXPECT_EQ(engine.getIndex()->getPositions("automobile", 1), engine.getIndex()->getPositions("car", 1));
+
+    for (const std::string query : {"car", "automobile"}) {
+        auto results = engine.search(query);
+        ASSERT_EQ(results.size(), 2u) << query;
+        EXPECT_GT(results[1].score, 0.0);
+    }
+}
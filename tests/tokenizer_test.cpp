@@ -213,6 +213,20 @@ TEST_F(TokenizerTest, SimpleStemming_ComplexSuffixes) {
     EXPECT_EQ(tokens[1], "nation");      // "national" -> "nation" (removes "al")
 }
 
+TEST_F(TokenizerTest, AnalyzeWordMatchesTokenize) {
+    tokenizer.setStemmer(StemmerType::SIMPLE);
+    for (std::string word : {"Running", "NATIONAL", "relational", "cats", "glass", "run", "it's"}) {
+        const auto tokens = tokenizer.tokenize(word);
+        ASSERT_EQ(tokens.size(), 1u) << word;
+        EXPECT_TRUE(tokenizer.analyzeWord(word));
+        EXPECT_EQ(word, tokens[0]);
+    }
+    tokenizer.setRemoveStopwords(true);
+    std::string stop = "The";
+    EXPECT_TRUE(tokenizer.tokenize(stop).empty());
+    EXPECT_FALSE(tokenizer.analyzeWord(stop));
+}
+
 TEST_F(TokenizerTest, NoStemming) {
     tokenizer.setStemmer(StemmerType::NONE);
     
@@ -0,0 +1,494 @@
+#include <gtest/gtest.h>
+#include "vector_index.hpp"
+#include "search_engine.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <sstream>
+#include <unordered_set>
+
+using namespace rtrv_search_engine;
+
+static std::vector<std::vector<float>> randomVectors(size_t count, size_t dimension, uint32_t seed) {
+    std::mt19937 gen(seed);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<std::vector<float>> vectors(count, std::vector<float>(dimension));
+    for (auto& vector : vectors) {
+        for (auto& x : vector) x = dist(gen);
+    }
+    return vectors;
+}
+
+TEST(VectorIndexTest, KernelsMatchScalarReference) {
+    // Odd dimension exercises the SIMD body and the scalar tail
+    auto vectors = randomVectors(2, 37, 7);
+    const auto& a = vectors[0];
+    const auto& b = vectors[1];
+
+    double dot = 0.0, l2 = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        dot += a[i] * b[i];
+        l2 += (a[i] - b[i]) * (a[i] - b[i]);
+    }
+    EXPECT_NEAR(vector_kernels::dotProduct(a.data(), b.data(), a.size()), dot, 1e-3);
+    EXPECT_NEAR(vector_kernels::squaredL2(a.data(), b.data(), a.size()), l2, 1e-3);
+
+    auto unit = a;
+    vector_kernels::normalize(unit.data(), unit.size());
+    EXPECT_NEAR(vector_kernels::dotProduct(unit.data(), unit.data(), unit.size()), 1.0, 1e-5);
+}
+
+TEST(VectorIndexTest, ApproximateSearchHasHighRecall) {
+    const auto vectors = randomVectors(2000, 32, 1);
+    const auto queries = randomVectors(20, 32, 2);
+    for (auto metric : {VectorMetric::L2, VectorMetric::COSINE, VectorMetric::DOT}) {
+        HnswIndex index(32, metric);
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            ASSERT_TRUE(index.add(i + 1, vectors[i]));
+        }
+        EXPECT_EQ(index.size(), vectors.size());
+
+        size_t found = 0;
+        for (const auto& query : queries) {
+            std::unordered_set<uint64_t> truth;
+            for (const auto& hit : index.exactSearch(query, 10)) truth.insert(hit.doc_id);
+            auto hits = index.search(query, 10, 100);
+            ASSERT_EQ(hits.size(), 10u);
+            for (size_t i = 1; i < hits.size(); ++i) {
+                EXPECT_LE(hits[i - 1].distance, hits[i].distance);
+            }
+            for (const auto& hit : hits) found += truth.count(hit.doc_id);
+        }
+        EXPECT_GE(found, queries.size() * 10 * 9 / 10) << "metric " << static_cast<int>(metric);
+    }
+}
+
+TEST(VectorIndexTest, FilterAndRemoval) {
+    const auto vectors = randomVectors(500, 16, 3);
+    HnswIndex index(16, VectorMetric::L2);
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        index.add(i, vectors[i]);
+    }
+    EXPECT_FALSE(index.add(999, std::vector<float>(8, 1.0f)));
+
+    // Even ids only
+    auto even = index.search(vectors[1], 5, 0, [](uint64_t id) { return id % 2 == 0; });
+    ASSERT_EQ(even.size(), 5u);
+    for (const auto& hit : even) EXPECT_EQ(hit.doc_id % 2, 0u);
+
+    // Too selective for the graph neighbourhood: falls back to an exact scan
+    auto rare = index.search(vectors[0], 3, 0, [](uint64_t id) { return id % 100 == 7; });
+    ASSERT_EQ(rare.size(), 3u);
+    auto exact = index.exactSearch(vectors[0], 3, [](uint64_t id) { return id % 100 == 7; });
+    for (size_t i = 0; i < rare.size(); ++i) {
+        EXPECT_EQ(rare[i].doc_id, exact[i].doc_id);
+    }
+
+    EXPECT_EQ(index.search(vectors[42], 1).front().doc_id, 42u);
+    EXPECT_TRUE(index.remove(42));
+    EXPECT_FALSE(index.contains(42));
+    EXPECT_NE(index.search(vectors[42], 1).front().doc_id, 42u);
+}
+
+TEST(VectorIndexTest, EngineKnnSearchSurvivesSnapshot) {
+    const auto vectors = randomVectors(300, 8, 4);
+    SearchEngine engine;
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        Document doc{0, {{"content", i % 2 == 0 ? "even document" : "odd document"}}};
+        doc.vector = vectors[i];
+        engine.indexDocument(doc);
+    }
+    engine.enableVectorSearch(8, VectorMetric::COSINE);
+    EXPECT_GT(engine.memoryUsage().vector_index_bytes, 0u);
+
+    auto results = engine.knnSearch(vectors[10], 5);
+    ASSERT_EQ(results.size(), 5u);
+    EXPECT_EQ(results[0].document.id, 11u);
+    EXPECT_NEAR(results[0].score, 1.0, 1e-5);
+
+    auto odd = engine.knnSearch(vectors[10], 5, [](const Document& doc) {
+        return doc.getField("content") == "odd document";
+    });
+    ASSERT_EQ(odd.size(), 5u);
+    for (const auto& r : odd) EXPECT_EQ(r.document.id % 2, 0u);  // Ids start at 1
+
+    const std::string filepath = "/tmp/test_vector_snapshot.bin";
+    ASSERT_TRUE(engine.saveSnapshot(filepath));
+    SearchEngine loaded;
+    ASSERT_TRUE(loaded.loadSnapshot(filepath));
+    std::remove(filepath.c_str());
+
+    auto reloaded = loaded.knnSearch(vectors[10], 5);
+    ASSERT_EQ(reloaded.size(), results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(reloaded[i].document.id, results[i].document.id);
+        EXPECT_EQ(reloaded[i].document.vector, results[i].document.vector);
+    }
+
+    EXPECT_TRUE(engine.deleteDocument(11));
+    EXPECT_NE(engine.knnSearch(vectors[10], 1).front().document.id, 11u);
+    EXPECT_TRUE(engine.knnSearch(std::vector<float>(3, 1.0f), 5).empty());
+}
+
+TEST(VectorIndexTest, LoadRejectsDanglingLinks) {
+    const auto vectors = randomVectors(50, 4, 6);
+    HnswIndex index(4, VectorMetric::L2);
+    for (size_t i = 0; i < vectors.size(); ++i) index.add(i, vectors[i]);
+    std::ostringstream out;
+    index.save(out);
+    const std::string saved = out.str();
+
+    // magic, node count, entry point, max level, quantized flag, vectors;
+    // then node 0: doc id, deleted, level count, layer-0 link count, links
+    const size_t entry_offset = 4 + 8;
+    const size_t first_link = 4 + 8 + 4 + 4 + 1 + vectors.size() * 4 * sizeof(float) + 8 + 1 + 4 + 4;
+    const uint32_t past_end = static_cast<uint32_t>(vectors.size());
+    for (size_t offset : {entry_offset, first_link}) {
+        std::string corrupt = saved;
+        std::memcpy(&corrupt[offset], &past_end, sizeof(past_end));
+        std::istringstream in(corrupt);
+        HnswIndex loaded(4, VectorMetric::L2);
+        EXPECT_FALSE(loaded.load(in)) << "offset " << offset;
+        EXPECT_EQ(loaded.size(), 0u);
+    }
+
+    std::istringstream in(saved);
+    HnswIndex loaded(4, VectorMetric::L2);
+    ASSERT_TRUE(loaded.load(in));
+    EXPECT_EQ(loaded.search(vectors[7], 1).front().doc_id, 7u);
+
+    // Quantizer header after the quantized flag: type, then dimension
+    HnswParams params;
+    params.quantization = VectorQuantization::INT8;
+    HnswIndex quantized(4, VectorMetric::L2, params);
+    for (size_t i = 0; i < vectors.size(); ++i) quantized.add(i, vectors[i]);
+    quantized.quantize();
+    std::ostringstream quantized_out;
+    quantized.save(quantized_out);
+    const std::string quantized_saved = quantized_out.str();
+    const size_t type_offset = 4 + 8 + 4 + 4 + 1;
+    const uint32_t unknown_type = 7;
+    const uint64_t wrong_dimension = 5;
+    std::string corrupt = quantized_saved;
+    std::memcpy(&corrupt[type_offset], &unknown_type, sizeof(unknown_type));
+    std::istringstream bad_type(corrupt);
+    HnswIndex rejected(4, VectorMetric::L2, params);
+    EXPECT_FALSE(rejected.load(bad_type));
+    EXPECT_EQ(rejected.size(), 0u);
+    corrupt = quantized_saved;
+    std::memcpy(&corrupt[type_offset + 4], &wrong_dimension, sizeof(wrong_dimension));
+    std::istringstream bad_dimension(corrupt);
+    EXPECT_FALSE(rejected.load(bad_dimension));
+    std::istringstream other_index(quantized_saved);
+    HnswIndex wider(8, VectorMetric::L2, params);
+    EXPECT_FALSE(wider.load(other_index));
+    std::istringstream intact(quantized_saved);
+    ASSERT_TRUE(rejected.load(intact));
+    EXPECT_EQ(rejected.size(), vectors.size());
+}
+
+TEST(VectorIndexTest, HybridRankerFusesLexicalAndVector) {
+    SearchEngine engine;
+    engine.enableVectorSearch(2, VectorMetric::COSINE);
+    auto add = [&](const std::string& text, std::vector<float> vector) {
+        Document doc{0, {{"content", text}}};
+        doc.vector = std::move(vector);
+        return engine.indexDocument(doc);
+    };
+    const uint64_t both = add("neural search ranking", {1.0f, 0.1f});
+    const uint64_t lexical = add("search search search engines", {-1.0f, 0.0f});
+    const uint64_t semantic = add("dense retrieval embeddings", {1.0f, 0.0f});
+    add("cooking recipes", {0.0f, 1.0f});
+    add("search tips for the kitchen and garden", {0.0f, -1.0f});
+    
+    SearchOptions options;
+    options.ranker_name = "Hybrid-RRF";
+    options.query_vector = {1.0f, 0.0f};
+    options.explain_scores = true;
+    auto results = engine.search("search", options);
+    ASSERT_EQ(results.size(), 5u);  // Union of both top-N lists
+    EXPECT_EQ(results[0].document.id, both);
+    EXPECT_NE(results[0].explanation.find("Lexical: #"), std::string::npos);
+    
+    std::vector<uint64_t> ids;
+    for (const auto& r : results) ids.push_back(r.document.id);
+    EXPECT_NE(std::find(ids.begin(), ids.end(), semantic), ids.end());  // No query term
+    EXPECT_NE(std::find(ids.begin(), ids.end(), lexical), ids.end());
+    
+    // A different embedding is a different cache entry
+    options.query_vector = {-1.0f, 0.0f};
+    EXPECT_EQ(engine.search("search", options)[0].document.id, lexical);
+    
+    options.ranker_name = "Hybrid-Weighted";
+    options.query_vector = {1.0f, 0.0f};
+    EXPECT_EQ(engine.search("search", options)[0].document.id, both);
+    
+    // No embedding: plain BM25 over the lexical matches
+    options.query_vector.clear();
+    results = engine.search("search", options);
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0].document.id, lexical);
+}
+
+TEST(VectorIndexTest, HybridFiltersApplyToTheVectorSide) {
+    SearchEngine engine;
+    engine.enableVectorSearch(2, VectorMetric::COSINE);
+    engine.defineField("lang", FieldType::KEYWORD);
+    FusionParams params;
+    params.window_size = 5;
+    engine.registerCustomRanker(std::make_unique<HybridRanker>("Hybrid-Small", params));
+    for (uint32_t id = 1; id <= 40; ++id) {
+        // The nearest vectors are all German
+        const bool english = id > 30;
+        Document doc{id, {{"content", "article " + std::to_string(id)}, {"lang", english ? "en" : "de"}}};
+        doc.vector = english ? std::vector<float>{0.5f, 1.0f} : std::vector<float>{1.0f, 0.01f * id};
+        engine.indexDocument(doc);
+    }
+
+    SearchOptions options;
+    options.ranker_name = "Hybrid-Small";
+    options.query_vector = {1.0f, 0.0f};
+    options.filters = {"lang:en"};
+    options.max_results = 5;
+    const auto results = engine.search("missing", options);
+    ASSERT_EQ(results.size(), 5u);  // Not the 5 nearest, filtered away
+    for (const auto& result : results) {
+        EXPECT_GT(result.document.id, 30u);
+    }
+}
+
+TEST(VectorIndexTest, HybridVectorOnlyQuery) {
+    SearchEngine engine;
+    engine.enableVectorSearch(2, VectorMetric::COSINE);
+    engine.defineField("lang", FieldType::KEYWORD);
+    for (uint32_t id = 1; id <= 10; ++id) {
+        Document doc{id, {{"content", "article " + std::to_string(id)}, {"lang", id % 2 ? "en" : "de"}}};
+        doc.vector = {1.0f, 0.1f * id};
+        engine.indexDocument(doc);
+    }
+
+    // Empty text: the kNN leg alone ranks, nearest first
+    SearchOptions options;
+    options.ranker_name = "Hybrid-RRF";
+    options.query_vector = {1.0f, 0.0f};
+    options.max_results = 3;
+    auto results = engine.search("", options);
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0].document.id, 1u);
+    EXPECT_EQ(results[1].document.id, 2u);
+    EXPECT_EQ(results[2].document.id, 3u);
+
+    // Filters still apply to the vector side
+    options.filters = {"lang:de"};
+    results = engine.search("", options);
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0].document.id, 2u);
+
+    // Without an embedding an empty query stays filter-only
+    options.query_vector.clear();
+    options.filters.clear();
+    EXPECT_TRUE(engine.search("", options).empty());
+}
+
+TEST(VectorIndexTest, HybridFacetsDoNotDependOnPageSize) {
+    SearchEngine engine;
+    engine.enableVectorSearch(2, VectorMetric::COSINE);
+    engine.defineField("lang", FieldType::KEYWORD);
+    FusionParams params;
+    params.window_size = 5;
+    engine.registerCustomRanker(std::make_unique<HybridRanker>("Hybrid-Small", params));
+    for (uint32_t id = 1; id <= 20; ++id) {
+        Document doc{id, {{"content", id % 2 ? "search engine" : "cooking"}, {"lang", id % 3 ? "en" : "de"}}};
+        doc.vector = {1.0f, 0.05f * id};
+        engine.indexDocument(doc);
+    }
+
+    SearchOptions options;
+    options.ranker_name = "Hybrid-Small";
+    options.query_vector = {1.0f, 0.0f};
+    options.facets = {"lang"};
+    const auto counts = [&](size_t page_size) {
+        options.max_results = page_size;
+        const auto page = engine.searchPaginated("search", options);
+        std::map<std::string, size_t> counts;
+        for (const auto& value : page.facets.at(0).values) {
+            counts[value.value] = value.count;
+        }
+        return counts;
+    };
+    const auto all = counts(20);
+    EXPECT_FALSE(all.empty());
+    EXPECT_EQ(counts(1), all);
+    EXPECT_EQ(counts(3), all);
+}
+
+TEST(VectorIndexTest, QuantizedKernelsMatchScalarReference) {
+    auto vectors = randomVectors(3, 37, 11);
+    std::vector<uint8_t> codes(37);
+    for (size_t i = 0; i < codes.size(); ++i) codes[i] = static_cast<uint8_t>(i * 7 % 256);
+
+    double dot = 0.0, l2 = 0.0;
+    for (size_t i = 0; i < codes.size(); ++i) {
+        dot += vectors[0][i] * codes[i];
+        const double diff = vectors[0][i] - vectors[1][i] * codes[i];
+        l2 += diff * diff;
+    }
+    EXPECT_NEAR(vector_kernels::dotProductU8(vectors[0].data(), codes.data(), 37), dot, 1e-2);
+    EXPECT_NEAR(vector_kernels::squaredL2U8(vectors[0].data(), vectors[1].data(), codes.data(), 37), l2, 1e-1);
+
+    // 13 subspaces of 256 entries
+    std::vector<float> table(13 * 256);
+    for (size_t i = 0; i < table.size(); ++i) table[i] = static_cast<float>(i % 101);
+    double sum = 0.0;
+    for (size_t m = 0; m < 13; ++m) sum += table[m * 256 + codes[m]];
+    EXPECT_NEAR(vector_kernels::lookupSum(table.data(), codes.data(), 13, 256), sum, 1e-3);
+}
+
+TEST(VectorIndexTest, QuantizationShrinksVectorsWithBoundedRecallLoss) {
+    const auto vectors = randomVectors(2000, 32, 5);
+    const auto queries = randomVectors(20, 32, 6);
+    HnswIndex exact(32, VectorMetric::L2);
+    for (size_t i = 0; i < vectors.size(); ++i) exact.add(i, vectors[i]);
+
+    auto recall = [&](const HnswIndex& index) {
+        size_t found = 0;
+        for (const auto& query : queries) {
+            std::unordered_set<uint64_t> truth;
+            for (const auto& hit : exact.exactSearch(query, 10)) truth.insert(hit.doc_id);
+            for (const auto& hit : index.search(query, 10, 100)) found += truth.count(hit.doc_id);
+        }
+        return static_cast<double>(found) / (queries.size() * 10);
+    };
+
+    const std::string vector_file = "/tmp/test_vector_rows.f32";
+    for (auto type : {VectorQuantization::INT8, VectorQuantization::PQ}) {
+        for (bool rescore : {false, true}) {
+            HnswParams params;
+            params.quantization = type;
+            params.pq_subspaces = 8;   // 8 bytes instead of 128: 16x
+            params.train_size = 1000;  // Trains halfway through the build
+            if (rescore) params.vector_file = vector_file;
+            HnswIndex index(32, VectorMetric::L2, params);
+            for (size_t i = 0; i < vectors.size(); ++i) {
+                ASSERT_TRUE(index.add(i, vectors[i]));
+            }
+            EXPECT_TRUE(index.quantized());
+            EXPECT_LT(index.memoryUsage(), exact.memoryUsage());
+
+            const double r = recall(index);
+            const bool int8 = type == VectorQuantization::INT8;
+            // Isotropic Gaussian data is the worst case for PQ; real embeddings do better
+            const double floor = int8 ? (rescore ? 0.95 : 0.9) : (rescore ? 0.85 : 0.4);
+            EXPECT_GE(r, floor) << "int8=" << int8 << " rescore=" << rescore;
+            if (rescore) {
+                // Re-scored distances are exact
+                auto hit = index.search(vectors[7], 1).front();
+                EXPECT_EQ(hit.doc_id, 7u);
+                EXPECT_NEAR(hit.distance, 0.0f, 1e-5);
+            }
+        }
+    }
+    std::remove(vector_file.c_str());
+}
+
+TEST(VectorIndexTest, QuantizedEngineSnapshotKeepsCodesAndRows) {
+    const auto vectors = randomVectors(400, 16, 8);
+    const std::string vector_file = "/tmp/test_engine_vectors.f32";
+    HnswParams params;
+    params.quantization = VectorQuantization::PQ;
+    params.pq_subspaces = 4;
+    params.train_size = 200;
+    params.vector_file = vector_file;
+
+    SearchEngine engine;
+    engine.enableVectorSearch(16, VectorMetric::COSINE, params);
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        Document doc{0, {{"content", "document"}}};
+        doc.vector = vectors[i];
+        engine.indexDocument(doc);
+    }
+    EXPECT_TRUE(engine.getVectorIndex()->quantized());
+    auto results = engine.knnSearch(vectors[20], 5);
+    ASSERT_EQ(results.size(), 5u);
+    EXPECT_EQ(results[0].document.id, 21u);
+    EXPECT_NEAR(results[0].score, 1.0, 1e-5);
+    EXPECT_TRUE(results[0].document.vector.empty());  // Only the index keeps it
+
+    const std::string filepath = "/tmp/test_quantized_snapshot.bin";
+    ASSERT_TRUE(engine.saveSnapshot(filepath));
+
+    // Configured with its own file: rows are restored there, re-scoring works
+    const std::string loaded_file = "/tmp/test_engine_vectors_loaded.f32";
+    HnswParams loaded_params = params;
+    loaded_params.vector_file = loaded_file;
+    SearchEngine loaded;
+    loaded.enableVectorSearch(16, VectorMetric::COSINE, loaded_params);
+    ASSERT_TRUE(loaded.loadSnapshot(filepath));
+    ASSERT_TRUE(loaded.getVectorIndex()->quantized());
+    EXPECT_EQ(loaded.getVectorIndex()->params().pq_subspaces, 4u);
+    auto reloaded = loaded.knnSearch(vectors[20], 5);
+    ASSERT_EQ(reloaded.size(), results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(reloaded[i].document.id, results[i].document.id);
+        EXPECT_FLOAT_EQ(reloaded[i].score, results[i].score);
+    }
+
+    // Not configured: codes only
+    SearchEngine codes_only;
+    ASSERT_TRUE(codes_only.loadSnapshot(filepath));
+    EXPECT_EQ(codes_only.knnSearch(vectors[20], 5).size(), 5u);
+
+    std::remove(filepath.c_str());
+    std::remove(vector_file.c_str());
+    std::remove(loaded_file.c_str());
+}
+
+TEST(VectorIndexTest, QuantizedEngineReenablesAndReloads) {
+    const auto vectors = randomVectors(300, 16, 12);
+    const std::string vector_file = "/tmp/test_reenable_vectors.f32";
+    HnswParams params;
+    params.quantization = VectorQuantization::INT8;
+    params.train_size = 100;
+    params.vector_file = vector_file;
+
+    SearchEngine engine;
+    engine.enableVectorSearch(16, VectorMetric::COSINE, params);
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        Document doc{0, {{"content", "document"}}};
+        doc.vector = vectors[i];
+        engine.indexDocument(doc);
+    }
+    const auto expected = engine.knnSearch(vectors[40], 5);
+    ASSERT_EQ(expected.size(), 5u);
+    EXPECT_EQ(expected[0].document.id, 41u);
+
+    // Enabling again rebuilds from the index's full-precision rows
+    engine.enableVectorSearch(16, VectorMetric::COSINE, params);
+    ASSERT_EQ(engine.getVectorIndex()->size(), vectors.size());
+    EXPECT_TRUE(engine.getVectorIndex()->quantized());
+    auto results = engine.knnSearch(vectors[40], 5);
+    ASSERT_EQ(results.size(), 5u);
+    EXPECT_EQ(results[0].document.id, 41u);
+    EXPECT_NEAR(results[0].score, 1.0, 1e-5);
+
+    const std::string filepath = "/tmp/test_reenable_snapshot.bin";
+    ASSERT_TRUE(engine.saveSnapshot(filepath));
+    SearchEngine loaded;
+    ASSERT_TRUE(loaded.loadSnapshot(filepath));
+    ASSERT_EQ(loaded.getVectorIndex()->size(), vectors.size());
+
+    // Codes only: rebuilding without quantization keeps the decoded vectors
+    loaded.enableVectorSearch(16, VectorMetric::COSINE);
+    ASSERT_EQ(loaded.getVectorIndex()->size(), vectors.size());
+    EXPECT_FALSE(loaded.getVectorIndex()->quantized());
+    results = loaded.knnSearch(vectors[40], 5);
+    ASSERT_EQ(results.size(), 5u);
+    EXPECT_EQ(results[0].document.id, 41u);
+    EXPECT_EQ(results[0].document.vector.size(), 16u);
+
+    std::remove(filepath.c_str());
+    std::remove(vector_file.c_str());
+}